@@ -75,6 +75,25 @@ struct LocalLightData
     }
 };
 
+//one skinned mesh of the merged vertex skinning dispatch, each job covers ceil(vertexCount / 64) thread groups starting at firstGroup
+struct SkinningJob
+{
+    uint firstGroup;
+    uint vertexCount;
+    uint jointIDBufferAddress;
+    uint jointWeightBufferAddress;
+
+    uint staticPosBufferAddress;
+    uint staticNormalBufferAddress;
+    uint staticTangentBufferAddress;
+    uint jointMatrixBufferAddress;
+
+    uint animPosBufferAddress;
+    uint animNormalBufferAddress;
+    uint animTangentBufferAddress;
+    uint _padding;
+};
+
 #ifndef __cplusplus
 
 template<typename T>
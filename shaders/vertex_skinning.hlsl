@@ -1,75 +1,96 @@
 #include "common.hlsli"
 #include "gpu_scene.hlsli"
 
-cbuffer CB : register(b1)
+cbuffer CB : register(b0)
 {
-    uint c_vertexCount;
+    uint c_jobCount;
+    uint c_jobBufferAddress;
+    uint c_groupCount;
+    uint c_groupCountX; //the groups are dispatched in 2D when there are more than 65535
+};
 
-    uint c_staticPosBufferAddress;
-    uint c_staticNormalBufferAddress;
-    uint c_staticTangentBufferAddress;
+SkinningJob LoadSkinningJob(uint job_index)
+{
+    return LoadSceneConstantBuffer<SkinningJob>(c_jobBufferAddress + sizeof(SkinningJob) * job_index);
+}
 
-    uint c_animPosBufferAddress;
-    uint c_animNormalBufferAddress;
-    uint c_animTangentBufferAddress;
+//the last job whose first group is not after group_index, the jobs are sorted by firstGroup
+uint FindSkinningJob(uint group_index)
+{
+    uint first = 0;
+    uint last = c_jobCount - 1;
 
-    uint c_jointIDBufferAddress;
-    uint c_jointWeightBufferAddress;
-    uint c_jointMatrixBufferAddress;
-};
+    while (first < last)
+    {
+        uint middle = (first + last + 1) / 2;
+        uint firstGroup = LoadSceneConstantBuffer<uint>(c_jobBufferAddress + sizeof(SkinningJob) * middle);
+
+        if (firstGroup <= group_index)
+        {
+            first = middle;
+        }
+        else
+        {
+            last = middle - 1;
+        }
+    }
+
+    return first;
+}
+
+//the joint matrices are uploaded as the first 3 rows of affine 4x4 matrices
+float3x4 LoadJointMatrix(uint jointMatrixBufferAddress, uint joint_id)
+{
+    uint address = jointMatrixBufferAddress + sizeof(float4) * 3 * joint_id;
+    float4 row0 = LoadSceneConstantBuffer<float4>(address);
+    float4 row1 = LoadSceneConstantBuffer<float4>(address + sizeof(float4));
+    float4 row2 = LoadSceneConstantBuffer<float4>(address + sizeof(float4) * 2);
+    return float3x4(row0, row1, row2);
+}
 
 [numthreads(64, 1, 1)]
-void main(uint3 dispatchThreadID : SV_DispatchThreadID)
+void main(uint3 groupID : SV_GroupID, uint groupIndex : SV_GroupIndex)
 {
-    uint vertex_id = dispatchThreadID.x;
-    if (vertex_id >= c_vertexCount)
+    uint group_index = groupID.y * c_groupCountX + groupID.x;
+    if (group_index >= c_groupCount)
     {
         return;
     }
 
-    uint16_t4 jointID = LoadSceneStaticBuffer<uint16_t4>(c_jointIDBufferAddress, vertex_id);
-    float4x4 jointMatrix0 = LoadSceneConstantBuffer<float4x4>(c_jointMatrixBufferAddress + sizeof(float4x4) * jointID.x);
-    float4x4 jointMatrix1 = LoadSceneConstantBuffer<float4x4>(c_jointMatrixBufferAddress + sizeof(float4x4) * jointID.y);
-    float4x4 jointMatrix2 = LoadSceneConstantBuffer<float4x4>(c_jointMatrixBufferAddress + sizeof(float4x4) * jointID.z);
-    float4x4 jointMatrix3 = LoadSceneConstantBuffer<float4x4>(c_jointMatrixBufferAddress + sizeof(float4x4) * jointID.w);
-#if !GFX_BACKEND_VULKAN
-    jointMatrix0 = transpose(jointMatrix0);
-    jointMatrix1 = transpose(jointMatrix1);
-    jointMatrix2 = transpose(jointMatrix2);
-    jointMatrix3 = transpose(jointMatrix3);
-#endif
-    float4 jointWeight = LoadSceneStaticBuffer<float4>(c_jointWeightBufferAddress, vertex_id);
-
-    float3 pos = LoadSceneStaticBuffer<float3>(c_staticPosBufferAddress, vertex_id);
-
-    float4 skinned_pos = mul(jointMatrix0, float4(pos, 1.0)) * jointWeight.x +
-        mul(jointMatrix1, float4(pos, 1.0)) * jointWeight.y +
-        mul(jointMatrix2, float4(pos, 1.0)) * jointWeight.z +
-        mul(jointMatrix3, float4(pos, 1.0)) * jointWeight.w;
-
-    StoreSceneAnimationBuffer<float3>(c_animPosBufferAddress, vertex_id, skinned_pos.xyz);
-
-    if (c_staticNormalBufferAddress != INVALID_ADDRESS)
+    SkinningJob job = LoadSkinningJob(FindSkinningJob(group_index));
+
+    uint vertex_id = (group_index - job.firstGroup) * 64 + groupIndex;
+    if (vertex_id >= job.vertexCount)
     {
-        float3 normal = LoadSceneStaticBuffer<float3>(c_staticNormalBufferAddress, vertex_id);
-
-        float4 skinned_normal = mul(jointMatrix0, float4(normal, 0.0)) * jointWeight.x +
-            mul(jointMatrix1, float4(normal, 0.0)) * jointWeight.y +
-            mul(jointMatrix2, float4(normal, 0.0)) * jointWeight.z +
-            mul(jointMatrix3, float4(normal, 0.0)) * jointWeight.w;
-        
-        StoreSceneAnimationBuffer<float3>(c_animNormalBufferAddress, vertex_id, skinned_normal.xyz);
+        return;
     }
 
-    if (c_staticTangentBufferAddress != INVALID_ADDRESS)
+    uint16_t4 jointID = LoadSceneStaticBuffer<uint16_t4>(job.jointIDBufferAddress, vertex_id);
+    float4 jointWeight = LoadSceneStaticBuffer<float4>(job.jointWeightBufferAddress, vertex_id);
+
+    float3x4 jointMatrix = LoadJointMatrix(job.jointMatrixBufferAddress, jointID.x) * jointWeight.x +
+        LoadJointMatrix(job.jointMatrixBufferAddress, jointID.y) * jointWeight.y +
+        LoadJointMatrix(job.jointMatrixBufferAddress, jointID.z) * jointWeight.z +
+        LoadJointMatrix(job.jointMatrixBufferAddress, jointID.w) * jointWeight.w;
+
+    float3 pos = LoadSceneStaticBuffer<float3>(job.staticPosBufferAddress, vertex_id);
+    float3 skinned_pos = mul(jointMatrix, float4(pos, 1.0));
+
+    StoreSceneAnimationBuffer<float3>(job.animPosBufferAddress, vertex_id, skinned_pos);
+
+    if (job.staticNormalBufferAddress != INVALID_ADDRESS)
     {
-        float4 tangent = LoadSceneStaticBuffer<float4>(c_staticTangentBufferAddress, vertex_id);
+        float3 normal = LoadSceneStaticBuffer<float3>(job.staticNormalBufferAddress, vertex_id);
+        float3 skinned_normal = mul(jointMatrix, float4(normal, 0.0));
 
-        float4 skinned_tangent = mul(jointMatrix0, float4(tangent.xyz, 0.0)) * jointWeight.x +
-            mul(jointMatrix1, float4(tangent.xyz, 0.0)) * jointWeight.y +
-            mul(jointMatrix2, float4(tangent.xyz, 0.0)) * jointWeight.z +
-            mul(jointMatrix3, float4(tangent.xyz, 0.0)) * jointWeight.w;
+        StoreSceneAnimationBuffer<float3>(job.animNormalBufferAddress, vertex_id, skinned_normal);
+    }
+
+    if (job.staticTangentBufferAddress != INVALID_ADDRESS)
+    {
+        float4 tangent = LoadSceneStaticBuffer<float4>(job.staticTangentBufferAddress, vertex_id);
+        float3 skinned_tangent = mul(jointMatrix, float4(tangent.xyz, 0.0));
 
-        StoreSceneAnimationBuffer<float4>(c_animTangentBufferAddress, vertex_id, float4(skinned_tangent.xyz, tangent.w));
+        StoreSceneAnimationBuffer<float4>(job.animTangentBufferAddress, vertex_id, float4(skinned_tangent, tangent.w));
     }
 }
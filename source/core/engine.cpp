@@ -2,6 +2,9 @@
 #include "utils/log.h"
 #include "utils/profiler.h"
 #include "utils/system.h"
+#include "utils/memory.h"
+#include "physics/physics_query_benchmark.h"
+#include "renderer/pass_profiler.h"
 #include "enkiTS/TaskScheduler.h"
 #include "rpmalloc/rpmalloc.h"
 #include "rpmalloc/rpnew.h"
@@ -27,6 +30,8 @@ Engine::~Engine()
 
 void Engine::Init(const eastl::string& work_path, void* window_handle, uint32_t window_width, uint32_t window_height)
 {
+    stm_setup(); //loading code times itself with stm_now
+
 #if RE_PLATFORM_WINDOWS
     auto console_sink = std::make_shared<spdlog::sinks::msvc_sink_mt>();
 #else
@@ -77,6 +82,7 @@ void Engine::Init(const eastl::string& work_path, void* window_handle, uint32_t
 
     m_assetPath = m_workPath + configIni.GetValue("RealEngine", "AssetPath");
     m_shaderPath = m_workPath + configIni.GetValue("RealEngine", "ShaderPath");
+    m_memoryStatsLogInterval = (float)configIni.GetDoubleValue("RealEngine", "MemoryStatsLogInterval");
 
     const char* backend = configIni.GetValue("Render", "Backend");
     GfxRenderBackend renderBackend = magic_enum::enum_cast<GfxRenderBackend>(backend).
@@ -88,23 +94,46 @@ void Engine::Init(const eastl::string& work_path, void* window_handle, uint32_t
 
     m_pRenderer = eastl::make_unique<Renderer>();
     m_pRenderer->SetAsyncComputeEnabled(configIni.GetBoolValue("Render", "AsyncCompute"));
+    m_pRenderer->SetCommandCaptureEnabled(configIni.GetBoolValue("Render", "CommandCapture"));
     if (!m_pRenderer->CreateDevice(renderBackend, window_handle, window_width, window_height))
     {
         exit(0);
     }
 
+    //"pass name=gpu ms[,cpu ms]", passes over budget are reported by the pass profiler
+    CSimpleIniA::TNamesDepend budgets;
+    configIni.GetAllKeys("PassBudgets", budgets);
+    for (auto iter = budgets.begin(); iter != budgets.end(); ++iter)
+    {
+        PassProfiler::Budget budget;
+        sscanf(configIni.GetValue("PassBudgets", iter->pItem), "%f,%f", &budget.gpu, &budget.cpu);
+        m_pRenderer->GetPassProfiler()->SetBudget(iter->pItem, budget);
+    }
+
     m_pWorld = eastl::make_unique<World>();
+
+    IPhysicsSystem* physics = m_pWorld->GetPhysicsSystem();
+    physics->SetStepRate((float)configIni.GetDoubleValue("Physics", "StepRate", 60.0));
+    physics->SetMaxSubsteps((uint32_t)configIni.GetLongValue("Physics", "MaxSubsteps", 4));
+    physics->SetAsyncStepEnabled(configIni.GetBoolValue("Physics", "AsyncStep"));
+    physics->SetStatsLogInterval((uint32_t)configIni.GetLongValue("Physics", "StatsLogInterval"));
+
     m_pWorld->LoadScene(m_assetPath + configIni.GetValue("World", "Scene"));
 
-    m_pEditor = eastl::make_unique<Editor>(m_pRenderer.get());
+    if (configIni.GetBoolValue("Physics", "QueryBenchmark"))
+    {
+        RunPhysicsQueryBenchmark(physics);
+    }
 
-    stm_setup();
+    m_pEditor = eastl::make_unique<Editor>(m_pRenderer.get());
 }
 
 void Engine::Shut()
 {
     m_pTaskScheduler->WaitforAll();
 
+    LogMemoryStats();
+
     m_pWorld.reset();
     m_pEditor.reset();
     m_pTaskScheduler.reset();
@@ -137,5 +166,29 @@ void Engine::Tick()
         m_pRenderer->RenderFrame();
     }
 
+    UpdateMemoryFrameStats();
+
+    if (m_memoryStatsLogInterval > 0.0f && stm_sec(stm_since(m_lastMemoryStatsLogTime)) >= m_memoryStatsLogInterval)
+    {
+        LogMemoryStats();
+        m_lastMemoryStatsLogTime = stm_now();
+    }
+
     FrameMark;
 }
+
+void Engine::LogMemoryStats()
+{
+    RE_INFO("Memory stats :");
+
+    for (uint32_t i = 0; i < (uint32_t)MemoryTag::Count; ++i)
+    {
+        const MemoryTagStats& stats = GetMemoryTagStats((MemoryTag)i);
+
+        RE_INFO("    {:<12} live {:.2f} MB, peak {:.2f} MB, {} allocs/{} frees last frame",
+            GetMemoryTagName((MemoryTag)i),
+            stats.liveBytes.load(std::memory_order_relaxed) / (1024.0 * 1024.0),
+            stats.peakBytes.load(std::memory_order_relaxed) / (1024.0 * 1024.0),
+            stats.frameAllocCount, stats.frameFreeCount);
+    }
+}
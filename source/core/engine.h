@@ -34,6 +34,8 @@ public:
 private:
     ~Engine();
 
+    void LogMemoryStats();
+
 private:
     eastl::unique_ptr<Renderer> m_pRenderer;
     eastl::unique_ptr<World> m_pWorld;
@@ -44,6 +46,9 @@ private:
     uint64_t m_lastFrameTime = 0;
     float m_frameTime = 0.0f; //in seconds
 
+    float m_memoryStatsLogInterval = 0.0f; //in seconds, 0 only logs at shutdown
+    uint64_t m_lastMemoryStatsLogTime = 0;
+
     void* m_windowHandle = nullptr;
     eastl::string m_workPath;
     eastl::string m_assetPath;
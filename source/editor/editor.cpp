@@ -3,6 +3,8 @@
 #include "im3d_impl.h"
 #include "core/engine.h"
 #include "renderer/texture_loader.h"
+#include "renderer/pass_profiler.h"
+#include "world/animation_lod.h"
 #include "utils/assert.h"
 #include "utils/system.h"
 #include "imgui/imgui.h"
@@ -52,6 +54,8 @@ Editor::~Editor()
 
 void Editor::NewFrame()
 {
+    MemoryTagScope memoryTag(MemoryTag::Editor);
+
     m_pImGui->NewFrame();
     m_pIm3d->NewFrame();
 
@@ -68,6 +72,8 @@ void Editor::NewFrame()
 
 void Editor::Tick()
 {
+    MemoryTagScope memoryTag(MemoryTag::Editor);
+
     FlushPendingTextureDeletions();
 
     BuildDockLayout();
@@ -85,6 +91,42 @@ void Editor::Tick()
         ImGui::End();
     }
 
+    if (m_bShowProfiler)
+    {
+        ImGui::Begin("Profiler", &m_bShowProfiler);
+
+        m_pRenderer->GetPassProfiler()->OnGui();
+
+        ImGui::End();
+    }
+
+    if (m_bShowMemoryStats)
+    {
+        ImGui::Begin("Memory Stats", &m_bShowMemoryStats);
+
+        DrawMemoryStats();
+
+        ImGui::End();
+    }
+
+    if (m_bShowAnimationLOD)
+    {
+        ImGui::Begin("Animation LOD", &m_bShowAnimationLOD);
+
+        Engine::GetInstance()->GetWorld()->GetAnimationLOD()->OnGui();
+
+        ImGui::End();
+    }
+
+    if (m_bShowPhysics)
+    {
+        ImGui::Begin("Physics", &m_bShowPhysics);
+
+        Engine::GetInstance()->GetWorld()->GetPhysicsSystem()->OnGui();
+
+        ImGui::End();
+    }
+
     if (m_bShowInspector)
     {
         ImGui::Begin("Inspector", &m_bShowInspector);
@@ -213,6 +255,10 @@ void Editor::DrawMenu()
         {
             ImGui::MenuItem("Inspector", "", &m_bShowInspector);
             ImGui::MenuItem("Renderer", "", &m_bShowRenderer);
+            ImGui::MenuItem("Profiler", "", &m_bShowProfiler);
+            ImGui::MenuItem("Memory Stats", "", &m_bShowMemoryStats);
+            ImGui::MenuItem("Animation LOD", "", &m_bShowAnimationLOD);
+            ImGui::MenuItem("Physics", "", &m_bShowPhysics);
 
             m_bResetLayout = ImGui::MenuItem("Reset Layout");
 
@@ -390,6 +436,41 @@ void Editor::DrawFrameStats()
     ImGui::End();
 }
 
+void Editor::DrawMemoryStats()
+{
+    ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit;
+    if (!ImGui::BeginTable("MemoryStats", 5, flags))
+    {
+        return;
+    }
+
+    ImGui::TableSetupColumn("Tag", ImGuiTableColumnFlags_WidthStretch);
+    ImGui::TableSetupColumn("Live (MB)");
+    ImGui::TableSetupColumn("Peak (MB)");
+    ImGui::TableSetupColumn("Allocs/Frame");
+    ImGui::TableSetupColumn("Frees/Frame");
+    ImGui::TableHeadersRow();
+
+    for (uint32_t i = 0; i < (uint32_t)MemoryTag::Count; ++i)
+    {
+        const MemoryTagStats& stats = GetMemoryTagStats((MemoryTag)i);
+
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::Text("%s", GetMemoryTagName((MemoryTag)i));
+        ImGui::TableNextColumn();
+        ImGui::Text("%.2f", stats.liveBytes.load(std::memory_order_relaxed) / (1024.0f * 1024.0f));
+        ImGui::TableNextColumn();
+        ImGui::Text("%.2f", stats.peakBytes.load(std::memory_order_relaxed) / (1024.0f * 1024.0f));
+        ImGui::TableNextColumn();
+        ImGui::Text("%u", stats.frameAllocCount);
+        ImGui::TableNextColumn();
+        ImGui::Text("%u", stats.frameFreeCount);
+    }
+
+    ImGui::EndTable();
+}
+
 void Editor::CreateGpuMemoryStats()
 {
     Engine* pEngine = Engine::GetInstance();
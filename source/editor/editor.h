@@ -20,6 +20,7 @@ private:
     void DrawToolBar();
     void DrawGizmo();
     void DrawFrameStats();
+    void DrawMemoryStats();
 
     void CreateGpuMemoryStats();
     void ShowRenderGraph();
@@ -40,6 +41,10 @@ private:
 
     bool m_bShowInspector = true;
     bool m_bShowRenderer = true;
+    bool m_bShowProfiler = false;
+    bool m_bShowMemoryStats = false;
+    bool m_bShowAnimationLOD = false;
+    bool m_bShowPhysics = false;
 
     unsigned int m_dockSpace = 0;
 
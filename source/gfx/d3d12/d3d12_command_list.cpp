@@ -5,6 +5,7 @@
 #include "d3d12_buffer.h"
 #include "d3d12_pipeline_state.h"
 #include "d3d12_heap.h"
+#include "d3d12_query_heap.h"
 #include "d3d12_descriptor.h"
 #include "d3d12_rt_blas.h"
 #include "d3d12_rt_tlas.h"
@@ -78,6 +79,8 @@ bool D3D12CommandList::Create()
 void D3D12CommandList::ResetAllocator()
 {
     m_pCommandAllocator->Reset();
+    m_constantBufferAllocator.Reset();
+    m_stateCache.ResetStats();
 }
 
 void D3D12CommandList::Begin()
@@ -140,7 +143,7 @@ void D3D12CommandList::Submit()
 void D3D12CommandList::ResetState()
 {
     m_commandCount = 0;
-    m_pCurrentPSO = nullptr;
+    m_stateCache.Reset();
 
     if (m_queueType == GfxCommandQueue::Graphics || m_queueType == GfxCommandQueue::Compute)
     {
@@ -369,6 +372,26 @@ void D3D12CommandList::UpdateTileMappings(IGfxTexture* texture, IGfxHeap* heap,
         D3D12_TILE_MAPPING_FLAG_NONE);
 }
 
+void D3D12CommandList::ResetQueries(IGfxQueryHeap* heap, uint32_t first, uint32_t count)
+{
+    //d3d12 queries don't need to be reset
+}
+
+void D3D12CommandList::WriteTimestamp(IGfxQueryHeap* heap, uint32_t index)
+{
+    m_pCommandList->EndQuery((ID3D12QueryHeap*)heap->GetHandle(), D3D12_QUERY_TYPE_TIMESTAMP, index);
+    ++m_commandCount;
+}
+
+void D3D12CommandList::ResolveQueries(IGfxQueryHeap* heap, uint32_t first, uint32_t count, IGfxBuffer* dst_buffer, uint32_t offset)
+{
+    RE_ASSERT(offset % sizeof(uint64_t) == 0);
+
+    m_pCommandList->ResolveQueryData((ID3D12QueryHeap*)heap->GetHandle(), D3D12_QUERY_TYPE_TIMESTAMP, first, count, 
+        (ID3D12Resource*)dst_buffer->GetHandle(), offset);
+    ++m_commandCount;
+}
+
 void D3D12CommandList::TextureBarrier(IGfxTexture* texture, uint32_t sub_resource, GfxAccessFlags access_before, GfxAccessFlags access_after)
 {
     D3D12_TEXTURE_BARRIER barrier = {};
@@ -557,10 +580,8 @@ void D3D12CommandList::EndRenderPass()
 
 void D3D12CommandList::SetPipelineState(IGfxPipelineState* state)
 {
-    if (m_pCurrentPSO != state)
+    if (m_stateCache.SetPipelineState(state))
     {
-        m_pCurrentPSO = state;
-
         m_pCommandList->SetPipelineState((ID3D12PipelineState*)state->GetHandle());
 
         if (state->GetType() == GfxPipelineType::Graphics)
@@ -584,6 +605,11 @@ void D3D12CommandList::SetIndexBuffer(IGfxBuffer* buffer, uint32_t offset, GfxFo
 {
     RE_ASSERT(format == GfxFormat::R16UI || format == GfxFormat::R32UI);
 
+    if (!m_stateCache.SetIndexBuffer(buffer, offset, format))
+    {
+        return;
+    }
+
     D3D12_INDEX_BUFFER_VIEW ibv;
     ibv.BufferLocation = buffer->GetGpuAddress() + offset;
     ibv.SizeInBytes = buffer->GetDesc().size - offset;
@@ -594,20 +620,33 @@ void D3D12CommandList::SetIndexBuffer(IGfxBuffer* buffer, uint32_t offset, GfxFo
 
 void D3D12CommandList::SetViewport(uint32_t x, uint32_t y, uint32_t width, uint32_t height)
 {
-    D3D12_VIEWPORT vp = { (float)x, (float)y, (float)width, (float)height, 0.0f, 1.0f };
-    m_pCommandList->RSSetViewports(1, &vp);
+    if (m_stateCache.SetViewport(x, y, width, height))
+    {
+        D3D12_VIEWPORT vp = { (float)x, (float)y, (float)width, (float)height, 0.0f, 1.0f };
+        m_pCommandList->RSSetViewports(1, &vp);
+    }
 
     SetScissorRect(x, y, width, height);
 }
 
 void D3D12CommandList::SetScissorRect(uint32_t x, uint32_t y, uint32_t width, uint32_t height)
 {
+    if (!m_stateCache.SetScissorRect(x, y, width, height))
+    {
+        return;
+    }
+
     D3D12_RECT rect = { (LONG)x, (LONG)y, LONG(x + width), LONG(y + height) };
     m_pCommandList->RSSetScissorRects(1, &rect);
 }
 
 void D3D12CommandList::SetGraphicsConstants(uint32_t slot, const void* data, size_t data_size)
 {
+    if (!m_stateCache.SetGraphicsConstants(slot, data, data_size))
+    {
+        return;
+    }
+
     if (slot == 0)
     {
         uint32_t consts_count = (uint32_t)data_size / sizeof(uint32_t);
@@ -617,15 +656,25 @@ void D3D12CommandList::SetGraphicsConstants(uint32_t slot, const void* data, siz
     else
     {
         RE_ASSERT(slot < GFX_MAX_CBV_BINDINGS);
-        D3D12_GPU_VIRTUAL_ADDRESS address = ((D3D12Device*)m_pDevice)->AllocateConstantBuffer(data, data_size);
-        RE_ASSERT(address);
-
-        m_pCommandList->SetGraphicsRootConstantBufferView(slot, address);
+        D3D12_GPU_VIRTUAL_ADDRESS address = ((D3D12Device*)m_pDevice)->AllocateConstantBuffer(m_constantBufferAllocator, data, data_size);
+        if (address != 0)
+        {
+            m_pCommandList->SetGraphicsRootConstantBufferView(slot, address);
+        }
+        else
+        {
+            m_stateCache.InvalidateGraphicsConstants(slot);
+        }
     }
 }
 
 void D3D12CommandList::SetComputeConstants(uint32_t slot, const void* data, size_t data_size)
 {
+    if (!m_stateCache.SetComputeConstants(slot, data, data_size))
+    {
+        return;
+    }
+
     if (slot == 0)
     {
         uint32_t consts_count = (uint32_t)data_size / sizeof(uint32_t);
@@ -635,10 +684,15 @@ void D3D12CommandList::SetComputeConstants(uint32_t slot, const void* data, size
     else
     {
         RE_ASSERT(slot < GFX_MAX_CBV_BINDINGS);
-        D3D12_GPU_VIRTUAL_ADDRESS address = ((D3D12Device*)m_pDevice)->AllocateConstantBuffer(data, data_size);
-        RE_ASSERT(address);
-
-        m_pCommandList->SetComputeRootConstantBufferView(slot, address);
+        D3D12_GPU_VIRTUAL_ADDRESS address = ((D3D12Device*)m_pDevice)->AllocateConstantBuffer(m_constantBufferAllocator, data, data_size);
+        if (address != 0)
+        {
+            m_pCommandList->SetComputeRootConstantBufferView(slot, address);
+        }
+        else
+        {
+            m_stateCache.InvalidateComputeConstants(slot);
+        }
     }
 }
 
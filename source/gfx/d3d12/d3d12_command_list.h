@@ -2,6 +2,7 @@
 
 #include "d3d12_header.h"
 #include "../gfx_command_list.h"
+#include "../gfx_constant_buffer_allocator.h"
 
 class D3D12Device;
 
@@ -42,6 +43,10 @@ public:
     virtual void WriteBuffer(IGfxBuffer* buffer, uint32_t offset, uint32_t data) override;
     virtual void UpdateTileMappings(IGfxTexture* texture, IGfxHeap* heap, uint32_t mapping_count, const GfxTileMapping* mappings) override;
 
+    virtual void ResetQueries(IGfxQueryHeap* heap, uint32_t first, uint32_t count) override;
+    virtual void WriteTimestamp(IGfxQueryHeap* heap, uint32_t index) override;
+    virtual void ResolveQueries(IGfxQueryHeap* heap, uint32_t first, uint32_t count, IGfxBuffer* dst_buffer, uint32_t offset) override;
+
     virtual void TextureBarrier(IGfxTexture* texture, uint32_t sub_resource, GfxAccessFlags access_before, GfxAccessFlags access_after) override;
     virtual void BufferBarrier(IGfxBuffer* buffer, GfxAccessFlags access_before, GfxAccessFlags access_after) override;
     virtual void GlobalBarrier(GfxAccessFlags access_before, GfxAccessFlags access_after) override;
@@ -83,7 +88,8 @@ private:
     ID3D12GraphicsCommandList7* m_pCommandList = nullptr;
 
     uint32_t m_commandCount = 0;
-    IGfxPipelineState* m_pCurrentPSO = nullptr;
+
+    GfxConstantBufferSubAllocator m_constantBufferAllocator;
 
     eastl::vector<D3D12_TEXTURE_BARRIER> m_textureBarriers;
     eastl::vector<D3D12_BUFFER_BARRIER> m_bufferBarriers;
@@ -8,8 +8,10 @@
 #include "d3d12_pipeline_state.h"
 #include "d3d12_descriptor.h"
 #include "d3d12_heap.h"
+#include "d3d12_query_heap.h"
 #include "d3d12_rt_blas.h"
 #include "d3d12_rt_tlas.h"
+#include "d3d12_pipeline_library.h"
 #include "d3d12ma/D3D12MemAlloc.h"
 #include "pix_runtime.h"
 #include "ags.h"
@@ -92,6 +94,12 @@ D3D12Device::~D3D12Device()
     m_pResDescriptorAllocator.reset();
     m_pSamplerAllocator.reset();
     m_pNonShaderVisibleUavAllocator.reset();
+
+    if (m_pPipelineLibrary)
+    {
+        m_pPipelineLibrary->Save();
+        m_pPipelineLibrary.reset();
+    }
     
     SAFE_RELEASE(m_pDrawSignature);
     SAFE_RELEASE(m_pDrawIndexedSignature);
@@ -177,6 +185,17 @@ IGfxHeap* D3D12Device::CreateHeap(const GfxHeapDesc& desc, const eastl::string&
     return pHeap;
 }
 
+IGfxQueryHeap* D3D12Device::CreateQueryHeap(const GfxQueryHeapDesc& desc, const eastl::string& name)
+{
+    D3D12QueryHeap* pHeap = new D3D12QueryHeap(this, desc, name);
+    if (!pHeap->Create())
+    {
+        delete pHeap;
+        return nullptr;
+    }
+    return pHeap;
+}
+
 IGfxSwapchain* D3D12Device::CreateSwapchain(const GfxSwapchainDesc& desc, const eastl::string& name)
 {
     D3D12Swapchain* pSwapchain = new D3D12Swapchain(this, desc, name);
@@ -202,7 +221,7 @@ IGfxCommandList* D3D12Device::CreateCommandList(GfxCommandQueue queue_type, cons
 IGfxShader* D3D12Device::CreateShader(const GfxShaderDesc& desc, eastl::span<uint8_t> data, const eastl::string& name)
 {
     D3D12Shader* pShader = new D3D12Shader(this, desc, name);
-    if (!pShader->Create(data))
+    if (!data.empty() && !pShader->Create(data))
     {
         delete pShader;
         return nullptr;
@@ -213,7 +232,7 @@ IGfxShader* D3D12Device::CreateShader(const GfxShaderDesc& desc, eastl::span<uin
 IGfxPipelineState* D3D12Device::CreateGraphicsPipelineState(const GfxGraphicsPipelineDesc& desc, const eastl::string& name)
 {
     D3D12GraphicsPipelineState* pPipeline = new D3D12GraphicsPipelineState(this, desc, name);
-    if (!pPipeline->Create())
+    if (IsShaderReady(desc) && !pPipeline->Create())
     {
         delete pPipeline;
         return nullptr;
@@ -224,7 +243,7 @@ IGfxPipelineState* D3D12Device::CreateGraphicsPipelineState(const GfxGraphicsPip
 IGfxPipelineState* D3D12Device::CreateMeshShadingPipelineState(const GfxMeshShadingPipelineDesc& desc, const eastl::string& name)
 {
     D3D12MeshShadingPipelineState* pPipeline = new D3D12MeshShadingPipelineState(this, desc, name);
-    if (!pPipeline->Create())
+    if (IsShaderReady(desc) && !pPipeline->Create())
     {
         delete pPipeline;
         return nullptr;
@@ -235,7 +254,7 @@ IGfxPipelineState* D3D12Device::CreateMeshShadingPipelineState(const GfxMeshShad
 IGfxPipelineState* D3D12Device::CreateComputePipelineState(const GfxComputePipelineDesc& desc, const eastl::string& name)
 {
     D3D12ComputePipelineState* pPipeline = new D3D12ComputePipelineState(this, desc, name);
-    if (!pPipeline->Create())
+    if (IsShaderReady(desc) && !pPipeline->Create())
     {
         delete pPipeline;
         return nullptr;
@@ -317,6 +336,13 @@ uint32_t D3D12Device::GetAllocationSize(const GfxTextureDesc& desc)
     return (uint32_t)info.SizeInBytes;
 }
 
+uint64_t D3D12Device::GetTimestampFrequency()
+{
+    uint64_t frequency = 0;
+    m_pGraphicsQueue->GetTimestampFrequency(&frequency);
+    return frequency;
+}
+
 bool D3D12Device::DumpMemoryStats(const eastl::string& file)
 {
     FILE* f = nullptr;
@@ -336,6 +362,11 @@ bool D3D12Device::DumpMemoryStats(const eastl::string& file)
     return true;
 }
 
+void D3D12Device::LogPipelineCacheStats()
+{
+    m_pPipelineLibrary->LogStats();
+}
+
 void D3D12Device::BeginFrame()
 {
     DoDeferredDeletion();
@@ -500,6 +531,10 @@ bool D3D12Device::Create()
     m_pNonShaderVisibleUavAllocator = eastl::make_unique<D3D12DescriptorAllocator>(m_pDevice, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, false, 4096, "Non shader visible UAV Heap");
 
     CreateRootSignature();
+
+    m_pPipelineLibrary = eastl::make_unique<D3D12PipelineLibrary>(this, m_desc.pipeline_cache_path);
+    m_pPipelineLibrary->Create();
+
     CreateIndirectCommandSignatures();
 
     pix::Init();
@@ -516,13 +551,16 @@ bool D3D12Device::Create()
     return true;
 }
 
-D3D12_GPU_VIRTUAL_ADDRESS D3D12Device::AllocateConstantBuffer(const void* data, size_t data_size)
+D3D12_GPU_VIRTUAL_ADDRESS D3D12Device::AllocateConstantBuffer(GfxConstantBufferSubAllocator& allocator, const void* data, size_t data_size)
 {
     void* cpu_address;
     uint64_t gpu_address;
 
     uint32_t index = m_frameID % GFX_MAX_INFLIGHT_FRAMES;
-    m_pConstantBufferAllocators[index]->Allocate((uint32_t)data_size, &cpu_address, &gpu_address);
+    if (!allocator.Allocate(m_pConstantBufferAllocators[index].get(), (uint32_t)data_size, &cpu_address, &gpu_address))
+    {
+        return 0;
+    }
 
     memcpy(cpu_address, data, data_size);
 
@@ -866,27 +904,30 @@ D3D12Descriptor D3D12DescriptorAllocator::GetDescriptor(uint32_t index) const
     return descriptor;
 }
 
-D3D12ConstantBufferAllocator::D3D12ConstantBufferAllocator(D3D12Device* device, uint32_t buffer_size, const eastl::string& name)
+D3D12ConstantBufferAllocator::D3D12ConstantBufferAllocator(D3D12Device* device, uint32_t buffer_size, const eastl::string& name) :
+    GfxConstantBufferAllocator(buffer_size, 64 * 1024, 256) //alignment be a multiple of 256
 {
-    GfxBufferDesc desc;
-    desc.size = buffer_size;
-    desc.memory_type = GfxMemoryType::CpuToGpu;
-    desc.usage = GfxBufferUsageConstantBuffer;
+    m_pDevice = device;
+    m_name = name;
 
-    m_pBuffer.reset(device->CreateBuffer(desc, name));
+    AddPages(1);
 }
 
-void D3D12ConstantBufferAllocator::Allocate(uint32_t size, void** cpu_address, uint64_t* gpu_address)
+bool D3D12ConstantBufferAllocator::CreatePage(uint32_t index, Page& page)
 {
-    RE_ASSERT(m_allocatedSize + size <= m_pBuffer->GetDesc().size);
-
-    *cpu_address = (char*)m_pBuffer->GetCpuAddress() + m_allocatedSize;
-    *gpu_address = m_pBuffer->GetGpuAddress() + m_allocatedSize;
+    GfxBufferDesc desc;
+    desc.size = m_pageSize;
+    desc.memory_type = GfxMemoryType::CpuToGpu;
+    desc.usage = GfxBufferUsageConstantBuffer;
 
-    m_allocatedSize += RoundUpPow2(size, 256); //alignment be a multiple of 256
-}
+    eastl::string name = index == 0 ? m_name : fmt::format("{} overflow {}", m_name, index).c_str();
+    m_pBuffers[index].reset(m_pDevice->CreateBuffer(desc, name));
+    if (m_pBuffers[index] == nullptr)
+    {
+        return false;
+    }
 
-void D3D12ConstantBufferAllocator::Reset()
-{
-    m_allocatedSize = 0;
+    page.cpu_address = m_pBuffers[index]->GetCpuAddress();
+    page.gpu_address = m_pBuffers[index]->GetGpuAddress();
+    return true;
 }
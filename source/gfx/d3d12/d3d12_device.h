@@ -2,6 +2,7 @@
 
 #include "d3d12_header.h"
 #include "../gfx_device.h"
+#include "../gfx_constant_buffer_allocator.h"
 #include "EASTL/unique_ptr.h"
 #include "EASTL/queue.h"
 
@@ -38,17 +39,20 @@ private:
 };
 
 class D3D12Device;
+class D3D12PipelineLibrary;
 
-class D3D12ConstantBufferAllocator
+class D3D12ConstantBufferAllocator : public GfxConstantBufferAllocator
 {
 public:
     D3D12ConstantBufferAllocator(D3D12Device* device, uint32_t buffer_size, const eastl::string& name);
 
-    void Allocate(uint32_t size, void** cpu_address, uint64_t* gpu_address);
-    void Reset();
 private:
-    eastl::unique_ptr<IGfxBuffer> m_pBuffer = nullptr;
-    uint32_t m_allocatedSize = 0;
+    virtual bool CreatePage(uint32_t index, Page& page) override;
+
+private:
+    D3D12Device* m_pDevice = nullptr;
+    eastl::string m_name;
+    eastl::unique_ptr<IGfxBuffer> m_pBuffers[MAX_PAGE_COUNT];
 };
 
 class D3D12Device : public IGfxDevice
@@ -66,6 +70,7 @@ public:
     virtual IGfxCommandList* CreateCommandList(GfxCommandQueue queue_type, const eastl::string& name) override;
     virtual IGfxFence* CreateFence(const eastl::string& name) override;
     virtual IGfxHeap* CreateHeap(const GfxHeapDesc& desc, const eastl::string& name) override;
+    virtual IGfxQueryHeap* CreateQueryHeap(const GfxQueryHeapDesc& desc, const eastl::string& name) override;
     virtual IGfxBuffer* CreateBuffer(const GfxBufferDesc& desc, const eastl::string& name) override;
     virtual IGfxTexture* CreateTexture(const GfxTextureDesc& desc, const eastl::string& name) override;
     virtual IGfxShader* CreateShader(const GfxShaderDesc& desc, eastl::span<uint8_t> data, const eastl::string& name) override;
@@ -80,7 +85,9 @@ public:
     virtual IGfxRayTracingTLAS* CreateRayTracingTLAS(const GfxRayTracingTLASDesc& desc, const eastl::string& name) override;
 
     virtual uint32_t GetAllocationSize(const GfxTextureDesc& desc) override;
+    virtual uint64_t GetTimestampFrequency() override;
     virtual bool DumpMemoryStats(const eastl::string& file) override;
+    virtual void LogPipelineCacheStats() override;
 
     IDXGIFactory5* GetDxgiFactory() const { return m_pDxgiFactory; }
     ID3D12CommandQueue* GetGraphicsQueue() const { return m_pGraphicsQueue; }
@@ -90,6 +97,7 @@ public:
     ID3D12DescriptorHeap* GetResourceDescriptorHeap() const { return m_pResDescriptorAllocator->GetHeap(); }
     ID3D12DescriptorHeap* GetSamplerDescriptorHeap() const { return m_pSamplerAllocator->GetHeap(); }
     ID3D12RootSignature* GetRootSignature() const { return m_pRootSignature; }
+    D3D12PipelineLibrary* GetPipelineLibrary() const { return m_pPipelineLibrary.get(); }
     ID3D12CommandSignature* GetDrawSignature() const { return m_pDrawSignature; }
     ID3D12CommandSignature* GetDrawIndexedSignature() const { return m_pDrawIndexedSignature; }
     ID3D12CommandSignature* GetDispatchSignature() const { return m_pDispatchSignature; }
@@ -99,7 +107,8 @@ public:
     ID3D12CommandSignature* GetMultiDispatchSignature() const { return m_pMultiDispatchSignature; }
     ID3D12CommandSignature* GetMultiDispatchMeshSignature() const { return m_pMultiDispatchMeshSignature; }
 
-    D3D12_GPU_VIRTUAL_ADDRESS AllocateConstantBuffer(const void* data, size_t data_size);
+    //returns 0 when the frame is out of constant buffer memory
+    D3D12_GPU_VIRTUAL_ADDRESS AllocateConstantBuffer(GfxConstantBufferSubAllocator& allocator, const void* data, size_t data_size);
 
     void FlushDeferredDeletions();
     void Delete(IUnknown* object);
@@ -156,6 +165,7 @@ private:
     eastl::unique_ptr<D3D12DescriptorAllocator> m_pResDescriptorAllocator;
     eastl::unique_ptr<D3D12DescriptorAllocator> m_pSamplerAllocator;
     eastl::unique_ptr<D3D12DescriptorAllocator> m_pNonShaderVisibleUavAllocator;
+    eastl::unique_ptr<D3D12PipelineLibrary> m_pPipelineLibrary;
 
     struct ObjectDeletion
     {
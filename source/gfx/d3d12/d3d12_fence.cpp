@@ -30,6 +30,11 @@ void D3D12Fence::Signal(uint64_t value)
     m_pFence->Signal(value);
 }
 
+uint64_t D3D12Fence::GetCompletedValue() const
+{
+    return m_pFence->GetCompletedValue();
+}
+
 bool D3D12Fence::Create()
 {
     ID3D12Device* pDevice = (ID3D12Device*)m_pDevice->GetHandle();
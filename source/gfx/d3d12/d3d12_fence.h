@@ -14,6 +14,7 @@ public:
     virtual void* GetHandle() const override { return m_pFence; }
     virtual void Wait(uint64_t value) override;
     virtual void Signal(uint64_t value) override;
+    virtual uint64_t GetCompletedValue() const override;
 
     bool Create();
 
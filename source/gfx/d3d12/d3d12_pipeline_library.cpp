@@ -0,0 +1,152 @@
+#include "d3d12_pipeline_library.h"
+#include "d3d12_device.h"
+#include "utils/log.h"
+#include "utils/fmt.h"
+#include "sokol/sokol_time.h"
+#include <filesystem>
+#include <fstream>
+
+//bump it when the root signature or the hashed pipeline states change
+#define D3D12_PIPELINE_LIBRARY_VERSION 1
+
+D3D12PipelineLibrary::D3D12PipelineLibrary(D3D12Device* device, const eastl::string& path)
+{
+    m_pDevice = device;
+
+    if (!path.empty())
+    {
+        m_file = path + "d3d12_pipeline_library.bin";
+    }
+}
+
+D3D12PipelineLibrary::~D3D12PipelineLibrary()
+{
+    SAFE_RELEASE(m_pLibrary);
+}
+
+bool D3D12PipelineLibrary::Create()
+{
+    ID3D12Device1* device = (ID3D12Device1*)m_pDevice->GetHandle();
+
+    if (!m_file.empty() && m_data.Open(m_file))
+    {
+        HRESULT hr = device->CreatePipelineLibrary(m_data.GetData(), m_data.GetSize(), IID_PPV_ARGS(&m_pLibrary));
+        if (SUCCEEDED(hr))
+        {
+            RE_INFO("[D3D12PipelineLibrary] loaded {:.2f} KB from {}", m_data.GetSize() / 1024.0, m_file);
+            return true;
+        }
+
+        //D3D12_ERROR_DRIVER_VERSION_MISMATCH, D3D12_ERROR_ADAPTER_NOT_FOUND or a corrupted file
+        RE_INFO("[D3D12PipelineLibrary] {} can't be used (0x{:x}), discarded", m_file, (uint32_t)hr);
+        m_data.Close();
+    }
+
+    HRESULT hr = device->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&m_pLibrary));
+    if (FAILED(hr))
+    {
+        //e.g. DXGI_ERROR_UNSUPPORTED on drivers without pipeline library support, PSOs are created without it
+        RE_WARN("[D3D12PipelineLibrary] failed to create the pipeline library (0x{:x})", (uint32_t)hr);
+        m_pLibrary = nullptr;
+        return false;
+    }
+
+    return true;
+}
+
+void D3D12PipelineLibrary::Save()
+{
+    if (m_pLibrary == nullptr || m_file.empty())
+    {
+        return;
+    }
+
+    eastl::vector<uint8_t> data(m_pLibrary->GetSerializedSize());
+    if (data.empty() || FAILED(m_pLibrary->Serialize(data.data(), data.size())))
+    {
+        return;
+    }
+
+    //the old file is still mapped by the library
+    SAFE_RELEASE(m_pLibrary);
+    m_data.Close();
+
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(m_file.c_str()).parent_path(), error);
+
+    std::ofstream os;
+    os.open(m_file.c_str(), std::ios::binary);
+    if (os.fail())
+    {
+        RE_WARN("[D3D12PipelineLibrary] failed to write {}", m_file);
+        return;
+    }
+
+    os.write((const char*)data.data(), data.size());
+
+    RE_INFO("[D3D12PipelineLibrary] saved {:.2f} KB to {}", data.size() / 1024.0, m_file);
+}
+
+void D3D12PipelineLibrary::LogStats() const
+{
+    uint32_t hits = m_nHits.load();
+    uint32_t misses = m_nMisses.load();
+    uint32_t total = hits + misses;
+    double time = stm_ms(m_nCreationTime.load());
+
+    RE_INFO("[D3D12PipelineLibrary] hits : {}, misses : {}, hit rate : {:.1f}%, PSO creation time : {:.2f} ms (avg {:.3f} ms)",
+        hits, misses, total > 0 ? 100.0 * hits / total : 0.0, time, total > 0 ? time / total : 0.0);
+}
+
+ID3D12PipelineState* D3D12PipelineLibrary::CreateGraphicsPipeline(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, uint64_t hash)
+{
+    return LoadOrCreate(hash,
+        [&](const wchar_t* name, ID3D12PipelineState** pso) { return m_pLibrary->LoadGraphicsPipeline(name, &desc, IID_PPV_ARGS(pso)); },
+        [&](ID3D12PipelineState** pso) { return ((ID3D12Device*)m_pDevice->GetHandle())->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(pso)); });
+}
+
+ID3D12PipelineState* D3D12PipelineLibrary::CreateComputePipeline(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc, uint64_t hash)
+{
+    return LoadOrCreate(hash,
+        [&](const wchar_t* name, ID3D12PipelineState** pso) { return m_pLibrary->LoadComputePipeline(name, &desc, IID_PPV_ARGS(pso)); },
+        [&](ID3D12PipelineState** pso) { return ((ID3D12Device*)m_pDevice->GetHandle())->CreateComputePipelineState(&desc, IID_PPV_ARGS(pso)); });
+}
+
+ID3D12PipelineState* D3D12PipelineLibrary::CreatePipeline(const D3D12_PIPELINE_STATE_STREAM_DESC& desc, uint64_t hash)
+{
+    return LoadOrCreate(hash,
+        [&](const wchar_t* name, ID3D12PipelineState** pso) { return m_pLibrary->LoadPipeline(name, &desc, IID_PPV_ARGS(pso)); },
+        [&](ID3D12PipelineState** pso) { return ((ID3D12Device2*)m_pDevice->GetHandle())->CreatePipelineState(&desc, IID_PPV_ARGS(pso)); });
+}
+
+template<typename LoadFunc, typename CreateFunc>
+ID3D12PipelineState* D3D12PipelineLibrary::LoadOrCreate(uint64_t hash, LoadFunc load, CreateFunc create)
+{
+    uint64_t ticks = stm_now();
+    ID3D12PipelineState* pipelineState = nullptr;
+
+    eastl::wstring name = string_to_wstring(fmt::format("{:016x}_{}", hash, D3D12_PIPELINE_LIBRARY_VERSION).c_str());
+
+    //the library is free-threaded, loads and stores may happen on the PSO compilation workers
+    if (m_pLibrary && SUCCEEDED(load(name.c_str(), &pipelineState)))
+    {
+        m_nHits++;
+        m_nCreationTime += stm_since(ticks);
+        return pipelineState;
+    }
+
+    if (FAILED(create(&pipelineState)))
+    {
+        return nullptr;
+    }
+
+    if (m_pLibrary)
+    {
+        //E_INVALIDARG if another thread stored the same pipeline in the meantime, which is fine
+        m_pLibrary->StorePipeline(name.c_str(), pipelineState);
+    }
+
+    m_nMisses++;
+    m_nCreationTime += stm_since(ticks);
+    return pipelineState;
+}
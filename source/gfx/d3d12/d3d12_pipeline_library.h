@@ -0,0 +1,40 @@
+#pragma once
+
+#include "d3d12_header.h"
+#include "utils/memory_mapped_file.h"
+#include "EASTL/atomic.h"
+
+class D3D12Device;
+
+// device-level ID3D12PipelineLibrary shared by all PSO creation, persisted between runs
+class D3D12PipelineLibrary
+{
+public:
+    D3D12PipelineLibrary(D3D12Device* device, const eastl::string& path);
+    ~D3D12PipelineLibrary();
+
+    bool Create();
+    void Save();
+    void LogStats() const;
+
+    //hash : identifies the pipeline in the library, must cover the shaders and all states
+    ID3D12PipelineState* CreateGraphicsPipeline(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, uint64_t hash);
+    ID3D12PipelineState* CreateComputePipeline(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc, uint64_t hash);
+    ID3D12PipelineState* CreatePipeline(const D3D12_PIPELINE_STATE_STREAM_DESC& desc, uint64_t hash);
+
+private:
+    template<typename LoadFunc, typename CreateFunc>
+    ID3D12PipelineState* LoadOrCreate(uint64_t hash, LoadFunc load, CreateFunc create);
+
+private:
+    D3D12Device* m_pDevice = nullptr;
+    ID3D12PipelineLibrary1* m_pLibrary = nullptr;
+    eastl::string m_file;
+
+    //the library reads the serialized blob in place, it must stay mapped for the library's lifetime
+    MemoryMappedFile m_data;
+
+    eastl::atomic<uint32_t> m_nHits{ 0 };
+    eastl::atomic<uint32_t> m_nMisses{ 0 };
+    eastl::atomic<uint64_t> m_nCreationTime{ 0 }; //in ticks
+};
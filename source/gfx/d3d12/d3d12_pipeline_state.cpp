@@ -1,7 +1,9 @@
 #include "d3d12_pipeline_state.h"
 #include "d3d12_device.h"
 #include "d3d12_shader.h"
+#include "d3d12_pipeline_library.h"
 #include "utils/log.h"
+#include "xxHash/xxhash.h"
 
 template<class T>
 inline bool has_rt_binding(const T& desc)
@@ -16,6 +18,19 @@ inline bool has_rt_binding(const T& desc)
     return false;
 }
 
+//identifies a PSO in the pipeline library across runs : shader bytecode hashes + fixed function states
+inline uint64_t pipeline_hash(IGfxShader* s0, IGfxShader* s1, IGfxShader* s2, const void* state, size_t state_size)
+{
+    uint64_t hashes[4] =
+    {
+        s0 ? s0->GetHash() : 0,
+        s1 ? s1->GetHash() : 0,
+        s2 ? s2->GetHash() : 0,
+        state_size > 0 ? XXH3_64bits(state, state_size) : 0,
+    };
+    return XXH3_64bits(hashes, sizeof(hashes));
+}
+
 D3D12GraphicsPipelineState::D3D12GraphicsPipelineState(D3D12Device* pDevice, const GfxGraphicsPipelineDesc& desc, const eastl::string& name)
 {
     m_pDevice = pDevice;
@@ -56,9 +71,11 @@ bool D3D12GraphicsPipelineState::Create()
     desc.SampleMask = 0xFFFFFFFF;
     desc.SampleDesc.Count = 1;
 
-    ID3D12PipelineState* pipelineState = nullptr;
-    ID3D12Device* pDevice = (ID3D12Device*)m_pDevice->GetHandle();
-    if (FAILED(pDevice->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(&pipelineState))))
+    const size_t stateOffset = offsetof(GfxGraphicsPipelineDesc, rasterizer_state);
+    uint64_t hash = pipeline_hash(m_desc.vs, m_desc.ps, nullptr, (const char*)&m_desc + stateOffset, sizeof(m_desc) - stateOffset);
+
+    ID3D12PipelineState* pipelineState = ((D3D12Device*)m_pDevice)->GetPipelineLibrary()->CreateGraphicsPipeline(desc, hash);
+    if (pipelineState == nullptr)
     {
         RE_ERROR("[D3D12GraphicsPipelineState] failed to create {}", m_name);
         return false;
@@ -72,6 +89,7 @@ bool D3D12GraphicsPipelineState::Create()
     }
 
     m_pPipelineState = pipelineState;
+    m_bReady = true;
     return true;
 }
 
@@ -95,9 +113,10 @@ bool D3D12ComputePipelineState::Create()
     desc.pRootSignature = ((D3D12Device*)m_pDevice)->GetRootSignature();
     desc.CS = ((D3D12Shader*)m_desc.cs)->GetByteCode();
 
-    ID3D12PipelineState* pipelineState = nullptr;
-    ID3D12Device* pDevice = (ID3D12Device*)m_pDevice->GetHandle();
-    if (FAILED(pDevice->CreateComputePipelineState(&desc, IID_PPV_ARGS(&pipelineState))))
+    uint64_t hash = pipeline_hash(m_desc.cs, nullptr, nullptr, nullptr, 0);
+
+    ID3D12PipelineState* pipelineState = ((D3D12Device*)m_pDevice)->GetPipelineLibrary()->CreateComputePipeline(desc, hash);
+    if (pipelineState == nullptr)
     {
         RE_ERROR("[D3D12ComputePipelineState] failed to create {}", m_name);
         return false;
@@ -111,6 +130,7 @@ bool D3D12ComputePipelineState::Create()
     }
 
     m_pPipelineState = pipelineState;
+    m_bReady = true;
     return true;
 }
 
@@ -164,10 +184,11 @@ bool D3D12MeshShadingPipelineState::Create()
     streamDesc.pPipelineStateSubobjectStream = &psoStream;
     streamDesc.SizeInBytes = sizeof(psoStream);
 
-    ID3D12PipelineState* pipelineState = nullptr;
-    ID3D12Device2* pDevice = (ID3D12Device2*)m_pDevice->GetHandle();
-    HRESULT hr = pDevice->CreatePipelineState(&streamDesc, IID_PPV_ARGS(&pipelineState));
-    if (FAILED(hr))
+    const size_t stateOffset = offsetof(GfxMeshShadingPipelineDesc, rasterizer_state);
+    uint64_t hash = pipeline_hash(m_desc.as, m_desc.ms, m_desc.ps, (const char*)&m_desc + stateOffset, sizeof(m_desc) - stateOffset);
+
+    ID3D12PipelineState* pipelineState = ((D3D12Device*)m_pDevice)->GetPipelineLibrary()->CreatePipeline(streamDesc, hash);
+    if (pipelineState == nullptr)
     {
         RE_ERROR("[D3D12MeshShadingPipelineState] failed to create {}", m_name);
         return false;
@@ -181,5 +202,6 @@ bool D3D12MeshShadingPipelineState::Create()
     }
 
     m_pPipelineState = pipelineState;
+    m_bReady = true;
     return true;
 }
@@ -0,0 +1,35 @@
+#include "d3d12_query_heap.h"
+#include "d3d12_device.h"
+#include "utils/log.h"
+
+D3D12QueryHeap::D3D12QueryHeap(D3D12Device* pDevice, const GfxQueryHeapDesc& desc, const eastl::string& name)
+{
+    m_pDevice = pDevice;
+    m_desc = desc;
+    m_name = name;
+}
+
+D3D12QueryHeap::~D3D12QueryHeap()
+{
+    D3D12Device* pDevice = (D3D12Device*)m_pDevice;
+    pDevice->Delete(m_pHeap);
+}
+
+bool D3D12QueryHeap::Create()
+{
+    D3D12_QUERY_HEAP_DESC heapDesc = {};
+    heapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+    heapDesc.Count = m_desc.count;
+
+    ID3D12Device* pDevice = (ID3D12Device*)m_pDevice->GetHandle();
+    HRESULT hr = pDevice->CreateQueryHeap(&heapDesc, IID_PPV_ARGS(&m_pHeap));
+    if (FAILED(hr))
+    {
+        RE_ERROR("[D3D12QueryHeap] failed to create {}", m_name);
+        return false;
+    }
+
+    m_pHeap->SetName(string_to_wstring(m_name).c_str());
+
+    return true;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "d3d12_header.h"
+#include "../gfx_query_heap.h"
+
+class D3D12Device;
+
+class D3D12QueryHeap : public IGfxQueryHeap
+{
+public:
+    D3D12QueryHeap(D3D12Device* pDevice, const GfxQueryHeapDesc& desc, const eastl::string& name);
+    ~D3D12QueryHeap();
+
+    virtual void* GetHandle() const override { return m_pHeap; }
+
+    bool Create();
+
+private:
+    ID3D12QueryHeap* m_pHeap = nullptr;
+};
\ No newline at end of file
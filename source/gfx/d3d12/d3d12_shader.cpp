@@ -16,5 +16,6 @@ bool D3D12Shader::Create(eastl::span<uint8_t> data)
 
     m_hash = XXH3_64bits(data.data(), data.size());
 
+    m_bReady = true;
     return true;
 }
@@ -11,6 +11,7 @@
 #include "gfx_swapchain.h"
 #include "gfx_descriptor.h"
 #include "gfx_heap.h"
+#include "gfx_query_heap.h"
 #include "gfx_rt_blas.h"
 #include "gfx_rt_tlas.h"
 
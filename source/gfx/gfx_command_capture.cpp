@@ -0,0 +1,583 @@
+#include "gfx_command_capture.h"
+#include "utils/log.h"
+#include "xxHash/xxhash.h"
+#include <filesystem>
+#include <fstream>
+
+GfxCommandCapture::GfxCommandCapture(GfxRenderBackend backend, const PipelineDescriber& describer)
+{
+    m_backend = backend;
+    m_pipelineDescriber = describer;
+}
+
+void GfxCommandCapture::BeginFrame()
+{
+    std::scoped_lock lock(m_mutex);
+
+    m_resourceIDs.clear();
+    m_resourceTable.clear();
+    m_nResourceCount = 0;
+    m_stream.clear();
+    m_nCommandCount = 0;
+
+    m_bCapturing = true;
+}
+
+bool GfxCommandCapture::EndFrame(const eastl::string& file)
+{
+    std::scoped_lock lock(m_mutex);
+
+    m_bCapturing = false;
+
+    GfxCaptureHeader header;
+    header.magic = GFX_CAPTURE_MAGIC;
+    header.version = GFX_CAPTURE_VERSION;
+    header.layoutHash = GetLayoutHash();
+    header.backend = m_backend;
+    header.resourceCount = m_nResourceCount;
+    header.resourceTableSize = (uint32_t)m_resourceTable.size();
+    header.commandCount = m_nCommandCount;
+    header.streamSize = (uint32_t)m_stream.size();
+
+    std::filesystem::path directory = std::filesystem::path(file.c_str()).parent_path();
+    if (!directory.empty())
+    {
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+    }
+
+    std::ofstream stream(file.c_str(), std::ios::binary);
+    stream.write((const char*)&header, sizeof(header));
+    stream.write((const char*)m_resourceTable.data(), m_resourceTable.size());
+    stream.write((const char*)m_stream.data(), m_stream.size());
+
+    if (stream.fail())
+    {
+        RE_ERROR("[GfxCommandCapture] failed to write {}", file);
+        return false;
+    }
+
+    RE_INFO("[GfxCommandCapture] saved {} commands, {} resources to {} ({:.2f} MB)", m_nCommandCount, m_nResourceCount, file,
+        (sizeof(header) + m_resourceTable.size() + m_stream.size()) / (1024.0 * 1024.0));
+    return true;
+}
+
+void GfxCommandCapture::WriteCommand(GfxCaptureCommand command, IGfxCommandList* command_list)
+{
+    uint32_t id = GetResourceID(command_list, GfxCaptureResourceType::CommandList);
+
+    Write(command);
+    Write(id);
+    ++m_nCommandCount;
+}
+
+void GfxCommandCapture::WriteData(const void* data, uint32_t size)
+{
+    Write(size);
+    m_stream.insert(m_stream.end(), (const uint8_t*)data, (const uint8_t*)data + size);
+}
+
+void GfxCommandCapture::WriteString(const eastl::string& str)
+{
+    WriteData(str.data(), (uint32_t)str.length());
+}
+
+uint32_t GfxCommandCapture::GetResourceID(IGfxResource* resource, GfxCaptureResourceType type, uint32_t owner)
+{
+    if (resource == nullptr)
+    {
+        return UINT32_MAX;
+    }
+
+    auto iter = m_resourceIDs.find(resource);
+    if (iter != m_resourceIDs.end())
+    {
+        return iter->second;
+    }
+
+    uint32_t id = m_nResourceCount++;
+    m_resourceIDs.insert(eastl::make_pair(resource, id));
+
+    WriteTable(&type, sizeof(type));
+    WriteTableString(resource->GetName());
+
+    switch (type)
+    {
+    case GfxCaptureResourceType::CommandList:
+    {
+        GfxCommandQueue queue = ((IGfxCommandList*)resource)->GetQueue();
+        WriteTable(&queue, sizeof(queue));
+        break;
+    }
+    case GfxCaptureResourceType::Buffer:
+    {
+        GfxBufferDesc desc = ((IGfxBuffer*)resource)->GetDesc();
+        desc.heap = nullptr; //placed resources are recreated as standalone ones
+        desc.heap_offset = 0;
+        WriteTable(&desc, sizeof(desc));
+        break;
+    }
+    case GfxCaptureResourceType::Texture:
+    {
+        GfxTextureDesc desc = ((IGfxTexture*)resource)->GetDesc();
+        desc.heap = nullptr;
+        desc.heap_offset = 0;
+        WriteTable(&desc, sizeof(desc));
+        break;
+    }
+    case GfxCaptureResourceType::UnorderedAccessView:
+        RE_ASSERT(owner != UINT32_MAX);
+        WriteTable(&owner, sizeof(owner));
+        break;
+    case GfxCaptureResourceType::Heap:
+        WriteTable(&((IGfxHeap*)resource)->GetDesc(), sizeof(GfxHeapDesc));
+        break;
+    case GfxCaptureResourceType::PipelineState:
+        WritePipelineState((IGfxPipelineState*)resource);
+        break;
+    default:
+        break;
+    }
+
+    return id;
+}
+
+uint64_t GfxCommandCapture::GetLayoutHash()
+{
+    //raw structs are stored in the capture, it can only be replayed by a build with the same layouts
+    uint32_t layout[] =
+    {
+        GFX_CAPTURE_VERSION,
+        (uint32_t)GfxCaptureCommand::Count,
+        sizeof(GfxBufferDesc),
+        sizeof(GfxTextureDesc),
+        sizeof(GfxHeapDesc),
+        sizeof(GfxRenderPassDesc),
+        sizeof(GfxTileMapping),
+        sizeof(GfxGraphicsPipelineDesc),
+        sizeof(GfxMeshShadingPipelineDesc),
+    };
+
+    return XXH3_64bits(layout, sizeof(layout));
+}
+
+void GfxCommandCapture::WriteTable(const void* data, size_t size)
+{
+    m_resourceTable.insert(m_resourceTable.end(), (const uint8_t*)data, (const uint8_t*)data + size);
+}
+
+void GfxCommandCapture::WriteTableString(const eastl::string& str)
+{
+    uint32_t length = (uint32_t)str.length();
+    WriteTable(&length, sizeof(length));
+    WriteTable(str.data(), length);
+}
+
+void GfxCommandCapture::WritePipelineState(const IGfxPipelineState* state)
+{
+    GfxCapturedPipeline pipeline;
+    bool described = m_pipelineDescriber && m_pipelineDescriber(state, pipeline);
+    if (!described)
+    {
+        pipeline = GfxCapturedPipeline();
+        pipeline.type = state->GetType();
+        RE_WARN("[GfxCommandCapture] no desc for PSO {}, it can only be replayed on the mock device", state->GetName());
+    }
+
+    WriteTable(&pipeline.type, sizeof(pipeline.type));
+    WriteTable(&pipeline.shaderMask, sizeof(pipeline.shaderMask));
+
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        if (pipeline.shaderMask & (1 << i))
+        {
+            const GfxShaderDesc& desc = pipeline.shaders[i];
+            WriteTable(&desc.type, sizeof(desc.type));
+            WriteTableString(desc.file);
+            WriteTableString(desc.entry_point);
+            WriteTable(&desc.flags, sizeof(desc.flags));
+
+            uint32_t defineCount = (uint32_t)desc.defines.size();
+            WriteTable(&defineCount, sizeof(defineCount));
+            for (uint32_t j = 0; j < defineCount; ++j)
+            {
+                WriteTableString(desc.defines[j]);
+            }
+        }
+    }
+
+    uint32_t stateSize = (uint32_t)pipeline.states.size();
+    WriteTable(&stateSize, sizeof(stateSize));
+    WriteTable(pipeline.states.data(), stateSize);
+}
+
+GfxCaptureCommandList::GfxCaptureCommandList(IGfxCommandList* command_list, GfxCommandCapture* capture) :
+    m_pCommandList(command_list),
+    m_pCapture(capture)
+{
+    m_pDevice = command_list->GetDevice();
+    m_name = command_list->GetName();
+    m_queueType = command_list->GetQueue();
+}
+
+void GfxCaptureCommandList::ResetAllocator()
+{
+    Record(GfxCaptureCommand::ResetAllocator);
+    m_pCommandList->ResetAllocator();
+}
+
+void GfxCaptureCommandList::Begin()
+{
+    Record(GfxCaptureCommand::Begin);
+    m_pCommandList->Begin();
+}
+
+void GfxCaptureCommandList::End()
+{
+    Record(GfxCaptureCommand::End);
+    m_pCommandList->End();
+}
+
+void GfxCaptureCommandList::Wait(IGfxFence* fence, uint64_t value)
+{
+    Record(GfxCaptureCommand::Wait, fence, value);
+    m_pCommandList->Wait(fence, value);
+}
+
+void GfxCaptureCommandList::Signal(IGfxFence* fence, uint64_t value)
+{
+    Record(GfxCaptureCommand::Signal, fence, value);
+    m_pCommandList->Signal(fence, value);
+}
+
+void GfxCaptureCommandList::Present(IGfxSwapchain* swapchain)
+{
+    Record(GfxCaptureCommand::Present, swapchain);
+    m_pCommandList->Present(swapchain);
+}
+
+void GfxCaptureCommandList::Submit()
+{
+    Record(GfxCaptureCommand::Submit);
+    m_pCommandList->Submit();
+}
+
+void GfxCaptureCommandList::ResetState()
+{
+    Record(GfxCaptureCommand::ResetState);
+    m_pCommandList->ResetState();
+}
+
+void GfxCaptureCommandList::BeginEvent(const eastl::string& event_name, const eastl::string& file, const eastl::string& function, uint32_t line)
+{
+    if (m_pCapture->IsCapturing())
+    {
+        std::scoped_lock lock(m_pCapture->GetMutex());
+        m_pCapture->WriteCommand(GfxCaptureCommand::BeginEvent, m_pCommandList.get());
+        m_pCapture->WriteString(event_name);
+    }
+
+    m_pCommandList->BeginEvent(event_name, file, function, line);
+}
+
+void GfxCaptureCommandList::EndEvent()
+{
+    Record(GfxCaptureCommand::EndEvent);
+    m_pCommandList->EndEvent();
+}
+
+void GfxCaptureCommandList::CopyBufferToTexture(IGfxTexture* dst_texture, uint32_t mip_level, uint32_t array_slice, IGfxBuffer* src_buffer, uint32_t offset)
+{
+    Record(GfxCaptureCommand::CopyBufferToTexture, dst_texture, mip_level, array_slice, src_buffer, offset);
+    m_pCommandList->CopyBufferToTexture(dst_texture, mip_level, array_slice, src_buffer, offset);
+}
+
+void GfxCaptureCommandList::CopyTextureToBuffer(IGfxBuffer* dst_buffer, uint32_t offset, IGfxTexture* src_texture, uint32_t mip_level, uint32_t array_slice)
+{
+    Record(GfxCaptureCommand::CopyTextureToBuffer, dst_buffer, offset, src_texture, mip_level, array_slice);
+    m_pCommandList->CopyTextureToBuffer(dst_buffer, offset, src_texture, mip_level, array_slice);
+}
+
+void GfxCaptureCommandList::CopyBuffer(IGfxBuffer* dst, uint32_t dst_offset, IGfxBuffer* src, uint32_t src_offset, uint32_t size)
+{
+    Record(GfxCaptureCommand::CopyBuffer, dst, dst_offset, src, src_offset, size);
+    m_pCommandList->CopyBuffer(dst, dst_offset, src, src_offset, size);
+}
+
+void GfxCaptureCommandList::CopyTexture(IGfxTexture* dst, uint32_t dst_mip, uint32_t dst_array, IGfxTexture* src, uint32_t src_mip, uint32_t src_array)
+{
+    Record(GfxCaptureCommand::CopyTexture, dst, dst_mip, dst_array, src, src_mip, src_array);
+    m_pCommandList->CopyTexture(dst, dst_mip, dst_array, src, src_mip, src_array);
+}
+
+static void WriteClearUAV(GfxCommandCapture* capture, GfxCaptureCommand command, IGfxCommandList* command_list, IGfxResource* resource, IGfxDescriptor* uav, const void* clear_value)
+{
+    std::scoped_lock lock(capture->GetMutex());
+    capture->WriteCommand(command, command_list);
+
+    GfxCaptureResourceType type = resource->IsTexture() ? GfxCaptureResourceType::Texture : GfxCaptureResourceType::Buffer;
+    uint32_t owner = capture->GetResourceID(resource, type);
+    capture->Write(owner);
+    capture->Write(capture->GetResourceID(uav, GfxCaptureResourceType::UnorderedAccessView, owner));
+    capture->WriteData(clear_value, sizeof(float) * 4);
+}
+
+void GfxCaptureCommandList::ClearUAV(IGfxResource* resource, IGfxDescriptor* uav, const float* clear_value)
+{
+    if (m_pCapture->IsCapturing())
+    {
+        WriteClearUAV(m_pCapture, GfxCaptureCommand::ClearUAVFloat, m_pCommandList.get(), resource, uav, clear_value);
+    }
+
+    m_pCommandList->ClearUAV(resource, uav, clear_value);
+}
+
+void GfxCaptureCommandList::ClearUAV(IGfxResource* resource, IGfxDescriptor* uav, const uint32_t* clear_value)
+{
+    if (m_pCapture->IsCapturing())
+    {
+        WriteClearUAV(m_pCapture, GfxCaptureCommand::ClearUAVUint, m_pCommandList.get(), resource, uav, clear_value);
+    }
+
+    m_pCommandList->ClearUAV(resource, uav, clear_value);
+}
+
+void GfxCaptureCommandList::WriteBuffer(IGfxBuffer* buffer, uint32_t offset, uint32_t data)
+{
+    Record(GfxCaptureCommand::WriteBuffer, buffer, offset, data);
+    m_pCommandList->WriteBuffer(buffer, offset, data);
+}
+
+void GfxCaptureCommandList::UpdateTileMappings(IGfxTexture* texture, IGfxHeap* heap, uint32_t mapping_count, const GfxTileMapping* mappings)
+{
+    if (m_pCapture->IsCapturing())
+    {
+        std::scoped_lock lock(m_pCapture->GetMutex());
+        m_pCapture->WriteCommand(GfxCaptureCommand::UpdateTileMappings, m_pCommandList.get());
+        WriteArg(texture);
+        WriteArg(heap);
+        m_pCapture->WriteData(mappings, sizeof(GfxTileMapping) * mapping_count);
+    }
+
+    m_pCommandList->UpdateTileMappings(texture, heap, mapping_count, mappings);
+}
+
+//queries only measure the captured frame, they are not part of the stream
+void GfxCaptureCommandList::ResetQueries(IGfxQueryHeap* heap, uint32_t first, uint32_t count)
+{
+    m_pCommandList->ResetQueries(heap, first, count);
+}
+
+void GfxCaptureCommandList::WriteTimestamp(IGfxQueryHeap* heap, uint32_t index)
+{
+    m_pCommandList->WriteTimestamp(heap, index);
+}
+
+void GfxCaptureCommandList::ResolveQueries(IGfxQueryHeap* heap, uint32_t first, uint32_t count, IGfxBuffer* dst_buffer, uint32_t offset)
+{
+    m_pCommandList->ResolveQueries(heap, first, count, dst_buffer, offset);
+}
+
+void GfxCaptureCommandList::TextureBarrier(IGfxTexture* texture, uint32_t sub_resource, GfxAccessFlags access_before, GfxAccessFlags access_after)
+{
+    Record(GfxCaptureCommand::TextureBarrier, texture, sub_resource, access_before, access_after);
+    m_pCommandList->TextureBarrier(texture, sub_resource, access_before, access_after);
+}
+
+void GfxCaptureCommandList::BufferBarrier(IGfxBuffer* buffer, GfxAccessFlags access_before, GfxAccessFlags access_after)
+{
+    Record(GfxCaptureCommand::BufferBarrier, buffer, access_before, access_after);
+    m_pCommandList->BufferBarrier(buffer, access_before, access_after);
+}
+
+void GfxCaptureCommandList::GlobalBarrier(GfxAccessFlags access_before, GfxAccessFlags access_after)
+{
+    Record(GfxCaptureCommand::GlobalBarrier, access_before, access_after);
+    m_pCommandList->GlobalBarrier(access_before, access_after);
+}
+
+void GfxCaptureCommandList::FlushBarriers()
+{
+    Record(GfxCaptureCommand::FlushBarriers);
+    m_pCommandList->FlushBarriers();
+}
+
+void GfxCaptureCommandList::BeginRenderPass(const GfxRenderPassDesc& render_pass)
+{
+    if (m_pCapture->IsCapturing())
+    {
+        std::scoped_lock lock(m_pCapture->GetMutex());
+        m_pCapture->WriteCommand(GfxCaptureCommand::BeginRenderPass, m_pCommandList.get());
+
+        //the texture pointers are replaced by resource ids
+        GfxRenderPassDesc desc = render_pass;
+        for (uint32_t i = 0; i < 8; ++i)
+        {
+            desc.color[i].texture = (IGfxTexture*)(uintptr_t)m_pCapture->GetResourceID(render_pass.color[i].texture, GfxCaptureResourceType::Texture);
+        }
+        desc.depth.texture = (IGfxTexture*)(uintptr_t)m_pCapture->GetResourceID(render_pass.depth.texture, GfxCaptureResourceType::Texture);
+
+        m_pCapture->Write(desc);
+    }
+
+    m_pCommandList->BeginRenderPass(render_pass);
+}
+
+void GfxCaptureCommandList::EndRenderPass()
+{
+    Record(GfxCaptureCommand::EndRenderPass);
+    m_pCommandList->EndRenderPass();
+}
+
+void GfxCaptureCommandList::SetPipelineState(IGfxPipelineState* state)
+{
+    Record(GfxCaptureCommand::SetPipelineState, state);
+    m_pCommandList->SetPipelineState(state);
+}
+
+void GfxCaptureCommandList::SetStencilReference(uint8_t stencil)
+{
+    Record(GfxCaptureCommand::SetStencilReference, stencil);
+    m_pCommandList->SetStencilReference(stencil);
+}
+
+void GfxCaptureCommandList::SetBlendFactor(const float* blend_factor)
+{
+    Record(GfxCaptureCommand::SetBlendFactor, blend_factor[0], blend_factor[1], blend_factor[2], blend_factor[3]);
+    m_pCommandList->SetBlendFactor(blend_factor);
+}
+
+void GfxCaptureCommandList::SetIndexBuffer(IGfxBuffer* buffer, uint32_t offset, GfxFormat format)
+{
+    Record(GfxCaptureCommand::SetIndexBuffer, buffer, offset, format);
+    m_pCommandList->SetIndexBuffer(buffer, offset, format);
+}
+
+void GfxCaptureCommandList::SetViewport(uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+{
+    Record(GfxCaptureCommand::SetViewport, x, y, width, height);
+    m_pCommandList->SetViewport(x, y, width, height);
+}
+
+void GfxCaptureCommandList::SetScissorRect(uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+{
+    Record(GfxCaptureCommand::SetScissorRect, x, y, width, height);
+    m_pCommandList->SetScissorRect(x, y, width, height);
+}
+
+void GfxCaptureCommandList::SetGraphicsConstants(uint32_t slot, const void* data, size_t data_size)
+{
+    if (m_pCapture->IsCapturing())
+    {
+        std::scoped_lock lock(m_pCapture->GetMutex());
+        m_pCapture->WriteCommand(GfxCaptureCommand::SetGraphicsConstants, m_pCommandList.get());
+        m_pCapture->Write(slot);
+        m_pCapture->WriteData(data, (uint32_t)data_size);
+    }
+
+    m_pCommandList->SetGraphicsConstants(slot, data, data_size);
+}
+
+void GfxCaptureCommandList::SetComputeConstants(uint32_t slot, const void* data, size_t data_size)
+{
+    if (m_pCapture->IsCapturing())
+    {
+        std::scoped_lock lock(m_pCapture->GetMutex());
+        m_pCapture->WriteCommand(GfxCaptureCommand::SetComputeConstants, m_pCommandList.get());
+        m_pCapture->Write(slot);
+        m_pCapture->WriteData(data, (uint32_t)data_size);
+    }
+
+    m_pCommandList->SetComputeConstants(slot, data, data_size);
+}
+
+void GfxCaptureCommandList::Draw(uint32_t vertex_count, uint32_t instance_count)
+{
+    Record(GfxCaptureCommand::Draw, vertex_count, instance_count);
+    m_pCommandList->Draw(vertex_count, instance_count);
+}
+
+void GfxCaptureCommandList::DrawIndexed(uint32_t index_count, uint32_t instance_count, uint32_t index_offset)
+{
+    Record(GfxCaptureCommand::DrawIndexed, index_count, instance_count, index_offset);
+    m_pCommandList->DrawIndexed(index_count, instance_count, index_offset);
+}
+
+void GfxCaptureCommandList::Dispatch(uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z)
+{
+    Record(GfxCaptureCommand::Dispatch, group_count_x, group_count_y, group_count_z);
+    m_pCommandList->Dispatch(group_count_x, group_count_y, group_count_z);
+}
+
+void GfxCaptureCommandList::DispatchMesh(uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z)
+{
+    Record(GfxCaptureCommand::DispatchMesh, group_count_x, group_count_y, group_count_z);
+    m_pCommandList->DispatchMesh(group_count_x, group_count_y, group_count_z);
+}
+
+void GfxCaptureCommandList::DrawIndirect(IGfxBuffer* buffer, uint32_t offset)
+{
+    Record(GfxCaptureCommand::DrawIndirect, buffer, offset);
+    m_pCommandList->DrawIndirect(buffer, offset);
+}
+
+void GfxCaptureCommandList::DrawIndexedIndirect(IGfxBuffer* buffer, uint32_t offset)
+{
+    Record(GfxCaptureCommand::DrawIndexedIndirect, buffer, offset);
+    m_pCommandList->DrawIndexedIndirect(buffer, offset);
+}
+
+void GfxCaptureCommandList::DispatchIndirect(IGfxBuffer* buffer, uint32_t offset)
+{
+    Record(GfxCaptureCommand::DispatchIndirect, buffer, offset);
+    m_pCommandList->DispatchIndirect(buffer, offset);
+}
+
+void GfxCaptureCommandList::DispatchMeshIndirect(IGfxBuffer* buffer, uint32_t offset)
+{
+    Record(GfxCaptureCommand::DispatchMeshIndirect, buffer, offset);
+    m_pCommandList->DispatchMeshIndirect(buffer, offset);
+}
+
+void GfxCaptureCommandList::MultiDrawIndirect(uint32_t max_count, IGfxBuffer* args_buffer, uint32_t args_buffer_offset, IGfxBuffer* count_buffer, uint32_t count_buffer_offset)
+{
+    Record(GfxCaptureCommand::MultiDrawIndirect, max_count, args_buffer, args_buffer_offset, count_buffer, count_buffer_offset);
+    m_pCommandList->MultiDrawIndirect(max_count, args_buffer, args_buffer_offset, count_buffer, count_buffer_offset);
+}
+
+void GfxCaptureCommandList::MultiDrawIndexedIndirect(uint32_t max_count, IGfxBuffer* args_buffer, uint32_t args_buffer_offset, IGfxBuffer* count_buffer, uint32_t count_buffer_offset)
+{
+    Record(GfxCaptureCommand::MultiDrawIndexedIndirect, max_count, args_buffer, args_buffer_offset, count_buffer, count_buffer_offset);
+    m_pCommandList->MultiDrawIndexedIndirect(max_count, args_buffer, args_buffer_offset, count_buffer, count_buffer_offset);
+}
+
+void GfxCaptureCommandList::MultiDispatchIndirect(uint32_t max_count, IGfxBuffer* args_buffer, uint32_t args_buffer_offset, IGfxBuffer* count_buffer, uint32_t count_buffer_offset)
+{
+    Record(GfxCaptureCommand::MultiDispatchIndirect, max_count, args_buffer, args_buffer_offset, count_buffer, count_buffer_offset);
+    m_pCommandList->MultiDispatchIndirect(max_count, args_buffer, args_buffer_offset, count_buffer, count_buffer_offset);
+}
+
+void GfxCaptureCommandList::MultiDispatchMeshIndirect(uint32_t max_count, IGfxBuffer* args_buffer, uint32_t args_buffer_offset, IGfxBuffer* count_buffer, uint32_t count_buffer_offset)
+{
+    Record(GfxCaptureCommand::MultiDispatchMeshIndirect, max_count, args_buffer, args_buffer_offset, count_buffer, count_buffer_offset);
+    m_pCommandList->MultiDispatchMeshIndirect(max_count, args_buffer, args_buffer_offset, count_buffer, count_buffer_offset);
+}
+
+void GfxCaptureCommandList::BuildRayTracingBLAS(IGfxRayTracingBLAS* blas)
+{
+    Record(GfxCaptureCommand::BuildRayTracingBLAS, blas);
+    m_pCommandList->BuildRayTracingBLAS(blas);
+}
+
+void GfxCaptureCommandList::UpdateRayTracingBLAS(IGfxRayTracingBLAS* blas, IGfxBuffer* vertex_buffer, uint32_t vertex_buffer_offset)
+{
+    Record(GfxCaptureCommand::UpdateRayTracingBLAS, blas, vertex_buffer, vertex_buffer_offset);
+    m_pCommandList->UpdateRayTracingBLAS(blas, vertex_buffer, vertex_buffer_offset);
+}
+
+void GfxCaptureCommandList::BuildRayTracingTLAS(IGfxRayTracingTLAS* tlas, const GfxRayTracingInstance* instances, uint32_t instance_count)
+{
+    //the instances reference BLASes by pointer, only the count is kept. ray tracing commands are not replayed
+    Record(GfxCaptureCommand::BuildRayTracingTLAS, tlas, instance_count);
+    m_pCommandList->BuildRayTracingTLAS(tlas, instances, instance_count);
+}
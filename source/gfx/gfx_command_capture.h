@@ -0,0 +1,261 @@
+#pragma once
+
+#include "gfx.h"
+#include "EASTL/hash_map.h"
+#include "EASTL/functional.h"
+#include "EASTL/unique_ptr.h"
+#include "EASTL/atomic.h"
+#include <mutex>
+
+#define GFX_CAPTURE_MAGIC 0x50434552 //"RECP"
+#define GFX_CAPTURE_VERSION 1
+
+enum class GfxCaptureCommand : uint8_t
+{
+    ResetAllocator,
+    Begin,
+    End,
+    Wait,
+    Signal,
+    Present,
+    Submit,
+    ResetState,
+    BeginEvent,
+    EndEvent,
+    CopyBufferToTexture,
+    CopyTextureToBuffer,
+    CopyBuffer,
+    CopyTexture,
+    ClearUAVFloat,
+    ClearUAVUint,
+    WriteBuffer,
+    UpdateTileMappings,
+    TextureBarrier,
+    BufferBarrier,
+    GlobalBarrier,
+    FlushBarriers,
+    BeginRenderPass,
+    EndRenderPass,
+    SetPipelineState,
+    SetStencilReference,
+    SetBlendFactor,
+    SetIndexBuffer,
+    SetViewport,
+    SetScissorRect,
+    SetGraphicsConstants,
+    SetComputeConstants,
+    Draw,
+    DrawIndexed,
+    Dispatch,
+    DispatchMesh,
+    DrawIndirect,
+    DrawIndexedIndirect,
+    DispatchIndirect,
+    DispatchMeshIndirect,
+    MultiDrawIndirect,
+    MultiDrawIndexedIndirect,
+    MultiDispatchIndirect,
+    MultiDispatchMeshIndirect,
+    BuildRayTracingBLAS,
+    UpdateRayTracingBLAS,
+    BuildRayTracingTLAS,
+
+    Count,
+};
+
+enum class GfxCaptureResourceType : uint8_t
+{
+    CommandList,
+    Buffer,
+    Texture,
+    UnorderedAccessView,
+    Fence,
+    Swapchain,
+    Heap,
+    PipelineState,
+    RayTracingBLAS,
+    RayTracingTLAS,
+};
+
+//what is needed to recreate a PSO on another device : the shader descs and the fixed function states
+struct GfxCapturedPipeline
+{
+    GfxPipelineType type = GfxPipelineType::Graphics;
+    uint32_t shaderMask = 0; //graphics : vs, ps. mesh shading : as, ms, ps. compute : cs
+    GfxShaderDesc shaders[3];
+    eastl::vector<uint8_t> states; //the pipeline desc from rasterizer_state to the end
+};
+
+struct GfxCaptureHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t layoutHash;
+    GfxRenderBackend backend;
+    uint32_t resourceCount;
+    uint32_t resourceTableSize;
+    uint32_t commandCount;
+    uint32_t streamSize;
+};
+
+// records every command of the wrapped command lists for one frame, see GfxCommandReplay for playing it back.
+// resources are referenced by id in the command stream, their descs are saved in a table in front of it
+class GfxCommandCapture
+{
+public:
+    //the gfx layer doesn't keep pipeline descs around, the renderer's PSO cache provides them
+    using PipelineDescriber = eastl::function<bool(const IGfxPipelineState*, GfxCapturedPipeline&)>;
+
+    GfxCommandCapture(GfxRenderBackend backend, const PipelineDescriber& describer);
+
+    void BeginFrame();
+    bool EndFrame(const eastl::string& file);
+    bool IsCapturing() const { return m_bCapturing; }
+
+    //the lock has to be held while recording a command
+    std::mutex& GetMutex() { return m_mutex; }
+
+    void WriteCommand(GfxCaptureCommand command, IGfxCommandList* command_list);
+    void WriteData(const void* data, uint32_t size);
+    void WriteString(const eastl::string& str);
+
+    //the desc of a resource is added to the resource table when it is first seen, nullptr is UINT32_MAX
+    uint32_t GetResourceID(IGfxResource* resource, GfxCaptureResourceType type, uint32_t owner = UINT32_MAX);
+    void WriteResource(IGfxResource* resource, GfxCaptureResourceType type) { Write(GetResourceID(resource, type)); }
+
+    template<typename T>
+    void Write(const T& value)
+    {
+        static_assert(eastl::is_trivially_copyable_v<T>);
+        m_stream.insert(m_stream.end(), (const uint8_t*)&value, (const uint8_t*)&value + sizeof(T));
+    }
+
+    static uint64_t GetLayoutHash();
+
+private:
+    void WriteTable(const void* data, size_t size);
+    void WriteTableString(const eastl::string& str);
+    void WritePipelineState(const IGfxPipelineState* state);
+
+private:
+    GfxRenderBackend m_backend;
+    PipelineDescriber m_pipelineDescriber;
+
+    std::mutex m_mutex;
+    eastl::atomic<bool> m_bCapturing{ false };
+
+    eastl::hash_map<IGfxResource*, uint32_t> m_resourceIDs;
+    eastl::vector<uint8_t> m_resourceTable;
+    uint32_t m_nResourceCount = 0;
+
+    eastl::vector<uint8_t> m_stream;
+    uint32_t m_nCommandCount = 0;
+};
+
+// forwards every call to the wrapped command list, and records it while a capture is in progress
+class GfxCaptureCommandList : public IGfxCommandList
+{
+public:
+    GfxCaptureCommandList(IGfxCommandList* command_list, GfxCommandCapture* capture);
+
+    IGfxCommandList* GetCommandList() const { return m_pCommandList.get(); }
+
+    virtual void* GetHandle() const override { return m_pCommandList->GetHandle(); }
+    virtual const GfxStateCache::Stats& GetStateCacheStats() const override { return m_pCommandList->GetStateCacheStats(); }
+
+    virtual void ResetAllocator() override;
+    virtual void Begin() override;
+    virtual void End() override;
+    virtual void Wait(IGfxFence* fence, uint64_t value) override;
+    virtual void Signal(IGfxFence* fence, uint64_t value) override;
+    virtual void Present(IGfxSwapchain* swapchain) override;
+    virtual void Submit() override;
+    virtual void ResetState() override;
+
+    virtual void BeginEvent(const eastl::string& event_name, const eastl::string& file = "", const eastl::string& function = "", uint32_t line = 0) override;
+    virtual void EndEvent() override;
+
+    virtual void CopyBufferToTexture(IGfxTexture* dst_texture, uint32_t mip_level, uint32_t array_slice, IGfxBuffer* src_buffer, uint32_t offset) override;
+    virtual void CopyTextureToBuffer(IGfxBuffer* dst_buffer, uint32_t offset, IGfxTexture* src_texture, uint32_t mip_level, uint32_t array_slice) override;
+    virtual void CopyBuffer(IGfxBuffer* dst, uint32_t dst_offset, IGfxBuffer* src, uint32_t src_offset, uint32_t size) override;
+    virtual void CopyTexture(IGfxTexture* dst, uint32_t dst_mip, uint32_t dst_array, IGfxTexture* src, uint32_t src_mip, uint32_t src_array) override;
+    virtual void ClearUAV(IGfxResource* resource, IGfxDescriptor* uav, const float* clear_value) override;
+    virtual void ClearUAV(IGfxResource* resource, IGfxDescriptor* uav, const uint32_t* clear_value) override;
+    virtual void WriteBuffer(IGfxBuffer* buffer, uint32_t offset, uint32_t data) override;
+    virtual void UpdateTileMappings(IGfxTexture* texture, IGfxHeap* heap, uint32_t mapping_count, const GfxTileMapping* mappings) override;
+
+    virtual void ResetQueries(IGfxQueryHeap* heap, uint32_t first, uint32_t count) override;
+    virtual void WriteTimestamp(IGfxQueryHeap* heap, uint32_t index) override;
+    virtual void ResolveQueries(IGfxQueryHeap* heap, uint32_t first, uint32_t count, IGfxBuffer* dst_buffer, uint32_t offset) override;
+
+    virtual void TextureBarrier(IGfxTexture* texture, uint32_t sub_resource, GfxAccessFlags access_before, GfxAccessFlags access_after) override;
+    virtual void BufferBarrier(IGfxBuffer* buffer, GfxAccessFlags access_before, GfxAccessFlags access_after) override;
+    virtual void GlobalBarrier(GfxAccessFlags access_before, GfxAccessFlags access_after) override;
+    virtual void FlushBarriers() override;
+
+    virtual void BeginRenderPass(const GfxRenderPassDesc& render_pass) override;
+    virtual void EndRenderPass() override;
+    virtual void SetPipelineState(IGfxPipelineState* state) override;
+    virtual void SetStencilReference(uint8_t stencil) override;
+    virtual void SetBlendFactor(const float* blend_factor) override;
+    virtual void SetIndexBuffer(IGfxBuffer* buffer, uint32_t offset, GfxFormat format) override;
+    virtual void SetViewport(uint32_t x, uint32_t y, uint32_t width, uint32_t height) override;
+    virtual void SetScissorRect(uint32_t x, uint32_t y, uint32_t width, uint32_t height) override;
+    virtual void SetGraphicsConstants(uint32_t slot, const void* data, size_t data_size) override;
+    virtual void SetComputeConstants(uint32_t slot, const void* data, size_t data_size) override;
+
+    virtual void Draw(uint32_t vertex_count, uint32_t instance_count = 1) override;
+    virtual void DrawIndexed(uint32_t index_count, uint32_t instance_count = 1, uint32_t index_offset = 0) override;
+    virtual void Dispatch(uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z) override;
+    virtual void DispatchMesh(uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z) override;
+
+    virtual void DrawIndirect(IGfxBuffer* buffer, uint32_t offset) override;
+    virtual void DrawIndexedIndirect(IGfxBuffer* buffer, uint32_t offset) override;
+    virtual void DispatchIndirect(IGfxBuffer* buffer, uint32_t offset) override;
+    virtual void DispatchMeshIndirect(IGfxBuffer* buffer, uint32_t offset) override;
+
+    virtual void MultiDrawIndirect(uint32_t max_count, IGfxBuffer* args_buffer, uint32_t args_buffer_offset, IGfxBuffer* count_buffer, uint32_t count_buffer_offset) override;
+    virtual void MultiDrawIndexedIndirect(uint32_t max_count, IGfxBuffer* args_buffer, uint32_t args_buffer_offset, IGfxBuffer* count_buffer, uint32_t count_buffer_offset) override;
+    virtual void MultiDispatchIndirect(uint32_t max_count, IGfxBuffer* args_buffer, uint32_t args_buffer_offset, IGfxBuffer* count_buffer, uint32_t count_buffer_offset) override;
+    virtual void MultiDispatchMeshIndirect(uint32_t max_count, IGfxBuffer* args_buffer, uint32_t args_buffer_offset, IGfxBuffer* count_buffer, uint32_t count_buffer_offset) override;
+
+    virtual void BuildRayTracingBLAS(IGfxRayTracingBLAS* blas) override;
+    virtual void UpdateRayTracingBLAS(IGfxRayTracingBLAS* blas, IGfxBuffer* vertex_buffer, uint32_t vertex_buffer_offset) override;
+    virtual void BuildRayTracingTLAS(IGfxRayTracingTLAS* tlas, const GfxRayTracingInstance* instances, uint32_t instance_count) override;
+
+private:
+    //resources are written as ids, everything else as raw bytes
+    template<typename T>
+    void WriteArg(const T& value) { m_pCapture->Write(value); }
+    void WriteArg(IGfxResource* resource) = delete;
+    void WriteArg(IGfxBuffer* buffer) { m_pCapture->WriteResource(buffer, GfxCaptureResourceType::Buffer); }
+    void WriteArg(IGfxTexture* texture) { m_pCapture->WriteResource(texture, GfxCaptureResourceType::Texture); }
+    void WriteArg(IGfxFence* fence) { m_pCapture->WriteResource(fence, GfxCaptureResourceType::Fence); }
+    void WriteArg(IGfxSwapchain* swapchain) { m_pCapture->WriteResource(swapchain, GfxCaptureResourceType::Swapchain); }
+    void WriteArg(IGfxHeap* heap) { m_pCapture->WriteResource(heap, GfxCaptureResourceType::Heap); }
+    void WriteArg(IGfxPipelineState* state) { m_pCapture->WriteResource(state, GfxCaptureResourceType::PipelineState); }
+    void WriteArg(IGfxRayTracingBLAS* blas) { m_pCapture->WriteResource(blas, GfxCaptureResourceType::RayTracingBLAS); }
+    void WriteArg(IGfxRayTracingTLAS* tlas) { m_pCapture->WriteResource(tlas, GfxCaptureResourceType::RayTracingTLAS); }
+
+    template<typename... Args>
+    void Record(GfxCaptureCommand command, const Args&... args)
+    {
+        if (m_pCapture->IsCapturing())
+        {
+            std::scoped_lock lock(m_pCapture->GetMutex());
+            m_pCapture->WriteCommand(command, m_pCommandList.get());
+            (WriteArg(args), ...);
+        }
+    }
+
+private:
+    eastl::unique_ptr<IGfxCommandList> m_pCommandList;
+    GfxCommandCapture* m_pCapture;
+};
+
+//backend specific code which needs the actual command list
+inline IGfxCommandList* UnwrapCommandList(IGfxCommandList* command_list)
+{
+    GfxCaptureCommandList* capture = dynamic_cast<GfxCaptureCommandList*>(command_list);
+    return capture ? capture->GetCommandList() : command_list;
+}
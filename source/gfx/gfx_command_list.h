@@ -1,11 +1,13 @@
 #pragma once
 
 #include "gfx_resource.h"
+#include "gfx_state_cache.h"
 
 class IGfxFence;
 class IGfxBuffer;
 class IGfxTexture;
 class IGfxHeap;
+class IGfxQueryHeap;
 class IGfxDescriptor;
 class IGfxPipelineState;
 class IGfxRayTracingBLAS;
@@ -18,6 +20,7 @@ public:
     virtual ~IGfxCommandList() {}
 
     GfxCommandQueue GetQueue() const { return m_queueType; }
+    virtual const GfxStateCache::Stats& GetStateCacheStats() const { return m_stateCache.GetStats(); }
 
     virtual void ResetAllocator() = 0;
     virtual void Begin() = 0;
@@ -40,6 +43,11 @@ public:
     virtual void WriteBuffer(IGfxBuffer* buffer, uint32_t offset, uint32_t data) = 0;
     virtual void UpdateTileMappings(IGfxTexture* texture, IGfxHeap* heap, uint32_t mapping_count, const GfxTileMapping* mappings) = 0;
 
+    //queries must be reset before they are written again, outside of render passes
+    virtual void ResetQueries(IGfxQueryHeap* heap, uint32_t first, uint32_t count) = 0;
+    virtual void WriteTimestamp(IGfxQueryHeap* heap, uint32_t index) = 0;
+    virtual void ResolveQueries(IGfxQueryHeap* heap, uint32_t first, uint32_t count, IGfxBuffer* dst_buffer, uint32_t offset) = 0;
+
     virtual void TextureBarrier(IGfxTexture* texture, uint32_t sub_resource, GfxAccessFlags access_before, GfxAccessFlags access_after) = 0;
     virtual void BufferBarrier(IGfxBuffer* buffer, GfxAccessFlags access_before, GfxAccessFlags access_after) = 0;
     virtual void GlobalBarrier(GfxAccessFlags access_before, GfxAccessFlags access_after) = 0;
@@ -77,4 +85,5 @@ public:
 
 protected:
     GfxCommandQueue m_queueType;
+    GfxStateCache m_stateCache;
 };
\ No newline at end of file
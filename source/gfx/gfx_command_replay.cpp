@@ -0,0 +1,957 @@
+#include "gfx_command_replay.h"
+#include "utils/log.h"
+#include "sokol/sokol_time.h"
+#include "magic_enum/magic_enum.hpp"
+#include "EASTL/sort.h"
+#include <fstream>
+
+class GfxCommandReplay::Reader
+{
+public:
+    Reader(const uint8_t* data, size_t size) : m_pData(data), m_size(size) {}
+
+    bool IsValid() const { return m_bValid; }
+    bool IsEnd() const { return m_offset >= m_size; }
+
+    template<typename T>
+    T Read()
+    {
+        T value = {};
+        if (Check(sizeof(T)))
+        {
+            memcpy(&value, m_pData + m_offset, sizeof(T));
+            m_offset += sizeof(T);
+        }
+        return value;
+    }
+
+    const uint8_t* ReadData(uint32_t& size)
+    {
+        size = Read<uint32_t>();
+        if (!Check(size))
+        {
+            size = 0;
+            return nullptr;
+        }
+
+        const uint8_t* data = m_pData + m_offset;
+        m_offset += size;
+        return data;
+    }
+
+    eastl::string ReadString()
+    {
+        uint32_t length;
+        const uint8_t* data = ReadData(length);
+        return eastl::string((const char*)data, length);
+    }
+
+private:
+    bool Check(size_t size)
+    {
+        m_bValid = m_bValid && m_offset + size <= m_size;
+        return m_bValid;
+    }
+
+private:
+    const uint8_t* m_pData;
+    size_t m_size;
+    size_t m_offset = 0;
+    bool m_bValid = true;
+};
+
+//the resource types a command argument can reference
+template<typename T>
+struct GfxReplayResourceType;
+
+template<>
+struct GfxReplayResourceType<IGfxCommandList>
+{
+    static constexpr const char* name = "CommandList";
+    static bool Match(GfxCaptureResourceType type) { return type == GfxCaptureResourceType::CommandList; }
+};
+
+template<>
+struct GfxReplayResourceType<IGfxBuffer>
+{
+    static constexpr const char* name = "Buffer";
+    static bool Match(GfxCaptureResourceType type) { return type == GfxCaptureResourceType::Buffer; }
+};
+
+template<>
+struct GfxReplayResourceType<IGfxTexture>
+{
+    static constexpr const char* name = "Texture";
+    static bool Match(GfxCaptureResourceType type) { return type == GfxCaptureResourceType::Texture; }
+};
+
+template<>
+struct GfxReplayResourceType<IGfxResource>
+{
+    static constexpr const char* name = "Buffer or Texture";
+    static bool Match(GfxCaptureResourceType type) { return type == GfxCaptureResourceType::Buffer || type == GfxCaptureResourceType::Texture; }
+};
+
+template<>
+struct GfxReplayResourceType<IGfxDescriptor>
+{
+    static constexpr const char* name = "UnorderedAccessView";
+    static bool Match(GfxCaptureResourceType type) { return type == GfxCaptureResourceType::UnorderedAccessView; }
+};
+
+template<>
+struct GfxReplayResourceType<IGfxFence>
+{
+    static constexpr const char* name = "Fence";
+    static bool Match(GfxCaptureResourceType type) { return type == GfxCaptureResourceType::Fence; }
+};
+
+template<>
+struct GfxReplayResourceType<IGfxHeap>
+{
+    static constexpr const char* name = "Heap";
+    static bool Match(GfxCaptureResourceType type) { return type == GfxCaptureResourceType::Heap; }
+};
+
+template<>
+struct GfxReplayResourceType<IGfxPipelineState>
+{
+    static constexpr const char* name = "PipelineState";
+    static bool Match(GfxCaptureResourceType type) { return type == GfxCaptureResourceType::PipelineState; }
+};
+
+GfxCommandReplay::GfxCommandReplay(IGfxDevice* device, const PipelineFactory& factory)
+{
+    m_pDevice = device;
+    m_pipelineFactory = factory;
+}
+
+GfxCommandReplay::~GfxCommandReplay()
+{
+    DestroyResources();
+}
+
+bool GfxCommandReplay::Load(const eastl::string& file)
+{
+    DestroyResources();
+
+    std::ifstream stream(file.c_str(), std::ios::binary | std::ios::ate);
+    if (stream.fail())
+    {
+        RE_ERROR("[GfxCommandReplay] failed to open {}", file);
+        return false;
+    }
+
+    eastl::vector<uint8_t> data((size_t)stream.tellg());
+    stream.seekg(0);
+    stream.read((char*)data.data(), data.size());
+
+    Reader reader(data.data(), data.size());
+    GfxCaptureHeader header = reader.Read<GfxCaptureHeader>();
+
+    if (!reader.IsValid() || header.magic != GFX_CAPTURE_MAGIC || header.version != GFX_CAPTURE_VERSION ||
+        header.layoutHash != GfxCommandCapture::GetLayoutHash() ||
+        sizeof(GfxCaptureHeader) + header.resourceTableSize + header.streamSize != data.size())
+    {
+        RE_ERROR("[GfxCommandReplay] {} is not a capture of this build", file);
+        return false;
+    }
+
+    m_captureBackend = header.backend;
+
+    Reader tableReader(data.data() + sizeof(GfxCaptureHeader), header.resourceTableSize);
+    if (!CreateResources(tableReader, header.resourceCount))
+    {
+        RE_ERROR("[GfxCommandReplay] the resource table of {} is corrupted", file);
+        DestroyResources();
+        return false;
+    }
+
+    const uint8_t* streamData = data.data() + sizeof(GfxCaptureHeader) + header.resourceTableSize;
+    m_stream.assign(streamData, streamData + header.streamSize);
+    m_nCommandCount = header.commandCount;
+
+    RE_INFO("[GfxCommandReplay] loaded {} : {} commands, {} resources, captured with {}", file, m_nCommandCount, (uint32_t)m_resources.size(),
+        magic_enum::enum_name(m_captureBackend));
+    return true;
+}
+
+template<typename T>
+T* GfxCommandReplay::GetResource(uint32_t id)
+{
+    if (id == UINT32_MAX)
+    {
+        return nullptr;
+    }
+
+    if (id >= m_resources.size() || !GfxReplayResourceType<T>::Match(m_resources[id].type))
+    {
+        if (!m_bCorrupted)
+        {
+            if (id < m_resources.size())
+            {
+                RE_ERROR("[GfxCommandReplay] resource {} ({}) is a {}, not a {}, the capture is corrupted", id, m_resources[id].name,
+                    magic_enum::enum_name(m_resources[id].type), GfxReplayResourceType<T>::name);
+            }
+            else
+            {
+                RE_ERROR("[GfxCommandReplay] resource {} is out of range, the capture is corrupted", id);
+            }
+        }
+
+        m_bCorrupted = true;
+        return nullptr;
+    }
+
+    return (T*)m_resources[id].resource;
+}
+
+bool GfxCommandReplay::CreateResources(Reader& reader, uint32_t count)
+{
+    m_resources.resize(count);
+
+    for (uint32_t i = 0; i < count && reader.IsValid() && !m_bCorrupted; ++i)
+    {
+        Resource& resource = m_resources[i];
+        resource.type = reader.Read<GfxCaptureResourceType>();
+        resource.name = reader.ReadString();
+
+        switch (resource.type)
+        {
+        case GfxCaptureResourceType::CommandList:
+        {
+            GfxCommandQueue queue = reader.Read<GfxCommandQueue>();
+            resource.resource = m_pDevice->CreateCommandList(queue, resource.name);
+
+            CommandListState& state = m_commandLists[i];
+            state.fence.reset(m_pDevice->CreateFence(resource.name + " replay fence"));
+            break;
+        }
+        case GfxCaptureResourceType::Buffer:
+            resource.resource = m_pDevice->CreateBuffer(reader.Read<GfxBufferDesc>(), resource.name);
+            break;
+        case GfxCaptureResourceType::Texture:
+            resource.resource = m_pDevice->CreateTexture(reader.Read<GfxTextureDesc>(), resource.name);
+            break;
+        case GfxCaptureResourceType::UnorderedAccessView:
+        {
+            uint32_t ownerID = reader.Read<uint32_t>();
+            if (ownerID >= i)
+            {
+                //the owner is always written to the table before its views
+                RE_ERROR("[GfxCommandReplay] the owner {} of {} isn't in the table before it", ownerID, resource.name);
+                m_bCorrupted = true;
+                break;
+            }
+
+            IGfxResource* owner = GetResource<IGfxResource>(ownerID);
+            if (owner == nullptr)
+            {
+                break;
+            }
+
+            //the view desc isn't captured, the whole resource is cleared instead
+            GfxUnorderedAccessViewDesc desc;
+            if (owner->IsTexture())
+            {
+                const GfxTextureDesc& textureDesc = ((IGfxTexture*)owner)->GetDesc();
+                desc.format = textureDesc.format;
+                desc.type = textureDesc.type == GfxTextureType::Texture3D ? GfxUnorderedAccessViewType::Texture3D :
+                    (textureDesc.type == GfxTextureType::Texture2D ? GfxUnorderedAccessViewType::Texture2D : GfxUnorderedAccessViewType::Texture2DArray);
+                desc.texture.array_size = textureDesc.array_size;
+            }
+            else
+            {
+                const GfxBufferDesc& bufferDesc = ((IGfxBuffer*)owner)->GetDesc();
+                desc.format = bufferDesc.format;
+                desc.type = (bufferDesc.usage & GfxBufferUsageStructuredBuffer) ? GfxUnorderedAccessViewType::StructuredBuffer :
+                    ((bufferDesc.usage & GfxBufferUsageTypedBuffer) ? GfxUnorderedAccessViewType::TypedBuffer : GfxUnorderedAccessViewType::RawBuffer);
+                desc.buffer.size = bufferDesc.size;
+            }
+
+            resource.resource = m_pDevice->CreateUnorderedAccessView(owner, desc, resource.name);
+            break;
+        }
+        case GfxCaptureResourceType::Fence:
+            resource.resource = m_pDevice->CreateFence(resource.name);
+            break;
+        case GfxCaptureResourceType::Heap:
+            resource.resource = m_pDevice->CreateHeap(reader.Read<GfxHeapDesc>(), resource.name);
+            break;
+        case GfxCaptureResourceType::PipelineState:
+        {
+            GfxCapturedPipeline pipeline;
+            pipeline.type = reader.Read<GfxPipelineType>();
+            pipeline.shaderMask = reader.Read<uint32_t>();
+
+            for (uint32_t j = 0; j < 3; ++j)
+            {
+                if (pipeline.shaderMask & (1 << j))
+                {
+                    GfxShaderDesc& desc = pipeline.shaders[j];
+                    desc.type = reader.Read<GfxShaderType>();
+                    desc.file = reader.ReadString();
+                    desc.entry_point = reader.ReadString();
+                    desc.flags = reader.Read<GfxShaderCompilerFlags>();
+
+                    uint32_t defineCount = reader.Read<uint32_t>();
+                    for (uint32_t k = 0; k < defineCount && reader.IsValid(); ++k)
+                    {
+                        desc.defines.push_back(reader.ReadString());
+                    }
+                }
+            }
+
+            uint32_t stateSize;
+            const uint8_t* states = reader.ReadData(stateSize);
+            pipeline.states.assign(states, states + stateSize);
+
+            if (reader.IsValid())
+            {
+                resource.owned = !m_pipelineFactory;
+                resource.resource = CreatePipelineState(pipeline, resource.name);
+            }
+            break;
+        }
+        default:
+            //swapchains and acceleration structures, the commands using them are skipped
+            break;
+        }
+
+        if (resource.resource == nullptr && !m_bCorrupted && resource.type != GfxCaptureResourceType::Swapchain &&
+            resource.type != GfxCaptureResourceType::RayTracingBLAS && resource.type != GfxCaptureResourceType::RayTracingTLAS)
+        {
+            RE_WARN("[GfxCommandReplay] failed to create {} {}, the commands using it are skipped", magic_enum::enum_name(resource.type), resource.name);
+        }
+    }
+
+    return reader.IsValid() && !m_bCorrupted;
+}
+
+IGfxPipelineState* GfxCommandReplay::CreatePipelineState(const GfxCapturedPipeline& pipeline, const eastl::string& name)
+{
+    if (m_pipelineFactory)
+    {
+        return m_pipelineFactory(pipeline, name);
+    }
+
+    IGfxShader* shaders[3] = {};
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        if (pipeline.shaderMask & (1 << i))
+        {
+            uint8_t placeholder = 0;
+            shaders[i] = m_pDevice->CreateShader(pipeline.shaders[i], eastl::span<uint8_t>(&placeholder, 1), pipeline.shaders[i].entry_point);
+            m_shaders.emplace_back(shaders[i]);
+        }
+    }
+
+    switch (pipeline.type)
+    {
+    case GfxPipelineType::Graphics:
+    {
+        GfxGraphicsPipelineDesc desc;
+        const size_t offset = offsetof(GfxGraphicsPipelineDesc, rasterizer_state);
+        if (pipeline.states.size() == sizeof(desc) - offset)
+        {
+            memcpy((uint8_t*)&desc + offset, pipeline.states.data(), pipeline.states.size());
+        }
+        desc.vs = shaders[0];
+        desc.ps = shaders[1];
+        return m_pDevice->CreateGraphicsPipelineState(desc, name);
+    }
+    case GfxPipelineType::MeshShading:
+    {
+        GfxMeshShadingPipelineDesc desc;
+        const size_t offset = offsetof(GfxMeshShadingPipelineDesc, rasterizer_state);
+        if (pipeline.states.size() == sizeof(desc) - offset)
+        {
+            memcpy((uint8_t*)&desc + offset, pipeline.states.data(), pipeline.states.size());
+        }
+        desc.as = shaders[0];
+        desc.ms = shaders[1];
+        desc.ps = shaders[2];
+        return m_pDevice->CreateMeshShadingPipelineState(desc, name);
+    }
+    case GfxPipelineType::Compute:
+    {
+        GfxComputePipelineDesc desc;
+        desc.cs = shaders[0];
+        return m_pDevice->CreateComputePipelineState(desc, name);
+    }
+    default:
+        return nullptr;
+    }
+}
+
+bool GfxCommandReplay::Replay(uint32_t iterations)
+{
+    //each iteration is a device frame, so the per-frame constant buffer allocators are reset like in the captured frame.
+    //FinishCommandLists waits for the submitted work, so the allocators aren't in use anymore when they are reset
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        m_pDevice->BeginFrame();
+        bool valid = ReplayStream();
+        FinishCommandLists();
+        m_pDevice->EndFrame();
+
+        if (!valid)
+        {
+            return false;
+        }
+
+        m_nIterations++;
+    }
+
+    return true;
+}
+
+bool GfxCommandReplay::ReplayStream()
+{
+    if (m_bCorrupted)
+    {
+        return false;
+    }
+
+    m_signaledValues.clear();
+
+    Reader reader(m_stream.data(), m_stream.size());
+
+    while (!reader.IsEnd() && reader.IsValid())
+    {
+        GfxCaptureCommand command = reader.Read<GfxCaptureCommand>();
+        uint32_t listID = reader.Read<uint32_t>();
+
+        if ((size_t)command >= (size_t)GfxCaptureCommand::Count)
+        {
+            RE_ERROR("[GfxCommandReplay] unknown command {}, the stream is corrupted", (uint32_t)command);
+            m_bCorrupted = true;
+            break;
+        }
+
+        IGfxCommandList* pCommandList = GetResource<IGfxCommandList>(listID);
+        if (listID == UINT32_MAX && !m_bCorrupted)
+        {
+            RE_ERROR("[GfxCommandReplay] {} isn't recorded on a command list, the stream is corrupted", magic_enum::enum_name(command));
+            m_bCorrupted = true;
+        }
+
+        if (m_bCorrupted)
+        {
+            break;
+        }
+
+        CommandListState& state = m_commandLists[listID];
+        CommandStats& stats = m_stats[(size_t)command];
+
+        //the arguments are always read, so a skipped command doesn't break the stream
+        auto execute = [&](bool valid, auto&& call)
+        {
+            if (!valid || pCommandList == nullptr)
+            {
+                ++stats.skipped;
+                return;
+            }
+
+            uint64_t ticks = stm_now();
+            call();
+            stats.ticks += stm_since(ticks);
+            ++stats.count;
+        };
+
+        switch (command)
+        {
+        case GfxCaptureCommand::ResetAllocator:
+            execute(true, [&]() { pCommandList->ResetAllocator(); });
+            break;
+        case GfxCaptureCommand::Begin:
+            execute(true, [&]() { pCommandList->Begin(); });
+            state.open = true;
+            state.ended = false;
+            break;
+        case GfxCaptureCommand::End:
+            execute(true, [&]() { pCommandList->End(); });
+            state.ended = true;
+            break;
+        case GfxCaptureCommand::Wait:
+        {
+            uint32_t fenceID = reader.Read<uint32_t>();
+            uint64_t value = reader.Read<uint64_t>();
+            IGfxFence* fence = GetResource<IGfxFence>(fenceID);
+
+            //waits for values signaled before the captured frame would never complete
+            uint64_t replayValue = 0;
+            auto iter = m_signaledValues.find(fenceID);
+            if (iter != m_signaledValues.end())
+            {
+                for (size_t i = 0; i < iter->second.size(); ++i)
+                {
+                    if (iter->second[i].first >= value)
+                    {
+                        replayValue = iter->second[i].second;
+                        break;
+                    }
+                }
+            }
+
+            execute(fence && replayValue != 0, [&]() { pCommandList->Wait(fence, replayValue); });
+            break;
+        }
+        case GfxCaptureCommand::Signal:
+        {
+            uint32_t fenceID = reader.Read<uint32_t>();
+            uint64_t value = reader.Read<uint64_t>();
+            IGfxFence* fence = GetResource<IGfxFence>(fenceID);
+
+            if (fence)
+            {
+                uint64_t replayValue = ++m_fenceValues[fenceID];
+                m_signaledValues[fenceID].push_back(eastl::make_pair(value, replayValue));
+                execute(true, [&]() { pCommandList->Signal(fence, replayValue); });
+            }
+            else
+            {
+                execute(false, []() {});
+            }
+            break;
+        }
+        case GfxCaptureCommand::Present:
+            reader.Read<uint32_t>();
+            execute(false, []() {});
+            break;
+        case GfxCaptureCommand::Submit:
+            if (pCommandList)
+            {
+                pCommandList->Signal(state.fence.get(), ++state.fenceValue);
+            }
+            execute(true, [&]() { pCommandList->Submit(); });
+            state.open = false;
+            break;
+        case GfxCaptureCommand::ResetState:
+            execute(true, [&]() { pCommandList->ResetState(); });
+            break;
+        case GfxCaptureCommand::BeginEvent:
+        {
+            eastl::string name = reader.ReadString();
+            execute(true, [&]() { pCommandList->BeginEvent(name); });
+            break;
+        }
+        case GfxCaptureCommand::EndEvent:
+            execute(true, [&]() { pCommandList->EndEvent(); });
+            break;
+        case GfxCaptureCommand::CopyBufferToTexture:
+        {
+            IGfxTexture* texture = GetResource<IGfxTexture>(reader.Read<uint32_t>());
+            uint32_t mip = reader.Read<uint32_t>();
+            uint32_t slice = reader.Read<uint32_t>();
+            IGfxBuffer* buffer = GetResource<IGfxBuffer>(reader.Read<uint32_t>());
+            uint32_t offset = reader.Read<uint32_t>();
+            execute(texture && buffer, [&]() { pCommandList->CopyBufferToTexture(texture, mip, slice, buffer, offset); });
+            break;
+        }
+        case GfxCaptureCommand::CopyTextureToBuffer:
+        {
+            IGfxBuffer* buffer = GetResource<IGfxBuffer>(reader.Read<uint32_t>());
+            uint32_t offset = reader.Read<uint32_t>();
+            IGfxTexture* texture = GetResource<IGfxTexture>(reader.Read<uint32_t>());
+            uint32_t mip = reader.Read<uint32_t>();
+            uint32_t slice = reader.Read<uint32_t>();
+            execute(texture && buffer, [&]() { pCommandList->CopyTextureToBuffer(buffer, offset, texture, mip, slice); });
+            break;
+        }
+        case GfxCaptureCommand::CopyBuffer:
+        {
+            IGfxBuffer* dst = GetResource<IGfxBuffer>(reader.Read<uint32_t>());
+            uint32_t dstOffset = reader.Read<uint32_t>();
+            IGfxBuffer* src = GetResource<IGfxBuffer>(reader.Read<uint32_t>());
+            uint32_t srcOffset = reader.Read<uint32_t>();
+            uint32_t size = reader.Read<uint32_t>();
+            execute(dst && src, [&]() { pCommandList->CopyBuffer(dst, dstOffset, src, srcOffset, size); });
+            break;
+        }
+        case GfxCaptureCommand::CopyTexture:
+        {
+            IGfxTexture* dst = GetResource<IGfxTexture>(reader.Read<uint32_t>());
+            uint32_t dstMip = reader.Read<uint32_t>();
+            uint32_t dstSlice = reader.Read<uint32_t>();
+            IGfxTexture* src = GetResource<IGfxTexture>(reader.Read<uint32_t>());
+            uint32_t srcMip = reader.Read<uint32_t>();
+            uint32_t srcSlice = reader.Read<uint32_t>();
+            execute(dst && src, [&]() { pCommandList->CopyTexture(dst, dstMip, dstSlice, src, srcMip, srcSlice); });
+            break;
+        }
+        case GfxCaptureCommand::ClearUAVFloat:
+        case GfxCaptureCommand::ClearUAVUint:
+        {
+            IGfxResource* resource = GetResource<IGfxResource>(reader.Read<uint32_t>());
+            IGfxDescriptor* uav = GetResource<IGfxDescriptor>(reader.Read<uint32_t>());
+            uint32_t size;
+            const uint8_t* value = reader.ReadData(size);
+            execute(resource && uav && size == sizeof(float) * 4, [&]()
+                {
+                    if (command == GfxCaptureCommand::ClearUAVFloat)
+                    {
+                        pCommandList->ClearUAV(resource, uav, (const float*)value);
+                    }
+                    else
+                    {
+                        pCommandList->ClearUAV(resource, uav, (const uint32_t*)value);
+                    }
+                });
+            break;
+        }
+        case GfxCaptureCommand::WriteBuffer:
+        {
+            IGfxBuffer* buffer = GetResource<IGfxBuffer>(reader.Read<uint32_t>());
+            uint32_t offset = reader.Read<uint32_t>();
+            uint32_t data = reader.Read<uint32_t>();
+            execute(buffer, [&]() { pCommandList->WriteBuffer(buffer, offset, data); });
+            break;
+        }
+        case GfxCaptureCommand::UpdateTileMappings:
+        {
+            IGfxTexture* texture = GetResource<IGfxTexture>(reader.Read<uint32_t>());
+            IGfxHeap* heap = GetResource<IGfxHeap>(reader.Read<uint32_t>());
+            uint32_t size;
+            const uint8_t* mappings = reader.ReadData(size);
+            execute(texture && heap, [&]() { pCommandList->UpdateTileMappings(texture, heap, size / sizeof(GfxTileMapping), (const GfxTileMapping*)mappings); });
+            break;
+        }
+        case GfxCaptureCommand::TextureBarrier:
+        {
+            IGfxTexture* texture = GetResource<IGfxTexture>(reader.Read<uint32_t>());
+            uint32_t subresource = reader.Read<uint32_t>();
+            GfxAccessFlags before = reader.Read<GfxAccessFlags>();
+            GfxAccessFlags after = reader.Read<GfxAccessFlags>();
+            execute(texture, [&]() { pCommandList->TextureBarrier(texture, subresource, before, after); });
+            break;
+        }
+        case GfxCaptureCommand::BufferBarrier:
+        {
+            IGfxBuffer* buffer = GetResource<IGfxBuffer>(reader.Read<uint32_t>());
+            GfxAccessFlags before = reader.Read<GfxAccessFlags>();
+            GfxAccessFlags after = reader.Read<GfxAccessFlags>();
+            execute(buffer, [&]() { pCommandList->BufferBarrier(buffer, before, after); });
+            break;
+        }
+        case GfxCaptureCommand::GlobalBarrier:
+        {
+            GfxAccessFlags before = reader.Read<GfxAccessFlags>();
+            GfxAccessFlags after = reader.Read<GfxAccessFlags>();
+            execute(true, [&]() { pCommandList->GlobalBarrier(before, after); });
+            break;
+        }
+        case GfxCaptureCommand::FlushBarriers:
+            execute(true, [&]() { pCommandList->FlushBarriers(); });
+            break;
+        case GfxCaptureCommand::BeginRenderPass:
+        {
+            GfxRenderPassDesc desc = reader.Read<GfxRenderPassDesc>();
+
+            bool valid = true;
+            auto remap = [&](IGfxTexture*& texture)
+            {
+                uint32_t id = (uint32_t)(uintptr_t)texture;
+                texture = GetResource<IGfxTexture>(id);
+                valid = valid && (id == UINT32_MAX || texture != nullptr);
+            };
+
+            for (uint32_t i = 0; i < 8; ++i)
+            {
+                remap(desc.color[i].texture);
+            }
+            remap(desc.depth.texture);
+
+            execute(valid, [&]() { pCommandList->BeginRenderPass(desc); });
+            break;
+        }
+        case GfxCaptureCommand::EndRenderPass:
+            execute(true, [&]() { pCommandList->EndRenderPass(); });
+            break;
+        case GfxCaptureCommand::SetPipelineState:
+        {
+            IGfxPipelineState* pso = GetResource<IGfxPipelineState>(reader.Read<uint32_t>());
+            state.pipelineValid = pso != nullptr && pso->IsReady();
+            execute(state.pipelineValid, [&]() { pCommandList->SetPipelineState(pso); });
+            break;
+        }
+        case GfxCaptureCommand::SetStencilReference:
+        {
+            uint8_t stencil = reader.Read<uint8_t>();
+            execute(true, [&]() { pCommandList->SetStencilReference(stencil); });
+            break;
+        }
+        case GfxCaptureCommand::SetBlendFactor:
+        {
+            float factor[4];
+            for (uint32_t i = 0; i < 4; ++i)
+            {
+                factor[i] = reader.Read<float>();
+            }
+            execute(true, [&]() { pCommandList->SetBlendFactor(factor); });
+            break;
+        }
+        case GfxCaptureCommand::SetIndexBuffer:
+        {
+            IGfxBuffer* buffer = GetResource<IGfxBuffer>(reader.Read<uint32_t>());
+            uint32_t offset = reader.Read<uint32_t>();
+            GfxFormat format = reader.Read<GfxFormat>();
+            execute(buffer, [&]() { pCommandList->SetIndexBuffer(buffer, offset, format); });
+            break;
+        }
+        case GfxCaptureCommand::SetViewport:
+        case GfxCaptureCommand::SetScissorRect:
+        {
+            uint32_t x = reader.Read<uint32_t>();
+            uint32_t y = reader.Read<uint32_t>();
+            uint32_t width = reader.Read<uint32_t>();
+            uint32_t height = reader.Read<uint32_t>();
+            execute(true, [&]()
+                {
+                    if (command == GfxCaptureCommand::SetViewport)
+                    {
+                        pCommandList->SetViewport(x, y, width, height);
+                    }
+                    else
+                    {
+                        pCommandList->SetScissorRect(x, y, width, height);
+                    }
+                });
+            break;
+        }
+        case GfxCaptureCommand::SetGraphicsConstants:
+        case GfxCaptureCommand::SetComputeConstants:
+        {
+            uint32_t slot = reader.Read<uint32_t>();
+            uint32_t size;
+            const uint8_t* data = reader.ReadData(size);
+            execute(slot < GFX_MAX_CBV_BINDINGS, [&]()
+                {
+                    if (command == GfxCaptureCommand::SetGraphicsConstants)
+                    {
+                        pCommandList->SetGraphicsConstants(slot, data, size);
+                    }
+                    else
+                    {
+                        pCommandList->SetComputeConstants(slot, data, size);
+                    }
+                });
+            break;
+        }
+        case GfxCaptureCommand::Draw:
+        {
+            uint32_t vertexCount = reader.Read<uint32_t>();
+            uint32_t instanceCount = reader.Read<uint32_t>();
+            execute(state.pipelineValid, [&]() { pCommandList->Draw(vertexCount, instanceCount); });
+            break;
+        }
+        case GfxCaptureCommand::DrawIndexed:
+        {
+            uint32_t indexCount = reader.Read<uint32_t>();
+            uint32_t instanceCount = reader.Read<uint32_t>();
+            uint32_t indexOffset = reader.Read<uint32_t>();
+            execute(state.pipelineValid, [&]() { pCommandList->DrawIndexed(indexCount, instanceCount, indexOffset); });
+            break;
+        }
+        case GfxCaptureCommand::Dispatch:
+        case GfxCaptureCommand::DispatchMesh:
+        {
+            uint32_t x = reader.Read<uint32_t>();
+            uint32_t y = reader.Read<uint32_t>();
+            uint32_t z = reader.Read<uint32_t>();
+            execute(state.pipelineValid, [&]()
+                {
+                    if (command == GfxCaptureCommand::Dispatch)
+                    {
+                        pCommandList->Dispatch(x, y, z);
+                    }
+                    else
+                    {
+                        pCommandList->DispatchMesh(x, y, z);
+                    }
+                });
+            break;
+        }
+        case GfxCaptureCommand::DrawIndirect:
+        case GfxCaptureCommand::DrawIndexedIndirect:
+        case GfxCaptureCommand::DispatchIndirect:
+        case GfxCaptureCommand::DispatchMeshIndirect:
+        {
+            IGfxBuffer* buffer = GetResource<IGfxBuffer>(reader.Read<uint32_t>());
+            uint32_t offset = reader.Read<uint32_t>();
+            execute(buffer && state.pipelineValid, [&]()
+                {
+                    switch (command)
+                    {
+                    case GfxCaptureCommand::DrawIndirect:
+                        pCommandList->DrawIndirect(buffer, offset);
+                        break;
+                    case GfxCaptureCommand::DrawIndexedIndirect:
+                        pCommandList->DrawIndexedIndirect(buffer, offset);
+                        break;
+                    case GfxCaptureCommand::DispatchIndirect:
+                        pCommandList->DispatchIndirect(buffer, offset);
+                        break;
+                    default:
+                        pCommandList->DispatchMeshIndirect(buffer, offset);
+                        break;
+                    }
+                });
+            break;
+        }
+        case GfxCaptureCommand::MultiDrawIndirect:
+        case GfxCaptureCommand::MultiDrawIndexedIndirect:
+        case GfxCaptureCommand::MultiDispatchIndirect:
+        case GfxCaptureCommand::MultiDispatchMeshIndirect:
+        {
+            uint32_t maxCount = reader.Read<uint32_t>();
+            IGfxBuffer* argsBuffer = GetResource<IGfxBuffer>(reader.Read<uint32_t>());
+            uint32_t argsOffset = reader.Read<uint32_t>();
+            IGfxBuffer* countBuffer = GetResource<IGfxBuffer>(reader.Read<uint32_t>());
+            uint32_t countOffset = reader.Read<uint32_t>();
+            execute(argsBuffer && countBuffer && state.pipelineValid, [&]()
+                {
+                    switch (command)
+                    {
+                    case GfxCaptureCommand::MultiDrawIndirect:
+                        pCommandList->MultiDrawIndirect(maxCount, argsBuffer, argsOffset, countBuffer, countOffset);
+                        break;
+                    case GfxCaptureCommand::MultiDrawIndexedIndirect:
+                        pCommandList->MultiDrawIndexedIndirect(maxCount, argsBuffer, argsOffset, countBuffer, countOffset);
+                        break;
+                    case GfxCaptureCommand::MultiDispatchIndirect:
+                        pCommandList->MultiDispatchIndirect(maxCount, argsBuffer, argsOffset, countBuffer, countOffset);
+                        break;
+                    default:
+                        pCommandList->MultiDispatchMeshIndirect(maxCount, argsBuffer, argsOffset, countBuffer, countOffset);
+                        break;
+                    }
+                });
+            break;
+        }
+        case GfxCaptureCommand::BuildRayTracingBLAS:
+            reader.Read<uint32_t>();
+            execute(false, []() {});
+            break;
+        case GfxCaptureCommand::UpdateRayTracingBLAS:
+            reader.Read<uint32_t>();
+            reader.Read<uint32_t>();
+            reader.Read<uint32_t>();
+            execute(false, []() {});
+            break;
+        case GfxCaptureCommand::BuildRayTracingTLAS:
+            reader.Read<uint32_t>();
+            reader.Read<uint32_t>();
+            execute(false, []() {});
+            break;
+        default:
+            break;
+        }
+
+        if (m_bCorrupted)
+        {
+            break;
+        }
+    }
+
+    if (!reader.IsValid())
+    {
+        RE_ERROR("[GfxCommandReplay] the command stream is truncated");
+        m_bCorrupted = true;
+    }
+
+    return !m_bCorrupted;
+}
+
+void GfxCommandReplay::FinishCommandLists()
+{
+    for (auto iter = m_commandLists.begin(); iter != m_commandLists.end(); ++iter)
+    {
+        IGfxCommandList* pCommandList = GetResource<IGfxCommandList>(iter->first);
+        CommandListState& state = iter->second;
+
+        if (pCommandList && state.open)
+        {
+            if (!state.ended)
+            {
+                pCommandList->End();
+            }
+            pCommandList->Signal(state.fence.get(), ++state.fenceValue);
+            pCommandList->Submit();
+            state.open = false;
+        }
+    }
+
+    //the next iteration resets the command allocators
+    for (auto iter = m_commandLists.begin(); iter != m_commandLists.end(); ++iter)
+    {
+        CommandListState& state = iter->second;
+        if (state.fence && state.fenceValue > 0)
+        {
+            state.fence->Wait(state.fenceValue);
+        }
+    }
+}
+
+void GfxCommandReplay::DestroyResources()
+{
+    FinishCommandLists();
+
+    //views and command lists first, they reference the other resources
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        for (size_t i = 0; i < m_resources.size(); ++i)
+        {
+            Resource& resource = m_resources[i];
+            bool first = resource.type == GfxCaptureResourceType::UnorderedAccessView || resource.type == GfxCaptureResourceType::CommandList;
+
+            if (resource.resource && resource.owned && first == (pass == 0))
+            {
+                delete resource.resource;
+                resource.resource = nullptr;
+            }
+        }
+    }
+
+    m_resources.clear();
+    m_shaders.clear();
+    m_commandLists.clear();
+    m_signaledValues.clear();
+    m_fenceValues.clear();
+    m_stream.clear();
+    m_nCommandCount = 0;
+    m_bCorrupted = false;
+}
+
+void GfxCommandReplay::LogStats() const
+{
+    eastl::vector<GfxCaptureCommand> commands;
+    uint64_t totalTicks = 0;
+
+    for (size_t i = 0; i < (size_t)GfxCaptureCommand::Count; ++i)
+    {
+        if (m_stats[i].count > 0 || m_stats[i].skipped > 0)
+        {
+            commands.push_back((GfxCaptureCommand)i);
+            totalTicks += m_stats[i].ticks;
+        }
+    }
+
+    eastl::sort(commands.begin(), commands.end(), [&](GfxCaptureCommand a, GfxCaptureCommand b)
+        {
+            return m_stats[(size_t)a].ticks > m_stats[(size_t)b].ticks;
+        });
+
+    uint32_t iterations = eastl::max(m_nIterations, 1u);
+    RE_INFO("[GfxCommandReplay] {} iterations on {}, {:.3f} ms per frame", m_nIterations, magic_enum::enum_name(m_pDevice->GetDesc().backend),
+        stm_ms(totalTicks) / iterations);
+
+    for (size_t i = 0; i < commands.size(); ++i)
+    {
+        const CommandStats& stats = m_stats[(size_t)commands[i]];
+        double ns = stats.count > 0 ? stm_ns(stats.ticks) / stats.count : 0.0;
+
+        RE_INFO("    {:<28} {:>8} calls, {:>8.1f} ns/call, {:>8.3f} ms per frame, {} skipped", magic_enum::enum_name(commands[i]),
+            stats.count / iterations, ns, stm_ms(stats.ticks) / iterations, stats.skipped / iterations);
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "gfx_command_capture.h"
+
+// plays a capture of GfxCommandCapture back on any device, and measures the cpu time spent in each command type.
+// resources are recreated from their descs with undefined contents, present and ray tracing commands are skipped
+class GfxCommandReplay
+{
+public:
+    //PSOs need compiled shaders on a real device, which the renderer provides.
+    //without a factory they are created from placeholder bytecode, which only the mock device accepts
+    using PipelineFactory = eastl::function<IGfxPipelineState*(const GfxCapturedPipeline&, const eastl::string& name)>;
+
+    struct CommandStats
+    {
+        uint32_t count = 0;
+        uint32_t skipped = 0;
+        uint64_t ticks = 0;
+    };
+
+    GfxCommandReplay(IGfxDevice* device, const PipelineFactory& factory = nullptr);
+    ~GfxCommandReplay();
+
+    bool Load(const eastl::string& file);
+    //returns false when the command stream is corrupted, the replay stops at the first invalid command
+    bool Replay(uint32_t iterations);
+
+    const CommandStats& GetStats(GfxCaptureCommand command) const { return m_stats[(size_t)command]; }
+    void LogStats() const;
+
+private:
+    class Reader;
+
+    struct Resource
+    {
+        GfxCaptureResourceType type;
+        eastl::string name;
+        IGfxResource* resource = nullptr;
+        bool owned = true;
+    };
+
+    struct CommandListState
+    {
+        eastl::unique_ptr<IGfxFence> fence; //signaled on each submit, to wait for the list before replaying it again
+        uint64_t fenceValue = 0;
+        bool open = false;
+        bool ended = false;
+        bool pipelineValid = true;
+    };
+
+    bool CreateResources(Reader& reader, uint32_t count);
+    IGfxPipelineState* CreatePipelineState(const GfxCapturedPipeline& pipeline, const eastl::string& name);
+    bool ReplayStream();
+    void FinishCommandLists();
+    void DestroyResources();
+
+    //nullptr for UINT32_MAX and for resources which failed to be created.
+    //an id out of range or of another resource type marks the capture as corrupted
+    template<typename T>
+    T* GetResource(uint32_t id);
+
+private:
+    IGfxDevice* m_pDevice;
+    PipelineFactory m_pipelineFactory;
+
+    GfxRenderBackend m_captureBackend = GfxRenderBackend::Mock;
+    eastl::vector<Resource> m_resources;
+    eastl::vector<eastl::unique_ptr<IGfxShader>> m_shaders;
+    eastl::hash_map<uint32_t, CommandListState> m_commandLists;
+
+    //fences are remapped, a recorded value maps to the value which was signaled for it in the current iteration
+    eastl::hash_map<uint32_t, eastl::vector<eastl::pair<uint64_t, uint64_t>>> m_signaledValues;
+    eastl::hash_map<uint32_t, uint64_t> m_fenceValues;
+
+    eastl::vector<uint8_t> m_stream;
+    uint32_t m_nCommandCount = 0;
+    uint32_t m_nIterations = 0;
+    bool m_bCorrupted = false;
+
+    CommandStats m_stats[(size_t)GfxCaptureCommand::Count];
+};
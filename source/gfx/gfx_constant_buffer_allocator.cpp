@@ -0,0 +1,126 @@
+#include "gfx_constant_buffer_allocator.h"
+#include "utils/log.h"
+#include "utils/math.h"
+
+GfxConstantBufferAllocator::GfxConstantBufferAllocator(uint32_t page_size, uint32_t block_size, uint32_t alignment)
+{
+    RE_ASSERT(page_size % block_size == 0 && block_size % alignment == 0);
+
+    m_pageSize = page_size;
+    m_blockSize = block_size;
+    m_alignment = alignment;
+}
+
+bool GfxConstantBufferAllocator::AllocateBlocks(uint32_t block_count, uint32_t* page_index, uint32_t* offset)
+{
+    const uint32_t blocksPerPage = m_pageSize / m_blockSize;
+    if (block_count > blocksPerPage)
+    {
+        RE_ERROR("[GfxConstantBufferAllocator] {} bytes can't fit in a page", block_count * m_blockSize);
+        return false;
+    }
+
+    while (true)
+    {
+        uint32_t first = m_nNextBlock.fetch_add(block_count);
+        uint32_t page = first / blocksPerPage;
+
+        if (page >= MAX_PAGE_COUNT)
+        {
+            if (!m_bExhausted.exchange(true))
+            {
+                RE_ERROR("[GfxConstantBufferAllocator] out of constant buffer memory, the allocations are dropped for this frame");
+            }
+            return false;
+        }
+
+        //the run would cross the end of the page, its tail is wasted and the next page is tried
+        if ((first + block_count - 1) / blocksPerPage != page)
+        {
+            continue;
+        }
+
+        if (page >= m_nPageCount && !AddPages(page + 1))
+        {
+            return false;
+        }
+
+        *page_index = page;
+        *offset = (first % blocksPerPage) * m_blockSize;
+        return true;
+    }
+}
+
+void GfxConstantBufferAllocator::Reset()
+{
+    m_nNextBlock = 0;
+    m_bExhausted = false;
+    ++m_generation;
+}
+
+bool GfxConstantBufferAllocator::AddPages(uint32_t page_count)
+{
+    std::scoped_lock lock(m_pageMutex);
+
+    while (m_nPageCount < page_count)
+    {
+        uint32_t index = m_nPageCount;
+        if (!CreatePage(index, m_pages[index]))
+        {
+            RE_ERROR("[GfxConstantBufferAllocator] failed to create page {}", index);
+            return false;
+        }
+
+        if (index > 0)
+        {
+            RE_WARN("[GfxConstantBufferAllocator] out of constant buffer memory, overflow page {} is created", index);
+        }
+
+        //published after the page is filled in, other threads read it once they see the new count
+        m_nPageCount = index + 1;
+    }
+
+    return true;
+}
+
+bool GfxConstantBufferSubAllocator::Allocate(GfxConstantBufferAllocator* allocator, uint32_t size, void** cpu_address, uint64_t* gpu_address, uint32_t* page_index)
+{
+    uint32_t alignedSize = RoundUpPow2(eastl::max(size, 1u), allocator->GetAlignment());
+
+    if (m_pAllocator != allocator || m_generation != allocator->GetGeneration() || m_offset + alignedSize > m_end)
+    {
+        uint32_t blockSize = allocator->GetBlockSize();
+        uint32_t blockCount = (alignedSize + blockSize - 1) / blockSize;
+
+        uint32_t page, offset;
+        if (!allocator->AllocateBlocks(blockCount, &page, &offset))
+        {
+            Reset();
+            return false;
+        }
+
+        m_pAllocator = allocator;
+        m_generation = allocator->GetGeneration();
+        m_page = page;
+        m_offset = offset;
+        m_end = offset + blockCount * blockSize;
+    }
+
+    const GfxConstantBufferAllocator::Page& page = allocator->GetPage(m_page);
+    *cpu_address = (char*)page.cpu_address + m_offset;
+    *gpu_address = page.gpu_address + m_offset;
+    if (page_index)
+    {
+        *page_index = m_page;
+    }
+
+    m_offset += alignedSize;
+    return true;
+}
+
+void GfxConstantBufferSubAllocator::Reset()
+{
+    m_pAllocator = nullptr;
+    m_offset = 0;
+    m_end = 0;
+}
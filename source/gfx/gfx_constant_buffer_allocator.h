@@ -0,0 +1,66 @@
+#pragma once
+
+#include "gfx_defines.h"
+#include "EASTL/atomic.h"
+#include <mutex>
+
+// per-frame memory for constant buffers and other transient data, handed out in fixed size blocks.
+// a block is grabbed with an atomic add, so command lists recorded on different threads only contend when they need a new block.
+// when the memory runs out, overflow pages are created instead of overwriting data still in use
+class GfxConstantBufferAllocator
+{
+public:
+    struct Page
+    {
+        void* cpu_address = nullptr;
+        uint64_t gpu_address = 0;
+    };
+
+    GfxConstantBufferAllocator(uint32_t page_size, uint32_t block_size, uint32_t alignment);
+    virtual ~GfxConstantBufferAllocator() {}
+
+    //a run of blocks never crosses a page, returns false when the allocation can't be satisfied
+    bool AllocateBlocks(uint32_t block_count, uint32_t* page_index, uint32_t* offset);
+    void Reset();
+
+    const Page& GetPage(uint32_t index) const { return m_pages[index]; }
+    uint32_t GetPageCount() const { return m_nPageCount; }
+    uint32_t GetPageSize() const { return m_pageSize; }
+    uint32_t GetBlockSize() const { return m_blockSize; }
+    uint32_t GetAlignment() const { return m_alignment; }
+    uint32_t GetGeneration() const { return m_generation; }
+
+protected:
+    //backends call it for page 0 in their constructor, overflow pages are created on demand from any thread
+    virtual bool CreatePage(uint32_t index, Page& page) = 0;
+    bool AddPages(uint32_t page_count);
+
+protected:
+    static const uint32_t MAX_PAGE_COUNT = 8;
+
+    uint32_t m_pageSize = 0;
+    uint32_t m_blockSize = 0;
+    uint32_t m_alignment = 0;
+    uint32_t m_generation = 0; //incremented on each reset, invalidates the blocks held by the sub-allocators
+
+    Page m_pages[MAX_PAGE_COUNT];
+    eastl::atomic<uint32_t> m_nPageCount{ 0 };
+    eastl::atomic<uint32_t> m_nNextBlock{ 0 };
+    eastl::atomic<bool> m_bExhausted{ false };
+    std::mutex m_pageMutex;
+};
+
+// owned by a command list, only accessed by the thread recording it
+class GfxConstantBufferSubAllocator
+{
+public:
+    bool Allocate(GfxConstantBufferAllocator* allocator, uint32_t size, void** cpu_address, uint64_t* gpu_address, uint32_t* page_index = nullptr);
+    void Reset();
+
+private:
+    GfxConstantBufferAllocator* m_pAllocator = nullptr;
+    uint32_t m_generation = 0;
+    uint32_t m_page = 0;
+    uint32_t m_offset = 0;
+    uint32_t m_end = 0;
+};
@@ -225,6 +225,7 @@ static const uint32_t GFX_INVALID_RESOURCE = 0xFFFFFFFF;
 struct GfxDeviceDesc
 {
     GfxRenderBackend backend = GfxRenderBackend::D3D12;
+    eastl::string pipeline_cache_path; //driver pipeline caches are persisted in this folder, empty to disable
 };
 
 struct GfxSwapchainDesc
@@ -242,6 +243,17 @@ struct GfxHeapDesc
     GfxMemoryType memory_type = GfxMemoryType::GpuOnly;
 };
 
+enum class GfxQueryType
+{
+    Timestamp,
+};
+
+struct GfxQueryHeapDesc
+{
+    GfxQueryType type = GfxQueryType::Timestamp;
+    uint32_t count = 1;
+};
+
 struct GfxBufferDesc
 {
     uint32_t stride = 1;
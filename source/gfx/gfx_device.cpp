@@ -0,0 +1,47 @@
+#include "gfx.h"
+#include "core/platform.h"
+#include "vulkan/vulkan_device.h"
+#include "mock/mock_device.h"
+
+#if RE_PLATFORM_WINDOWS
+#include "d3d12/d3d12_device.h"
+#endif
+
+#if RE_PLATFORM_MAC || RE_PLATFORM_IOS
+#include "metal/metal_device.h"
+#endif
+
+IGfxDevice* CreateGfxDevice(const GfxDeviceDesc& desc)
+{
+    IGfxDevice* pDevice = nullptr;
+
+    switch (desc.backend)
+    {
+#if RE_PLATFORM_WINDOWS
+    case GfxRenderBackend::D3D12:
+        pDevice = new D3D12Device(desc);
+        break;
+#endif
+    case GfxRenderBackend::Vulkan:
+        pDevice = new VulkanDevice(desc);
+        break;
+#if RE_PLATFORM_MAC || RE_PLATFORM_IOS
+    case GfxRenderBackend::Metal:
+        pDevice = new MetalDevice(desc);
+        break;
+#endif
+    case GfxRenderBackend::Mock:
+        pDevice = new MockDevice(desc);
+        break;
+    default:
+        break;
+    }
+
+    if (pDevice && !pDevice->Create())
+    {
+        delete pDevice;
+        pDevice = nullptr;
+    }
+    
+    return pDevice;
+}
@@ -12,6 +12,7 @@ class IGfxShader;
 class IGfxPipelineState;
 class IGfxDescriptor;
 class IGfxHeap;
+class IGfxQueryHeap;
 class IGfxRayTracingBLAS;
 class IGfxRayTracingTLAS;
 
@@ -33,6 +34,7 @@ public:
     virtual IGfxCommandList* CreateCommandList(GfxCommandQueue queue_type, const eastl::string& name) = 0;
     virtual IGfxFence* CreateFence(const eastl::string& name) = 0;
     virtual IGfxHeap* CreateHeap(const GfxHeapDesc& desc, const eastl::string& name) = 0;
+    virtual IGfxQueryHeap* CreateQueryHeap(const GfxQueryHeapDesc& desc, const eastl::string& name) = 0; //returns nullptr if the queries are not supported
     virtual IGfxBuffer* CreateBuffer(const GfxBufferDesc& desc, const eastl::string& name) = 0;
     virtual IGfxTexture* CreateTexture(const GfxTextureDesc& desc, const eastl::string& name) = 0;
     virtual IGfxShader* CreateShader(const GfxShaderDesc& desc, eastl::span<uint8_t> data, const eastl::string& name) = 0;
@@ -47,7 +49,9 @@ public:
     virtual IGfxRayTracingTLAS* CreateRayTracingTLAS(const GfxRayTracingTLASDesc& desc, const eastl::string& name) = 0;
 
     virtual uint32_t GetAllocationSize(const GfxTextureDesc& desc) = 0;
+    virtual uint64_t GetTimestampFrequency() = 0; //ticks per second of the graphics queue
     virtual bool DumpMemoryStats(const eastl::string& file) = 0;
+    virtual void LogPipelineCacheStats() = 0;
 
 protected:
     GfxDeviceDesc m_desc;
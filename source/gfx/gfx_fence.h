@@ -9,4 +9,5 @@ public:
 
     virtual void Wait(uint64_t value) = 0;
     virtual void Signal(uint64_t value) = 0;
+    virtual uint64_t GetCompletedValue() const = 0;
 };
\ No newline at end of file
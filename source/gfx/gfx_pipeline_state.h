@@ -1,14 +1,39 @@
 #pragma once
 
-#include "gfx_resource.h"
+#include "gfx_shader.h"
 
 class IGfxPipelineState : public IGfxResource
 {
 public:
     GfxPipelineType GetType() const { return m_type; }
 
+    //false until the shaders are compiled and Create succeeds
+    bool IsReady() const { return m_bReady; }
+
     virtual bool Create() = 0;
 
 protected:
     GfxPipelineType m_type;
-};
\ No newline at end of file
+    eastl::atomic<bool> m_bReady{ false };
+};
+
+//pipeline states are created lazily when some of their shaders are still being compiled
+inline bool IsShaderReady(const IGfxShader* shader)
+{
+    return shader == nullptr || shader->IsReady();
+}
+
+inline bool IsShaderReady(const GfxGraphicsPipelineDesc& desc)
+{
+    return IsShaderReady(desc.vs) && IsShaderReady(desc.ps);
+}
+
+inline bool IsShaderReady(const GfxMeshShadingPipelineDesc& desc)
+{
+    return IsShaderReady(desc.as) && IsShaderReady(desc.ms) && IsShaderReady(desc.ps);
+}
+
+inline bool IsShaderReady(const GfxComputePipelineDesc& desc)
+{
+    return IsShaderReady(desc.cs);
+}
\ No newline at end of file
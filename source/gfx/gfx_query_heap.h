@@ -0,0 +1,12 @@
+#pragma once
+
+#include "gfx_resource.h"
+
+class IGfxQueryHeap : public IGfxResource
+{
+public:
+    const GfxQueryHeapDesc& GetDesc() const { return m_desc; }
+
+protected:
+    GfxQueryHeapDesc m_desc = {};
+};
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "gfx_resource.h"
+#include "EASTL/atomic.h"
 
 class IGfxShader : public IGfxResource
 {
@@ -9,9 +10,13 @@ public:
 
     uint64_t GetHash() const { return m_hash; }
 
+    //shaders can be created without bytecode and compiled asynchronously, they are ready after a successful Create
+    bool IsReady() const { return m_bReady; }
+
     virtual bool Create(eastl::span<uint8_t> data) = 0;
 
 protected:
     GfxShaderDesc m_desc = {};
     uint64_t m_hash = 0;
+    eastl::atomic<bool> m_bReady{ false };
 };
\ No newline at end of file
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "gfx_defines.h"
+#include "utils/assert.h"
+#include "EASTL/vector.h"
+#include <string.h>
+
+class IGfxPipelineState;
+class IGfxBuffer;
+
+// remembers the last state set on a command list, so the backends can drop redundant api calls.
+// each Set* function returns true when the state has changed and the backend should issue the call
+class GfxStateCache
+{
+public:
+    struct Stats
+    {
+        uint32_t pipelineStates = 0;
+        uint32_t pipelineStatesSkipped = 0;
+        uint32_t constants = 0;
+        uint32_t constantsSkipped = 0;
+        uint32_t indexBuffers = 0;
+        uint32_t indexBuffersSkipped = 0;
+        uint32_t viewports = 0; //viewports and scissor rects
+        uint32_t viewportsSkipped = 0;
+    };
+
+    //constant buffers larger than this are always set, comparing them costs about as much as uploading them
+    static const uint32_t MAX_CACHED_CONSTANT_SIZE = 512;
+
+    //forgets the bound state, should be called whenever the native command list state is lost or modified outside of the cache
+    void Reset()
+    {
+        m_pPipelineState = nullptr;
+        m_pIndexBuffer = nullptr;
+        m_bViewportValid = false;
+        m_bScissorValid = false;
+
+        for (uint32_t i = 0; i < GFX_MAX_CBV_BINDINGS; ++i)
+        {
+            m_graphicsConstants[i].valid = false;
+            m_computeConstants[i].valid = false;
+        }
+    }
+
+    void ResetStats() { m_stats = Stats(); }
+    const Stats& GetStats() const { return m_stats; }
+
+    bool SetPipelineState(IGfxPipelineState* state)
+    {
+        if (m_pPipelineState == state)
+        {
+            ++m_stats.pipelineStatesSkipped;
+            return false;
+        }
+
+        m_pPipelineState = state;
+        ++m_stats.pipelineStates;
+        return true;
+    }
+
+    bool SetGraphicsConstants(uint32_t slot, const void* data, size_t data_size)
+    {
+        RE_ASSERT(slot < GFX_MAX_CBV_BINDINGS);
+        return SetConstants(m_graphicsConstants[slot], data, data_size);
+    }
+
+    bool SetComputeConstants(uint32_t slot, const void* data, size_t data_size)
+    {
+        RE_ASSERT(slot < GFX_MAX_CBV_BINDINGS);
+        return SetConstants(m_computeConstants[slot], data, data_size);
+    }
+
+    //the backend failed to bind the constants, they need to be set again next time
+    void InvalidateGraphicsConstants(uint32_t slot) { m_graphicsConstants[slot].valid = false; }
+    void InvalidateComputeConstants(uint32_t slot) { m_computeConstants[slot].valid = false; }
+
+    bool SetIndexBuffer(IGfxBuffer* buffer, uint32_t offset, GfxFormat format)
+    {
+        if (m_pIndexBuffer == buffer && m_indexBufferOffset == offset && m_indexBufferFormat == format)
+        {
+            ++m_stats.indexBuffersSkipped;
+            return false;
+        }
+
+        m_pIndexBuffer = buffer;
+        m_indexBufferOffset = offset;
+        m_indexBufferFormat = format;
+        ++m_stats.indexBuffers;
+        return true;
+    }
+
+    bool SetViewport(uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+    {
+        return SetRect(m_viewport, m_bViewportValid, x, y, width, height);
+    }
+
+    bool SetScissorRect(uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+    {
+        return SetRect(m_scissorRect, m_bScissorValid, x, y, width, height);
+    }
+
+private:
+    struct ConstantSlot
+    {
+        bool valid = false;
+        eastl::vector<uint8_t> data;
+    };
+
+    bool SetConstants(ConstantSlot& slot, const void* data, size_t data_size)
+    {
+        if (slot.valid && slot.data.size() == data_size && memcmp(slot.data.data(), data, data_size) == 0)
+        {
+            ++m_stats.constantsSkipped;
+            return false;
+        }
+
+        slot.valid = data_size <= MAX_CACHED_CONSTANT_SIZE;
+        if (slot.valid)
+        {
+            slot.data.assign((const uint8_t*)data, (const uint8_t*)data + data_size);
+        }
+
+        ++m_stats.constants;
+        return true;
+    }
+
+    bool SetRect(uint32_t* rect, bool& valid, uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+    {
+        if (valid && rect[0] == x && rect[1] == y && rect[2] == width && rect[3] == height)
+        {
+            ++m_stats.viewportsSkipped;
+            return false;
+        }
+
+        rect[0] = x;
+        rect[1] = y;
+        rect[2] = width;
+        rect[3] = height;
+        valid = true;
+        ++m_stats.viewports;
+        return true;
+    }
+
+private:
+    IGfxPipelineState* m_pPipelineState = nullptr;
+
+    ConstantSlot m_graphicsConstants[GFX_MAX_CBV_BINDINGS];
+    ConstantSlot m_computeConstants[GFX_MAX_CBV_BINDINGS];
+
+    IGfxBuffer* m_pIndexBuffer = nullptr;
+    uint32_t m_indexBufferOffset = 0;
+    GfxFormat m_indexBufferFormat = GfxFormat::Unknown;
+
+    uint32_t m_viewport[4] = {};
+    uint32_t m_scissorRect[4] = {};
+    bool m_bViewportValid = false;
+    bool m_bScissorValid = false;
+
+    Stats m_stats;
+};
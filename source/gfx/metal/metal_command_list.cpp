@@ -33,6 +33,8 @@ bool MetalCommandList::Create()
 
 void MetalCommandList::ResetAllocator()
 {
+    m_constantBufferAllocator.Reset();
+    m_stateCache.ResetStats();
 }
 
 void MetalCommandList::Begin()
@@ -40,6 +42,7 @@ void MetalCommandList::Begin()
     MTL::CommandQueue* queue = ((MetalDevice*)m_pDevice)->GetQueue();
     
     m_pCommandBuffer = queue->commandBuffer();
+    m_stateCache.Reset();
 }
 
 void MetalCommandList::End()
@@ -78,6 +81,7 @@ void MetalCommandList::ResetState()
     m_pASEncoder = nullptr;
     
     m_pCurrentPSO = nullptr;
+    m_stateCache.Reset(); //render encoder state doesn't survive the encoder
     
     m_pIndexBuffer = nullptr;
     m_indexBufferOffset = 0;
@@ -231,6 +235,18 @@ void MetalCommandList::UpdateTileMappings(IGfxTexture* texture, IGfxHeap* heap,
     //todo
 }
 
+void MetalCommandList::ResetQueries(IGfxQueryHeap* heap, uint32_t first, uint32_t count)
+{
+}
+
+void MetalCommandList::WriteTimestamp(IGfxQueryHeap* heap, uint32_t index)
+{
+}
+
+void MetalCommandList::ResolveQueries(IGfxQueryHeap* heap, uint32_t first, uint32_t count, IGfxBuffer* dst_buffer, uint32_t offset)
+{
+}
+
 void MetalCommandList::TextureBarrier(IGfxTexture* texture, uint32_t sub_resource, GfxAccessFlags access_before, GfxAccessFlags access_after)
 {
 }
@@ -359,9 +375,8 @@ void MetalCommandList::EndRenderPass()
 
 void MetalCommandList::SetPipelineState(IGfxPipelineState* state)
 {
-    if(m_pCurrentPSO != state)
+    if(m_stateCache.SetPipelineState(state))
     {
-        
         m_pCurrentPSO = state;
         
         if(state->GetType() != GfxPipelineType::Compute)
@@ -407,6 +422,11 @@ void MetalCommandList::SetIndexBuffer(IGfxBuffer* buffer, uint32_t offset, GfxFo
 {
     RE_ASSERT(m_pRenderCommandEncoder != nullptr);
     
+    if(!m_stateCache.SetIndexBuffer(buffer, offset, format))
+    {
+        return;
+    }
+    
     m_pIndexBuffer = (MTL::Buffer*)buffer->GetHandle();
     m_indexBufferOffset = offset;
     m_indexType = format == GfxFormat::R16UI ? MTL::IndexTypeUInt16 : MTL::IndexTypeUInt32;
@@ -416,8 +436,11 @@ void MetalCommandList::SetViewport(uint32_t x, uint32_t y, uint32_t width, uint3
 {
     RE_ASSERT(m_pRenderCommandEncoder != nullptr);
     
-    MTL::Viewport viewport = { x, y, width, height, 0.0, 1.0 };
-    m_pRenderCommandEncoder->setViewport(viewport);
+    if(m_stateCache.SetViewport(x, y, width, height))
+    {
+        MTL::Viewport viewport = { x, y, width, height, 0.0, 1.0 };
+        m_pRenderCommandEncoder->setViewport(viewport);
+    }
     
     SetScissorRect(x, y, width, height);
 }
@@ -426,12 +449,22 @@ void MetalCommandList::SetScissorRect(uint32_t x, uint32_t y, uint32_t width, ui
 {
     RE_ASSERT(m_pRenderCommandEncoder != nullptr);
     
+    if(!m_stateCache.SetScissorRect(x, y, width, height))
+    {
+        return;
+    }
+    
     MTL::ScissorRect scissorRect = { x, y, width, height };
     m_pRenderCommandEncoder->setScissorRect(scissorRect);
 }
 
 void MetalCommandList::SetGraphicsConstants(uint32_t slot, const void* data, size_t data_size)
 {
+    if(!m_stateCache.SetGraphicsConstants(slot, data, data_size))
+    {
+        return;
+    }
+    
     if(slot == 0)
     {
         RE_ASSERT(data_size <= GFX_MAX_ROOT_CONSTANTS * sizeof(uint32_t));
@@ -440,7 +473,12 @@ void MetalCommandList::SetGraphicsConstants(uint32_t slot, const void* data, siz
     else
     {
         RE_ASSERT(slot < GFX_MAX_CBV_BINDINGS);
-        uint64_t gpuAddress = ((MetalDevice*)m_pDevice)->AllocateConstantBuffer(data, data_size);
+        uint64_t gpuAddress = ((MetalDevice*)m_pDevice)->AllocateConstantBuffer(m_constantBufferAllocator, data, data_size);
+        if(gpuAddress == 0)
+        {
+            m_stateCache.InvalidateGraphicsConstants(slot);
+            return;
+        }
         
         if(slot == 1)
         {
@@ -455,6 +493,11 @@ void MetalCommandList::SetGraphicsConstants(uint32_t slot, const void* data, siz
 
 void MetalCommandList::SetComputeConstants(uint32_t slot, const void* data, size_t data_size)
 {
+    if(!m_stateCache.SetComputeConstants(slot, data, data_size))
+    {
+        return;
+    }
+    
     if(slot == 0)
     {
         RE_ASSERT(data_size <= GFX_MAX_ROOT_CONSTANTS * sizeof(uint32_t));
@@ -463,7 +506,12 @@ void MetalCommandList::SetComputeConstants(uint32_t slot, const void* data, size
     else
     {
         RE_ASSERT(slot < GFX_MAX_CBV_BINDINGS);
-        uint64_t gpuAddress = ((MetalDevice*)m_pDevice)->AllocateConstantBuffer(data, data_size);
+        uint64_t gpuAddress = ((MetalDevice*)m_pDevice)->AllocateConstantBuffer(m_constantBufferAllocator, data, data_size);
+        if(gpuAddress == 0)
+        {
+            m_stateCache.InvalidateComputeConstants(slot);
+            return;
+        }
         
         if(slot == 1)
         {
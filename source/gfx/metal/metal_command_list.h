@@ -2,6 +2,7 @@
 
 #include "metal_utils.h"
 #include "../gfx_command_list.h"
+#include "../gfx_constant_buffer_allocator.h"
 
 class MetalDevice;
 
@@ -37,6 +38,10 @@ public:
     virtual void WriteBuffer(IGfxBuffer* buffer, uint32_t offset, uint32_t data) override;
     virtual void UpdateTileMappings(IGfxTexture* texture, IGfxHeap* heap, uint32_t mapping_count, const GfxTileMapping* mappings) override;
 
+    virtual void ResetQueries(IGfxQueryHeap* heap, uint32_t first, uint32_t count) override;
+    virtual void WriteTimestamp(IGfxQueryHeap* heap, uint32_t index) override;
+    virtual void ResolveQueries(IGfxQueryHeap* heap, uint32_t first, uint32_t count, IGfxBuffer* dst_buffer, uint32_t offset) override;
+
     virtual void TextureBarrier(IGfxTexture* texture, uint32_t sub_resource, GfxAccessFlags access_before, GfxAccessFlags access_after) override;
     virtual void BufferBarrier(IGfxBuffer* buffer, GfxAccessFlags access_before, GfxAccessFlags access_after) override;
     virtual void GlobalBarrier(GfxAccessFlags access_before, GfxAccessFlags access_after) override;
@@ -115,4 +120,6 @@ private:
     
     TopLevelArgumentBuffer m_graphicsArgumentBuffer;
     TopLevelArgumentBuffer m_computeArgumentBuffer;
+
+    GfxConstantBufferSubAllocator m_constantBufferAllocator;
 };
@@ -14,49 +14,49 @@
 #include "utils/log.h"
 #include "utils/math.h"
 
-class MetalConstantBufferAllocator
+class MetalConstantBufferAllocator : public GfxConstantBufferAllocator
 {
 public:
-    MetalConstantBufferAllocator(MetalDevice* device, uint32_t buffer_size, const eastl::string& name)
+    MetalConstantBufferAllocator(MetalDevice* device, uint32_t buffer_size, const eastl::string& name) :
+        GfxConstantBufferAllocator(buffer_size, 64 * 1024, 8) // Shader converter requires an alignment of 8-bytes
     {
         m_pDevice = device;
+        m_name = name;
         
-        MTL::Device* mtlDevice = (MTL::Device*)m_pDevice->GetHandle();
-        m_pBuffer = mtlDevice->newBuffer(buffer_size, MTL::ResourceStorageModeShared | MTL::ResourceCPUCacheModeWriteCombined | MTL::ResourceHazardTrackingModeTracked);
-        m_pDevice->MakeResident(m_pBuffer);
-        SetDebugLabel(m_pBuffer, name.c_str());
-        
-        m_pCpuAddress = m_pBuffer->contents();
-        m_bufferSize = buffer_size;
+        AddPages(1);
     }
     
     ~MetalConstantBufferAllocator()
     {
-        m_pDevice->Evict(m_pBuffer);
-        m_pDevice->Release(m_pBuffer);
-    }
-
-    void Allocate(uint32_t size, void** cpu_address, uint64_t* gpu_address)
-    {
-        RE_ASSERT(m_allocatedSize + size <= m_bufferSize);
-
-        *cpu_address = (char*)m_pCpuAddress + m_allocatedSize;
-        *gpu_address = m_pBuffer->gpuAddress() + m_allocatedSize;
-
-        m_allocatedSize += RoundUpPow2(size, 8); // Shader converter requires an alignment of 8-bytes:
+        for (uint32_t i = 0; i < GetPageCount(); ++i)
+        {
+            m_pDevice->Evict(m_pBuffers[i]);
+            m_pDevice->Release(m_pBuffers[i]);
+        }
     }
     
-    void Reset()
+private:
+    virtual bool CreatePage(uint32_t index, Page& page) override
     {
-        m_allocatedSize = 0;
+        MTL::Device* mtlDevice = (MTL::Device*)m_pDevice->GetHandle();
+        m_pBuffers[index] = mtlDevice->newBuffer(m_pageSize, MTL::ResourceStorageModeShared | MTL::ResourceCPUCacheModeWriteCombined | MTL::ResourceHazardTrackingModeTracked);
+        if (m_pBuffers[index] == nullptr)
+        {
+            return false;
+        }
+        
+        m_pDevice->MakeResident(m_pBuffers[index]);
+        SetDebugLabel(m_pBuffers[index], index == 0 ? m_name.c_str() : fmt::format("{} overflow {}", m_name, index).c_str());
+        
+        page.cpu_address = m_pBuffers[index]->contents();
+        page.gpu_address = m_pBuffers[index]->gpuAddress();
+        return true;
     }
     
 private:
     MetalDevice* m_pDevice = nullptr;
-    MTL::Buffer* m_pBuffer = nullptr;
-    void* m_pCpuAddress = nullptr;
-    uint32_t m_bufferSize = 0;
-    uint32_t m_allocatedSize = 0;
+    eastl::string m_name;
+    MTL::Buffer* m_pBuffers[MAX_PAGE_COUNT] = {};
 };
 
 class MetalDescriptorAllocator
@@ -281,6 +281,12 @@ IGfxHeap* MetalDevice::CreateHeap(const GfxHeapDesc& desc, const eastl::string&
     return heap;
 }
 
+IGfxQueryHeap* MetalDevice::CreateQueryHeap(const GfxQueryHeapDesc& desc, const eastl::string& name)
+{
+    //todo : counter sample buffers, timestamps at encoder boundaries only
+    return nullptr;
+}
+
 IGfxBuffer* MetalDevice::CreateBuffer(const GfxBufferDesc& desc, const eastl::string& name)
 {
     MetalBuffer* buffer = new MetalBuffer(this, desc, name);
@@ -306,7 +312,7 @@ IGfxTexture* MetalDevice::CreateTexture(const GfxTextureDesc& desc, const eastl:
 IGfxShader* MetalDevice::CreateShader(const GfxShaderDesc& desc, eastl::span<uint8_t> data, const eastl::string& name)
 {
     MetalShader* shader = new MetalShader(this, desc, name);
-    if (!shader->Create(data))
+    if (!data.empty() && !shader->Create(data))
     {
         delete shader;
         return nullptr;
@@ -317,7 +323,7 @@ IGfxShader* MetalDevice::CreateShader(const GfxShaderDesc& desc, eastl::span<uin
 IGfxPipelineState* MetalDevice::CreateGraphicsPipelineState(const GfxGraphicsPipelineDesc& desc, const eastl::string& name)
 {
     MetalGraphicsPipelineState* pso = new MetalGraphicsPipelineState(this, desc, name);
-    if (!pso->Create())
+    if (IsShaderReady(desc) && !pso->Create())
     {
         delete pso;
         return nullptr;
@@ -328,7 +334,7 @@ IGfxPipelineState* MetalDevice::CreateGraphicsPipelineState(const GfxGraphicsPip
 IGfxPipelineState* MetalDevice::CreateMeshShadingPipelineState(const GfxMeshShadingPipelineDesc& desc, const eastl::string& name)
 {
     MetalMeshShadingPipelineState* pso = new MetalMeshShadingPipelineState(this, desc, name);
-    if (!pso->Create())
+    if (IsShaderReady(desc) && !pso->Create())
     {
         delete pso;
         return nullptr;
@@ -339,7 +345,7 @@ IGfxPipelineState* MetalDevice::CreateMeshShadingPipelineState(const GfxMeshShad
 IGfxPipelineState* MetalDevice::CreateComputePipelineState(const GfxComputePipelineDesc& desc, const eastl::string& name)
 {
     MetalComputePipelineState* pso = new MetalComputePipelineState(this, desc, name);
-    if (!pso->Create())
+    if (IsShaderReady(desc) && !pso->Create())
     {
         delete pso;
         return nullptr;
@@ -422,18 +428,26 @@ uint32_t MetalDevice::GetAllocationSize(const GfxTextureDesc& desc)
     return (uint32_t)sizeAndAlign.size;
 }
 
+uint64_t MetalDevice::GetTimestampFrequency()
+{
+    return 0;
+}
+
 bool MetalDevice::DumpMemoryStats(const eastl::string& file)
 {
     return false;
 }
 
-uint64_t MetalDevice::AllocateConstantBuffer(const void* data, size_t data_size)
+uint64_t MetalDevice::AllocateConstantBuffer(GfxConstantBufferSubAllocator& allocator, const void* data, size_t data_size)
 {
     void* cpu_address;
     uint64_t gpu_address;
 
     uint32_t index = m_frameID % GFX_MAX_INFLIGHT_FRAMES;
-    m_pConstantBufferAllocators[index]->Allocate((uint32_t)data_size, &cpu_address, &gpu_address);
+    if (!allocator.Allocate(m_pConstantBufferAllocators[index].get(), (uint32_t)data_size, &cpu_address, &gpu_address))
+    {
+        return 0;
+    }
 
     memcpy(cpu_address, data, data_size);
 
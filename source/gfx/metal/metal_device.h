@@ -2,6 +2,7 @@
 
 #include "metal_utils.h"
 #include "../gfx_device.h"
+#include "../gfx_constant_buffer_allocator.h"
 #include "EASTL/unique_ptr.h"
 #include "EASTL/queue.h"
 
@@ -20,6 +21,7 @@ public:
     virtual IGfxCommandList* CreateCommandList(GfxCommandQueue queue_type, const eastl::string& name) override;
     virtual IGfxFence* CreateFence(const eastl::string& name) override;
     virtual IGfxHeap* CreateHeap(const GfxHeapDesc& desc, const eastl::string& name) override;
+    virtual IGfxQueryHeap* CreateQueryHeap(const GfxQueryHeapDesc& desc, const eastl::string& name) override;
     virtual IGfxBuffer* CreateBuffer(const GfxBufferDesc& desc, const eastl::string& name) override;
     virtual IGfxTexture* CreateTexture(const GfxTextureDesc& desc, const eastl::string& name) override;
     virtual IGfxShader* CreateShader(const GfxShaderDesc& desc, eastl::span<uint8_t> data, const eastl::string& name) override;
@@ -34,11 +36,13 @@ public:
     virtual IGfxRayTracingTLAS* CreateRayTracingTLAS(const GfxRayTracingTLASDesc& desc, const eastl::string& name) override;
 
     virtual uint32_t GetAllocationSize(const GfxTextureDesc& desc) override;
+    virtual uint64_t GetTimestampFrequency() override;
     virtual bool DumpMemoryStats(const eastl::string& file) override;
+    virtual void LogPipelineCacheStats() override {}
     
     MTL::CommandQueue* GetQueue() const { return m_pQueue; }
     
-    uint64_t AllocateConstantBuffer(const void* data, size_t data_size);
+    uint64_t AllocateConstantBuffer(GfxConstantBufferSubAllocator& allocator, const void* data, size_t data_size); //returns 0 when out of memory
     
     uint32_t AllocateResourceDescriptor(IRDescriptorTableEntry** descriptor);
     uint32_t AllocateSamplerDescriptor(IRDescriptorTableEntry** descriptor);
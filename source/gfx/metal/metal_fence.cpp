@@ -38,3 +38,8 @@ void MetalFence::Signal(uint64_t value)
 {
     m_pEvent->setSignaledValue(value);
 }
+
+uint64_t MetalFence::GetCompletedValue() const
+{
+    return m_pEvent->signaledValue();
+}
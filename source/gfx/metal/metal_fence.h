@@ -16,6 +16,7 @@ public:
     virtual void* GetHandle() const override { return m_pEvent; }
     virtual void Wait(uint64_t value) override;
     virtual void Signal(uint64_t value) override;
+    virtual uint64_t GetCompletedValue() const override;
     
 private:
     MTL::SharedEvent* m_pEvent = nullptr;
@@ -73,6 +73,7 @@ bool MetalGraphicsPipelineState::Create()
     m_pDepthStencilState = device->newDepthStencilState(depthStencilDescriptor);
     depthStencilDescriptor->release();
     
+    m_bReady = true;
     return true;
 }
 
@@ -157,6 +158,7 @@ bool MetalMeshShadingPipelineState::Create()
     const MetalShaderReflection& reflection = ((MetalShader*)m_desc.ms)->GetReflection();
     m_threadsPerMeshThreadgroup = MTL::Size::Make(reflection.threadsPerThreadgroup[0], reflection.threadsPerThreadgroup[1], reflection.threadsPerThreadgroup[2]);
     
+    m_bReady = true;
     return true;
 }
 
@@ -197,5 +199,6 @@ bool MetalComputePipelineState::Create()
     const MetalShaderReflection& reflection = ((MetalShader*)m_desc.cs)->GetReflection();
     m_threadsPerThreadgroup = MTL::Size::Make(reflection.threadsPerThreadgroup[0], reflection.threadsPerThreadgroup[1], reflection.threadsPerThreadgroup[2]);
     
+    m_bReady = true;
     return true;
 }
@@ -45,5 +45,6 @@ bool MetalShader::Create(eastl::span<uint8_t> data)
     
     m_hash = XXH3_64bits(data.data(), data.size());
 
+    m_bReady = true;
     return true;
 }
@@ -1,6 +1,8 @@
 #include "mock_command_list.h"
 #include "mock_device.h"
 #include "mock_swapchain.h"
+#include "mock_query_heap.h"
+#include "../gfx_buffer.h"
 
 MockCommandList::MockCommandList(MockDevice* pDevice, GfxCommandQueue queue_type, const eastl::string& name)
 {
@@ -25,10 +27,13 @@ void* MockCommandList::GetHandle() const
 
 void MockCommandList::ResetAllocator()
 {
+    m_constantBufferAllocator.Reset();
+    m_stateCache.ResetStats();
 }
 
 void MockCommandList::Begin()
 {
+    ResetState();
 }
 
 void MockCommandList::End()
@@ -54,6 +59,7 @@ void MockCommandList::Submit()
 
 void MockCommandList::ResetState()
 {
+    m_stateCache.Reset();
 }
 
 void MockCommandList::BeginEvent(const eastl::string& event_name, const eastl::string& file, const eastl::string& function, uint32_t line)
@@ -96,6 +102,26 @@ void MockCommandList::UpdateTileMappings(IGfxTexture* texture, IGfxHeap* heap, u
 {
 }
 
+void MockCommandList::ResetQueries(IGfxQueryHeap* heap, uint32_t first, uint32_t count)
+{
+    RE_ASSERT(first + count <= heap->GetDesc().count);
+    memset(((MockQueryHeap*)heap)->GetResults() + first, 0, sizeof(uint64_t) * count);
+}
+
+void MockCommandList::WriteTimestamp(IGfxQueryHeap* heap, uint32_t index)
+{
+    RE_ASSERT(index < heap->GetDesc().count);
+    ((MockQueryHeap*)heap)->GetResults()[index] = m_fakeTimestamp;
+}
+
+void MockCommandList::ResolveQueries(IGfxQueryHeap* heap, uint32_t first, uint32_t count, IGfxBuffer* dst_buffer, uint32_t offset)
+{
+    RE_ASSERT(offset + sizeof(uint64_t) * count <= dst_buffer->GetDesc().size);
+
+    void* dst = (char*)dst_buffer->GetCpuAddress() + offset;
+    memcpy(dst, ((MockQueryHeap*)heap)->GetResults() + first, sizeof(uint64_t) * count);
+}
+
 void MockCommandList::TextureBarrier(IGfxTexture* texture, uint32_t sub_resource, GfxAccessFlags access_before, GfxAccessFlags access_after)
 {
 }
@@ -122,6 +148,7 @@ void MockCommandList::EndRenderPass()
 
 void MockCommandList::SetPipelineState(IGfxPipelineState* state)
 {
+    m_stateCache.SetPipelineState(state);
 }
 
 void MockCommandList::SetStencilReference(uint8_t stencil)
@@ -134,70 +161,105 @@ void MockCommandList::SetBlendFactor(const float* blend_factor)
 
 void MockCommandList::SetIndexBuffer(IGfxBuffer* buffer, uint32_t offset, GfxFormat format)
 {
+    m_stateCache.SetIndexBuffer(buffer, offset, format);
 }
 
 void MockCommandList::SetViewport(uint32_t x, uint32_t y, uint32_t width, uint32_t height)
 {
+    m_stateCache.SetViewport(x, y, width, height);
+
+    SetScissorRect(x, y, width, height);
 }
 
 void MockCommandList::SetScissorRect(uint32_t x, uint32_t y, uint32_t width, uint32_t height)
 {
+    m_stateCache.SetScissorRect(x, y, width, height);
 }
 
 void MockCommandList::SetGraphicsConstants(uint32_t slot, const void* data, size_t data_size)
 {
+    if (!m_stateCache.SetGraphicsConstants(slot, data, data_size))
+    {
+        return;
+    }
+
+    if (slot > 0 && ((MockDevice*)m_pDevice)->AllocateConstantBuffer(m_constantBufferAllocator, data, data_size) == nullptr)
+    {
+        m_stateCache.InvalidateGraphicsConstants(slot);
+    }
 }
 
 void MockCommandList::SetComputeConstants(uint32_t slot, const void* data, size_t data_size)
 {
+    if (!m_stateCache.SetComputeConstants(slot, data, data_size))
+    {
+        return;
+    }
+
+    if (slot > 0 && ((MockDevice*)m_pDevice)->AllocateConstantBuffer(m_constantBufferAllocator, data, data_size) == nullptr)
+    {
+        m_stateCache.InvalidateComputeConstants(slot);
+    }
 }
 
 void MockCommandList::Draw(uint32_t vertex_count, uint32_t instance_count)
 {
+    m_fakeTimestamp += MOCK_TICKS_PER_WORK;
 }
 
 void MockCommandList::DrawIndexed(uint32_t index_count, uint32_t instance_count, uint32_t index_offset)
 {
+    m_fakeTimestamp += MOCK_TICKS_PER_WORK;
 }
 
 void MockCommandList::Dispatch(uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z)
 {
+    m_fakeTimestamp += MOCK_TICKS_PER_WORK;
 }
 
 void MockCommandList::DispatchMesh(uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z)
 {
+    m_fakeTimestamp += MOCK_TICKS_PER_WORK;
 }
 
 void MockCommandList::DrawIndirect(IGfxBuffer* buffer, uint32_t offset)
 {
+    m_fakeTimestamp += MOCK_TICKS_PER_WORK;
 }
 
 void MockCommandList::DrawIndexedIndirect(IGfxBuffer* buffer, uint32_t offset)
 {
+    m_fakeTimestamp += MOCK_TICKS_PER_WORK;
 }
 
 void MockCommandList::DispatchIndirect(IGfxBuffer* buffer, uint32_t offset)
 {
+    m_fakeTimestamp += MOCK_TICKS_PER_WORK;
 }
 
 void MockCommandList::DispatchMeshIndirect(IGfxBuffer* buffer, uint32_t offset)
 {
+    m_fakeTimestamp += MOCK_TICKS_PER_WORK;
 }
 
 void MockCommandList::MultiDrawIndirect(uint32_t max_count, IGfxBuffer* args_buffer, uint32_t args_buffer_offset, IGfxBuffer* count_buffer, uint32_t count_buffer_offset)
 {
+    m_fakeTimestamp += MOCK_TICKS_PER_WORK;
 }
 
 void MockCommandList::MultiDrawIndexedIndirect(uint32_t max_count, IGfxBuffer* args_buffer, uint32_t args_buffer_offset, IGfxBuffer* count_buffer, uint32_t count_buffer_offset)
 {
+    m_fakeTimestamp += MOCK_TICKS_PER_WORK;
 }
 
 void MockCommandList::MultiDispatchIndirect(uint32_t max_count, IGfxBuffer* args_buffer, uint32_t args_buffer_offset, IGfxBuffer* count_buffer, uint32_t count_buffer_offset)
 {
+    m_fakeTimestamp += MOCK_TICKS_PER_WORK;
 }
 
 void MockCommandList::MultiDispatchMeshIndirect(uint32_t max_count, IGfxBuffer* args_buffer, uint32_t args_buffer_offset, IGfxBuffer* count_buffer, uint32_t count_buffer_offset)
 {
+    m_fakeTimestamp += MOCK_TICKS_PER_WORK;
 }
 
 void MockCommandList::BuildRayTracingBLAS(IGfxRayTracingBLAS* blas)
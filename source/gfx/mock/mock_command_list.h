@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../gfx_command_list.h"
+#include "../gfx_constant_buffer_allocator.h"
 
 class MockDevice;
 
@@ -35,6 +36,10 @@ public:
     virtual void WriteBuffer(IGfxBuffer* buffer, uint32_t offset, uint32_t data) override;
     virtual void UpdateTileMappings(IGfxTexture* texture, IGfxHeap* heap, uint32_t mapping_count, const GfxTileMapping* mappings) override;
 
+    virtual void ResetQueries(IGfxQueryHeap* heap, uint32_t first, uint32_t count) override;
+    virtual void WriteTimestamp(IGfxQueryHeap* heap, uint32_t index) override;
+    virtual void ResolveQueries(IGfxQueryHeap* heap, uint32_t first, uint32_t count, IGfxBuffer* dst_buffer, uint32_t offset) override;
+
     virtual void TextureBarrier(IGfxTexture* texture, uint32_t sub_resource, GfxAccessFlags access_before, GfxAccessFlags access_after) override;
     virtual void BufferBarrier(IGfxBuffer* buffer, GfxAccessFlags access_before, GfxAccessFlags access_after) override;
     virtual void GlobalBarrier(GfxAccessFlags access_before, GfxAccessFlags access_after) override;
@@ -69,4 +74,8 @@ public:
     virtual void BuildRayTracingBLAS(IGfxRayTracingBLAS* blas) override;
     virtual void UpdateRayTracingBLAS(IGfxRayTracingBLAS* blas, IGfxBuffer* vertex_buffer, uint32_t vertex_buffer_offset) override;
     virtual void BuildRayTracingTLAS(IGfxRayTracingTLAS* tlas, const GfxRayTracingInstance* instances, uint32_t instance_count) override;
+
+private:
+    GfxConstantBufferSubAllocator m_constantBufferAllocator;
+    uint64_t m_fakeTimestamp = 0;
 };
\ No newline at end of file
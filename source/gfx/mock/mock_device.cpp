@@ -8,9 +8,37 @@
 #include "mock_pipeline_state.h"
 #include "mock_descriptor.h"
 #include "mock_heap.h"
+#include "mock_query_heap.h"
 #include "mock_rt_blas.h"
 #include "mock_rt_tlas.h"
 #include "../gfx.h"
+#include "utils/memory.h"
+
+class MockConstantBufferAllocator : public GfxConstantBufferAllocator
+{
+public:
+    MockConstantBufferAllocator(uint32_t buffer_size) : GfxConstantBufferAllocator(buffer_size, 64 * 1024, 256)
+    {
+        AddPages(1);
+    }
+
+    ~MockConstantBufferAllocator()
+    {
+        for (uint32_t i = 0; i < m_nPageCount; ++i)
+        {
+            RE_FREE(m_pages[i].cpu_address);
+        }
+    }
+
+private:
+    //aligned like the gpu buffers of the other backends, so the offsets handed out are aligned addresses
+    virtual bool CreatePage(uint32_t index, Page& page) override
+    {
+        page.cpu_address = RE_ALLOC(m_pageSize, m_alignment);
+        page.gpu_address = (uint64_t)page.cpu_address;
+        return page.cpu_address != nullptr;
+    }
+};
 
 MockDevice::MockDevice(const GfxDeviceDesc& desc)
 {
@@ -23,6 +51,11 @@ MockDevice::~MockDevice()
 
 bool MockDevice::Create()
 {
+    for (uint32_t i = 0; i < GFX_MAX_INFLIGHT_FRAMES; ++i)
+    {
+        m_pConstantBufferAllocators[i] = eastl::make_unique<MockConstantBufferAllocator>(8 * 1024 * 1024);
+    }
+
     return true;
 }
 
@@ -33,6 +66,8 @@ void* MockDevice::GetHandle() const
 
 void MockDevice::BeginFrame()
 {
+    uint32_t index = m_frameID % GFX_MAX_INFLIGHT_FRAMES;
+    m_pConstantBufferAllocators[index]->Reset();
 }
 
 void MockDevice::EndFrame()
@@ -84,6 +119,17 @@ IGfxHeap* MockDevice::CreateHeap(const GfxHeapDesc& desc, const eastl::string& n
     return heap;
 }
 
+IGfxQueryHeap* MockDevice::CreateQueryHeap(const GfxQueryHeapDesc& desc, const eastl::string& name)
+{
+    MockQueryHeap* heap = new MockQueryHeap(this, desc, name);
+    if (!heap->Create())
+    {
+        delete heap;
+        return nullptr;
+    }
+    return heap;
+}
+
 IGfxBuffer* MockDevice::CreateBuffer(const GfxBufferDesc& desc, const eastl::string& name)
 {
     MockBuffer* buffer = new MockBuffer(this, desc, name);
@@ -109,7 +155,7 @@ IGfxTexture* MockDevice::CreateTexture(const GfxTextureDesc& desc, const eastl::
 IGfxShader* MockDevice::CreateShader(const GfxShaderDesc& desc, eastl::span<uint8_t> data, const eastl::string& name)
 {
     MockShader* shader = new MockShader(this, desc, name);
-    if (!shader->Create(data))
+    if (!data.empty() && !shader->Create(data))
     {
         delete shader;
         return nullptr;
@@ -120,7 +166,7 @@ IGfxShader* MockDevice::CreateShader(const GfxShaderDesc& desc, eastl::span<uint
 IGfxPipelineState* MockDevice::CreateGraphicsPipelineState(const GfxGraphicsPipelineDesc& desc, const eastl::string& name)
 {
     MockGraphicsPipelineState* pso = new MockGraphicsPipelineState(this, desc, name);
-    if (!pso->Create())
+    if (IsShaderReady(desc) && !pso->Create())
     {
         delete pso;
         return nullptr;
@@ -131,7 +177,7 @@ IGfxPipelineState* MockDevice::CreateGraphicsPipelineState(const GfxGraphicsPipe
 IGfxPipelineState* MockDevice::CreateMeshShadingPipelineState(const GfxMeshShadingPipelineDesc& desc, const eastl::string& name)
 {
     MockMeshShadingPipelineState* pso = new MockMeshShadingPipelineState(this, desc, name);
-    if (!pso->Create())
+    if (IsShaderReady(desc) && !pso->Create())
     {
         delete pso;
         return nullptr;
@@ -142,7 +188,7 @@ IGfxPipelineState* MockDevice::CreateMeshShadingPipelineState(const GfxMeshShadi
 IGfxPipelineState* MockDevice::CreateComputePipelineState(const GfxComputePipelineDesc& desc, const eastl::string& name)
 {
     MockComputePipelineState* pso = new MockComputePipelineState(this, desc, name);
-    if (!pso->Create())
+    if (IsShaderReady(desc) && !pso->Create())
     {
         delete pso;
         return nullptr;
@@ -238,7 +284,28 @@ uint32_t MockDevice::GetAllocationSize(const GfxTextureDesc& desc)
     return size;
 }
 
+uint64_t MockDevice::GetTimestampFrequency()
+{
+    return MOCK_TIMESTAMP_FREQUENCY;
+}
+
 bool MockDevice::DumpMemoryStats(const eastl::string& file)
 {
     return false;
 }
+
+void* MockDevice::AllocateConstantBuffer(GfxConstantBufferSubAllocator& allocator, const void* data, size_t data_size)
+{
+    void* cpu_address;
+    uint64_t gpu_address;
+
+    uint32_t index = m_frameID % GFX_MAX_INFLIGHT_FRAMES;
+    if (!allocator.Allocate(m_pConstantBufferAllocators[index].get(), (uint32_t)data_size, &cpu_address, &gpu_address))
+    {
+        return nullptr;
+    }
+
+    memcpy(cpu_address, data, data_size);
+
+    return cpu_address;
+}
@@ -1,6 +1,12 @@
 #pragma once
 
 #include "../gfx_device.h"
+#include "../gfx_constant_buffer_allocator.h"
+#include "EASTL/unique_ptr.h"
+
+//fake gpu clock : every draw or dispatch takes 1us, so timings of the mock backend are deterministic
+static const uint64_t MOCK_TIMESTAMP_FREQUENCY = 1000000000;
+static const uint64_t MOCK_TICKS_PER_WORK = 1000;
 
 class MockDevice : public IGfxDevice
 {
@@ -17,6 +23,7 @@ public:
     virtual IGfxCommandList* CreateCommandList(GfxCommandQueue queue_type, const eastl::string& name) override;
     virtual IGfxFence* CreateFence(const eastl::string& name) override;
     virtual IGfxHeap* CreateHeap(const GfxHeapDesc& desc, const eastl::string& name) override;
+    virtual IGfxQueryHeap* CreateQueryHeap(const GfxQueryHeapDesc& desc, const eastl::string& name) override;
     virtual IGfxBuffer* CreateBuffer(const GfxBufferDesc& desc, const eastl::string& name) override;
     virtual IGfxTexture* CreateTexture(const GfxTextureDesc& desc, const eastl::string& name) override;
     virtual IGfxShader* CreateShader(const GfxShaderDesc& desc, eastl::span<uint8_t> data, const eastl::string& name) override;
@@ -31,5 +38,13 @@ public:
     virtual IGfxRayTracingTLAS* CreateRayTracingTLAS(const GfxRayTracingTLASDesc& desc, const eastl::string& name) override;
 
     virtual uint32_t GetAllocationSize(const GfxTextureDesc& desc) override;
+    virtual uint64_t GetTimestampFrequency() override;
     virtual bool DumpMemoryStats(const eastl::string& file) override;
+    virtual void LogPipelineCacheStats() override {}
+
+    //backed by cpu memory, keeps the multi-threaded recording path exercised without a gpu
+    void* AllocateConstantBuffer(GfxConstantBufferSubAllocator& allocator, const void* data, size_t data_size);
+
+private:
+    eastl::unique_ptr<GfxConstantBufferAllocator> m_pConstantBufferAllocators[GFX_MAX_INFLIGHT_FRAMES];
 };
\ No newline at end of file
@@ -28,3 +28,8 @@ void MockFence::Wait(uint64_t value)
 void MockFence::Signal(uint64_t value)
 {
 }
+
+uint64_t MockFence::GetCompletedValue() const
+{
+    return UINT64_MAX; //there is no gpu work to wait for
+}
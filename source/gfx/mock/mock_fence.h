@@ -15,4 +15,5 @@ public:
     virtual void* GetHandle() const override;
     virtual void Wait(uint64_t value) override;
     virtual void Signal(uint64_t value) override;
+    virtual uint64_t GetCompletedValue() const override;
 };
\ No newline at end of file
@@ -20,6 +20,7 @@ void* MockGraphicsPipelineState::GetHandle() const
 
 bool MockGraphicsPipelineState::Create()
 {
+    m_bReady = true;
     return true;
 }
 
@@ -42,6 +43,7 @@ void* MockMeshShadingPipelineState::GetHandle() const
 
 bool MockMeshShadingPipelineState::Create()
 {
+    m_bReady = true;
     return true;
 }
 
@@ -64,5 +66,6 @@ void* MockComputePipelineState::GetHandle() const
 
 bool MockComputePipelineState::Create()
 {
+    m_bReady = true;
     return true;
 }
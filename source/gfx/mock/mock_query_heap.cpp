@@ -0,0 +1,24 @@
+#include "mock_query_heap.h"
+#include "mock_device.h"
+
+MockQueryHeap::MockQueryHeap(MockDevice* pDevice, const GfxQueryHeapDesc& desc, const eastl::string& name)
+{
+    m_pDevice = pDevice;
+    m_desc = desc;
+    m_name = name;
+}
+
+MockQueryHeap::~MockQueryHeap()
+{
+}
+
+bool MockQueryHeap::Create()
+{
+    m_results.resize(m_desc.count);
+    return true;
+}
+
+void* MockQueryHeap::GetHandle() const
+{
+    return nullptr;
+}
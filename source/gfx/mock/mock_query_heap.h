@@ -0,0 +1,22 @@
+#pragma once
+
+#include "../gfx_query_heap.h"
+#include "EASTL/vector.h"
+
+class MockDevice;
+
+class MockQueryHeap : public IGfxQueryHeap
+{
+public:
+    MockQueryHeap(MockDevice* pDevice, const GfxQueryHeapDesc& desc, const eastl::string& name);
+    ~MockQueryHeap();
+
+    bool Create();
+
+    virtual void* GetHandle() const override;
+
+    uint64_t* GetResults() { return m_results.data(); }
+
+private:
+    eastl::vector<uint64_t> m_results;
+};
\ No newline at end of file
@@ -21,5 +21,6 @@ bool MockShader::Create(eastl::span<uint8_t> data)
 
     m_hash = XXH3_64bits(data.data(), data.size());
 
+    m_bReady = true;
     return true;
 }
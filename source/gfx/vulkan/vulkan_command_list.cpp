@@ -73,6 +73,9 @@ void VulkanCommandList::ResetAllocator()
         m_freeCommandBuffers.push_back(m_pendingCommandBuffers[i]);
     }
     m_pendingCommandBuffers.clear();
+
+    m_constantBufferAllocator.Reset();
+    m_stateCache.ResetStats();
 }
 
 void VulkanCommandList::Begin()
@@ -194,32 +197,11 @@ void VulkanCommandList::Submit()
 
 void VulkanCommandList::ResetState()
 {
+    m_stateCache.Reset();
+
     if (m_queueType == GfxCommandQueue::Graphics || m_queueType == GfxCommandQueue::Compute)
     {
-        VulkanDevice* device = (VulkanDevice*)m_pDevice;
-
-        VkDescriptorBufferBindingInfoEXT descriptorBuffer[3] = {};
-        descriptorBuffer[0].sType = VK_STRUCTURE_TYPE_DESCRIPTOR_BUFFER_BINDING_INFO_EXT;
-        descriptorBuffer[0].address = device->GetConstantBufferAllocator()->GetGpuAddress();
-        descriptorBuffer[0].usage = VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT;
-        descriptorBuffer[1].sType = VK_STRUCTURE_TYPE_DESCRIPTOR_BUFFER_BINDING_INFO_EXT;
-        descriptorBuffer[1].address = device->GetResourceDescriptorAllocator()->GetGpuAddress();
-        descriptorBuffer[1].usage = VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT;
-        descriptorBuffer[2].sType = VK_STRUCTURE_TYPE_DESCRIPTOR_BUFFER_BINDING_INFO_EXT;
-        descriptorBuffer[2].address = device->GetSamplerDescriptorAllocator()->GetGpuAddress();
-        descriptorBuffer[2].usage = VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT;
-
-        vkCmdBindDescriptorBuffersEXT(m_commandBuffer, 3, descriptorBuffer);
-
-        uint32_t bufferIndices[] = { 1, 2 };
-        VkDeviceSize offsets[] = { 0, 0 };
-
-        vkCmdSetDescriptorBufferOffsetsEXT(m_commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, device->GetPipelineLayout(), 1, 2, bufferIndices, offsets);
-
-        if (m_queueType == GfxCommandQueue::Graphics)
-        {
-            vkCmdSetDescriptorBufferOffsetsEXT(m_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, device->GetPipelineLayout(), 1, 2, bufferIndices, offsets);
-        }
+        BindDescriptorBuffers(0);
     }
 }
 
@@ -381,6 +363,26 @@ void VulkanCommandList::UpdateTileMappings(IGfxTexture* texture, IGfxHeap* heap,
     //todo
 }
 
+void VulkanCommandList::ResetQueries(IGfxQueryHeap* heap, uint32_t first, uint32_t count)
+{
+    FlushBarriers();
+
+    vkCmdResetQueryPool(m_commandBuffer, (VkQueryPool)heap->GetHandle(), first, count);
+}
+
+void VulkanCommandList::WriteTimestamp(IGfxQueryHeap* heap, uint32_t index)
+{
+    vkCmdWriteTimestamp2(m_commandBuffer, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, (VkQueryPool)heap->GetHandle(), index);
+}
+
+void VulkanCommandList::ResolveQueries(IGfxQueryHeap* heap, uint32_t first, uint32_t count, IGfxBuffer* dst_buffer, uint32_t offset)
+{
+    FlushBarriers();
+
+    vkCmdCopyQueryPoolResults(m_commandBuffer, (VkQueryPool)heap->GetHandle(), first, count, (VkBuffer)dst_buffer->GetHandle(), offset,
+        sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+}
+
 void VulkanCommandList::TextureBarrier(IGfxTexture* texture, uint32_t sub_resource, GfxAccessFlags access_before, GfxAccessFlags access_after)
 {
     VkImageMemoryBarrier2 barrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2 };
@@ -562,6 +564,11 @@ void VulkanCommandList::EndRenderPass()
 
 void VulkanCommandList::SetPipelineState(IGfxPipelineState* state)
 {
+    if (!m_stateCache.SetPipelineState(state))
+    {
+        return;
+    }
+
     VkPipelineBindPoint bindPoint = state->GetType() == GfxPipelineType::Compute ? VK_PIPELINE_BIND_POINT_COMPUTE : VK_PIPELINE_BIND_POINT_GRAPHICS;
     vkCmdBindPipeline(m_commandBuffer, bindPoint, (VkPipeline)state->GetHandle());
 }
@@ -578,29 +585,42 @@ void VulkanCommandList::SetBlendFactor(const float* blend_factor)
 
 void VulkanCommandList::SetIndexBuffer(IGfxBuffer* buffer, uint32_t offset, GfxFormat format)
 {
+    if (!m_stateCache.SetIndexBuffer(buffer, offset, format))
+    {
+        return;
+    }
+
     VkIndexType type = format == GfxFormat::R16UI ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
     vkCmdBindIndexBuffer(m_commandBuffer, (VkBuffer)buffer->GetHandle(), (VkDeviceSize)offset, type);
 }
 
 void VulkanCommandList::SetViewport(uint32_t x, uint32_t y, uint32_t width, uint32_t height)
 {
-    // negate the height and move the origin to the bottom left, to match d3d12's ndc space
+    if (m_stateCache.SetViewport(x, y, width, height))
+    {
+        // negate the height and move the origin to the bottom left, to match d3d12's ndc space
 
-    VkViewport viewport;
-    viewport.x = x;
-    viewport.y = (float)height - (float)y;
-    viewport.width = width;
-    viewport.height = -(float)height;
-    viewport.minDepth = 0.0;
-    viewport.maxDepth = 1.0;
+        VkViewport viewport;
+        viewport.x = x;
+        viewport.y = (float)height - (float)y;
+        viewport.width = width;
+        viewport.height = -(float)height;
+        viewport.minDepth = 0.0;
+        viewport.maxDepth = 1.0;
 
-    vkCmdSetViewport(m_commandBuffer, 0, 1, &viewport);
+        vkCmdSetViewport(m_commandBuffer, 0, 1, &viewport);
+    }
 
     SetScissorRect(x, y, width, height);
 }
 
 void VulkanCommandList::SetScissorRect(uint32_t x, uint32_t y, uint32_t width, uint32_t height)
 {
+    if (!m_stateCache.SetScissorRect(x, y, width, height))
+    {
+        return;
+    }
+
     VkRect2D scissor;
     scissor.offset.x = x;
     scissor.offset.y = y;
@@ -612,6 +632,11 @@ void VulkanCommandList::SetScissorRect(uint32_t x, uint32_t y, uint32_t width, u
 
 void VulkanCommandList::SetGraphicsConstants(uint32_t slot, const void* data, size_t data_size)
 {
+    if (!m_stateCache.SetGraphicsConstants(slot, data, data_size))
+    {
+        return;
+    }
+
     if (slot == 0)
     {
         RE_ASSERT(data_size <= GFX_MAX_ROOT_CONSTANTS * sizeof(uint32_t));
@@ -620,7 +645,12 @@ void VulkanCommandList::SetGraphicsConstants(uint32_t slot, const void* data, si
     else
     {
         RE_ASSERT(slot < GFX_MAX_CBV_BINDINGS);
-        VkDeviceAddress gpuAddress = ((VulkanDevice*)m_pDevice)->AllocateConstantBuffer(data, data_size);
+        VkDeviceAddress gpuAddress = ((VulkanDevice*)m_pDevice)->AllocateConstantBuffer(m_constantBufferAllocator, data, data_size);
+        if (gpuAddress == 0)
+        {
+            m_stateCache.InvalidateGraphicsConstants(slot);
+            return;
+        }
 
         if (slot == 1)
         {
@@ -639,6 +669,11 @@ void VulkanCommandList::SetGraphicsConstants(uint32_t slot, const void* data, si
 
 void VulkanCommandList::SetComputeConstants(uint32_t slot, const void* data, size_t data_size)
 {
+    if (!m_stateCache.SetComputeConstants(slot, data, data_size))
+    {
+        return;
+    }
+
     if (slot == 0)
     {
         RE_ASSERT(data_size <= GFX_MAX_ROOT_CONSTANTS * sizeof(uint32_t));
@@ -647,7 +682,12 @@ void VulkanCommandList::SetComputeConstants(uint32_t slot, const void* data, siz
     else
     {
         RE_ASSERT(slot < GFX_MAX_CBV_BINDINGS);
-        VkDeviceAddress gpuAddress = ((VulkanDevice*)m_pDevice)->AllocateConstantBuffer(data, data_size);
+        VkDeviceAddress gpuAddress = ((VulkanDevice*)m_pDevice)->AllocateConstantBuffer(m_constantBufferAllocator, data, data_size);
+        if (gpuAddress == 0)
+        {
+            m_stateCache.InvalidateComputeConstants(slot);
+            return;
+        }
 
         if (slot == 1)
         {
@@ -792,12 +832,56 @@ void VulkanCommandList::BuildRayTracingTLAS(IGfxRayTracingTLAS* tlas, const GfxR
     vkCmdBuildAccelerationStructuresKHR(m_commandBuffer, 1, &info, &pRangeInfo);
 }
 
+void VulkanCommandList::BindDescriptorBuffers(uint32_t constant_buffer_page)
+{
+    VulkanDevice* device = (VulkanDevice*)m_pDevice;
+
+    VkDescriptorBufferBindingInfoEXT descriptorBuffer[3] = {};
+    descriptorBuffer[0].sType = VK_STRUCTURE_TYPE_DESCRIPTOR_BUFFER_BINDING_INFO_EXT;
+    descriptorBuffer[0].address = device->GetConstantBufferAllocator()->GetPage(constant_buffer_page).gpu_address;
+    descriptorBuffer[0].usage = VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT;
+    descriptorBuffer[1].sType = VK_STRUCTURE_TYPE_DESCRIPTOR_BUFFER_BINDING_INFO_EXT;
+    descriptorBuffer[1].address = device->GetResourceDescriptorAllocator()->GetGpuAddress();
+    descriptorBuffer[1].usage = VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT;
+    descriptorBuffer[2].sType = VK_STRUCTURE_TYPE_DESCRIPTOR_BUFFER_BINDING_INFO_EXT;
+    descriptorBuffer[2].address = device->GetSamplerDescriptorAllocator()->GetGpuAddress();
+    descriptorBuffer[2].usage = VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT;
+
+    vkCmdBindDescriptorBuffersEXT(m_commandBuffer, 3, descriptorBuffer);
+
+    uint32_t bufferIndices[] = { 1, 2 };
+    VkDeviceSize offsets[] = { 0, 0 };
+
+    vkCmdSetDescriptorBufferOffsetsEXT(m_commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, device->GetPipelineLayout(), 1, 2, bufferIndices, offsets);
+
+    if (m_queueType == GfxCommandQueue::Graphics)
+    {
+        vkCmdSetDescriptorBufferOffsetsEXT(m_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, device->GetPipelineLayout(), 1, 2, bufferIndices, offsets);
+    }
+
+    //the set 0 offsets of both bind points referred to the previous constant buffer page
+    m_constantBufferPage = constant_buffer_page;
+    m_graphicsConstants.dirty = true;
+    m_computeConstants.dirty = true;
+}
+
 void VulkanCommandList::UpdateGraphicsDescriptorBuffer()
 {
     if (m_graphicsConstants.dirty)
     {
         VulkanDevice* device = (VulkanDevice*)m_pDevice;
-        VkDeviceSize cbvDescriptorOffset = device->AllocateConstantBufferDescriptor(m_graphicsConstants.cbv0, m_graphicsConstants.cbv1, m_graphicsConstants.cbv2);
+
+        uint32_t page;
+        VkDeviceSize cbvDescriptorOffset;
+        if (!device->AllocateConstantBufferDescriptor(m_constantBufferAllocator, m_graphicsConstants.cbv0, m_graphicsConstants.cbv1, m_graphicsConstants.cbv2, &page, &cbvDescriptorOffset))
+        {
+            return;
+        }
+
+        if (page != m_constantBufferPage)
+        {
+            BindDescriptorBuffers(page);
+        }
 
         uint32_t bufferIndices[] = { 0 };
         VkDeviceSize offsets[] = { cbvDescriptorOffset };
@@ -813,7 +897,18 @@ void VulkanCommandList::UpdateComputeDescriptorBuffer()
     if (m_computeConstants.dirty)
     {
         VulkanDevice* device = (VulkanDevice*)m_pDevice;
-        VkDeviceSize cbvDescriptorOffset = device->AllocateConstantBufferDescriptor(m_computeConstants.cbv0, m_computeConstants.cbv1, m_computeConstants.cbv2);
+
+        uint32_t page;
+        VkDeviceSize cbvDescriptorOffset;
+        if (!device->AllocateConstantBufferDescriptor(m_constantBufferAllocator, m_computeConstants.cbv0, m_computeConstants.cbv1, m_computeConstants.cbv2, &page, &cbvDescriptorOffset))
+        {
+            return;
+        }
+
+        if (page != m_constantBufferPage)
+        {
+            BindDescriptorBuffers(page);
+        }
 
         uint32_t bufferIndices[] = { 0 };
         VkDeviceSize offsets[] = { cbvDescriptorOffset };
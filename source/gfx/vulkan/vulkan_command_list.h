@@ -2,6 +2,7 @@
 
 #include "vulkan_header.h"
 #include "../gfx_command_list.h"
+#include "../gfx_constant_buffer_allocator.h"
 
 class VulkanDevice;
 
@@ -42,6 +43,10 @@ public:
     virtual void WriteBuffer(IGfxBuffer* buffer, uint32_t offset, uint32_t data) override;
     virtual void UpdateTileMappings(IGfxTexture* texture, IGfxHeap* heap, uint32_t mapping_count, const GfxTileMapping* mappings) override;
 
+    virtual void ResetQueries(IGfxQueryHeap* heap, uint32_t first, uint32_t count) override;
+    virtual void WriteTimestamp(IGfxQueryHeap* heap, uint32_t index) override;
+    virtual void ResolveQueries(IGfxQueryHeap* heap, uint32_t first, uint32_t count, IGfxBuffer* dst_buffer, uint32_t offset) override;
+
     virtual void TextureBarrier(IGfxTexture* texture, uint32_t sub_resource, GfxAccessFlags access_before, GfxAccessFlags access_after) override;
     virtual void BufferBarrier(IGfxBuffer* buffer, GfxAccessFlags access_before, GfxAccessFlags access_after) override;
     virtual void GlobalBarrier(GfxAccessFlags access_before, GfxAccessFlags access_after) override;
@@ -78,6 +83,7 @@ public:
     virtual void BuildRayTracingTLAS(IGfxRayTracingTLAS* tlas, const GfxRayTracingInstance* instances, uint32_t instance_count) override;
 
 private:
+    void BindDescriptorBuffers(uint32_t constant_buffer_page);
     void UpdateGraphicsDescriptorBuffer();
     void UpdateComputeDescriptorBuffer();
 
@@ -108,6 +114,9 @@ private:
     ConstantData m_graphicsConstants;
     ConstantData m_computeConstants;
 
+    GfxConstantBufferSubAllocator m_constantBufferAllocator;
+    uint32_t m_constantBufferPage = 0; //page of the constant buffer allocator bound as descriptor buffer 0
+
     tracy::VkCtx* m_pTracyQueueCtx = nullptr;
     eastl::vector<tracy::VkCtxScope*> m_tracyZoneScopes;
 };
\ No newline at end of file
@@ -3,13 +3,26 @@
 #include "utils/assert.h"
 #include "utils/math.h"
 
-VulkanConstantBufferAllocator::VulkanConstantBufferAllocator(VulkanDevice* device, uint32_t buffer_size)
+VulkanConstantBufferAllocator::VulkanConstantBufferAllocator(VulkanDevice* device, uint32_t buffer_size) :
+    GfxConstantBufferAllocator(buffer_size, 64 * 1024, 256)
 {
     m_device = device;
-    m_bufferSize = buffer_size;
 
+    AddPages(1);
+}
+
+VulkanConstantBufferAllocator::~VulkanConstantBufferAllocator()
+{
+    for (uint32_t i = 0; i < GetPageCount(); ++i)
+    {
+        vmaDestroyBuffer(m_device->GetVmaAllocator(), m_buffers[i], m_allocations[i]);
+    }
+}
+
+bool VulkanConstantBufferAllocator::CreatePage(uint32_t index, Page& page)
+{
     VkBufferCreateInfo createInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
-    createInfo.size = buffer_size;
+    createInfo.size = m_pageSize;
     createInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | 
         VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT | 
         VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
@@ -19,31 +32,16 @@ VulkanConstantBufferAllocator::VulkanConstantBufferAllocator(VulkanDevice* devic
     allocationCreateInfo.flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
 
     VmaAllocationInfo allocationInfo;
-    vmaCreateBuffer(device->GetVmaAllocator(), &createInfo, &allocationCreateInfo, &m_buffer, &m_allocation, &allocationInfo);
+    if (vmaCreateBuffer(m_device->GetVmaAllocator(), &createInfo, &allocationCreateInfo, &m_buffers[index], &m_allocations[index], &allocationInfo) != VK_SUCCESS)
+    {
+        return false;
+    }
 
-    m_cpuAddress = allocationInfo.pMappedData;
+    page.cpu_address = allocationInfo.pMappedData;
 
     VkBufferDeviceAddressInfo info = { VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO };
-    info.buffer = m_buffer;
-    m_gpuAddress = vkGetBufferDeviceAddress((VkDevice)device->GetHandle(), &info);
-}
-
-VulkanConstantBufferAllocator::~VulkanConstantBufferAllocator()
-{
-    vmaDestroyBuffer(m_device->GetVmaAllocator(), m_buffer, m_allocation);
-}
-
-void VulkanConstantBufferAllocator::Allocate(uint32_t size, void** cpu_address, VkDeviceAddress* gpu_address)
-{
-    RE_ASSERT(m_allocatedSize + size <= m_bufferSize);
+    info.buffer = m_buffers[index];
+    page.gpu_address = vkGetBufferDeviceAddress((VkDevice)m_device->GetHandle(), &info);
 
-    *cpu_address = (char*)m_cpuAddress + m_allocatedSize;
-    *gpu_address = m_gpuAddress + m_allocatedSize;
-
-    m_allocatedSize += RoundUpPow2(size, 256);
-}
-
-void VulkanConstantBufferAllocator::Reset()
-{
-    m_allocatedSize = 0;
+    return true;
 }
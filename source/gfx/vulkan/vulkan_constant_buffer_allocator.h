@@ -1,25 +1,21 @@
 #pragma once
 
 #include "vulkan_header.h"
+#include "../gfx_constant_buffer_allocator.h"
 
 class VulkanDevice;
 
-class VulkanConstantBufferAllocator
+class VulkanConstantBufferAllocator : public GfxConstantBufferAllocator
 {
 public:
     VulkanConstantBufferAllocator(VulkanDevice* device, uint32_t buffer_size);
     ~VulkanConstantBufferAllocator();
-    
-    void Allocate(uint32_t size, void** cpu_address, VkDeviceAddress* gpu_address);
-    void Reset();
-    VkDeviceAddress GetGpuAddress() const { return m_gpuAddress; }
+
+private:
+    virtual bool CreatePage(uint32_t index, Page& page) override;
 
 private:
     VulkanDevice* m_device = nullptr;
-    VkBuffer m_buffer = VK_NULL_HANDLE;
-    VmaAllocation m_allocation = VK_NULL_HANDLE;
-    VkDeviceAddress m_gpuAddress = 0;
-    void* m_cpuAddress = nullptr;
-    uint32_t m_bufferSize = 0;
-    uint32_t m_allocatedSize = 0;
+    VkBuffer m_buffers[MAX_PAGE_COUNT] = {};
+    VmaAllocation m_allocations[MAX_PAGE_COUNT] = {};
 };
\ No newline at end of file
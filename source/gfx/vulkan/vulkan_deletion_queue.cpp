@@ -41,6 +41,7 @@ void VulkanDeletionQueue::Flush(bool force_delete)
     ITERATE_QUEUE(m_swapchainQueue, vkDestroySwapchainKHR);
     ITERATE_QUEUE(m_commandPoolQueue, vkDestroyCommandPool);
     ITERATE_QUEUE(m_asQueue, vkDestroyAccelerationStructureKHR);
+    ITERATE_QUEUE(m_queryPoolQueue, vkDestroyQueryPool);
 
     while (!m_surfaceQueue.empty())
     {
@@ -171,4 +172,10 @@ template<>
 void VulkanDeletionQueue::Delete(VkAccelerationStructureKHR object, uint64_t frameID)
 {
     m_asQueue.push(eastl::make_pair(object, frameID));
+}
+
+template<>
+void VulkanDeletionQueue::Delete(VkQueryPool object, uint64_t frameID)
+{
+    m_queryPoolQueue.push(eastl::make_pair(object, frameID));
 }
\ No newline at end of file
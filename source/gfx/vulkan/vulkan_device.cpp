@@ -8,10 +8,12 @@
 #include "vulkan_pipeline_state.h"
 #include "vulkan_descriptor.h"
 #include "vulkan_heap.h"
+#include "vulkan_query_heap.h"
 #include "vulkan_rt_blas.h"
 #include "vulkan_rt_tlas.h"
 #include "vulkan_descriptor_allocator.h"
 #include "vulkan_constant_buffer_allocator.h"
+#include "vulkan_pipeline_cache.h"
 #include "utils/log.h"
 #include "utils/assert.h"
 #include "utils/string.h"
@@ -55,6 +57,12 @@ VulkanDevice::~VulkanDevice()
     delete m_resourceDescriptorAllocator;
     delete m_samplerDescriptorAllocator;
 
+    if (m_pipelineCache)
+    {
+        m_pipelineCache->Save();
+        delete m_pipelineCache;
+    }
+
     if (m_pTracyGraphicsQueueCtx)
     {
         TracyVkDestroy(m_pTracyGraphicsQueueCtx);
@@ -89,6 +97,9 @@ bool VulkanDevice::Create()
 
     m_deferredDeletionQueue = new VulkanDeletionQueue(this);
 
+    m_pipelineCache = new VulkanPipelineCache(this, m_desc.pipeline_cache_path);
+    m_pipelineCache->Create();
+
     for (size_t i = 0; i < GFX_MAX_INFLIGHT_FRAMES; ++i)
     {
         m_transitionCopyCommandList[i] = CreateCommandList(GfxCommandQueue::Copy, "Transition CommandList(Copy)");
@@ -180,6 +191,17 @@ IGfxHeap* VulkanDevice::CreateHeap(const GfxHeapDesc& desc, const eastl::string&
     return heap;
 }
 
+IGfxQueryHeap* VulkanDevice::CreateQueryHeap(const GfxQueryHeapDesc& desc, const eastl::string& name)
+{
+    VulkanQueryHeap* heap = new VulkanQueryHeap(this, desc, name);
+    if (!heap->Create())
+    {
+        delete heap;
+        return nullptr;
+    }
+    return heap;
+}
+
 IGfxBuffer* VulkanDevice::CreateBuffer(const GfxBufferDesc& desc, const eastl::string& name)
 {
     VulkanBuffer* buffer = new VulkanBuffer(this, desc, name);
@@ -205,7 +227,7 @@ IGfxTexture* VulkanDevice::CreateTexture(const GfxTextureDesc& desc, const eastl
 IGfxShader* VulkanDevice::CreateShader(const GfxShaderDesc& desc, eastl::span<uint8_t> data, const eastl::string& name)
 {
     VulkanShader* shader = new VulkanShader(this, desc, name);
-    if (!shader->Create(data))
+    if (!data.empty() && !shader->Create(data))
     {
         delete shader;
         return nullptr;
@@ -216,7 +238,7 @@ IGfxShader* VulkanDevice::CreateShader(const GfxShaderDesc& desc, eastl::span<ui
 IGfxPipelineState* VulkanDevice::CreateGraphicsPipelineState(const GfxGraphicsPipelineDesc& desc, const eastl::string& name)
 {
     VulkanGraphicsPipelineState* pipeline = new VulkanGraphicsPipelineState(this, desc, name);
-    if (!pipeline->Create())
+    if (IsShaderReady(desc) && !pipeline->Create())
     {
         delete pipeline;
         return nullptr;
@@ -227,7 +249,7 @@ IGfxPipelineState* VulkanDevice::CreateGraphicsPipelineState(const GfxGraphicsPi
 IGfxPipelineState* VulkanDevice::CreateMeshShadingPipelineState(const GfxMeshShadingPipelineDesc& desc, const eastl::string& name)
 {
     VulkanMeshShadingPipelineState* pipeline = new VulkanMeshShadingPipelineState(this, desc, name);
-    if (!pipeline->Create())
+    if (IsShaderReady(desc) && !pipeline->Create())
     {
         delete pipeline;
         return nullptr;
@@ -238,7 +260,7 @@ IGfxPipelineState* VulkanDevice::CreateMeshShadingPipelineState(const GfxMeshSha
 IGfxPipelineState* VulkanDevice::CreateComputePipelineState(const GfxComputePipelineDesc& desc, const eastl::string& name)
 {
     VulkanComputePipelineState* pipeline = new VulkanComputePipelineState(this, desc, name);
-    if (!pipeline->Create())
+    if (IsShaderReady(desc) && !pipeline->Create())
     {
         delete pipeline;
         return nullptr;
@@ -340,11 +362,21 @@ uint32_t VulkanDevice::GetAllocationSize(const GfxTextureDesc& desc)
     return (uint32_t)requirements.memoryRequirements.size;
 }
 
+uint64_t VulkanDevice::GetTimestampFrequency()
+{
+    return (uint64_t)(1000000000.0 / m_timestampPeriod);
+}
+
 bool VulkanDevice::DumpMemoryStats(const eastl::string& file)
 {
     return false;
 }
 
+void VulkanDevice::LogPipelineCacheStats()
+{
+    m_pipelineCache->LogStats();
+}
+
 VkResult VulkanDevice::CreateInstance()
 {
     uint32_t layer_count;
@@ -469,6 +501,7 @@ VkResult VulkanDevice::CreateDevice()
 
     VkPhysicalDeviceProperties physicalDeviceProperties;
     vkGetPhysicalDeviceProperties(m_physicalDevice, &physicalDeviceProperties);
+    m_timestampPeriod = physicalDeviceProperties.limits.timestampPeriod;
 
     RE_INFO("GPU : {}", physicalDeviceProperties.deviceName);
     RE_INFO("API version : {}.{}.{}", VK_API_VERSION_MAJOR(physicalDeviceProperties.apiVersion), 
@@ -1029,23 +1062,30 @@ VulkanConstantBufferAllocator* VulkanDevice::GetConstantBufferAllocator() const
     return m_constantBufferAllocators[index];
 }
 
-VkDeviceAddress VulkanDevice::AllocateConstantBuffer(const void* data, size_t data_size)
+VkDeviceAddress VulkanDevice::AllocateConstantBuffer(GfxConstantBufferSubAllocator& allocator, const void* data, size_t data_size)
 {
     void* cpuAddress;
     VkDeviceAddress gpuAddress;
-    GetConstantBufferAllocator()->Allocate((uint32_t)data_size, &cpuAddress, &gpuAddress);
+    if (!allocator.Allocate(GetConstantBufferAllocator(), (uint32_t)data_size, &cpuAddress, &gpuAddress))
+    {
+        return 0;
+    }
 
     memcpy(cpuAddress, data, data_size);
 
     return gpuAddress;
 }
 
-VkDeviceSize VulkanDevice::AllocateConstantBufferDescriptor(const uint32_t* cbv0, const VkDescriptorAddressInfoEXT& cbv1, const VkDescriptorAddressInfoEXT& cbv2)
+bool VulkanDevice::AllocateConstantBufferDescriptor(GfxConstantBufferSubAllocator& allocator, const uint32_t* cbv0, const VkDescriptorAddressInfoEXT& cbv1, const VkDescriptorAddressInfoEXT& cbv2,
+    uint32_t* page, VkDeviceSize* offset)
 {
     size_t descriptorBufferSize = sizeof(uint32_t) * GFX_MAX_ROOT_CONSTANTS + m_descriptorBufferProperties.robustUniformBufferDescriptorSize * 2;
     void* cpuAddress;
     VkDeviceAddress gpuAddress;
-    GetConstantBufferAllocator()->Allocate((uint32_t)descriptorBufferSize, &cpuAddress, &gpuAddress);
+    if (!allocator.Allocate(GetConstantBufferAllocator(), (uint32_t)descriptorBufferSize, &cpuAddress, &gpuAddress, page))
+    {
+        return false;
+    }
 
     memcpy(cpuAddress, cbv0, sizeof(uint32_t) * GFX_MAX_ROOT_CONSTANTS);
 
@@ -1066,6 +1106,6 @@ VkDeviceSize VulkanDevice::AllocateConstantBufferDescriptor(const uint32_t* cbv0
             (char*)cpuAddress + sizeof(uint32_t) * GFX_MAX_ROOT_CONSTANTS + m_descriptorBufferProperties.robustUniformBufferDescriptorSize);
     }
 
-    VkDeviceSize descriptorBufferOffset = gpuAddress - GetConstantBufferAllocator()->GetGpuAddress();
-    return descriptorBufferOffset;
+    *offset = gpuAddress - GetConstantBufferAllocator()->GetPage(*page).gpu_address;
+    return true;
 }
@@ -3,6 +3,7 @@
 #include "vulkan_header.h"
 #include "vulkan_deletion_queue.h"
 #include "../gfx_device.h"
+#include "../gfx_constant_buffer_allocator.h"
 #include "EASTL/hash_map.h"
 #include "xxHash/xxhash.h"
 
@@ -38,6 +39,7 @@ public:
     virtual IGfxCommandList* CreateCommandList(GfxCommandQueue queue_type, const eastl::string& name) override;
     virtual IGfxFence* CreateFence(const eastl::string& name) override;
     virtual IGfxHeap* CreateHeap(const GfxHeapDesc& desc, const eastl::string& name) override;
+    virtual IGfxQueryHeap* CreateQueryHeap(const GfxQueryHeapDesc& desc, const eastl::string& name) override;
     virtual IGfxBuffer* CreateBuffer(const GfxBufferDesc& desc, const eastl::string& name) override;
     virtual IGfxTexture* CreateTexture(const GfxTextureDesc& desc, const eastl::string& name) override;
     virtual IGfxShader* CreateShader(const GfxShaderDesc& desc, eastl::span<uint8_t> data, const eastl::string& name) override;
@@ -52,7 +54,9 @@ public:
     virtual IGfxRayTracingTLAS* CreateRayTracingTLAS(const GfxRayTracingTLASDesc& desc, const eastl::string& name) override;
 
     virtual uint32_t GetAllocationSize(const GfxTextureDesc& desc) override;
+    virtual uint64_t GetTimestampFrequency() override;
     virtual bool DumpMemoryStats(const eastl::string& file) override;
+    virtual void LogPipelineCacheStats() override;
 
     VkInstance GetInstance() const { return m_instance; }
     VkPhysicalDevice GetPhysicalDevice() const { return m_physicalDevice; }
@@ -66,6 +70,7 @@ public:
     VkQueue GetComputeQueue() const { return m_computeQueue; }
     VkQueue GetCopyQueue() const { return m_copyQueue; }
     VkPipelineLayout GetPipelineLayout() const { return m_pipelineLayout; }
+    class VulkanPipelineCache* GetPipelineCache() const { return m_pipelineCache; }
     class VulkanDescriptorAllocator* GetResourceDescriptorAllocator() const { return m_resourceDescriptorAllocator; }
     class VulkanDescriptorAllocator* GetSamplerDescriptorAllocator() const { return m_samplerDescriptorAllocator; }
     class VulkanConstantBufferAllocator* GetConstantBufferAllocator() const;
@@ -76,8 +81,11 @@ public:
     void FreeResourceDescriptor(uint32_t index);
     void FreeSamplerDescriptor(uint32_t index);
 
-    VkDeviceAddress AllocateConstantBuffer(const void* data, size_t data_size);
-    VkDeviceSize AllocateConstantBufferDescriptor(const uint32_t* cbv0, const VkDescriptorAddressInfoEXT& cbv1, const VkDescriptorAddressInfoEXT& cbv2);
+    //both return false/0 when the frame is out of constant buffer memory
+    VkDeviceAddress AllocateConstantBuffer(GfxConstantBufferSubAllocator& allocator, const void* data, size_t data_size);
+    bool AllocateConstantBufferDescriptor(GfxConstantBufferSubAllocator& allocator, const uint32_t* cbv0, const VkDescriptorAddressInfoEXT& cbv1, const VkDescriptorAddressInfoEXT& cbv2,
+        uint32_t* page, VkDeviceSize* offset); //offset in the constant buffer page
+
 
     template<typename T>
     void Delete(T objectHandle);
@@ -120,6 +128,7 @@ private:
     VkQueue m_graphicsQueue = VK_NULL_HANDLE;
     VkQueue m_computeQueue = VK_NULL_HANDLE;
     VkQueue m_copyQueue = VK_NULL_HANDLE;
+    float m_timestampPeriod = 1.0f; //nanoseconds per tick
 
     VulkanDeletionQueue* m_deferredDeletionQueue = nullptr;
     IGfxCommandList* m_transitionCopyCommandList[GFX_MAX_INFLIGHT_FRAMES] = {};
@@ -128,6 +137,7 @@ private:
     class VulkanConstantBufferAllocator* m_constantBufferAllocators[GFX_MAX_INFLIGHT_FRAMES] = {};
     class VulkanDescriptorAllocator* m_resourceDescriptorAllocator = nullptr;
     class VulkanDescriptorAllocator* m_samplerDescriptorAllocator = nullptr;
+    class VulkanPipelineCache* m_pipelineCache = nullptr;
 
     eastl::vector<eastl::pair<IGfxTexture*, GfxAccessFlags>> m_pendingGraphicsTransitions;
     eastl::vector<eastl::pair<IGfxTexture*, GfxAccessFlags>> m_pendingCopyTransitions;
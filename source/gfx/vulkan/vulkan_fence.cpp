@@ -54,3 +54,10 @@ void VulkanFence::Signal(uint64_t value)
 
     vkSignalSemaphore((VkDevice)m_pDevice->GetHandle(), &info);
 }
+
+uint64_t VulkanFence::GetCompletedValue() const
+{
+    uint64_t value = 0;
+    vkGetSemaphoreCounterValue((VkDevice)m_pDevice->GetHandle(), m_semaphore, &value);
+    return value;
+}
@@ -16,6 +16,7 @@ public:
     virtual void* GetHandle() const override { return m_semaphore; }
     virtual void Wait(uint64_t value) override;
     virtual void Signal(uint64_t value) override;
+    virtual uint64_t GetCompletedValue() const override;
 
 private:
     VkSemaphore m_semaphore = VK_NULL_HANDLE;
@@ -0,0 +1,182 @@
+#include "vulkan_pipeline_cache.h"
+#include "vulkan_device.h"
+#include "utils/log.h"
+#include "utils/memory_mapped_file.h"
+#include "sokol/sokol_time.h"
+#include <filesystem>
+#include <fstream>
+
+VulkanPipelineCache::VulkanPipelineCache(VulkanDevice* device, const eastl::string& path)
+{
+    m_pDevice = device;
+
+    if (!path.empty())
+    {
+        m_file = path + "vulkan_pipeline_cache.bin";
+    }
+}
+
+VulkanPipelineCache::~VulkanPipelineCache()
+{
+    vkDestroyPipelineCache(m_pDevice->GetDevice(), m_cache, nullptr);
+}
+
+bool VulkanPipelineCache::Create()
+{
+    MemoryMappedFile file;
+    if (!m_file.empty() && file.Open(m_file) && !IsCompatible(file.GetData(), file.GetSize()))
+    {
+        RE_INFO("[VulkanPipelineCache] {} was created by a different driver or device, discarded", m_file);
+        file.Close();
+    }
+
+    VkPipelineCacheCreateInfo createInfo = { VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
+    createInfo.initialDataSize = file.GetSize();
+    createInfo.pInitialData = file.GetData();
+
+    VkResult result = vkCreatePipelineCache(m_pDevice->GetDevice(), &createInfo, nullptr, &m_cache);
+    if (result != VK_SUCCESS && file.IsOpen())
+    {
+        //the driver may still reject the blob, start with an empty cache then
+        createInfo.initialDataSize = 0;
+        createInfo.pInitialData = nullptr;
+        result = vkCreatePipelineCache(m_pDevice->GetDevice(), &createInfo, nullptr, &m_cache);
+    }
+
+    if (result != VK_SUCCESS)
+    {
+        RE_WARN("[VulkanPipelineCache] failed to create the pipeline cache");
+        m_cache = VK_NULL_HANDLE;
+        return false;
+    }
+
+    RE_INFO("[VulkanPipelineCache] loaded {:.2f} KB from {}", file.GetSize() / 1024.0, m_file);
+    return true;
+}
+
+void VulkanPipelineCache::Save()
+{
+    if (m_cache == VK_NULL_HANDLE || m_file.empty())
+    {
+        return;
+    }
+
+    VkDevice device = m_pDevice->GetDevice();
+
+    size_t size = 0;
+    if (vkGetPipelineCacheData(device, m_cache, &size, nullptr) != VK_SUCCESS || size == 0)
+    {
+        return;
+    }
+
+    eastl::vector<uint8_t> data(size);
+    if (vkGetPipelineCacheData(device, m_cache, &size, data.data()) != VK_SUCCESS)
+    {
+        return;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(m_file.c_str()).parent_path(), error);
+
+    std::ofstream os;
+    os.open(m_file.c_str(), std::ios::binary);
+    if (os.fail())
+    {
+        RE_WARN("[VulkanPipelineCache] failed to write {}", m_file);
+        return;
+    }
+
+    os.write((const char*)data.data(), size);
+
+    RE_INFO("[VulkanPipelineCache] saved {:.2f} KB to {}", size / 1024.0, m_file);
+}
+
+void VulkanPipelineCache::LogStats() const
+{
+    uint32_t hits = m_nHits.load();
+    uint32_t misses = m_nMisses.load();
+    uint32_t total = hits + misses;
+
+    RE_INFO("[VulkanPipelineCache] hits : {}, misses : {}, hit rate : {:.1f}%, PSO creation time : {:.2f} ms (avg {:.3f} ms)",
+        hits, misses, total > 0 ? 100.0 * hits / total : 0.0,
+        m_nCreationTime.load() / 1000000.0, total > 0 ? m_nCreationTime.load() / 1000000.0 / total : 0.0);
+}
+
+VkResult VulkanPipelineCache::CreateGraphicsPipeline(VkGraphicsPipelineCreateInfo& create_info, VkPipeline* pipeline)
+{
+    VkPipelineCreationFeedback feedback = {};
+    VkPipelineCreationFeedbackCreateInfo feedbackInfo = { VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO };
+    feedbackInfo.pNext = create_info.pNext;
+    feedbackInfo.pPipelineCreationFeedback = &feedback;
+    create_info.pNext = &feedbackInfo;
+
+    uint64_t ticks = stm_now();
+    VkResult result = vkCreateGraphicsPipelines(m_pDevice->GetDevice(), m_cache, 1, &create_info, nullptr, pipeline);
+    UpdateStats(result, feedback, stm_since(ticks));
+
+    create_info.pNext = feedbackInfo.pNext;
+    return result;
+}
+
+VkResult VulkanPipelineCache::CreateComputePipeline(VkComputePipelineCreateInfo& create_info, VkPipeline* pipeline)
+{
+    VkPipelineCreationFeedback feedback = {};
+    VkPipelineCreationFeedbackCreateInfo feedbackInfo = { VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO };
+    feedbackInfo.pNext = create_info.pNext;
+    feedbackInfo.pPipelineCreationFeedback = &feedback;
+    create_info.pNext = &feedbackInfo;
+
+    uint64_t ticks = stm_now();
+    VkResult result = vkCreateComputePipelines(m_pDevice->GetDevice(), m_cache, 1, &create_info, nullptr, pipeline);
+    UpdateStats(result, feedback, stm_since(ticks));
+
+    create_info.pNext = feedbackInfo.pNext;
+    return result;
+}
+
+bool VulkanPipelineCache::IsCompatible(const void* data, size_t size) const
+{
+    if (size < sizeof(VkPipelineCacheHeaderVersionOne))
+    {
+        return false;
+    }
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(m_pDevice->GetPhysicalDevice(), &properties);
+
+    VkPipelineCacheHeaderVersionOne header;
+    memcpy(&header, data, sizeof(header));
+
+    return header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+        header.vendorID == properties.vendorID &&
+        header.deviceID == properties.deviceID &&
+        memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+void VulkanPipelineCache::UpdateStats(VkResult result, const VkPipelineCreationFeedback& feedback, uint64_t ticks)
+{
+    if (result != VK_SUCCESS)
+    {
+        return;
+    }
+
+    //the feedback is optional, drivers may leave it invalid
+    if (feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT)
+    {
+        if (feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT)
+        {
+            m_nHits++;
+        }
+        else
+        {
+            m_nMisses++;
+        }
+
+        m_nCreationTime += feedback.duration;
+    }
+    else
+    {
+        m_nMisses++;
+        m_nCreationTime += (uint64_t)stm_ns(ticks);
+    }
+}
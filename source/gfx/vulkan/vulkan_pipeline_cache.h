@@ -0,0 +1,35 @@
+#pragma once
+
+#include "vulkan_header.h"
+#include "EASTL/string.h"
+#include "EASTL/atomic.h"
+
+class VulkanDevice;
+
+// device-level VkPipelineCache shared by all PSO creation, persisted between runs
+class VulkanPipelineCache
+{
+public:
+    VulkanPipelineCache(VulkanDevice* device, const eastl::string& path);
+    ~VulkanPipelineCache();
+
+    bool Create();
+    void Save();
+    void LogStats() const;
+
+    VkResult CreateGraphicsPipeline(VkGraphicsPipelineCreateInfo& create_info, VkPipeline* pipeline);
+    VkResult CreateComputePipeline(VkComputePipelineCreateInfo& create_info, VkPipeline* pipeline);
+
+private:
+    bool IsCompatible(const void* data, size_t size) const;
+    void UpdateStats(VkResult result, const VkPipelineCreationFeedback& feedback, uint64_t ticks);
+
+private:
+    VulkanDevice* m_pDevice = nullptr;
+    VkPipelineCache m_cache = VK_NULL_HANDLE;
+    eastl::string m_file;
+
+    eastl::atomic<uint32_t> m_nHits{ 0 };
+    eastl::atomic<uint32_t> m_nMisses{ 0 };
+    eastl::atomic<uint64_t> m_nCreationTime{ 0 }; //in ns
+};
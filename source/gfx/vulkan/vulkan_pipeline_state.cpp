@@ -1,6 +1,7 @@
 #include "vulkan_pipeline_state.h"
 #include "vulkan_device.h"
 #include "vulkan_shader.h"
+#include "vulkan_pipeline_cache.h"
 #include "utils/log.h"
 
 VulkanGraphicsPipelineState::VulkanGraphicsPipelineState(VulkanDevice* pDevice, const GfxGraphicsPipelineDesc& desc, const eastl::string& name)
@@ -82,7 +83,7 @@ bool VulkanGraphicsPipelineState::Create()
     createInfo.layout = ((VulkanDevice*)m_pDevice)->GetPipelineLayout();
 
     VkDevice device = (VkDevice)m_pDevice->GetHandle();
-    VkResult result = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &createInfo, nullptr, &m_pipeline);
+    VkResult result = ((VulkanDevice*)m_pDevice)->GetPipelineCache()->CreateGraphicsPipeline(createInfo, &m_pipeline);
     if (result != VK_SUCCESS)
     {
         RE_ERROR("[VulkanGraphicsPipelineState] failed to create {}", m_name);
@@ -91,6 +92,7 @@ bool VulkanGraphicsPipelineState::Create()
 
     SetDebugName(device, VK_OBJECT_TYPE_PIPELINE, m_pipeline, m_name.c_str());
 
+    m_bReady = true;
     return true;
 }
 
@@ -178,7 +180,7 @@ bool VulkanMeshShadingPipelineState::Create()
     createInfo.layout = ((VulkanDevice*)m_pDevice)->GetPipelineLayout();
 
     VkDevice device = (VkDevice)m_pDevice->GetHandle();
-    VkResult result = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &createInfo, nullptr, &m_pipeline);
+    VkResult result = ((VulkanDevice*)m_pDevice)->GetPipelineCache()->CreateGraphicsPipeline(createInfo, &m_pipeline);
     if (result != VK_SUCCESS)
     {
         RE_ERROR("[VulkanMeshShadingPipelineState] failed to create {}", m_name);
@@ -187,6 +189,7 @@ bool VulkanMeshShadingPipelineState::Create()
 
     SetDebugName(device, VK_OBJECT_TYPE_PIPELINE, m_pipeline, m_name.c_str());
 
+    m_bReady = true;
     return true;
 }
 
@@ -216,7 +219,7 @@ bool VulkanComputePipelineState::Create()
     createInfo.layout = ((VulkanDevice*)m_pDevice)->GetPipelineLayout();
 
     VkDevice device = ((VulkanDevice*)m_pDevice)->GetDevice();
-    VkResult result = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &createInfo, nullptr, &m_pipeline);
+    VkResult result = ((VulkanDevice*)m_pDevice)->GetPipelineCache()->CreateComputePipeline(createInfo, &m_pipeline);
     if (result != VK_SUCCESS)
     {
         RE_ERROR("[VulkanComputePipelineState] failed to create {}", m_name);
@@ -225,5 +228,6 @@ bool VulkanComputePipelineState::Create()
 
     SetDebugName(device, VK_OBJECT_TYPE_PIPELINE, m_pipeline, m_name.c_str());
 
+    m_bReady = true;
     return true;
 }
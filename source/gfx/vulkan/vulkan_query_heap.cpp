@@ -0,0 +1,34 @@
+#include "vulkan_query_heap.h"
+#include "vulkan_device.h"
+#include "utils/log.h"
+
+VulkanQueryHeap::VulkanQueryHeap(VulkanDevice* pDevice, const GfxQueryHeapDesc& desc, const eastl::string& name)
+{
+    m_pDevice = pDevice;
+    m_desc = desc;
+    m_name = name;
+}
+
+VulkanQueryHeap::~VulkanQueryHeap()
+{
+    ((VulkanDevice*)m_pDevice)->Delete(m_queryPool);
+}
+
+bool VulkanQueryHeap::Create()
+{
+    VkQueryPoolCreateInfo createInfo = { VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO };
+    createInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    createInfo.queryCount = m_desc.count;
+
+    VkDevice device = (VkDevice)m_pDevice->GetHandle();
+    VkResult result = vkCreateQueryPool(device, &createInfo, nullptr, &m_queryPool);
+    if (result != VK_SUCCESS)
+    {
+        RE_ERROR("[VulkanQueryHeap] failed to create {}", m_name);
+        return false;
+    }
+
+    SetDebugName(device, VK_OBJECT_TYPE_QUERY_POOL, m_queryPool, m_name.c_str());
+
+    return true;
+}
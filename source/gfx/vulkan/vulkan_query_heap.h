@@ -0,0 +1,20 @@
+#pragma once
+
+#include "vulkan_header.h"
+#include "../gfx_query_heap.h"
+
+class VulkanDevice;
+
+class VulkanQueryHeap : public IGfxQueryHeap
+{
+public:
+    VulkanQueryHeap(VulkanDevice* pDevice, const GfxQueryHeapDesc& desc, const eastl::string& name);
+    ~VulkanQueryHeap();
+
+    bool Create();
+
+    virtual void* GetHandle() const override { return m_queryPool; }
+
+private:
+    VkQueryPool m_queryPool = VK_NULL_HANDLE;
+};
\ No newline at end of file
@@ -36,5 +36,6 @@ bool VulkanShader::Create(eastl::span<uint8_t> data)
 
     m_hash = XXH3_64bits(data.data(), data.size());
 
+    m_bReady = true;
     return true;
 }
@@ -29,3 +29,24 @@ bool JoltObjectLayerPairFilter::ShouldCollide(JPH::ObjectLayer inLayer1, JPH::Ob
         return false;
     }
 }
+
+bool JoltQueryObjectLayerFilter::ShouldCollide(JPH::ObjectLayer inLayer) const
+{
+    return (m_layerMask & (1u << inLayer)) != 0;
+}
+
+JoltQueryBroadPhaseLayerFilter::JoltQueryBroadPhaseLayerFilter(const JPH::BroadPhaseLayerInterface& layerInterface, uint32_t layer_mask)
+{
+    for (uint16_t layer = 0; layer < PhysicsLayers::NUM; ++layer)
+    {
+        if (layer_mask & (1u << layer))
+        {
+            m_broadPhaseLayerMask |= 1u << (uint8_t)layerInterface.GetBroadPhaseLayer(layer);
+        }
+    }
+}
+
+bool JoltQueryBroadPhaseLayerFilter::ShouldCollide(JPH::BroadPhaseLayer inLayer) const
+{
+    return (m_broadPhaseLayerMask & (1u << (uint8_t)inLayer)) != 0;
+}
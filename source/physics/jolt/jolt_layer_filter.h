@@ -14,4 +14,27 @@ class JoltObjectLayerPairFilter : public JPH::ObjectLayerPairFilter
 {
 public:
     virtual bool ShouldCollide(JPH::ObjectLayer inLayer1, JPH::ObjectLayer inLayer2) const override;
+};
+
+//filters of the queries, accept the layers in the mask of a PhysicsQueryFilter
+class JoltQueryObjectLayerFilter : public JPH::ObjectLayerFilter
+{
+public:
+    JoltQueryObjectLayerFilter(uint32_t layer_mask) : m_layerMask(layer_mask) {}
+
+    virtual bool ShouldCollide(JPH::ObjectLayer inLayer) const override;
+
+private:
+    uint32_t m_layerMask;
+};
+
+class JoltQueryBroadPhaseLayerFilter : public JPH::BroadPhaseLayerFilter
+{
+public:
+    JoltQueryBroadPhaseLayerFilter(const JPH::BroadPhaseLayerInterface& layerInterface, uint32_t layer_mask);
+
+    virtual bool ShouldCollide(JPH::BroadPhaseLayer inLayer) const override;
+
+private:
+    uint32_t m_broadPhaseLayerMask = 0;
 };
\ No newline at end of file
@@ -1,18 +1,55 @@
 #include "jolt_rigid_body.h"
 #include "jolt_shape.h"
+#include "jolt_system.h"
 #include "jolt_utils.h"
 #include "Jolt/Physics/Body/BodyCreationSettings.h"
 #include "Jolt/Physics/Body/Body.h"
 #include "Jolt/Physics/Collision/Shape/ScaledShape.h"
 
-JoltRigidBody::JoltRigidBody(JPH::BodyInterface& bodyInterface) : 
+JoltRigidBody::JoltRigidBody(JoltSystem* system, JPH::BodyInterface& bodyInterface) : 
+    m_pSystem(system),
     m_bodyInterface(bodyInterface)
 {
 }
 
 JoltRigidBody::~JoltRigidBody()
 {
-    m_bodyInterface.DestroyBody(m_bodyID);
+    if (m_nSystemIndex != UINT32_MAX)
+    {
+        m_pSystem->RemoveRigidBody(this);
+    }
+
+    GetBodyInterface().DestroyBody(m_bodyID);
+}
+
+JPH::BodyInterface& JoltRigidBody::GetBodyInterface() const
+{
+    m_pSystem->WaitForStep();
+    return m_bodyInterface;
+}
+
+void JoltRigidBody::SetState(const float3& position, const quaternion& rotation)
+{
+    SetState(position);
+    SetState(rotation);
+}
+
+void JoltRigidBody::SetState(const float3& position)
+{
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+        m_states[i].prevPosition = position;
+        m_states[i].position = position;
+    }
+}
+
+void JoltRigidBody::SetState(const quaternion& rotation)
+{
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+        m_states[i].prevRotation = rotation;
+        m_states[i].rotation = rotation;
+    }
 }
 
 bool JoltRigidBody::Create(const IPhysicsShape* shape, PhysicsMotion motion_type, uint16_t layer, void* user_data)
@@ -25,71 +62,75 @@ bool JoltRigidBody::Create(const IPhysicsShape* shape, PhysicsMotion motion_type
     settings.mObjectLayer = ToJolt(layer);
     settings.mUserData = (JPH::uint64)user_data;
 
-    JPH::Body* body = m_bodyInterface.CreateBody(settings);
+    JPH::Body* body = GetBodyInterface().CreateBody(settings);
     if (body == nullptr)
     {
         return false;
     }
 
     m_bodyID = body->GetID();
+    SetState(FromJolt(body->GetPosition()), FromJolt(body->GetRotation()));
+
     return true;
 }
 
 void JoltRigidBody::AddToPhysicsSystem(bool activate)
 {
-    m_bodyInterface.AddBody(m_bodyID, activate ? JPH::EActivation::Activate : JPH::EActivation::DontActivate);
+    GetBodyInterface().AddBody(m_bodyID, activate ? JPH::EActivation::Activate : JPH::EActivation::DontActivate);
+    m_pSystem->AddRigidBody(this);
 }
 
 void JoltRigidBody::RemoveFromPhysicsSystem()
 {
-    m_bodyInterface.RemoveBody(m_bodyID);
+    GetBodyInterface().RemoveBody(m_bodyID);
+    m_pSystem->RemoveRigidBody(this);
 }
 
 void JoltRigidBody::Activate()
 {
-    m_bodyInterface.ActivateBody(m_bodyID);
+    GetBodyInterface().ActivateBody(m_bodyID);
 }
 
 void JoltRigidBody::Deactivate()
 {
-    m_bodyInterface.DeactivateBody(m_bodyID);
+    GetBodyInterface().DeactivateBody(m_bodyID);
 }
 
 bool JoltRigidBody::IsActive() const
 {
-    return m_bodyInterface.IsActive(m_bodyID);
+    return GetBodyInterface().IsActive(m_bodyID);
 }
 
 void JoltRigidBody::SetShape(IPhysicsShape* shape)
 {
     m_shape = ((const JoltShape*)shape)->GetShape();
 
-    m_bodyInterface.SetShape(m_bodyID, m_shape, true, JPH::EActivation::DontActivate);
+    GetBodyInterface().SetShape(m_bodyID, m_shape, true, JPH::EActivation::DontActivate);
 }
 
 uint16_t JoltRigidBody::GetLayer() const
 {
-    return m_bodyInterface.GetObjectLayer(m_bodyID);
+    return GetBodyInterface().GetObjectLayer(m_bodyID);
 }
 
 void JoltRigidBody::SetLayer(uint16_t layer)
 {
-    m_bodyInterface.SetObjectLayer(m_bodyID, layer);
+    GetBodyInterface().SetObjectLayer(m_bodyID, layer);
 }
 
 void* JoltRigidBody::GetUserData() const
 {
-    return (void*)m_bodyInterface.GetUserData(m_bodyID);
+    return (void*)GetBodyInterface().GetUserData(m_bodyID);
 }
 
 PhysicsMotion JoltRigidBody::GetMotionType() const
 {
-    return FromJolt(m_bodyInterface.GetMotionType(m_bodyID));
+    return FromJolt(GetBodyInterface().GetMotionType(m_bodyID));
 }
 
 void JoltRigidBody::SetMotionType(PhysicsMotion motion_type)
 {
-    m_bodyInterface.SetMotionType(m_bodyID, ToJolt(motion_type), JPH::EActivation::DontActivate);
+    GetBodyInterface().SetMotionType(m_bodyID, ToJolt(motion_type), JPH::EActivation::DontActivate);
 }
 
 float3 JoltRigidBody::GetScale() const
@@ -107,81 +148,94 @@ void JoltRigidBody::SetScale(const float3& scale)
 
         if (m_scale == float3(1.0f, 1.0f, 1.0f))
         {
-            m_bodyInterface.SetShape(m_bodyID, m_shape, true, JPH::EActivation::DontActivate);
+            GetBodyInterface().SetShape(m_bodyID, m_shape, true, JPH::EActivation::DontActivate);
         }
         else
         {
-            m_bodyInterface.SetShape(m_bodyID, new JPH::ScaledShape(m_shape, ToJolt(m_scale)), true, JPH::EActivation::DontActivate);
+            GetBodyInterface().SetShape(m_bodyID, new JPH::ScaledShape(m_shape, ToJolt(m_scale)), true, JPH::EActivation::DontActivate);
         }
     }
 }
 
 float3 JoltRigidBody::GetPosition() const
 {
-    return FromJolt(m_bodyInterface.GetPosition(m_bodyID));
+    return m_states[m_pSystem->GetPublishedState()].position;
 }
 
 void JoltRigidBody::SetPosition(const float3& position)
 {
-    m_bodyInterface.SetPosition(m_bodyID, ToJolt(position), JPH::EActivation::DontActivate);
+    GetBodyInterface().SetPosition(m_bodyID, ToJolt(position), JPH::EActivation::DontActivate);
+    SetState(position);
 }
 
 quaternion JoltRigidBody::GetRotation() const
 {
-    return FromJolt(m_bodyInterface.GetRotation(m_bodyID));
+    return m_states[m_pSystem->GetPublishedState()].rotation;
 }
 
 void JoltRigidBody::SetRotation(const quaternion& rotation)
 {
-    m_bodyInterface.SetRotation(m_bodyID, ToJolt(rotation), JPH::EActivation::DontActivate);
+    GetBodyInterface().SetRotation(m_bodyID, ToJolt(rotation), JPH::EActivation::DontActivate);
+    SetState(rotation);
 }
 
 void JoltRigidBody::SetPositionAndRotation(const float3& position, const quaternion& rotation)
 {
-    m_bodyInterface.SetPositionAndRotation(m_bodyID, ToJolt(position), ToJolt(rotation), JPH::EActivation::DontActivate);
+    GetBodyInterface().SetPositionAndRotation(m_bodyID, ToJolt(position), ToJolt(rotation), JPH::EActivation::DontActivate);
+    SetState(position, rotation);
+}
+
+float3 JoltRigidBody::GetPrevPosition() const
+{
+    return m_states[m_pSystem->GetPublishedState()].prevPosition;
+}
+
+quaternion JoltRigidBody::GetPrevRotation() const
+{
+    return m_states[m_pSystem->GetPublishedState()].prevRotation;
 }
 
 float3 JoltRigidBody::GetLinearVelocity() const
 {
-    return FromJolt(m_bodyInterface.GetLinearVelocity(m_bodyID));
+    return FromJolt(GetBodyInterface().GetLinearVelocity(m_bodyID));
 }
 
 void JoltRigidBody::SetLinearVelocity(const float3& velocity)
 {
-    m_bodyInterface.SetLinearVelocity(m_bodyID, ToJolt(velocity));
+    GetBodyInterface().SetLinearVelocity(m_bodyID, ToJolt(velocity));
 }
 
 float3 JoltRigidBody::GetAngularVelocity() const
 {
-    return FromJolt(m_bodyInterface.GetAngularVelocity(m_bodyID));
+    return FromJolt(GetBodyInterface().GetAngularVelocity(m_bodyID));
 }
 
 void JoltRigidBody::SetAngularVelocity(const float3& velocity)
 {
-    m_bodyInterface.SetAngularVelocity(m_bodyID, ToJolt(velocity));
+    GetBodyInterface().SetAngularVelocity(m_bodyID, ToJolt(velocity));
 }
 
 float JoltRigidBody::GetFriction() const
 {
-    return m_bodyInterface.GetFriction(m_bodyID);
+    return GetBodyInterface().GetFriction(m_bodyID);
 }
 
 void JoltRigidBody::SetFriction(float friction)
 {
-    m_bodyInterface.SetFriction(m_bodyID, friction);
+    GetBodyInterface().SetFriction(m_bodyID, friction);
 }
 
 void JoltRigidBody::AddForce(const float3& force)
 {
-    m_bodyInterface.AddForce(m_bodyID, ToJolt(force));
+    GetBodyInterface().AddForce(m_bodyID, ToJolt(force));
 }
 
 void JoltRigidBody::AddImpulse(const float3& impulse)
 {
-    m_bodyInterface.AddImpulse(m_bodyID, ToJolt(impulse));
+    GetBodyInterface().AddImpulse(m_bodyID, ToJolt(impulse));
 }
 
 void JoltRigidBody::AddTorque(const float3& torque)
 {
-    m_bodyInterface.AddTorque(m_bodyID, ToJolt(torque));
+    GetBodyInterface().AddTorque(m_bodyID, ToJolt(torque));
 }
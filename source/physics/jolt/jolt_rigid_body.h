@@ -9,11 +9,12 @@
 #include "Jolt/Physics/Collision/Shape/Shape.h"
 
 class IPhysicsShape;
+class JoltSystem;
 
 class JoltRigidBody : public IPhysicsRigidBody
 {
 public:
-    JoltRigidBody(JPH::BodyInterface& bodyInterface);
+    JoltRigidBody(JoltSystem* system, JPH::BodyInterface& bodyInterface);
     ~JoltRigidBody();
 
     bool Create(const IPhysicsShape* shape, PhysicsMotion motion_type, uint16_t layer, void* user_data);
@@ -47,6 +48,9 @@ public:
 
     virtual void SetPositionAndRotation(const float3& position, const quaternion& rotation) override;
 
+    virtual float3 GetPrevPosition() const override;
+    virtual quaternion GetPrevRotation() const override;
+
     virtual float3 GetLinearVelocity() const override;
     virtual void SetLinearVelocity(const float3& velocity) override;
 
@@ -61,8 +65,30 @@ public:
     virtual void AddTorque(const float3& torque) override;
 
 private:
+    //waits for the simulation steps running in the background before the body is accessed
+    JPH::BodyInterface& GetBodyInterface() const;
+
+    //teleports in both snapshots
+    void SetState(const float3& position, const quaternion& rotation);
+    void SetState(const float3& position);
+    void SetState(const quaternion& rotation);
+
+private:
+    friend class JoltSystem;
+
+    JoltSystem* m_pSystem;
     JPH::BodyInterface& m_bodyInterface;
     JPH::BodyID m_bodyID;
+    uint32_t m_nSystemIndex = UINT32_MAX; //in the system's list of added bodies
+
+    struct State
+    {
+        float3 prevPosition{ 0.0f, 0.0f, 0.0f };
+        quaternion prevRotation{ 0.0f, 0.0f, 0.0f, 1.0f };
+        float3 position{ 0.0f, 0.0f, 0.0f };
+        quaternion rotation{ 0.0f, 0.0f, 0.0f, 1.0f };
+    };
+    State m_states[2]; //double buffered, the system steps into one while the other is published
 
     float3 m_scale{ 1.0f, 1.0f, 1.0f };
     JPH::Ref<JPH::Shape> m_shape;
@@ -6,6 +6,53 @@
 #include "Jolt/Physics/Collision/Shape/CylinderShape.h"
 #include "Jolt/Physics/Collision/Shape/ConvexHullShape.h"
 #include "Jolt/Physics/Collision/Shape/MeshShape.h"
+#include "Jolt/Core/StreamIn.h"
+#include "Jolt/Core/StreamOut.h"
+
+class JoltStreamOut : public JPH::StreamOut
+{
+public:
+    JoltStreamOut(eastl::vector<uint8_t>& data) : m_data(data) {}
+
+    virtual void WriteBytes(const void* inData, size_t inNumBytes) override
+    {
+        m_data.insert(m_data.end(), (const uint8_t*)inData, (const uint8_t*)inData + inNumBytes);
+    }
+
+    virtual bool IsFailed() const override { return false; }
+
+private:
+    eastl::vector<uint8_t>& m_data;
+};
+
+class JoltStreamIn : public JPH::StreamIn
+{
+public:
+    JoltStreamIn(const void* data, uint32_t size) : m_pData((const uint8_t*)data), m_nSize(size) {}
+
+    virtual void ReadBytes(void* outData, size_t inNumBytes) override
+    {
+        if (m_nOffset + inNumBytes > m_nSize)
+        {
+            memset(outData, 0, inNumBytes);
+            m_nOffset = m_nSize;
+            m_bFailed = true;
+            return;
+        }
+
+        memcpy(outData, m_pData + m_nOffset, inNumBytes);
+        m_nOffset += inNumBytes;
+    }
+
+    virtual bool IsEOF() const override { return m_nOffset >= m_nSize; }
+    virtual bool IsFailed() const override { return m_bFailed; }
+
+private:
+    const uint8_t* m_pData;
+    size_t m_nSize;
+    size_t m_nOffset = 0;
+    bool m_bFailed = false;
+};
 
 bool JoltShape::CreateBox(const float3& half_extent)
 {
@@ -119,6 +166,43 @@ bool JoltShape::CreateMesh(const float* vertices, uint32_t vertex_stride, uint32
     return result.IsValid();
 }
 
+bool JoltShape::Save(eastl::vector<uint8_t>& data) const
+{
+    JoltStreamOut stream(data);
+
+    uint32_t version = JPH_VERSION_ID;
+    stream.Write(version);
+
+    JPH::Shape::ShapeToIDMap shapeMap;
+    JPH::Shape::MaterialToIDMap materialMap;
+    m_shape->SaveWithChildren(stream, shapeMap, materialMap);
+
+    return !stream.IsFailed();
+}
+
+bool JoltShape::Load(const void* data, uint32_t size)
+{
+    JoltStreamIn stream(data, size);
+
+    uint32_t version = 0;
+    stream.Read(version);
+    if (stream.IsFailed() || version != JPH_VERSION_ID)
+    {
+        return false;
+    }
+
+    JPH::Shape::IDToShapeMap shapeMap;
+    JPH::Shape::IDToMaterialMap materialMap;
+    JPH::Shape::ShapeResult result = JPH::Shape::sRestoreWithChildren(stream, shapeMap, materialMap);
+    if (stream.IsFailed() || !result.IsValid())
+    {
+        return false;
+    }
+
+    m_shape = result.Get();
+    return true;
+}
+
 bool JoltShape::IsConvexShape() const
 {
     return m_shape->GetType() == JPH::EShapeType::Convex;
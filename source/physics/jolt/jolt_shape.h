@@ -3,6 +3,7 @@
 #include "../physics_shape.h"
 #include "utils/math.h"
 #include "EASTL/span.h"
+#include "EASTL/vector.h"
 #include "Jolt/Jolt.h"
 #include "Jolt/Physics/Collision/Shape/Shape.h"
 
@@ -18,6 +19,10 @@ public:
     bool CreateMesh(const float* vertices, uint32_t vertex_stride, uint32_t vertex_count, const uint16_t* indices, uint32_t index_count, bool winding_order_ccw);
     bool CreateMesh(const float* vertices, uint32_t vertex_stride, uint32_t vertex_count, const uint32_t* indices, uint32_t index_count, bool winding_order_ccw);
 
+    //binary state of the shape and its children, only valid for the same Jolt version
+    bool Save(eastl::vector<uint8_t>& data) const;
+    bool Load(const void* data, uint32_t size);
+
     JPH::Shape* GetShape() const { return m_shape.GetPtr(); }
 
     virtual bool IsConvexShape() const override;
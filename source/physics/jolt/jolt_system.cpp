@@ -9,10 +9,14 @@
 #include "jolt_rigid_body.h"
 #include "jolt_utils.h"
 #include "core/engine.h"
+#include "physics/physics_query_benchmark.h"
 #include "renderer/renderer.h"
 #include "utils/log.h"
 #include "utils/memory.h"
 #include "utils/profiler.h"
+#include "utils/gui_util.h"
+#include "enkiTS/TaskScheduler.h"
+#include "sokol/sokol_time.h"
 
 #include "Jolt/Jolt.h"
 #include "Jolt/RegisterTypes.h"
@@ -21,8 +25,12 @@
 #include "Jolt/Core/JobSystemThreadPool.h"
 #include "Jolt/Physics/PhysicsSettings.h"
 #include "Jolt/Physics/PhysicsSystem.h"
+#include "Jolt/Physics/Body/BodyLock.h"
 #include "Jolt/Physics/Collision/RayCast.h"
 #include "Jolt/Physics/Collision/CastResult.h"
+#include "Jolt/Physics/Collision/ShapeCast.h"
+#include "Jolt/Physics/Collision/CollideShape.h"
+#include "Jolt/Physics/Collision/CollisionCollectorImpl.h"
 
 static void JoltTraceImpl(const char* inFMT, ...)
 {
@@ -41,6 +49,96 @@ static bool AssertFailedImpl(const char* inExpression, const char* inMessage, co
     return true;
 };
 
+//writes the user data of the bodies touched by a shape to the caller's array, without allocations
+class JoltOverlapCollector : public JPH::CollideShapeCollector
+{
+public:
+    JoltOverlapCollector(const JPH::BodyInterface& bodyInterface, void** hits, uint32_t max_hits) :
+        m_bodyInterface(bodyInterface), m_hits(hits), m_nMaxHits(max_hits)
+    {
+    }
+
+    virtual void AddHit(const JPH::CollideShapeResult& inResult) override
+    {
+        //the hits of a body are reported one after another, once per touching sub shape
+        if (inResult.mBodyID2 == m_lastBodyID)
+        {
+            return;
+        }
+
+        m_lastBodyID = inResult.mBodyID2;
+        m_hits[m_nHitCount++] = (void*)m_bodyInterface.GetUserData(inResult.mBodyID2);
+
+        if (m_nHitCount == m_nMaxHits)
+        {
+            ForceEarlyOut();
+        }
+    }
+
+    uint32_t GetHitCount() const { return m_nHitCount; }
+
+private:
+    const JPH::BodyInterface& m_bodyInterface;
+    void** m_hits;
+    uint32_t m_nMaxHits;
+    uint32_t m_nHitCount = 0;
+    JPH::BodyID m_lastBodyID;
+};
+
+static void CastRay(const JPH::NarrowPhaseQuery& query, const JPH::BodyLockInterface& lockInterface, const PhysicsRay& ray,
+    const JPH::BroadPhaseLayerFilter& broadPhaseFilter, const JPH::ObjectLayerFilter& objectFilter, PhysicsRayTraceResult& result)
+{
+    JPH::RRayCast rayCast(ToJolt(ray.origin), ToJolt(ray.direction * ray.max_distance));
+    JPH::RayCastResult castResult;
+    result.hit = query.CastRay(rayCast, castResult, broadPhaseFilter, objectFilter);
+
+    if (result.hit)
+    {
+        result.position = FromJolt(rayCast.GetPointOnRay(castResult.mFraction));
+        result.distance = castResult.mFraction * ray.max_distance;
+
+        JPH::BodyLockRead lock(lockInterface, castResult.mBodyID);
+        if (lock.Succeeded())
+        {
+            const JPH::Body& body = lock.GetBody();
+
+            result.normal = FromJolt(body.GetWorldSpaceSurfaceNormal(castResult.mSubShapeID2, ToJolt(result.position)));
+            result.user_data = (void*)body.GetUserData();
+        }
+    }
+}
+
+//splits the queries over at most thread_count task threads, small batches run on the calling thread
+template <typename F>
+static void RunQueries(uint32_t count, uint32_t thread_count, F fun)
+{
+    enki::TaskScheduler* ts = Engine::GetInstance()->GetTaskScheduler();
+    uint32_t max_threads = thread_count == 0 ? ts->GetNumTaskThreads() : min(thread_count, ts->GetNumTaskThreads());
+
+    const uint32_t min_range = 32; //queries per task, fewer don't pay for the scheduling
+    if (max_threads <= 1 || count <= min_range)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            fun(i);
+        }
+        return;
+    }
+
+    enki::TaskSet taskSet(count,
+        [&](enki::TaskSetPartition range, uint32_t threadnum)
+        {
+            for (uint32_t i = range.start; i != range.end; ++i)
+            {
+                fun(i);
+            }
+        });
+    taskSet.m_MinRange = max(DivideRoudingUp(count, max_threads), min_range);
+
+    ts->AddTaskSetToPipe(&taskSet);
+    ts->WaitforTask(&taskSet, taskSet.m_Priority);
+}
+
 const JPH::uint cMaxBodies = 65536;
 const JPH::uint cNumBodyMutexes = 0;
 const JPH::uint cMaxBodyPairs = 65536;
@@ -51,10 +149,10 @@ JoltSystem::JoltSystem()
     m_pRenderer = Engine::GetInstance()->GetRenderer();
 
 #ifndef JPH_DISABLE_CUSTOM_ALLOCATOR
-    JPH::Allocate = RE_ALLOC;
+    JPH::Allocate = [](size_t inSize) { return RE_ALLOC(inSize, MemoryTag::Physics); };
     JPH::Reallocate = [](void* inBlock, size_t inOldSize, size_t inNewSize) { return RE_REALLOC(inBlock, inNewSize); };
     JPH::Free = RE_FREE;
-    JPH::AlignedAllocate = RE_ALLOC;
+    JPH::AlignedAllocate = [](size_t inSize, size_t inAlignment) { return RE_ALLOC(inSize, inAlignment, MemoryTag::Physics); };
     JPH::AlignedFree = RE_FREE;
 #else
     JPH::RegisterDefaultAllocator();
@@ -71,6 +169,16 @@ JoltSystem::JoltSystem()
 
 JoltSystem::~JoltSystem()
 {
+    WaitForStep();
+
+    uint64_t tick_count = m_stepClock.GetTickCount();
+    if (tick_count > 0)
+    {
+        RE_INFO("[Physics] {} {} steps at {:.0f} Hz in {} ticks ({} dropped) : steps took {:.3f} ms per tick, the main thread waited {:.3f} ms per tick and stalled in {} ticks",
+            m_stepClock.GetTotalStepCount(), m_bAsyncStep ? "async" : "sync", m_stepClock.GetStepRate(), tick_count, m_stepClock.GetDroppedStepCount(),
+            stm_ms(m_nTotalStepTicks) / tick_count, stm_ms(m_nTotalWaitTicks) / tick_count, m_nStallCount);
+    }
+
     JPH::UnregisterTypes();
     delete JPH::Factory::sInstance;
 }
@@ -93,10 +201,18 @@ void JoltSystem::Initialize()
     m_pSystem->Init(cMaxBodies, cNumBodyMutexes, cMaxBodyPairs, cMaxContactConstraints, *m_pBroadPhaseLayer, *m_pBroadPhaseLayerFilter, *m_pObjectLayerFilter);
     m_pSystem->SetBodyActivationListener(m_pBodyActivationListener.get());
     m_pSystem->SetContactListener(m_pContactListener.get());
+
+    //low priority, so the main thread doesn't pick up the steps while it waits for its own tasks during rendering
+    m_pStepTask = eastl::make_unique<enki::TaskSet>([this](enki::TaskSetPartition range, uint32_t threadnum)
+        {
+            RunSteps();
+        });
+    m_pStepTask->m_Priority = enki::TASK_PRIORITY_LOW;
 }
 
 void JoltSystem::OptimizeTLAS()
 {
+    WaitForStep();
     m_pSystem->OptimizeBroadPhase();
 }
 
@@ -104,10 +220,7 @@ void JoltSystem::Tick(float delta_time)
 {
     CPU_EVENT("Physics", "JoltSystem::Tick");
 
-    const float cDeltaTime = 1.0f / 60.0f;
-    const int cCollisionSteps = 1;
-
-    m_pSystem->Update(cDeltaTime, cCollisionSteps, m_pTempAllocator.get(), m_pJobSystem.get());
+    WaitForStep();
 
     if (m_pRenderer->GetOutputType() == RendererOutput::Physics)
     {
@@ -120,6 +233,206 @@ void JoltSystem::Tick(float delta_time)
         m_pSystem->DrawConstraints(m_pDebugRenderer.get());
 #endif
     }
+
+    uint32_t step_count = m_stepClock.Tick(delta_time);
+
+    //the steps started by the last tick are complete now
+    if (m_nStatsLogInterval > 0 && m_stepClock.GetTickCount() - m_lastStatsLog.tickCount >= m_nStatsLogInterval)
+    {
+        LogStats();
+    }
+
+    if (step_count == 0)
+    {
+        return;
+    }
+
+    m_nPendingStepCount = step_count;
+    m_pendingStepTime = (float)m_stepClock.GetStepTime();
+
+    if (m_bAsyncStep)
+    {
+        m_bStepInFlight = true;
+        Engine::GetInstance()->GetTaskScheduler()->AddTaskSetToPipe(m_pStepTask.get());
+    }
+    else
+    {
+        RunSteps();
+        PublishStates();
+    }
+}
+
+void JoltSystem::SetAsyncStepEnabled(bool value)
+{
+    WaitForStep();
+    m_bAsyncStep = value;
+}
+
+void JoltSystem::WaitForStep()
+{
+    if (!m_bStepInFlight)
+    {
+        return;
+    }
+
+    uint64_t ticks = stm_now();
+
+    if (!m_pStepTask->GetIsComplete())
+    {
+        CPU_EVENT("Physics", "JoltSystem::WaitForStep");
+
+        Engine::GetInstance()->GetTaskScheduler()->WaitforTask(m_pStepTask.get());
+        m_nStallCount++;
+    }
+
+    m_nLastWaitTicks = stm_since(ticks);
+    m_nTotalWaitTicks += m_nLastWaitTicks;
+    m_nMaxWaitTicks = eastl::max(m_nMaxWaitTicks, m_nLastWaitTicks);
+    m_bStepInFlight = false;
+
+    PublishStates();
+}
+
+void JoltSystem::LogStats()
+{
+    StatsSnapshot stats;
+    stats.tickCount = m_stepClock.GetTickCount();
+    stats.stepCount = m_stepClock.GetTotalStepCount();
+    stats.stepTicks = m_nTotalStepTicks;
+    stats.waitTicks = m_nTotalWaitTicks;
+    stats.stallCount = m_nStallCount;
+
+    uint64_t tick_count = stats.tickCount - m_lastStatsLog.tickCount;
+    RE_INFO("[Physics] {} ticks, {} : {} steps, steps took {:.3f} ms per tick, the main thread waited {:.3f} ms per tick (max {:.3f} ms) and stalled in {} ticks",
+        tick_count, m_bAsyncStep ? "async" : "sync", stats.stepCount - m_lastStatsLog.stepCount,
+        stm_ms(stats.stepTicks - m_lastStatsLog.stepTicks) / tick_count, stm_ms(stats.waitTicks - m_lastStatsLog.waitTicks) / tick_count,
+        stm_ms(m_nMaxWaitTicks), stats.stallCount - m_lastStatsLog.stallCount);
+
+    m_lastStatsLog = stats;
+    m_nMaxWaitTicks = 0;
+}
+
+void JoltSystem::OnGui()
+{
+    bool async_step = m_bAsyncStep;
+    if (ImGui::Checkbox("Async Step", &async_step))
+    {
+        SetAsyncStepEnabled(async_step);
+    }
+
+    float step_rate = m_stepClock.GetStepRate();
+    if (ImGui::SliderFloat("Step Rate", &step_rate, 10.0f, 240.0f, "%.0f Hz"))
+    {
+        m_stepClock.SetStepRate(step_rate);
+    }
+
+    int max_substeps = (int)m_stepClock.GetMaxSubsteps();
+    if (ImGui::SliderInt("Max Substeps", &max_substeps, 1, 16))
+    {
+        m_stepClock.SetMaxSubsteps((uint32_t)max_substeps);
+    }
+
+    ImGui::Text("Steps : %u in the last tick, %llu in total", m_stepClock.GetLastStepCount(), m_stepClock.GetTotalStepCount());
+    ImGui::Text("Dropped steps : %llu", m_stepClock.GetDroppedStepCount());
+    ImGui::Text("Interpolation alpha : %.2f", m_stepClock.GetInterpolationAlpha());
+    ImGui::Text("Bodies : %u", (uint32_t)m_rigidBodies.size());
+
+    ImGui::Separator();
+    ImGui::Text("Last steps : %.3f ms", stm_ms(m_nLastStepTicks));
+    ImGui::Text("Last wait : %.3f ms", stm_ms(m_nLastWaitTicks));
+    ImGui::Text("Stalled ticks : %llu of %llu", m_nStallCount, m_stepClock.GetTickCount());
+
+    ImGui::Separator();
+    if (ImGui::Button("Run Query Benchmark"))
+    {
+        RunPhysicsQueryBenchmark(this);
+    }
+}
+
+void JoltSystem::AddRigidBody(JoltRigidBody* body)
+{
+    WaitForStep();
+
+    if (body->m_nSystemIndex == UINT32_MAX)
+    {
+        body->m_nSystemIndex = (uint32_t)m_rigidBodies.size();
+        m_rigidBodies.push_back(body);
+    }
+}
+
+void JoltSystem::RemoveRigidBody(JoltRigidBody* body)
+{
+    WaitForStep();
+
+    uint32_t index = body->m_nSystemIndex;
+    if (index == UINT32_MAX)
+    {
+        return;
+    }
+
+    m_rigidBodies[index] = m_rigidBodies.back();
+    m_rigidBodies[index]->m_nSystemIndex = index;
+    m_rigidBodies.pop_back();
+
+    body->m_nSystemIndex = UINT32_MAX;
+}
+
+void JoltSystem::RunSteps()
+{
+    CPU_EVENT("Physics", "JoltSystem::RunSteps");
+    uint64_t ticks = stm_now();
+
+    //the steps write the states which aren't published
+    uint32_t state = 1 - m_nPublishedState;
+    const int cCollisionSteps = 1;
+
+    for (uint32_t i = 0; i < m_nPendingStepCount; ++i)
+    {
+        if (i == m_nPendingStepCount - 1)
+        {
+            SaveBodyStates(state, true);
+        }
+
+        m_pSystem->Update(m_pendingStepTime, cCollisionSteps, m_pTempAllocator.get(), m_pJobSystem.get());
+    }
+
+    SaveBodyStates(state, false);
+
+    m_nLastStepTicks = stm_since(ticks);
+}
+
+void JoltSystem::SaveBodyStates(uint32_t state, bool prev)
+{
+    //called between steps, no body is modified concurrently
+    const JPH::BodyLockInterfaceNoLock& lockInterface = m_pSystem->GetBodyLockInterfaceNoLock();
+
+    for (size_t i = 0; i < m_rigidBodies.size(); ++i)
+    {
+        JPH::BodyLockRead lock(lockInterface, m_rigidBodies[i]->GetID());
+        if (lock.Succeeded() && !lock.GetBody().IsStatic())
+        {
+            const JPH::Body& body = lock.GetBody();
+            JoltRigidBody::State& bodyState = m_rigidBodies[i]->m_states[state];
+
+            if (prev)
+            {
+                bodyState.prevPosition = FromJolt(body.GetPosition());
+                bodyState.prevRotation = FromJolt(body.GetRotation());
+            }
+            else
+            {
+                bodyState.position = FromJolt(body.GetPosition());
+                bodyState.rotation = FromJolt(body.GetRotation());
+            }
+        }
+    }
+}
+
+void JoltSystem::PublishStates()
+{
+    //static bodies are not written by the steps, their states are kept equal in both buffers when they are moved
+    m_nPublishedState = 1 - m_nPublishedState;
+    m_nTotalStepTicks += m_nLastStepTicks;
 }
 
 IPhysicsShape* JoltSystem::CreateBoxShape(const float3& half_extent)
@@ -210,9 +523,27 @@ IPhysicsShape* JoltSystem::CreateMeshShape(const float* vertices, uint32_t verte
     return shape;
 }
 
+bool JoltSystem::SaveShape(const IPhysicsShape* shape, eastl::vector<uint8_t>& data) const
+{
+    return ((const JoltShape*)shape)->Save(data);
+}
+
+IPhysicsShape* JoltSystem::LoadShape(const void* data, uint32_t size)
+{
+    JoltShape* shape = new JoltShape();
+    if (!shape->Load(data, size))
+    {
+        delete shape;
+        return nullptr;
+    }
+    return shape;
+}
+
 IPhysicsRigidBody* JoltSystem::CreateRigidBody(const IPhysicsShape* shape, PhysicsMotion motion_type, uint16_t layer, void* user_data)
 {
-    JoltRigidBody* rigidBody = new JoltRigidBody(m_pSystem->GetBodyInterface());
+    WaitForStep();
+
+    JoltRigidBody* rigidBody = new JoltRigidBody(this, m_pSystem->GetBodyInterface());
     if (!rigidBody->Create(shape, motion_type, layer, user_data))
     {
         delete rigidBody;
@@ -221,29 +552,99 @@ IPhysicsRigidBody* JoltSystem::CreateRigidBody(const IPhysicsShape* shape, Physi
     return rigidBody;
 }
 
-bool JoltSystem::RayTrace(const float3& origin, const float3& direction, float max_distance, PhysicsRayTraceResult& result) const
+bool JoltSystem::RayTrace(const float3& origin, const float3& direction, float max_distance, PhysicsRayTraceResult& result, const PhysicsQueryFilter& filter) const
 {
+    WaitForStepBeforeQuery();
+
+    JoltQueryBroadPhaseLayerFilter broadPhaseFilter(*m_pBroadPhaseLayer, filter.layer_mask);
+    JoltQueryObjectLayerFilter objectFilter(filter.layer_mask);
+
+    CastRay(m_pSystem->GetNarrowPhaseQuery(), m_pSystem->GetBodyLockInterface(), { origin, direction, max_distance }, broadPhaseFilter, objectFilter, result);
+    return result.hit;
+}
+
+void JoltSystem::RayTrace(eastl::span<const PhysicsRay> rays, eastl::span<PhysicsRayTraceResult> results, const PhysicsQueryFilter& filter, uint32_t thread_count) const
+{
+    CPU_EVENT("Physics", "JoltSystem::RayTrace");
+    RE_ASSERT(results.size() >= rays.size());
+
+    WaitForStepBeforeQuery();
+
+    JoltQueryBroadPhaseLayerFilter broadPhaseFilter(*m_pBroadPhaseLayer, filter.layer_mask);
+    JoltQueryObjectLayerFilter objectFilter(filter.layer_mask);
     const JPH::NarrowPhaseQuery& query = m_pSystem->GetNarrowPhaseQuery();
+    const JPH::BodyLockInterface& lockInterface = m_pSystem->GetBodyLockInterface();
 
-    JPH::RRayCast ray(ToJolt(origin), ToJolt(direction * max_distance));
-    JPH::RayCastResult castResult;
-    bool hit = query.CastRay(ray, castResult);
+    RunQueries((uint32_t)rays.size(), thread_count, [&](uint32_t i)
+        {
+            CastRay(query, lockInterface, rays[i], broadPhaseFilter, objectFilter, results[i]);
+        });
+}
 
-    if (hit)
-    {
-        JPH::BodyInterface& bodyInterface = m_pSystem->GetBodyInterface();
+void JoltSystem::Overlap(eastl::span<const PhysicsOverlapQuery> queries, uint32_t max_hits, eastl::span<void*> hits, eastl::span<uint32_t> hit_counts, const PhysicsQueryFilter& filter, uint32_t thread_count) const
+{
+    CPU_EVENT("Physics", "JoltSystem::Overlap");
+    RE_ASSERT(hits.size() >= queries.size() * max_hits && hit_counts.size() >= queries.size());
 
-        result.position = FromJolt(ray.GetPointOnRay(castResult.mFraction));
+    WaitForStepBeforeQuery();
 
-        JPH::BodyLockRead lock(m_pSystem->GetBodyLockInterface(), castResult.mBodyID);
-        if (lock.Succeeded())
+    JoltQueryBroadPhaseLayerFilter broadPhaseFilter(*m_pBroadPhaseLayer, filter.layer_mask);
+    JoltQueryObjectLayerFilter objectFilter(filter.layer_mask);
+    const JPH::NarrowPhaseQuery& query = m_pSystem->GetNarrowPhaseQuery();
+    const JPH::BodyInterface& bodyInterface = m_pSystem->GetBodyInterface();
+
+    RunQueries((uint32_t)queries.size(), thread_count, [&](uint32_t i)
         {
-            const JPH::Body& body = lock.GetBody();
+            hit_counts[i] = 0;
+            if (max_hits == 0)
+            {
+                return;
+            }
 
-            result.normal = FromJolt(body.GetWorldSpaceSurfaceNormal(castResult.mSubShapeID2, ToJolt(result.position)));
-            result.user_data = (void*)body.GetUserData();
-        }
-    }
+            const JPH::Shape* shape = ((const JoltShape*)queries[i].shape)->GetShape();
+            JPH::RMat44 transform = JPH::RMat44::sRotationTranslation(ToJolt(queries[i].rotation), ToJolt(queries[i].position)) * JPH::Mat44::sTranslation(shape->GetCenterOfMass());
 
-    return hit;
+            JoltOverlapCollector collector(bodyInterface, &hits[i * max_hits], max_hits);
+            JPH::CollideShapeSettings settings;
+            query.CollideShape(shape, JPH::Vec3::sReplicate(1.0f), transform, settings, JPH::RVec3::sZero(), collector, broadPhaseFilter, objectFilter);
+
+            hit_counts[i] = collector.GetHitCount();
+        });
 }
+
+void JoltSystem::Sweep(eastl::span<const PhysicsSweepQuery> queries, eastl::span<PhysicsSweepResult> results, const PhysicsQueryFilter& filter, uint32_t thread_count) const
+{
+    CPU_EVENT("Physics", "JoltSystem::Sweep");
+    RE_ASSERT(results.size() >= queries.size());
+
+    WaitForStepBeforeQuery();
+
+    JoltQueryBroadPhaseLayerFilter broadPhaseFilter(*m_pBroadPhaseLayer, filter.layer_mask);
+    JoltQueryObjectLayerFilter objectFilter(filter.layer_mask);
+    const JPH::NarrowPhaseQuery& query = m_pSystem->GetNarrowPhaseQuery();
+    const JPH::BodyInterface& bodyInterface = m_pSystem->GetBodyInterface();
+
+    RunQueries((uint32_t)queries.size(), thread_count, [&](uint32_t i)
+        {
+            const PhysicsSweepQuery& sweep = queries[i];
+            const JPH::Shape* shape = ((const JoltShape*)sweep.shape)->GetShape();
+            JPH::RMat44 transform = JPH::RMat44::sRotationTranslation(ToJolt(sweep.rotation), ToJolt(sweep.position));
+            JPH::RShapeCast cast = JPH::RShapeCast::sFromWorldTransform(shape, JPH::Vec3::sReplicate(1.0f), transform, ToJolt(sweep.direction * sweep.max_distance));
+
+            JPH::ClosestHitCollisionCollector<JPH::CastShapeCollector> collector;
+            JPH::ShapeCastSettings settings;
+            query.CastShape(cast, settings, JPH::RVec3::sZero(), collector, broadPhaseFilter, objectFilter);
+
+            PhysicsSweepResult& result = results[i];
+            result.hit = collector.HadHit();
+
+            if (result.hit)
+            {
+                const JPH::ShapeCastResult& hit = collector.mHit;
+                result.distance = hit.mFraction * sweep.max_distance;
+                result.position = FromJolt(hit.mContactPointOn2);
+                result.normal = FromJolt(-hit.mPenetrationAxis.NormalizedOr(JPH::Vec3::sAxisY())); //the axis is zero for a sweep starting in contact
+                result.user_data = (void*)bodyInterface.GetUserData(hit.mBodyID2);
+            }
+        });
+}
\ No newline at end of file
@@ -1,7 +1,9 @@
 #pragma once
 
 #include "../physics_system.h"
+#include "../physics_step_clock.h"
 #include "EASTL/unique_ptr.h"
+#include "EASTL/vector.h"
 
 namespace JPH
 {
@@ -15,7 +17,13 @@ namespace JPH
     class ContactListener;
 }
 
+namespace enki
+{
+    class TaskSet;
+}
+
 class Renderer;
+class JoltRigidBody;
 
 class JoltSystem : public IPhysicsSystem
 {
@@ -26,6 +34,16 @@ public:
     virtual void Initialize() override;
     virtual void OptimizeTLAS() override;
     virtual void Tick(float delta_time) override;
+    virtual void OnGui() override;
+
+    virtual void SetStepRate(float step_rate) override { m_stepClock.SetStepRate(step_rate); }
+    virtual void SetMaxSubsteps(uint32_t max_substeps) override { m_stepClock.SetMaxSubsteps(max_substeps); }
+    virtual float GetInterpolationAlpha() const override { return m_stepClock.GetInterpolationAlpha(); }
+
+    virtual void SetAsyncStepEnabled(bool value) override;
+    virtual bool IsAsyncStepEnabled() const override { return m_bAsyncStep; }
+    virtual void WaitForStep() override;
+    virtual void SetStatsLogInterval(uint32_t interval_ticks) override { m_nStatsLogInterval = interval_ticks; }
 
     virtual IPhysicsShape* CreateBoxShape(const float3& half_extent) override;
     virtual IPhysicsShape* CreateSphereShape(float radius) override;
@@ -36,13 +54,66 @@ public:
     virtual IPhysicsShape* CreateMeshShape(const float* vertices, uint32_t vertex_stride, uint32_t vertex_count, const uint16_t* indices, uint32_t index_count, bool winding_order_ccw = false) override;
     virtual IPhysicsShape* CreateMeshShape(const float* vertices, uint32_t vertex_stride, uint32_t vertex_count, const uint32_t* indices, uint32_t index_count, bool winding_order_ccw = false) override;
 
+    virtual bool SaveShape(const IPhysicsShape* shape, eastl::vector<uint8_t>& data) const override;
+    virtual IPhysicsShape* LoadShape(const void* data, uint32_t size) override;
+
     virtual IPhysicsRigidBody* CreateRigidBody(const IPhysicsShape* shape, PhysicsMotion motion_type, uint16_t layer, void* user_data = nullptr) override;
 
-    virtual bool RayTrace(const float3& origin, const float3& direction, float max_distance, PhysicsRayTraceResult& result) const override;
+    virtual bool RayTrace(const float3& origin, const float3& direction, float max_distance, PhysicsRayTraceResult& result, const PhysicsQueryFilter& filter = {}) const override;
+
+    virtual void RayTrace(eastl::span<const PhysicsRay> rays, eastl::span<PhysicsRayTraceResult> results, const PhysicsQueryFilter& filter = {}, uint32_t thread_count = 0) const override;
+    virtual void Overlap(eastl::span<const PhysicsOverlapQuery> queries, uint32_t max_hits, eastl::span<void*> hits, eastl::span<uint32_t> hit_counts, const PhysicsQueryFilter& filter = {}, uint32_t thread_count = 0) const override;
+    virtual void Sweep(eastl::span<const PhysicsSweepQuery> queries, eastl::span<PhysicsSweepResult> results, const PhysicsQueryFilter& filter = {}, uint32_t thread_count = 0) const override;
+
+    //the bodies in the simulation, their states are saved around the steps for interpolation
+    void AddRigidBody(JoltRigidBody* body);
+    void RemoveRigidBody(JoltRigidBody* body);
+
+    //index of the body states read by the main thread, the steps write the other one
+    uint32_t GetPublishedState() const { return m_nPublishedState; }
+
+private:
+    //queries can't run concurrently with the steps
+    void WaitForStepBeforeQuery() const { const_cast<JoltSystem*>(this)->WaitForStep(); }
+
+    void RunSteps();
+    void SaveBodyStates(uint32_t state, bool prev);
+    void PublishStates();
+    void LogStats();
 
 private:
     Renderer* m_pRenderer;
 
+    PhysicsStepClock m_stepClock;
+
+    eastl::vector<JoltRigidBody*> m_rigidBodies;
+    uint32_t m_nPublishedState = 0;
+
+    bool m_bAsyncStep = false;
+    bool m_bStepInFlight = false; //only changed by the main thread, outside of the world's parallel phases
+    uint32_t m_nPendingStepCount = 0;
+    float m_pendingStepTime = 0.0f;
+    eastl::unique_ptr<enki::TaskSet> m_pStepTask;
+
+    //in stm ticks
+    uint64_t m_nLastStepTicks = 0; //written by the steps, read once they're complete
+    uint64_t m_nLastWaitTicks = 0;
+    uint64_t m_nTotalStepTicks = 0;
+    uint64_t m_nTotalWaitTicks = 0;
+    uint64_t m_nStallCount = 0; //ticks in which the main thread had to wait for the steps
+    uint64_t m_nMaxWaitTicks = 0; //since the last stats log
+
+    struct StatsSnapshot
+    {
+        uint64_t tickCount = 0;
+        uint64_t stepCount = 0;
+        uint64_t stepTicks = 0;
+        uint64_t waitTicks = 0;
+        uint64_t stallCount = 0;
+    };
+    uint32_t m_nStatsLogInterval = 0;
+    StatsSnapshot m_lastStatsLog;
+
     eastl::unique_ptr<class JPH::PhysicsSystem> m_pSystem;
     eastl::unique_ptr<class JPH::TempAllocatorImpl> m_pTempAllocator;
     eastl::unique_ptr<class JPH::BroadPhaseLayerInterface> m_pBroadPhaseLayer;
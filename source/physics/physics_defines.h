@@ -28,9 +28,50 @@ enum class PhysicsMotion
     Dynamic,
 };
 
+class IPhysicsShape;
+
+struct PhysicsQueryFilter
+{
+    uint32_t layer_mask = 0xFFFFFFFF; //bit n accepts bodies of PhysicsLayers n
+};
+
+struct PhysicsRay
+{
+    float3 origin;
+    float3 direction; //normalized
+    float max_distance;
+};
+
 struct PhysicsRayTraceResult
 {
     float3 position;
     float3 normal;
     void* user_data;
+    float distance;
+    bool hit;
+};
+
+struct PhysicsOverlapQuery
+{
+    const IPhysicsShape* shape;
+    float3 position;
+    quaternion rotation;
+};
+
+struct PhysicsSweepQuery
+{
+    const IPhysicsShape* shape;
+    float3 position;
+    quaternion rotation;
+    float3 direction; //normalized
+    float max_distance;
+};
+
+struct PhysicsSweepResult
+{
+    float3 position; //contact point at the time of impact
+    float3 normal;
+    void* user_data;
+    float distance;
+    bool hit;
 };
\ No newline at end of file
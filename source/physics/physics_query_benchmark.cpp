@@ -0,0 +1,190 @@
+#include "physics_query_benchmark.h"
+#include "physics.h"
+#include "core/engine.h"
+#include "utils/log.h"
+#include "utils/profiler.h"
+#include "enkiTS/TaskScheduler.h"
+#include "sokol/sokol_time.h"
+
+static const float3 cSceneOrigin = float3(0.0f, -10000.0f, 0.0f);
+static const uint32_t cGridSize = 32; //bodies per side
+static const uint32_t cGridHeight = 8;
+static const float cGridSpacing = 2.0f;
+static const uint32_t cQueryCount = 4096; //per batch size and thread count
+
+//xorshift, the benchmark uses the same queries on every run
+static float RandomFloat(uint32_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return (state & 0xFFFFFF) / (float)0x1000000;
+}
+
+static float3 RandomPosition(uint32_t& state)
+{
+    float3 extent = float3((float)cGridSize, (float)cGridHeight, (float)cGridSize) * cGridSpacing;
+    return cSceneOrigin + float3(RandomFloat(state), RandomFloat(state), RandomFloat(state)) * extent;
+}
+
+static float3 RandomDirection(uint32_t& state)
+{
+    float3 direction = float3(RandomFloat(state), RandomFloat(state), RandomFloat(state)) * 2.0f - 1.0f;
+    return length(direction) > 0.001f ? normalize(direction) : float3(0.0f, -1.0f, 0.0f);
+}
+
+//the batches run the same queries as the single RayTrace, only split over the task threads
+static bool CheckRayBatch(IPhysicsSystem* system, const eastl::vector<PhysicsRay>& rays, const eastl::vector<PhysicsRayTraceResult>& results, const PhysicsQueryFilter& filter)
+{
+    uint32_t mismatch_count = 0;
+    for (uint32_t i = 0; i < (uint32_t)rays.size(); ++i)
+    {
+        PhysicsRayTraceResult expected;
+        bool hit = system->RayTrace(rays[i].origin, rays[i].direction, rays[i].max_distance, expected, filter);
+
+        const PhysicsRayTraceResult& result = results[i];
+        bool match = result.hit == hit;
+        if (match && hit)
+        {
+            match = result.user_data == expected.user_data && abs(result.distance - expected.distance) < 1e-4f &&
+                maxelem(abs(result.position - expected.position)) < 1e-4f && maxelem(abs(result.normal - expected.normal)) < 1e-4f;
+        }
+
+        if (!match)
+        {
+            if (mismatch_count == 0)
+            {
+                RE_ERROR("[Physics] batched ray {} : hit {} at {:.4f}, the single query : hit {} at {:.4f}", i, result.hit, result.distance, hit, expected.distance);
+            }
+            ++mismatch_count;
+        }
+    }
+
+    if (mismatch_count > 0)
+    {
+        RE_ERROR("[Physics] {} of {} batched rays differ from the single queries", mismatch_count, (uint32_t)rays.size());
+    }
+    return mismatch_count == 0;
+}
+
+template <typename F>
+static void Measure(const char* name, uint32_t hit_count, F run_batch)
+{
+    enki::TaskScheduler* ts = Engine::GetInstance()->GetTaskScheduler();
+    const uint32_t batch_sizes[] = { 1, 16, 256, cQueryCount };
+    const uint32_t thread_counts[] = { 1, 2, 4, ts->GetNumTaskThreads() };
+
+    for (uint32_t thread_count : thread_counts)
+    {
+        for (uint32_t batch_size : batch_sizes)
+        {
+            uint64_t ticks = stm_now();
+
+            for (uint32_t first = 0; first < cQueryCount; first += batch_size)
+            {
+                run_batch(first, batch_size, thread_count);
+            }
+
+            double seconds = stm_sec(stm_since(ticks));
+            RE_INFO("[Physics] {:<8} batch {:>4}, {:>2} threads : {:>7.3f} M queries/s", name, batch_size, thread_count, cQueryCount / seconds / 1000000.0);
+        }
+    }
+
+    RE_INFO("[Physics] {:<8} {:.1f}% of the queries hit", name, 100.0f * hit_count / cQueryCount);
+}
+
+bool RunPhysicsQueryBenchmark(IPhysicsSystem* system)
+{
+    CPU_EVENT("Physics", "RunPhysicsQueryBenchmark");
+
+    eastl::unique_ptr<IPhysicsShape> boxShape(system->CreateBoxShape(float3(0.5f, 0.5f, 0.5f)));
+    eastl::unique_ptr<IPhysicsShape> sphereShape(system->CreateSphereShape(0.5f));
+    eastl::unique_ptr<IPhysicsShape> queryShape(system->CreateSphereShape(0.75f));
+
+    eastl::vector<eastl::unique_ptr<IPhysicsRigidBody>> bodies;
+    bodies.reserve(cGridSize * cGridSize * cGridHeight);
+
+    for (uint32_t y = 0; y < cGridHeight; ++y)
+    {
+        for (uint32_t z = 0; z < cGridSize; ++z)
+        {
+            for (uint32_t x = 0; x < cGridSize; ++x)
+            {
+                IPhysicsShape* shape = (x + y + z) % 2 ? boxShape.get() : sphereShape.get();
+                void* user_data = (void*)(uintptr_t)(bodies.size() + 1);
+
+                IPhysicsRigidBody* body = system->CreateRigidBody(shape, PhysicsMotion::Static, PhysicsLayers::STATIC, user_data);
+                body->SetPosition(cSceneOrigin + float3((float)x, (float)y, (float)z) * cGridSpacing);
+                body->AddToPhysicsSystem(false);
+                bodies.emplace_back(body);
+            }
+        }
+    }
+
+    system->OptimizeTLAS();
+
+    RE_INFO("[Physics] query benchmark : {} bodies, {} queries per batch size and thread count", (uint32_t)bodies.size(), cQueryCount);
+
+    uint32_t random = 0x12345678;
+    PhysicsQueryFilter filter;
+    filter.layer_mask = 1u << PhysicsLayers::STATIC;
+
+    eastl::vector<PhysicsRay> rays(cQueryCount);
+    eastl::vector<PhysicsOverlapQuery> overlaps(cQueryCount);
+    eastl::vector<PhysicsSweepQuery> sweeps(cQueryCount);
+
+    for (uint32_t i = 0; i < cQueryCount; ++i)
+    {
+        rays[i] = { RandomPosition(random), RandomDirection(random), 20.0f };
+        overlaps[i] = { queryShape.get(), RandomPosition(random), quaternion(0.0f, 0.0f, 0.0f, 1.0f) };
+        sweeps[i] = { queryShape.get(), RandomPosition(random), quaternion(0.0f, 0.0f, 0.0f, 1.0f), RandomDirection(random), 20.0f };
+    }
+
+    const uint32_t max_hits = 8;
+    eastl::vector<PhysicsRayTraceResult> rayResults(cQueryCount);
+    eastl::vector<void*> overlapHits(cQueryCount * max_hits);
+    eastl::vector<uint32_t> overlapHitCounts(cQueryCount);
+    eastl::vector<PhysicsSweepResult> sweepResults(cQueryCount);
+
+    //first pass for the hit rates, also warms up the caches
+    system->RayTrace(rays, rayResults, filter);
+    system->Overlap(overlaps, max_hits, overlapHits, overlapHitCounts, filter);
+    system->Sweep(sweeps, sweepResults, filter);
+
+    bool valid = CheckRayBatch(system, rays, rayResults, filter);
+
+    uint32_t rayHits = 0, overlapHitQueries = 0, sweepHits = 0;
+    for (uint32_t i = 0; i < cQueryCount; ++i)
+    {
+        rayHits += rayResults[i].hit ? 1 : 0;
+        overlapHitQueries += overlapHitCounts[i] > 0 ? 1 : 0;
+        sweepHits += sweepResults[i].hit ? 1 : 0;
+    }
+
+    Measure("Ray", rayHits, [&](uint32_t first, uint32_t count, uint32_t thread_count)
+        {
+            system->RayTrace({ rays.data() + first, count }, { rayResults.data() + first, count }, filter, thread_count);
+        });
+
+    //the results of the last run, split into batches of all the thread counts
+    valid &= CheckRayBatch(system, rays, rayResults, filter);
+
+    Measure("Overlap", overlapHitQueries, [&](uint32_t first, uint32_t count, uint32_t thread_count)
+        {
+            system->Overlap({ overlaps.data() + first, count }, max_hits, { overlapHits.data() + first * max_hits, count * max_hits }, { overlapHitCounts.data() + first, count }, filter, thread_count);
+        });
+
+    Measure("Sweep", sweepHits, [&](uint32_t first, uint32_t count, uint32_t thread_count)
+        {
+            system->Sweep({ sweeps.data() + first, count }, { sweepResults.data() + first, count }, filter, thread_count);
+        });
+
+    for (size_t i = 0; i < bodies.size(); ++i)
+    {
+        bodies[i]->RemoveFromPhysicsSystem();
+    }
+    bodies.clear();
+
+    system->OptimizeTLAS();
+    return valid;
+}
\ No newline at end of file
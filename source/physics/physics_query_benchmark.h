@@ -0,0 +1,8 @@
+#pragma once
+
+class IPhysicsSystem;
+
+//logs the throughput of the batched ray, overlap and sweep queries in queries per second for several batch sizes and thread counts.
+//the synthetic scene is a grid of static boxes and spheres built far away from the world's bodies, and removed afterwards.
+//returns false if the batched ray results differ from the single RayTrace ones, the throughput is still measured
+bool RunPhysicsQueryBenchmark(IPhysicsSystem* system);
\ No newline at end of file
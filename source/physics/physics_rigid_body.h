@@ -38,6 +38,11 @@ public:
 
     virtual void SetPositionAndRotation(const float3& position, const quaternion& rotation) = 0;
 
+    //position and rotation are from the last published snapshot of the simulation, see IPhysicsSystem::WaitForStep.
+    //prev is the state before the last simulation step, equal to the current state after teleporting the body
+    virtual float3 GetPrevPosition() const = 0;
+    virtual quaternion GetPrevRotation() const = 0;
+
     virtual float3 GetLinearVelocity() const = 0;
     virtual void SetLinearVelocity(const float3& velocity) = 0;
 
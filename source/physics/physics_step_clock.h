@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdint.h>
+
+//splits the frame times into fixed steps of 1 / step_rate seconds.
+//the steps only depend on the accumulated time, so the simulation is the same for any split of it into frames
+class PhysicsStepClock
+{
+public:
+    //returns the number of steps to take for this tick
+    uint32_t Tick(float delta_time)
+    {
+        const double step_time = GetStepTime();
+        m_accumulatedTime += delta_time;
+
+        uint32_t step_count = (uint32_t)(m_accumulatedTime / step_time);
+        m_accumulatedTime -= step_count * step_time;
+
+        if (step_count > m_nMaxSubsteps)
+        {
+            //the simulation slows down instead of taking ever more steps per frame
+            m_nDroppedStepCount += step_count - m_nMaxSubsteps;
+            step_count = m_nMaxSubsteps;
+        }
+
+        m_nLastStepCount = step_count;
+        m_nTotalStepCount += step_count;
+        m_nTickCount++;
+        m_interpolationAlpha = (float)(m_accumulatedTime / step_time);
+
+        return step_count;
+    }
+
+    float GetStepRate() const { return m_stepRate; }
+    void SetStepRate(float step_rate) { m_stepRate = step_rate; }
+    double GetStepTime() const { return 1.0 / m_stepRate; }
+
+    uint32_t GetMaxSubsteps() const { return m_nMaxSubsteps; }
+    void SetMaxSubsteps(uint32_t max_substeps) { m_nMaxSubsteps = max_substeps; }
+
+    //the time left over after the last tick, in steps
+    float GetInterpolationAlpha() const { return m_interpolationAlpha; }
+
+    uint32_t GetLastStepCount() const { return m_nLastStepCount; }
+    uint64_t GetTotalStepCount() const { return m_nTotalStepCount; }
+    uint64_t GetDroppedStepCount() const { return m_nDroppedStepCount; }
+    uint64_t GetTickCount() const { return m_nTickCount; }
+
+private:
+    float m_stepRate = 60.0f;
+    uint32_t m_nMaxSubsteps = 4;
+    double m_accumulatedTime = 0.0; //double, so the carried time doesn't drift over long sessions
+    float m_interpolationAlpha = 0.0f;
+
+    uint32_t m_nLastStepCount = 0;
+    uint64_t m_nTotalStepCount = 0;
+    uint64_t m_nDroppedStepCount = 0; //when a tick needed more than max substeps
+    uint64_t m_nTickCount = 0;
+};
@@ -2,6 +2,7 @@
 
 #include "physics_defines.h"
 #include "EASTL/span.h"
+#include "EASTL/vector.h"
 
 class IPhysicsShape;
 class IPhysicsRigidBody;
@@ -14,6 +15,24 @@ public:
     virtual void Initialize() = 0;
     virtual void OptimizeTLAS() = 0;
     virtual void Tick(float delta_time) = 0;
+    virtual void OnGui() = 0;
+
+    //the simulation advances in fixed steps of 1 / step_rate seconds, at most max_substeps per tick.
+    //the time left over is carried to the next tick, GetInterpolationAlpha is that time in steps
+    //and blends the bodies' previous and current states for rendering
+    virtual void SetStepRate(float step_rate) = 0;
+    virtual void SetMaxSubsteps(uint32_t max_substeps) = 0;
+    virtual float GetInterpolationAlpha() const = 0;
+
+    //with async steps, Tick only starts the steps on the task threads and they run while the frame is rendered.
+    //the bodies' positions and rotations are read from a snapshot published by WaitForStep, which waits only if the steps
+    //are still running. every other access to the simulation waits for the steps first
+    virtual void SetAsyncStepEnabled(bool value) = 0;
+    virtual bool IsAsyncStepEnabled() const = 0;
+    virtual void WaitForStep() = 0;
+
+    //logs the step and wait times per tick of the last interval_ticks ticks, every interval_ticks ticks. 0 only logs the totals at shutdown
+    virtual void SetStatsLogInterval(uint32_t interval_ticks) = 0;
 
     virtual IPhysicsShape* CreateBoxShape(const float3& half_extent) = 0;
     virtual IPhysicsShape* CreateSphereShape(float radius) = 0;
@@ -25,10 +44,20 @@ public:
     virtual IPhysicsShape* CreateMeshShape(const float* vertices, uint32_t vertex_stride, uint32_t vertex_count, const uint16_t* indices, uint32_t index_count, bool winding_order_ccw = false) = 0;
     virtual IPhysicsShape* CreateMeshShape(const float* vertices, uint32_t vertex_stride, uint32_t vertex_count, const uint32_t* indices, uint32_t index_count, bool winding_order_ccw = false) = 0;
     //todo : virtual IPhysicsShape* CreateHeightFiledShape() = 0;
+
+    //binary state of a shape, to skip baking it again. the data is only valid for the same physics system version
+    virtual bool SaveShape(const IPhysicsShape* shape, eastl::vector<uint8_t>& data) const = 0;
+    virtual IPhysicsShape* LoadShape(const void* data, uint32_t size) = 0;
+
     virtual IPhysicsRigidBody* CreateRigidBody(const IPhysicsShape* shape, PhysicsMotion motion_type, uint16_t layer, void* user_data = nullptr) = 0;
 
-    //todo : filters
-    virtual bool RayTrace(const float3& origin, const float3& direction, float max_distance, PhysicsRayTraceResult& result) const = 0;
-    //todo :virtual bool Overlap() const = 0;
-    //todo :virtual bool Sweep() const = 0;
+    virtual bool RayTrace(const float3& origin, const float3& direction, float max_distance, PhysicsRayTraceResult& result, const PhysicsQueryFilter& filter = {}) const = 0;
+
+    //batched queries, split over at most thread_count task threads (0 : all of them). the results are written to the
+    //caller's arrays, which have one element per query. Overlap writes the user data of up to max_hits bodies per query
+    //to hits[i * max_hits], and their count to hit_counts[i]. the bodies are locked like in the single RayTrace, so the
+    //batches may run while other threads create, move or remove bodies
+    virtual void RayTrace(eastl::span<const PhysicsRay> rays, eastl::span<PhysicsRayTraceResult> results, const PhysicsQueryFilter& filter = {}, uint32_t thread_count = 0) const = 0;
+    virtual void Overlap(eastl::span<const PhysicsOverlapQuery> queries, uint32_t max_hits, eastl::span<void*> hits, eastl::span<uint32_t> hit_counts, const PhysicsQueryFilter& filter = {}, uint32_t thread_count = 0) const = 0;
+    virtual void Sweep(eastl::span<const PhysicsSweepQuery> queries, eastl::span<PhysicsSweepResult> results, const PhysicsQueryFilter& filter = {}, uint32_t thread_count = 0) const = 0;
 };
\ No newline at end of file
@@ -67,6 +67,11 @@ RenderBatch& BasePass::AddBatch()
     return m_instances.emplace_back(*allocator);
 }
 
+void BasePass::AddBatch(const RenderBatch& batch)
+{
+    m_instances.push_back(batch);
+}
+
 void BasePass::Render1stPhase(RenderGraph* pRenderGraph)
 {
     RENDER_GRAPH_EVENT(pRenderGraph, "BasePass 1st phase");
@@ -431,13 +436,17 @@ void BasePass::Render2ndPhase(RenderGraph* pRenderGraph)
 
 void BasePass::MergeBatches()
 {
-    m_nTotalInstanceCount = (uint32_t)m_instances.size();
-
-    eastl::vector<uint32_t> instanceIndices(m_nTotalInstanceCount);
-    for (uint32_t i = 0; i < m_nTotalInstanceCount; ++i)
+    //instances whose PSO is still compiling are skipped
+    eastl::vector<uint32_t> instanceIndices;
+    instanceIndices.reserve(m_instances.size());
+    for (size_t i = 0; i < m_instances.size(); ++i)
     {
-        instanceIndices[i] = m_instances[i].instanceIndex;
+        if (m_instances[i].pso->IsReady())
+        {
+            instanceIndices.push_back(m_instances[i].instanceIndex);
+        }
     }
+    m_nTotalInstanceCount = (uint32_t)instanceIndices.size();
     m_instanceIndexAddress = m_pRenderer->AllocateSceneConstant(instanceIndices.data(), sizeof(uint32_t) * m_nTotalInstanceCount);
 
     m_nTotalMeshletCount = 0;
@@ -454,6 +463,11 @@ void BasePass::MergeBatches()
     for (size_t i = 0; i < m_instances.size(); ++i)
     {
         const RenderBatch& batch = m_instances[i];
+        if (!batch.pso->IsReady())
+        {
+            continue;
+        }
+
         if (batch.pso->GetType() == GfxPipelineType::MeshShading)
         {
             m_nTotalMeshletCount += batch.meshletCount;
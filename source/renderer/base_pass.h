@@ -11,6 +11,7 @@ public:
     BasePass(Renderer* pRenderer);
 
     RenderBatch& AddBatch();
+    void AddBatch(const RenderBatch& batch);
     void Render1stPhase(RenderGraph* pRenderGraph);
     void Render2ndPhase(RenderGraph* pRenderGraph);
 
@@ -0,0 +1,181 @@
+#include "blas_refit_scheduler.h"
+#include "utils/gui_util.h"
+#include "EASTL/sort.h"
+
+//BLASes not requested for this many frames are forgotten, e.g. when their mesh was destroyed
+#define STALE_STATE_FRAMES (600)
+
+inline uint32_t GetVertexCount(const IGfxRayTracingBLAS* blas)
+{
+    const GfxRayTracingBLASDesc& desc = blas->GetDesc();
+
+    uint32_t vertex_count = 0;
+    for (size_t i = 0; i < desc.geometries.size(); ++i)
+    {
+        vertex_count += desc.geometries[i].vertex_count;
+    }
+    return vertex_count;
+}
+
+//a rebuild reads the vertices the BLAS was created with, skinned meshes ping-pong between two position buffers
+//so this is true every other skinned frame
+inline bool IsBuiltFrom(const IGfxRayTracingBLAS* blas, const IGfxBuffer* vertex_buffer, uint32_t vertex_buffer_offset)
+{
+    const GfxRayTracingBLASDesc& desc = blas->GetDesc();
+    return desc.geometries.size() == 1 &&
+        desc.geometries[0].vertex_buffer == vertex_buffer &&
+        desc.geometries[0].vertex_buffer_offset == vertex_buffer_offset;
+}
+
+void BLASRefitScheduler::AddRequest(const Request& request)
+{
+    m_requests.push_back(request);
+}
+
+void BLASRefitScheduler::Schedule(uint64_t frame, const float3& camera_pos, eastl::vector<Request>& refits, eastl::vector<IGfxRayTracingBLAS*>& rebuilds)
+{
+    m_stats = {};
+    m_stats.requests = (uint32_t)m_requests.size();
+
+    m_sortedRequests.clear();
+    m_sortedRequests.reserve(m_requests.size());
+
+    for (size_t i = 0; i < m_requests.size(); ++i)
+    {
+        const Request& request = m_requests[i];
+
+        auto iter = m_states.find(request.blas);
+        if (iter == m_states.end())
+        {
+            //the BLAS was built when its mesh was created
+            State state;
+            state.lastRefitFrame = frame;
+            state.lastRefitCenter = request.center;
+            iter = m_states.insert(eastl::make_pair(request.blas, state)).first;
+        }
+        iter->second.lastRequestFrame = frame;
+
+        m_sortedRequests.push_back({ (uint32_t)i, CalcPriority(request, iter->second, frame, camera_pos) });
+    }
+
+    eastl::sort(m_sortedRequests.begin(), m_sortedRequests.end(), [](const PrioritizedRequest& lhs, const PrioritizedRequest& rhs)
+        {
+            return lhs.priority > rhs.priority;
+        });
+
+    for (size_t i = 0; i < m_sortedRequests.size(); ++i)
+    {
+        const Request& request = m_requests[m_sortedRequests[i].index];
+        State& state = m_states[request.blas];
+        uint32_t vertex_count = GetVertexCount(request.blas);
+
+        bool over_budget = m_stats.refits + m_stats.rebuilds >= m_settings.maxRefits ||
+            (i > 0 && m_stats.vertices + vertex_count > m_settings.vertexBudget);
+
+        if (over_budget)
+        {
+            m_stats.skipped++;
+            m_stats.maxAge = max(m_stats.maxAge, (uint32_t)(frame - state.lastRefitFrame));
+            continue;
+        }
+
+        bool rebuild = false;
+        if (state.refitsSinceRebuild >= m_settings.rebuildInterval)
+        {
+            if (m_stats.rebuilds < m_settings.maxRebuilds && IsBuiltFrom(request.blas, request.vertex_buffer, request.vertex_buffer_offset))
+            {
+                rebuild = true;
+            }
+            else
+            {
+                m_stats.deferredRebuilds++;
+            }
+        }
+
+        if (rebuild)
+        {
+            rebuilds.push_back(request.blas);
+            state.refitsSinceRebuild = 0;
+            m_stats.rebuilds++;
+        }
+        else
+        {
+            refits.push_back(request);
+            state.refitsSinceRebuild++;
+            m_stats.refits++;
+        }
+
+        state.lastRefitFrame = frame;
+        state.lastRefitCenter = request.center;
+        m_stats.vertices += vertex_count;
+    }
+
+    m_requests.clear();
+
+    RemoveStaleStates(frame);
+}
+
+float BLASRefitScheduler::CalcPriority(const Request& request, const State& state, uint64_t frame, const float3& camera_pos) const
+{
+    float radius = max(request.radius, 0.01f);
+
+    //roughly proportional to the size on screen, 1 when the camera is inside the bounds
+    float closeness = radius / max(distance(request.center, camera_pos), radius);
+
+    float motion = distance(request.center, state.lastRefitCenter) / radius;
+    float age = (float)(frame - state.lastRefitFrame);
+
+    //far BLASes need proportionally more age or motion to be picked, so they are refit less often instead of never
+    return (1.0f + m_settings.motionWeight * motion + m_settings.ageWeight * age) * powf(closeness, m_settings.distanceWeight);
+}
+
+void BLASRefitScheduler::RemoveStaleStates(uint64_t frame)
+{
+    for (auto iter = m_states.begin(); iter != m_states.end();)
+    {
+        if (frame - iter->second.lastRequestFrame > STALE_STATE_FRAMES)
+        {
+            iter = m_states.erase(iter);
+        }
+        else
+        {
+            ++iter;
+        }
+    }
+}
+
+void BLASRefitScheduler::OnGui()
+{
+    int maxRefits = (int)m_settings.maxRefits;
+    if (ImGui::SliderInt("Max refits##BLASRefit", &maxRefits, 1, 512))
+    {
+        m_settings.maxRefits = (uint32_t)maxRefits;
+    }
+
+    int vertexBudget = (int)(m_settings.vertexBudget / 1024);
+    if (ImGui::SliderInt("Vertex budget (K)##BLASRefit", &vertexBudget, 16, 16 * 1024))
+    {
+        m_settings.vertexBudget = (uint32_t)vertexBudget * 1024;
+    }
+
+    int maxRebuilds = (int)m_settings.maxRebuilds;
+    if (ImGui::SliderInt("Max rebuilds##BLASRefit", &maxRebuilds, 0, 16))
+    {
+        m_settings.maxRebuilds = (uint32_t)maxRebuilds;
+    }
+
+    int rebuildInterval = (int)m_settings.rebuildInterval;
+    if (ImGui::SliderInt("Rebuild interval##BLASRefit", &rebuildInterval, 1, 1024))
+    {
+        m_settings.rebuildInterval = (uint32_t)rebuildInterval;
+    }
+
+    ImGui::SliderFloat("Distance weight##BLASRefit", &m_settings.distanceWeight, 0.0f, 4.0f);
+    ImGui::SliderFloat("Motion weight##BLASRefit", &m_settings.motionWeight, 0.0f, 16.0f);
+    ImGui::SliderFloat("Age weight##BLASRefit", &m_settings.ageWeight, 0.0f, 4.0f);
+
+    ImGui::Text("Requests : %u, tracked : %u", m_stats.requests, GetTrackedCount());
+    ImGui::Text("Refits : %u, rebuilds : %u, deferred rebuilds : %u", m_stats.refits, m_stats.rebuilds, m_stats.deferredRebuilds);
+    ImGui::Text("Skipped : %u, oldest skipped : %u frames", m_stats.skipped, m_stats.maxAge);
+    ImGui::Text("Vertices : %u", m_stats.vertices);
+}
\ No newline at end of file
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "gfx/gfx.h"
+#include "utils/math.h"
+#include "EASTL/hash_map.h"
+
+//picks which skinned BLASes are refit in a frame. the requests are prioritized by their distance to the camera, how far they moved
+//and how many frames they weren't refit, and the most important ones are refit within a vertex budget.
+//a refit keeps the topology of the BVH, so its quality degrades as the mesh deforms : every BLAS is rebuilt after rebuildInterval refits.
+//only uses the descs of the BLASes, so it can be driven by any device including the mock one
+class BLASRefitScheduler
+{
+public:
+    struct Settings
+    {
+        uint32_t maxRefits = 64; //per frame
+        uint32_t vertexBudget = 2 * 1024 * 1024; //per frame, the first request is always processed
+        uint32_t maxRebuilds = 2; //per frame
+        uint32_t rebuildInterval = 256; //refits
+        float distanceWeight = 1.0f;
+        float motionWeight = 4.0f;
+        float ageWeight = 0.5f;
+    };
+
+    struct Request
+    {
+        IGfxRayTracingBLAS* blas;
+        IGfxBuffer* vertex_buffer;
+        uint32_t vertex_buffer_offset;
+        float3 center; //world space bounds
+        float radius;
+    };
+
+    struct Stats
+    {
+        uint32_t requests = 0;
+        uint32_t refits = 0;
+        uint32_t rebuilds = 0;
+        uint32_t skipped = 0;
+        uint32_t deferredRebuilds = 0; //due, but the BLAS wasn't skinned to the buffer its geometry was built with
+        uint32_t vertices = 0;
+        uint32_t maxAge = 0; //of the skipped requests, in frames
+    };
+
+    void AddRequest(const Request& request);
+
+    //the requests are consumed, refits and rebuilds are the work of this frame
+    void Schedule(uint64_t frame, const float3& camera_pos, eastl::vector<Request>& refits, eastl::vector<IGfxRayTracingBLAS*>& rebuilds);
+
+    Settings& GetSettings() { return m_settings; }
+    const Stats& GetStats() const { return m_stats; }
+    uint32_t GetTrackedCount() const { return (uint32_t)m_states.size(); }
+
+    void OnGui();
+
+private:
+    struct State
+    {
+        uint64_t lastRequestFrame = 0;
+        uint64_t lastRefitFrame = 0;
+        uint32_t refitsSinceRebuild = 0;
+        float3 lastRefitCenter;
+    };
+
+    float CalcPriority(const Request& request, const State& state, uint64_t frame, const float3& camera_pos) const;
+    void RemoveStaleStates(uint64_t frame);
+
+private:
+    Settings m_settings;
+    Stats m_stats;
+
+    eastl::vector<Request> m_requests;
+    eastl::hash_map<IGfxRayTracingBLAS*, State> m_states;
+
+    struct PrioritizedRequest
+    {
+        uint32_t index;
+        float priority;
+    };
+    eastl::vector<PrioritizedRequest> m_sortedRequests;
+};
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "gpu_scene.h"
 #include "renderer.h"
+#include "core/engine.h"
+#include "enkiTS/TaskScheduler.h"
 
 #define MAX_CONSTANT_BUFFER_SIZE (8 * 1024 * 1024)
 #define ALLOCATION_ALIGNMENT (4)
@@ -95,50 +97,123 @@ void GpuScene::BuildRayTracingAS(IGfxCommandList* pCommandList)
 
 uint32_t GpuScene::AllocateConstantBuffer(uint32_t size)
 {
-    RE_ASSERT(m_nConstantBufferOffset + size <= MAX_CONSTANT_BUFFER_SIZE);
-
-    uint32_t address = m_nConstantBufferOffset;
-    m_nConstantBufferOffset += RoundUpPow2(size, ALLOCATION_ALIGNMENT);
+    uint32_t aligned_size = RoundUpPow2(size, ALLOCATION_ALIGNMENT);
+    uint32_t address = m_nConstantBufferOffset.fetch_add(aligned_size, eastl::memory_order_relaxed);
+    RE_ASSERT(address + size <= MAX_CONSTANT_BUFFER_SIZE);
 
     return address;
 }
 
 uint32_t GpuScene::AddInstance(const InstanceData& data, IGfxRayTracingBLAS* blas, GfxRayTracingInstanceFlag flags)
 {
-    m_instanceData.push_back(data);
-    uint32_t instance_id = (uint32_t)m_instanceData.size() - 1;
+    uint32_t instance_id = m_nInstanceCount.fetch_add(1, eastl::memory_order_relaxed);
 
-    if (blas)
+    if (m_bParallelPhase)
     {
-        float4x4 transform = transpose(data.mtxWorld);
+        ThreadData& thread_data = m_threadData[Engine::GetInstance()->GetTaskScheduler()->GetThreadNum()];
+        thread_data.instances.push_back(eastl::make_pair(instance_id, data));
 
-        GfxRayTracingInstance instance;
-        instance.blas = blas;
-        memcpy(instance.transform, &transform, sizeof(float) * 12);
-        instance.instance_id = instance_id;
-        instance.instance_mask = 0xFF; //todo
-        instance.flags = flags;
+        if (blas)
+        {
+            thread_data.raytracingInstances.push_back(GetRayTracingInstance(data, instance_id, blas, flags));
+        }
+    }
+    else
+    {
+        m_instanceData.push_back(data);
 
-        m_raytracingInstances.push_back(instance);
+        if (blas)
+        {
+            m_raytracingInstances.push_back(GetRayTracingInstance(data, instance_id, blas, flags));
+        }
     }
 
     return instance_id;
 }
 
-
 uint32_t GpuScene::AddLocalLight(const LocalLightData& data)
 {
-    m_localLightsData.push_back(data);
-    return (uint32_t)m_localLightsData.size() - 1;
+    uint32_t index = m_nLocalLightCount.fetch_add(1, eastl::memory_order_relaxed);
+
+    if (m_bParallelPhase)
+    {
+        ThreadData& thread_data = m_threadData[Engine::GetInstance()->GetTaskScheduler()->GetThreadNum()];
+        thread_data.localLights.push_back(eastl::make_pair(index, data));
+    }
+    else
+    {
+        m_localLightsData.push_back(data);
+    }
+
+    return index;
+}
+
+GfxRayTracingInstance GpuScene::GetRayTracingInstance(const InstanceData& data, uint32_t instance_id, IGfxRayTracingBLAS* blas, GfxRayTracingInstanceFlag flags) const
+{
+    float4x4 transform = transpose(data.mtxWorld);
+
+    GfxRayTracingInstance instance;
+    instance.blas = blas;
+    memcpy(instance.transform, &transform, sizeof(float) * 12);
+    instance.instance_id = instance_id;
+    instance.instance_mask = 0xFF; //todo
+    instance.flags = flags;
+
+    return instance;
 }
 
 void GpuScene::ResetFrameData()
 {
     m_instanceData.clear();
     m_localLightsData.clear();
+    m_nInstanceCount = 0;
+    m_nLocalLightCount = 0;
     m_nConstantBufferOffset = 0;
 }
 
+void GpuScene::BeginParallelPhase(uint32_t thread_count)
+{
+    RE_ASSERT(!m_bParallelPhase);
+
+    if (m_threadData.size() < thread_count)
+    {
+        m_threadData.resize(thread_count);
+    }
+
+    m_bParallelPhase = true;
+}
+
+void GpuScene::EndParallelPhase()
+{
+    RE_ASSERT(m_bParallelPhase);
+    m_bParallelPhase = false;
+
+    m_instanceData.resize(m_nInstanceCount);
+    m_localLightsData.resize(m_nLocalLightCount);
+
+    for (size_t i = 0; i < m_threadData.size(); ++i)
+    {
+        ThreadData& thread_data = m_threadData[i];
+
+        for (size_t j = 0; j < thread_data.instances.size(); ++j)
+        {
+            m_instanceData[thread_data.instances[j].first] = thread_data.instances[j].second;
+        }
+
+        for (size_t j = 0; j < thread_data.localLights.size(); ++j)
+        {
+            m_localLightsData[thread_data.localLights[j].first] = thread_data.localLights[j].second;
+        }
+
+        //the TLAS doesn't depend on the order of its instances
+        m_raytracingInstances.insert(m_raytracingInstances.end(), thread_data.raytracingInstances.begin(), thread_data.raytracingInstances.end());
+
+        thread_data.instances.clear();
+        thread_data.localLights.clear();
+        thread_data.raytracingInstances.clear();
+    }
+}
+
 void GpuScene::BeginAnimationUpdate(IGfxCommandList* pCommandList)
 {
     pCommandList->BufferBarrier(m_pSceneAnimationBuffer->GetBuffer(), GfxAccessVertexShaderSRV, GfxAccessComputeUAV);
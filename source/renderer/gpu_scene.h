@@ -4,6 +4,7 @@
 #include "utils/math.h"
 #include "OffsetAllocator/offsetAllocator.hpp"
 #include "gpu_scene.hlsli"
+#include "EASTL/atomic.h"
 
 class Renderer;
 
@@ -19,12 +20,14 @@ public:
     OffsetAllocator::Allocation AllocateAnimationBuffer(uint32_t size);
     void FreeAnimationBuffer(OffsetAllocator::Allocation allocation);
 
-    uint32_t AllocateConstantBuffer(uint32_t size);
+    uint32_t AllocateConstantBuffer(uint32_t size); //thread-safe
 
+    //thread-safe between BeginParallelPhase and EndParallelPhase, the returned index is final immediately
+    //but the data is recorded per thread and only visible in the scene after EndParallelPhase
     uint32_t AddInstance(const InstanceData& data, IGfxRayTracingBLAS* blas, GfxRayTracingInstanceFlag flags);
     uint32_t GetInstanceCount() const { return (uint32_t)m_instanceData.size(); }
 
-    uint32_t AddLocalLight(const LocalLightData& data);
+    uint32_t AddLocalLight(const LocalLightData& data); //same as AddInstance
     uint32_t GetLocalLightCount() const { return (uint32_t)m_localLightsData.size(); }
     const LocalLightData* GetLocalLights() const { return m_localLightsData.data(); }
 
@@ -32,6 +35,9 @@ public:
     void BuildRayTracingAS(IGfxCommandList* pCommandList);
     void ResetFrameData();
 
+    void BeginParallelPhase(uint32_t thread_count);
+    void EndParallelPhase();
+
     void BeginAnimationUpdate(IGfxCommandList* pCommandList);
     void EndAnimationUpdate(IGfxCommandList* pCommandList);
 
@@ -50,14 +56,29 @@ public:
 
     IGfxDescriptor* GetRayTracingTLASSRV() const { return m_pSceneTLASSRV.get(); }
 
+private:
+    GfxRayTracingInstance GetRayTracingInstance(const InstanceData& data, uint32_t instance_id, IGfxRayTracingBLAS* blas, GfxRayTracingInstanceFlag flags) const;
+
 private:
     Renderer* m_pRenderer = nullptr;
 
     eastl::vector<InstanceData> m_instanceData;
     uint32_t m_instanceDataAddress = 0;
+    eastl::atomic<uint32_t> m_nInstanceCount{ 0 };
 
     eastl::vector<LocalLightData> m_localLightsData;
     uint32_t m_localLightsDataAddress = 0;
+    eastl::atomic<uint32_t> m_nLocalLightCount{ 0 };
+
+    //filled by the worker threads during a parallel phase, scattered to their reserved indices at the end of it
+    struct ThreadData
+    {
+        eastl::vector<eastl::pair<uint32_t, InstanceData>> instances;
+        eastl::vector<eastl::pair<uint32_t, LocalLightData>> localLights;
+        eastl::vector<GfxRayTracingInstance> raytracingInstances;
+    };
+    eastl::vector<ThreadData> m_threadData;
+    bool m_bParallelPhase = false;
 
     eastl::unique_ptr<RawBuffer> m_pSceneStaticBuffer;
     eastl::unique_ptr<OffsetAllocator::Allocator> m_pSceneStaticBufferAllocator;
@@ -66,7 +87,7 @@ private:
     eastl::unique_ptr<OffsetAllocator::Allocator> m_pSceneAnimationBufferAllocator;
 
     eastl::unique_ptr<RawBuffer> m_pConstantBuffer[GFX_MAX_INFLIGHT_FRAMES]; //todo : change to gpu memory, and only update dirty regions
-    uint32_t m_nConstantBufferOffset = 0;
+    eastl::atomic<uint32_t> m_nConstantBufferOffset{ 0 };
 
     eastl::unique_ptr<IGfxRayTracingTLAS> m_pSceneTLAS;
     eastl::unique_ptr<IGfxDescriptor> m_pSceneTLASSRV;
@@ -1,6 +1,10 @@
 #include "marschner_hair_lut.h"
 #include "renderer.h"
+#include "precomputed_data_cache.h"
 #include "utils/parallel_for.h"
+#include "utils/log.h"
+#include "xxHash/xxhash.h"
+#include "sokol/sokol_time.h"
 
 // reference:
 // Marschner et al. 2003, "Light Scattering from Human Hair Fibers"
@@ -14,6 +18,9 @@ static const uint32_t textureDepth = 32;
 static const float indexOfRefraction = 1.55f;
 static const float absorption = 0.2f;
 
+// bump it when the generators change
+static const uint32_t generatorVersion = 1;
+
 // https://en.wikipedia.org/wiki/Normal_distribution
 float NormalDistribution(float sigma, float x_mu)
 {
@@ -222,12 +229,53 @@ MarschnerHairLUT::MarschnerHairLUT(Renderer* pRenderer)
 
 void MarschnerHairLUT::Generate()
 {
-    GenerateM();
-    GenerateN();
+    struct
+    {
+        uint32_t width;
+        uint32_t height;
+        uint32_t depth;
+        float ior;
+        float absorption;
+        uint32_t version;
+    } params = { textureWidth, textureHeight, textureDepth, indexOfRefraction, absorption, generatorVersion };
+    uint64_t hash = XXH3_64bits(&params, sizeof(params));
+
+    PrecomputedDataCache* cache = m_pRenderer->GetPrecomputedDataCache();
+    PrecomputedDataCache::Entry M, N;
+
+    uint64_t ticks = stm_now();
+
+    m_pM.reset(m_pRenderer->CreateTexture3D(textureWidth, textureHeight, textureDepth, 1, GfxFormat::RGBA16F, 0, "MarschnerHairLUT::M"));
+    if (cache->Load("marschner_hair_lut_m", hash, M) && M.GetSize() == sizeof(ushort4) * textureWidth * textureHeight * textureDepth)
+    {
+        m_pRenderer->UploadTexture(m_pM->GetTexture(), M.GetData());
+    }
+    else
+    {
+        eastl::vector<ushort4> data = GenerateM();
+        m_pRenderer->UploadTexture(m_pM->GetTexture(), data.data());
+        cache->Save("marschner_hair_lut_m", hash, data.data(), (uint32_t)(sizeof(ushort4) * data.size()));
+    }
+
+    m_pN.reset(m_pRenderer->CreateTexture2D(textureWidth, textureHeight, 1, GfxFormat::RGBA16F, 0, "MarschnerHairLUT::N"));
+    if (cache->Load("marschner_hair_lut_n", hash, N) && N.GetSize() == sizeof(ushort4) * textureWidth * textureHeight)
+    {
+        m_pRenderer->UploadTexture(m_pN->GetTexture(), N.GetData());
+    }
+    else
+    {
+        eastl::vector<ushort4> data = GenerateN();
+        m_pRenderer->UploadTexture(m_pN->GetTexture(), data.data());
+        cache->Save("marschner_hair_lut_n", hash, data.data(), (uint32_t)(sizeof(ushort4) * data.size()));
+    }
+
+    RE_INFO("[MarschnerHairLUT] {:.2f} ms", stm_ms(stm_since(ticks)));
 }
 
-void MarschnerHairLUT::GenerateM()
+eastl::vector<ushort4> MarschnerHairLUT::GenerateM()
 {
+    uint64_t ticks = stm_now();
+
     eastl::vector<ushort4> M(textureWidth * textureHeight * textureDepth);
 
     for (uint32_t z = 0; z < textureDepth; ++z)
@@ -269,12 +317,15 @@ void MarschnerHairLUT::GenerateM()
             });
     }
 
-    m_pM.reset(m_pRenderer->CreateTexture3D(textureWidth, textureHeight, textureDepth, 1, GfxFormat::RGBA16F, 0, "MarschnerHairLUT::M"));
-    m_pRenderer->UploadTexture(m_pM->GetTexture(), &M[0]);
+    RE_INFO("[MarschnerHairLUT] GenerateM : {:.2f} ms", stm_ms(stm_since(ticks)));
+
+    return M;
 }
 
-void MarschnerHairLUT::GenerateN()
+eastl::vector<ushort4> MarschnerHairLUT::GenerateN()
 {
+    uint64_t ticks = stm_now();
+
     eastl::vector<ushort4> N(textureWidth * textureHeight);
 
     ParallelFor(textureWidth * textureHeight, [&](uint32_t index)
@@ -301,6 +352,7 @@ void MarschnerHairLUT::GenerateN()
             );
         });
 
-    m_pN.reset(m_pRenderer->CreateTexture2D(textureWidth, textureHeight, 1, GfxFormat::RGBA16F, 0, "MarschnerHairLUT::N"));
-    m_pRenderer->UploadTexture(m_pN->GetTexture(), &N[0]);
+    RE_INFO("[MarschnerHairLUT] GenerateN : {:.2f} ms", stm_ms(stm_since(ticks)));
+
+    return N;
 }
@@ -2,6 +2,7 @@
 
 #include "resource/texture_2d.h"
 #include "resource/texture_3d.h"
+#include "utils/math.h"
 
 class Renderer;
 
@@ -16,8 +17,8 @@ public:
     Texture2D* GetN() const { return m_pN.get(); }
 
 private:
-    void GenerateM();
-    void GenerateN();
+    eastl::vector<ushort4> GenerateM();
+    eastl::vector<ushort4> GenerateN();
 
 private:
     Renderer* m_pRenderer;
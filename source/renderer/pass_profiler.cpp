@@ -0,0 +1,539 @@
+#include "pass_profiler.h"
+#include "utils/log.h"
+#include "utils/gui_util.h"
+#include "sokol/sokol_time.h"
+#include "EASTL/sort.h"
+#include <fstream>
+#include <filesystem>
+
+PassProfiler::PassProfiler(IGfxDevice* pDevice, const eastl::string& export_path) : m_pDevice(pDevice), m_exportPath(export_path)
+{
+    m_timestampFrequency = pDevice->GetTimestampFrequency();
+
+    if (m_timestampFrequency > 0)
+    {
+        GfxQueryHeapDesc heapDesc;
+        heapDesc.type = GfxQueryType::Timestamp;
+        heapDesc.count = MAX_QUERIES_PER_FRAME * GFX_MAX_INFLIGHT_FRAMES;
+        m_pQueryHeap.reset(pDevice->CreateQueryHeap(heapDesc, "PassProfiler::m_pQueryHeap"));
+    }
+
+    if (m_pQueryHeap)
+    {
+        GfxBufferDesc bufferDesc;
+        bufferDesc.stride = sizeof(uint64_t);
+        bufferDesc.size = sizeof(uint64_t) * MAX_QUERIES_PER_FRAME * GFX_MAX_INFLIGHT_FRAMES;
+        bufferDesc.memory_type = GfxMemoryType::GpuToCpu;
+        m_pReadbackBuffer.reset(pDevice->CreateBuffer(bufferDesc, "PassProfiler::m_pReadbackBuffer"));
+
+        if (m_pReadbackBuffer == nullptr)
+        {
+            m_pQueryHeap.reset();
+        }
+    }
+
+    if (m_pQueryHeap == nullptr)
+    {
+        RE_INFO("[PassProfiler] gpu timestamps are not supported by the backend, only the cpu time is recorded");
+    }
+}
+
+PassProfiler::~PassProfiler()
+{
+}
+
+void PassProfiler::BeginFrame(IGfxCommandList* pCommandList)
+{
+    uint32_t frame_index = m_pDevice->GetFrameID() % GFX_MAX_INFLIGHT_FRAMES;
+    FrameData& frame = m_frames[frame_index];
+
+    if (frame.ended)
+    {
+        CollectFrame(frame);
+    }
+
+    frame.frameID = m_pDevice->GetFrameID();
+    frame.cpuBegin = stm_now();
+    frame.cpuEnd = 0;
+    frame.ended = false;
+    frame.passes.clear();
+    m_pCurrentFrame = &frame;
+
+    //queries 0 and 1 of each frame are the frame begin/end timestamps
+    frame.queryCount = 0;
+    if (m_pQueryHeap)
+    {
+        uint32_t first = frame_index * MAX_QUERIES_PER_FRAME;
+        pCommandList->ResetQueries(m_pQueryHeap.get(), first, MAX_QUERIES_PER_FRAME);
+        pCommandList->WriteTimestamp(m_pQueryHeap.get(), first);
+        frame.queryCount = 2;
+    }
+}
+
+void PassProfiler::EndFrame(IGfxCommandList* pCommandList)
+{
+    if (m_pCurrentFrame == nullptr)
+    {
+        return;
+    }
+
+    FrameData& frame = *m_pCurrentFrame;
+    frame.cpuEnd = stm_now();
+    frame.ended = true;
+
+    if (m_pQueryHeap)
+    {
+        uint32_t first = (frame.frameID % GFX_MAX_INFLIGHT_FRAMES) * MAX_QUERIES_PER_FRAME;
+        pCommandList->WriteTimestamp(m_pQueryHeap.get(), first + 1);
+        pCommandList->ResolveQueries(m_pQueryHeap.get(), first, frame.queryCount, m_pReadbackBuffer.get(), sizeof(uint64_t) * first);
+    }
+
+    m_pCurrentFrame = nullptr;
+}
+
+uint32_t PassProfiler::BeginPass(IGfxCommandList* pCommandList, const eastl::string& name)
+{
+    if (m_pCurrentFrame == nullptr)
+    {
+        return UINT32_MAX;
+    }
+
+    FrameData& frame = *m_pCurrentFrame;
+
+    PassRecord& record = frame.passes.push_back();
+    record.name = name;
+    record.cpuBegin = stm_now();
+
+    if (m_pQueryHeap && pCommandList->GetQueue() == GfxCommandQueue::Graphics && frame.queryCount + 2 <= MAX_QUERIES_PER_FRAME)
+    {
+        record.query = frame.queryCount;
+        frame.queryCount += 2;
+
+        uint32_t first = (frame.frameID % GFX_MAX_INFLIGHT_FRAMES) * MAX_QUERIES_PER_FRAME;
+        pCommandList->WriteTimestamp(m_pQueryHeap.get(), first + record.query);
+    }
+
+    return (uint32_t)frame.passes.size() - 1;
+}
+
+void PassProfiler::EndPass(IGfxCommandList* pCommandList, uint32_t pass)
+{
+    if (m_pCurrentFrame == nullptr || pass >= m_pCurrentFrame->passes.size())
+    {
+        return;
+    }
+
+    FrameData& frame = *m_pCurrentFrame;
+    PassRecord& record = frame.passes[pass];
+    record.cpuEnd = stm_now();
+
+    if (record.query != UINT32_MAX)
+    {
+        uint32_t first = (frame.frameID % GFX_MAX_INFLIGHT_FRAMES) * MAX_QUERIES_PER_FRAME;
+        pCommandList->WriteTimestamp(m_pQueryHeap.get(), first + record.query + 1);
+    }
+}
+
+void PassProfiler::SetBudget(const eastl::string& name, const Budget& budget)
+{
+    m_budgets[name] = budget;
+
+    auto iter = m_history.find(name);
+    if (iter != m_history.end())
+    {
+        iter->second.budget = budget;
+    }
+}
+
+PassProfiler::Stats PassProfiler::GetCpuStats(const eastl::string& name) const
+{
+    auto iter = m_history.find(name);
+    return iter != m_history.end() ? CalcStats(iter->second.cpu, iter->second.count) : Stats();
+}
+
+PassProfiler::Stats PassProfiler::GetGpuStats(const eastl::string& name) const
+{
+    auto iter = m_history.find(name);
+    return iter != m_history.end() ? CalcStats(iter->second.gpu, iter->second.count) : Stats();
+}
+
+uint32_t PassProfiler::GetOverBudgetFrames(const eastl::string& name) const
+{
+    auto iter = m_history.find(name);
+    return iter != m_history.end() ? iter->second.overBudgetFrames : 0;
+}
+
+PassProfiler::Stats PassProfiler::CalcStats(const float* samples, uint32_t count)
+{
+    eastl::vector<float> sorted;
+    sorted.reserve(count);
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (samples[i] >= 0.0f)
+        {
+            sorted.push_back(samples[i]);
+        }
+    }
+
+    Stats stats;
+    if (sorted.empty())
+    {
+        return stats;
+    }
+
+    eastl::sort(sorted.begin(), sorted.end());
+
+    double sum = 0.0;
+    for (size_t i = 0; i < sorted.size(); ++i)
+    {
+        sum += sorted[i];
+    }
+
+    auto percentile = [&](float p)
+    {
+        size_t rank = (size_t)ceilf(p * sorted.size());
+        return sorted[eastl::max(rank, (size_t)1) - 1];
+    };
+
+    stats.count = (uint32_t)sorted.size();
+    stats.min = sorted.front();
+    stats.max = sorted.back();
+    stats.avg = (float)(sum / sorted.size());
+    stats.p50 = percentile(0.50f);
+    stats.p95 = percentile(0.95f);
+    stats.p99 = percentile(0.99f);
+    return stats;
+}
+
+double PassProfiler::GetGpuTime(const uint64_t* timestamps, uint32_t query) const
+{
+    uint64_t begin = timestamps[query];
+    uint64_t end = timestamps[query + 1];
+    if (end < begin)
+    {
+        return -1.0;
+    }
+
+    return (double)(end - begin) * 1000.0 / m_timestampFrequency;
+}
+
+void PassProfiler::CollectFrame(FrameData& frame)
+{
+    const uint64_t* timestamps = nullptr;
+    if (m_pQueryHeap)
+    {
+        uint32_t first = (frame.frameID % GFX_MAX_INFLIGHT_FRAMES) * MAX_QUERIES_PER_FRAME;
+        timestamps = (const uint64_t*)m_pReadbackBuffer->GetCpuAddress() + first;
+    }
+
+    double frameGpuBegin = 0.0; //microseconds
+    if (timestamps)
+    {
+        frameGpuBegin = (double)timestamps[0] * 1000000.0 / m_timestampFrequency;
+        if (m_gpuTraceOffset < 0.0)
+        {
+            m_gpuTraceOffset = stm_us(frame.cpuBegin) - frameGpuBegin;
+        }
+    }
+
+    eastl::vector<TraceEvent>& trace = m_traceFrames[m_nTraceFrameIndex];
+    m_nTraceFrameIndex = (m_nTraceFrameIndex + 1) % TRACE_FRAME_COUNT;
+    trace.clear();
+
+    //passes with the same name are summed up
+    eastl::hash_map<eastl::string, eastl::pair<float, float>> passTimes;
+    m_passOrder.clear();
+    m_passOrder.push_back("Frame");
+
+    for (size_t i = 0; i < frame.passes.size(); ++i)
+    {
+        const PassRecord& record = frame.passes[i];
+
+        TraceEvent event;
+        event.name = record.name;
+        event.cpuBegin = stm_us(record.cpuBegin);
+        event.cpuDuration = stm_us(stm_diff(record.cpuEnd, record.cpuBegin));
+        event.gpuBegin = 0.0;
+        event.gpuDuration = -1.0;
+
+        if (timestamps && record.query != UINT32_MAX)
+        {
+            double gpu = GetGpuTime(timestamps, record.query);
+            if (gpu >= 0.0)
+            {
+                event.gpuBegin = (double)timestamps[record.query] * 1000000.0 / m_timestampFrequency + m_gpuTraceOffset;
+                event.gpuDuration = gpu * 1000.0;
+            }
+        }
+        trace.push_back(event);
+
+        float cpu = (float)(event.cpuDuration / 1000.0);
+        float gpu = (float)(event.gpuDuration / 1000.0);
+
+        auto iter = passTimes.find(record.name);
+        if (iter == passTimes.end())
+        {
+            passTimes.insert(eastl::make_pair(record.name, eastl::make_pair(cpu, gpu)));
+            m_passOrder.push_back(record.name);
+        }
+        else
+        {
+            iter->second.first += cpu;
+            iter->second.second = iter->second.second < 0.0f ? gpu : iter->second.second + eastl::max(gpu, 0.0f);
+        }
+    }
+
+    float frameCpu = (float)stm_ms(stm_diff(frame.cpuEnd, frame.cpuBegin));
+    float frameGpu = timestamps ? (float)GetGpuTime(timestamps, 0) : -1.0f;
+    AddSample("Frame", frameCpu, frameGpu, frame.frameID);
+
+    for (size_t i = 1; i < m_passOrder.size(); ++i)
+    {
+        const eastl::pair<float, float>& times = passTimes[m_passOrder[i]];
+        AddSample(m_passOrder[i], times.first, times.second, frame.frameID);
+    }
+    frame.ended = false;
+}
+
+void PassProfiler::AddSample(const eastl::string& name, float cpu, float gpu, uint64_t frameID)
+{
+    auto iter = m_history.find(name);
+    if (iter == m_history.end())
+    {
+        iter = m_history.insert(eastl::make_pair(name, PassHistory())).first;
+
+        auto budget = m_budgets.find(name);
+        if (budget != m_budgets.end())
+        {
+            iter->second.budget = budget->second;
+        }
+    }
+
+    PassHistory& history = iter->second;
+    history.cpu[history.next] = cpu;
+    history.gpu[history.next] = gpu;
+    history.next = (history.next + 1) % HISTORY_SIZE;
+    history.count = eastl::min(history.count + 1, HISTORY_SIZE);
+    history.lastFrame = frameID;
+
+    const Budget& budget = history.budget;
+    bool overBudget = (budget.gpu > 0.0f && gpu > budget.gpu) || (budget.cpu > 0.0f && cpu > budget.cpu);
+    if (overBudget)
+    {
+        ++history.overBudgetFrames;
+
+        //only warns when a pass goes over budget, not for every frame it stays there
+        if (!history.overBudget)
+        {
+            RE_WARN("[PassProfiler] {} is over budget in frame {} : gpu {:.3f}/{:.3f} ms, cpu {:.3f}/{:.3f} ms",
+                name, frameID, gpu, budget.gpu, cpu, budget.cpu);
+        }
+    }
+    history.overBudget = overBudget;
+}
+
+bool PassProfiler::ExportCSV(const eastl::string& file) const
+{
+    std::filesystem::path directory = std::filesystem::path(file.c_str()).parent_path();
+    if (!directory.empty())
+    {
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+    }
+
+    std::ofstream stream(file.c_str());
+    if (stream.fail())
+    {
+        RE_ERROR("[PassProfiler] failed to write {}", file);
+        return false;
+    }
+
+    stream << "pass,samples,cpu_min,cpu_avg,cpu_max,cpu_p50,cpu_p95,cpu_p99,gpu_min,gpu_avg,gpu_max,gpu_p50,gpu_p95,gpu_p99,cpu_budget,gpu_budget,over_budget_frames\n";
+
+    eastl::vector<eastl::string> names;
+    for (auto iter = m_history.begin(); iter != m_history.end(); ++iter)
+    {
+        names.push_back(iter->first);
+    }
+    eastl::sort(names.begin(), names.end());
+
+    for (size_t i = 0; i < names.size(); ++i)
+    {
+        const PassHistory& history = m_history.find(names[i])->second;
+        Stats cpu = CalcStats(history.cpu, history.count);
+        Stats gpu = CalcStats(history.gpu, history.count);
+
+        stream << fmt::format("\"{}\",{},{:.4f},{:.4f},{:.4f},{:.4f},{:.4f},{:.4f},{:.4f},{:.4f},{:.4f},{:.4f},{:.4f},{:.4f},{:.4f},{:.4f},{}\n",
+            names[i], history.count,
+            cpu.min, cpu.avg, cpu.max, cpu.p50, cpu.p95, cpu.p99,
+            gpu.min, gpu.avg, gpu.max, gpu.p50, gpu.p95, gpu.p99,
+            history.budget.cpu, history.budget.gpu, history.overBudgetFrames);
+    }
+
+    RE_INFO("[PassProfiler] exported {} passes to {}", names.size(), file);
+    return true;
+}
+
+static eastl::string EscapeJson(const eastl::string& str)
+{
+    eastl::string result;
+    for (char c : str)
+    {
+        if (c == '"' || c == '\\')
+        {
+            result += '\\';
+        }
+        result += c;
+    }
+    return result;
+}
+
+bool PassProfiler::ExportChromeTrace(const eastl::string& file) const
+{
+    std::filesystem::path directory = std::filesystem::path(file.c_str()).parent_path();
+    if (!directory.empty())
+    {
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+    }
+
+    std::ofstream stream(file.c_str());
+    if (stream.fail())
+    {
+        RE_ERROR("[PassProfiler] failed to write {}", file);
+        return false;
+    }
+
+    //the gpu events are aligned with the cpu clock at the first collected frame, without calibration they may drift
+    stream << "{\"traceEvents\":[\n";
+    stream << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"CPU\"}},\n";
+    stream << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"GPU\"}}";
+
+    uint32_t eventCount = 0;
+    for (uint32_t i = 0; i < TRACE_FRAME_COUNT; ++i)
+    {
+        const eastl::vector<TraceEvent>& trace = m_traceFrames[(m_nTraceFrameIndex + i) % TRACE_FRAME_COUNT];
+
+        for (size_t j = 0; j < trace.size(); ++j)
+        {
+            const TraceEvent& event = trace[j];
+            eastl::string name = EscapeJson(event.name);
+
+            stream << fmt::format(",\n{{\"name\":\"{}\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":{:.3f},\"dur\":{:.3f}}}", name, event.cpuBegin, event.cpuDuration);
+
+            if (event.gpuDuration >= 0.0)
+            {
+                stream << fmt::format(",\n{{\"name\":\"{}\",\"ph\":\"X\",\"pid\":1,\"tid\":0,\"ts\":{:.3f},\"dur\":{:.3f}}}", name, event.gpuBegin, event.gpuDuration);
+            }
+            ++eventCount;
+        }
+    }
+
+    stream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+    RE_INFO("[PassProfiler] exported {} events to {}", eventCount, file);
+    return true;
+}
+
+void PassProfiler::OnGui()
+{
+    if (!IsGpuTimingSupported())
+    {
+        ImGui::Text("GPU timestamps are not supported by this backend");
+    }
+
+    if (ImGui::RadioButton("GPU##PassProfiler", !m_bShowCpu))
+    {
+        m_bShowCpu = false;
+    }
+    ImGui::SameLine();
+    if (ImGui::RadioButton("CPU##PassProfiler", m_bShowCpu))
+    {
+        m_bShowCpu = true;
+    }
+
+    ImGui::SameLine();
+    if (ImGui::Button("Export CSV##PassProfiler"))
+    {
+        ExportCSV(m_exportPath + "passes.csv");
+    }
+
+    ImGui::SameLine();
+    if (ImGui::Button("Export Chrome Trace##PassProfiler"))
+    {
+        ExportChromeTrace(m_exportPath + "passes.json");
+    }
+
+    ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY | ImGuiTableFlags_SizingFixedFit;
+    if (!ImGui::BeginTable("PassProfiler", 9, flags))
+    {
+        return;
+    }
+
+    ImGui::TableSetupScrollFreeze(0, 1);
+    ImGui::TableSetupColumn("Pass", ImGuiTableColumnFlags_WidthStretch);
+    ImGui::TableSetupColumn("min");
+    ImGui::TableSetupColumn("avg");
+    ImGui::TableSetupColumn("max");
+    ImGui::TableSetupColumn("p50");
+    ImGui::TableSetupColumn("p95");
+    ImGui::TableSetupColumn("p99");
+    ImGui::TableSetupColumn("budget");
+    ImGui::TableSetupColumn("over");
+    ImGui::TableHeadersRow();
+
+    for (size_t i = 0; i < m_passOrder.size(); ++i)
+    {
+        const eastl::string& name = m_passOrder[i];
+        PassHistory& history = m_history[name];
+        Stats stats = CalcStats(m_bShowCpu ? history.cpu : history.gpu, history.count);
+
+        ImGui::PushID(name.c_str());
+        ImGui::TableNextRow();
+
+        ImGui::TableNextColumn();
+        if (history.overBudget)
+        {
+            ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "%s", name.c_str());
+        }
+        else
+        {
+            ImGui::Text("%s", name.c_str());
+        }
+
+        if (stats.count > 0)
+        {
+            float values[] = { stats.min, stats.avg, stats.max, stats.p50, stats.p95, stats.p99 };
+            for (uint32_t j = 0; j < 6; ++j)
+            {
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", values[j]);
+            }
+        }
+        else
+        {
+            for (uint32_t j = 0; j < 6; ++j)
+            {
+                ImGui::TableNextColumn();
+                ImGui::Text("-");
+            }
+        }
+
+        ImGui::TableNextColumn();
+        Budget budget = history.budget;
+        float& value = m_bShowCpu ? budget.cpu : budget.gpu;
+        ImGui::SetNextItemWidth(60.0f);
+        if (ImGui::InputFloat("##budget", &value, 0.0f, 0.0f, "%.2f"))
+        {
+            SetBudget(name, budget);
+        }
+
+        ImGui::TableNextColumn();
+        ImGui::Text("%d", history.overBudgetFrames);
+
+        ImGui::PopID();
+    }
+
+    ImGui::EndTable();
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "gfx/gfx.h"
+#include "EASTL/hash_map.h"
+#include "EASTL/unique_ptr.h"
+
+// records the cpu time of each render graph pass, and its gpu time with timestamp queries when the backend supports them.
+// timings are read back GFX_MAX_INFLIGHT_FRAMES frames later and kept in a rolling history
+class PassProfiler
+{
+public:
+    static const uint32_t HISTORY_SIZE = 256;
+    static const uint32_t TRACE_FRAME_COUNT = 32;
+    static const uint32_t MAX_QUERIES_PER_FRAME = 512;
+
+    struct Stats
+    {
+        float min = 0.0f;
+        float avg = 0.0f;
+        float max = 0.0f;
+        float p50 = 0.0f;
+        float p95 = 0.0f;
+        float p99 = 0.0f;
+        uint32_t count = 0;
+    };
+
+    //in milliseconds, 0 means no budget
+    struct Budget
+    {
+        float gpu = 0.0f;
+        float cpu = 0.0f;
+    };
+
+    //the profiler window exports to export_path
+    PassProfiler(IGfxDevice* pDevice, const eastl::string& export_path);
+    ~PassProfiler();
+
+    bool IsGpuTimingSupported() const { return m_pQueryHeap != nullptr; }
+
+    //the frame's slot must not be in flight anymore, i.e. after waiting for the frame fence
+    void BeginFrame(IGfxCommandList* pCommandList);
+    void EndFrame(IGfxCommandList* pCommandList);
+
+    //gpu timestamps are only written on the graphics queue, passes on other queues get the cpu time only
+    uint32_t BeginPass(IGfxCommandList* pCommandList, const eastl::string& name);
+    void EndPass(IGfxCommandList* pCommandList, uint32_t pass);
+
+    void SetBudget(const eastl::string& name, const Budget& budget);
+
+    Stats GetCpuStats(const eastl::string& name) const;
+    Stats GetGpuStats(const eastl::string& name) const;
+    uint32_t GetOverBudgetFrames(const eastl::string& name) const;
+
+    bool ExportCSV(const eastl::string& file) const;
+    bool ExportChromeTrace(const eastl::string& file) const;
+
+    void OnGui();
+
+    //samples < 0 are skipped, the percentiles use the nearest rank
+    static Stats CalcStats(const float* samples, uint32_t count);
+
+private:
+    struct PassRecord
+    {
+        eastl::string name;
+        uint64_t cpuBegin = 0;
+        uint64_t cpuEnd = 0;
+        uint32_t query = UINT32_MAX; //begin and end timestamps at query, query + 1
+    };
+
+    struct FrameData
+    {
+        uint64_t frameID = 0;
+        uint64_t cpuBegin = 0;
+        uint64_t cpuEnd = 0;
+        uint32_t queryCount = 0;
+        bool ended = false;
+        eastl::vector<PassRecord> passes;
+    };
+
+    struct PassHistory
+    {
+        float cpu[HISTORY_SIZE];
+        float gpu[HISTORY_SIZE];
+        uint32_t next = 0;
+        uint32_t count = 0;
+        uint64_t lastFrame = 0;
+
+        Budget budget;
+        uint32_t overBudgetFrames = 0;
+        bool overBudget = false;
+    };
+
+    struct TraceEvent
+    {
+        eastl::string name;
+        double cpuBegin; //microseconds
+        double cpuDuration;
+        double gpuBegin;
+        double gpuDuration; //< 0 without gpu timing
+    };
+
+    void CollectFrame(FrameData& frame);
+    void AddSample(const eastl::string& name, float cpu, float gpu, uint64_t frameID);
+    double GetGpuTime(const uint64_t* timestamps, uint32_t query) const; //milliseconds between the two timestamps
+
+private:
+    IGfxDevice* m_pDevice = nullptr;
+    eastl::string m_exportPath;
+    eastl::unique_ptr<IGfxQueryHeap> m_pQueryHeap;
+    eastl::unique_ptr<IGfxBuffer> m_pReadbackBuffer;
+    uint64_t m_timestampFrequency = 0;
+
+    FrameData m_frames[GFX_MAX_INFLIGHT_FRAMES];
+    FrameData* m_pCurrentFrame = nullptr;
+
+    eastl::hash_map<eastl::string, PassHistory> m_history;
+    eastl::hash_map<eastl::string, Budget> m_budgets; //also kept for passes which haven't run yet
+    eastl::vector<eastl::string> m_passOrder; //of the last collected frame
+
+    eastl::vector<TraceEvent> m_traceFrames[TRACE_FRAME_COUNT];
+    uint32_t m_nTraceFrameIndex = 0;
+    double m_gpuTraceOffset = -1.0; //aligns the gpu clock with the cpu clock at the first collected frame
+
+    bool m_bShowCpu = true;
+};
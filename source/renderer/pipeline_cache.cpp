@@ -1,16 +1,19 @@
 #include "pipeline_cache.h"
 #include "renderer.h"
+#include "shader_cache.h"
+#include "precomputed_data_cache.h"
+#include "core/engine.h"
+#include "gfx/gfx_command_capture.h"
+#include "utils/log.h"
+#include "enkiTS/TaskScheduler.h"
+#include <filesystem>
+
+//bump when the layout of the warm-up list changes
+#define PSO_WARMUP_VERSION 1
 
 inline bool operator==(const GfxGraphicsPipelineDesc& lhs, const GfxGraphicsPipelineDesc& rhs)
 {
-    if (lhs.vs->GetHash() != rhs.vs->GetHash())
-    {
-        return false;
-    }
-
-    uint64_t lhs_ps_hash = lhs.ps ? lhs.ps->GetHash() : 0;
-    uint64_t rhs_ps_hash = rhs.ps ? rhs.ps->GetHash() : 0;
-    if (lhs_ps_hash != rhs_ps_hash)
+    if (lhs.vs != rhs.vs || lhs.ps != rhs.ps)
     {
         return false;
     }
@@ -24,21 +27,7 @@ inline bool operator==(const GfxGraphicsPipelineDesc& lhs, const GfxGraphicsPipe
 
 inline bool operator==(const GfxMeshShadingPipelineDesc& lhs, const GfxMeshShadingPipelineDesc& rhs)
 {
-    if (lhs.ms->GetHash() != rhs.ms->GetHash())
-    {
-        return false;
-    }
-
-    uint64_t lhs_ps_hash = lhs.ps ? lhs.ps->GetHash() : 0;
-    uint64_t rhs_ps_hash = rhs.ps ? rhs.ps->GetHash() : 0;
-    if (lhs_ps_hash != rhs_ps_hash)
-    {
-        return false;
-    }
-
-    uint64_t lhs_as_hash = lhs.as ? lhs.as->GetHash() : 0;
-    uint64_t rhs_as_hash = rhs.as ? rhs.as->GetHash() : 0;
-    if (lhs_as_hash != rhs_as_hash)
+    if (lhs.ms != rhs.ms || lhs.as != rhs.as || lhs.ps != rhs.ps)
     {
         return false;
     }
@@ -52,7 +41,7 @@ inline bool operator==(const GfxMeshShadingPipelineDesc& lhs, const GfxMeshShadi
 
 inline bool operator==(const GfxComputePipelineDesc& lhs, const GfxComputePipelineDesc& rhs)
 {
-    return lhs.cs->GetHash() == rhs.cs->GetHash();
+    return lhs.cs == rhs.cs;
 }
 
 PipelineStateCache::PipelineStateCache(Renderer* pRenderer)
@@ -60,8 +49,15 @@ PipelineStateCache::PipelineStateCache(Renderer* pRenderer)
     m_pRenderer = pRenderer;
 }
 
+PipelineStateCache::~PipelineStateCache()
+{
+    WaitForAll();
+}
+
 IGfxPipelineState* PipelineStateCache::GetPipelineState(const GfxGraphicsPipelineDesc& desc, const eastl::string& name)
 {
+    std::scoped_lock lock(m_psoMutex);
+
     auto iter = m_cachedGraphicsPSO.find(desc);
     if (iter != m_cachedGraphicsPSO.end())
     {
@@ -71,6 +67,7 @@ IGfxPipelineState* PipelineStateCache::GetPipelineState(const GfxGraphicsPipelin
     IGfxPipelineState* pPSO = m_pRenderer->GetDevice()->CreateGraphicsPipelineState(desc, name);
     if (pPSO)
     {
+        CreateAsync(pPSO, { desc.vs, desc.ps });
         m_cachedGraphicsPSO.insert(eastl::make_pair(desc, eastl::unique_ptr<IGfxPipelineState>(pPSO)));
     }
 
@@ -79,6 +76,8 @@ IGfxPipelineState* PipelineStateCache::GetPipelineState(const GfxGraphicsPipelin
 
 IGfxPipelineState* PipelineStateCache::GetPipelineState(const GfxMeshShadingPipelineDesc& desc, const eastl::string& name)
 {
+    std::scoped_lock lock(m_psoMutex);
+
     auto iter = m_cachedMeshShadingPSO.find(desc);
     if (iter != m_cachedMeshShadingPSO.end())
     {
@@ -88,6 +87,7 @@ IGfxPipelineState* PipelineStateCache::GetPipelineState(const GfxMeshShadingPipe
     IGfxPipelineState* pPSO = m_pRenderer->GetDevice()->CreateMeshShadingPipelineState(desc, name);
     if (pPSO)
     {
+        CreateAsync(pPSO, { desc.as, desc.ms, desc.ps });
         m_cachedMeshShadingPSO.insert(eastl::make_pair(desc, eastl::unique_ptr<IGfxPipelineState>(pPSO)));
     }
 
@@ -96,6 +96,8 @@ IGfxPipelineState* PipelineStateCache::GetPipelineState(const GfxMeshShadingPipe
 
 IGfxPipelineState* PipelineStateCache::GetPipelineState(const GfxComputePipelineDesc& desc, const eastl::string& name)
 {
+    std::scoped_lock lock(m_psoMutex);
+
     auto iter = m_cachedComputePSO.find(desc);
     if (iter != m_cachedComputePSO.end())
     {
@@ -105,12 +107,116 @@ IGfxPipelineState* PipelineStateCache::GetPipelineState(const GfxComputePipeline
     IGfxPipelineState* pPSO = m_pRenderer->GetDevice()->CreateComputePipelineState(desc, name);
     if (pPSO)
     {
+        CreateAsync(pPSO, { desc.cs });
         m_cachedComputePSO.insert(eastl::make_pair(desc, eastl::unique_ptr<IGfxPipelineState>(pPSO)));
     }
 
     return pPSO;
 }
 
+void PipelineStateCache::WaitForPipelineState(IGfxPipelineState* pso)
+{
+    enki::TaskSet* task = nullptr;
+    {
+        std::scoped_lock lock(m_psoMutex);
+
+        auto iter = m_createTasks.find(pso);
+        if (iter != m_createTasks.end())
+        {
+            task = iter->second.get();
+        }
+    }
+
+    //not waited with the lock held, the waiting thread may run other tasks which request PSOs
+    if (task && !task->GetIsComplete())
+    {
+        Engine::GetInstance()->GetTaskScheduler()->WaitforTask(task);
+    }
+}
+
+void PipelineStateCache::WaitForAll()
+{
+    for (auto iter = m_createTasks.begin(); iter != m_createTasks.end(); ++iter)
+    {
+        if (!iter->second->GetIsComplete())
+        {
+            Engine::GetInstance()->GetTaskScheduler()->WaitforTask(iter->second.get());
+        }
+    }
+}
+
+uint32_t PipelineStateCache::GetPendingCount() const
+{
+    uint32_t count = 0;
+    for (auto iter = m_createTasks.begin(); iter != m_createTasks.end(); ++iter)
+    {
+        if (!iter->second->GetIsComplete())
+        {
+            ++count;
+        }
+    }
+    return count;
+}
+
+void PipelineStateCache::ReleaseCompletedTasks()
+{
+    std::scoped_lock lock(m_psoMutex);
+
+    for (auto iter = m_createTasks.begin(); iter != m_createTasks.end();)
+    {
+        if (iter->second->GetIsComplete())
+        {
+            iter = m_createTasks.erase(iter);
+        }
+        else
+        {
+            ++iter;
+        }
+    }
+}
+
+void PipelineStateCache::CreateAsync(IGfxPipelineState* pso, std::initializer_list<IGfxShader*> shaders)
+{
+    if (pso->IsReady())
+    {
+        return;
+    }
+
+    //the shader compile tasks are looked up here, worker threads never touch the task maps
+    eastl::vector<enki::ICompletable*> shaderTasks;
+    for (IGfxShader* shader : shaders)
+    {
+        enki::ICompletable* task = shader ? m_pRenderer->GetShaderCache()->GetCompileTask(shader) : nullptr;
+        if (task)
+        {
+            shaderTasks.push_back(task);
+        }
+    }
+
+    auto task = eastl::make_unique<enki::TaskSet>([pso, shaders = eastl::vector<IGfxShader*>(shaders), shaderTasks](enki::TaskSetPartition range, uint32_t threadnum)
+        {
+            enki::TaskScheduler* ts = Engine::GetInstance()->GetTaskScheduler();
+            for (size_t i = 0; i < shaderTasks.size(); ++i)
+            {
+                ts->WaitforTask(shaderTasks[i]);
+            }
+
+            for (size_t i = 0; i < shaders.size(); ++i)
+            {
+                if (!IsShaderReady(shaders[i]))
+                {
+                    RE_ERROR("[PipelineStateCache] {} is not created because {} failed to compile", pso->GetName(), shaders[i]->GetName());
+                    return;
+                }
+            }
+
+            pso->Create();
+        });
+
+    Engine::GetInstance()->GetTaskScheduler()->AddTaskSetToPipe(task.get());
+    m_createTasks.insert(eastl::make_pair(pso, eastl::move(task)));
+}
+
 void PipelineStateCache::RecreatePSO(IGfxShader* shader)
 {
     for (auto iter = m_cachedGraphicsPSO.begin(); iter != m_cachedGraphicsPSO.end(); ++iter)
@@ -149,3 +255,322 @@ void PipelineStateCache::RecreatePSO(IGfxShader* shader)
         }
     }
 }
+
+bool PipelineStateCache::DescribePipelineState(const IGfxPipelineState* pso, GfxCapturedPipeline& pipeline) const
+{
+    auto describe = [&](const auto& desc, std::initializer_list<const IGfxShader*> shaders)
+    {
+        using Desc = eastl::decay_t<decltype(desc)>;
+
+        pipeline.type = pso->GetType();
+        pipeline.shaderMask = 0;
+
+        uint32_t i = 0;
+        for (const IGfxShader* shader : shaders)
+        {
+            if (shader)
+            {
+                pipeline.shaders[i] = shader->GetDesc();
+                pipeline.shaderMask |= 1 << i;
+            }
+            ++i;
+        }
+
+        const size_t state_offset = offsetof(Desc, rasterizer_state);
+        pipeline.states.assign((const uint8_t*)&desc + state_offset, (const uint8_t*)&desc + sizeof(Desc));
+    };
+
+    //only called when a capture meets a PSO for the first time, a linear search is fine
+    for (auto iter = m_cachedGraphicsPSO.begin(); iter != m_cachedGraphicsPSO.end(); ++iter)
+    {
+        if (iter->second.get() == pso)
+        {
+            describe(iter->first, { iter->first.vs, iter->first.ps });
+            return true;
+        }
+    }
+
+    for (auto iter = m_cachedMeshShadingPSO.begin(); iter != m_cachedMeshShadingPSO.end(); ++iter)
+    {
+        if (iter->second.get() == pso)
+        {
+            describe(iter->first, { iter->first.as, iter->first.ms, iter->first.ps });
+            return true;
+        }
+    }
+
+    for (auto iter = m_cachedComputePSO.begin(); iter != m_cachedComputePSO.end(); ++iter)
+    {
+        if (iter->second.get() == pso)
+        {
+            const GfxComputePipelineDesc& desc = iter->first;
+            pipeline.type = GfxPipelineType::Compute;
+            pipeline.shaderMask = desc.cs ? 1 : 0;
+            if (desc.cs)
+            {
+                pipeline.shaders[0] = desc.cs->GetDesc();
+            }
+            pipeline.states.clear();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// warm-up list layout : shader count, { file, entry point, type, flags, defines } * count,
+//                       pso count, { type, name, shader indices[3], state size, states } * count
+void PipelineStateCache::LoadWarmupList()
+{
+    PrecomputedDataCache::Entry entry;
+    if (!m_pRenderer->GetPrecomputedDataCache()->Load("pso_warmup", GetWarmupListHash(), entry))
+    {
+        return;
+    }
+
+    const uint8_t* data = (const uint8_t*)entry.GetData();
+    const uint8_t* end = data + entry.GetSize();
+
+    auto read = [&](void* dst, size_t size)
+    {
+        if (data + size > end)
+        {
+            return false;
+        }
+        memcpy(dst, data, size);
+        data += size;
+        return true;
+    };
+
+    auto read_string = [&](eastl::string& str)
+    {
+        uint32_t length;
+        if (!read(&length, sizeof(uint32_t)) || data + length > end)
+        {
+            return false;
+        }
+        str.assign((const char*)data, length);
+        data += length;
+        return true;
+    };
+
+    ShaderCache* shaderCache = m_pRenderer->GetShaderCache();
+    eastl::string shaderPath = Engine::GetInstance()->GetShaderPath();
+
+    uint32_t shaderCount;
+    if (!read(&shaderCount, sizeof(uint32_t)))
+    {
+        return;
+    }
+
+    eastl::vector<IGfxShader*> shaders(shaderCount);
+    for (uint32_t i = 0; i < shaderCount; ++i)
+    {
+        eastl::string file, entryPoint;
+        GfxShaderType type;
+        GfxShaderCompilerFlags flags;
+        uint32_t defineCount;
+        if (!read_string(file) || !read_string(entryPoint) || !read(&type, sizeof(type)) || !read(&flags, sizeof(flags)) || !read(&defineCount, sizeof(uint32_t)))
+        {
+            return;
+        }
+
+        eastl::vector<eastl::string> defines(defineCount);
+        for (uint32_t j = 0; j < defineCount; ++j)
+        {
+            if (!read_string(defines[j]))
+            {
+                return;
+            }
+        }
+
+        //shaders removed since the last run are skipped with their PSOs
+        if (std::filesystem::exists((shaderPath + file).c_str()))
+        {
+            shaders[i] = shaderCache->GetShader(file, entryPoint, type, defines, flags);
+        }
+    }
+
+    auto get_shader = [&](uint32_t index, IGfxShader*& shader)
+    {
+        shader = index < shaderCount ? shaders[index] : nullptr;
+        return index == UINT32_MAX || shader != nullptr;
+    };
+
+    uint32_t psoCount;
+    if (!read(&psoCount, sizeof(uint32_t)))
+    {
+        return;
+    }
+
+    uint32_t warmupCount = 0;
+    for (uint32_t i = 0; i < psoCount; ++i)
+    {
+        GfxPipelineType type;
+        eastl::string name;
+        uint32_t shaderIndices[3];
+        uint32_t stateSize;
+        if (!read(&type, sizeof(type)) || !read_string(name) || !read(shaderIndices, sizeof(shaderIndices)) || !read(&stateSize, sizeof(uint32_t)) || data + stateSize > end)
+        {
+            return;
+        }
+
+        const uint8_t* states = data;
+        data += stateSize;
+
+        if (type == GfxPipelineType::Graphics)
+        {
+            GfxGraphicsPipelineDesc desc;
+            const size_t state_offset = offsetof(GfxGraphicsPipelineDesc, rasterizer_state);
+            if (stateSize == sizeof(desc) - state_offset && get_shader(shaderIndices[0], desc.vs) && get_shader(shaderIndices[1], desc.ps) && desc.vs)
+            {
+                memcpy((char*)&desc + state_offset, states, stateSize);
+                GetPipelineState(desc, name);
+                ++warmupCount;
+            }
+        }
+        else if (type == GfxPipelineType::MeshShading)
+        {
+            GfxMeshShadingPipelineDesc desc;
+            const size_t state_offset = offsetof(GfxMeshShadingPipelineDesc, rasterizer_state);
+            if (stateSize == sizeof(desc) - state_offset && get_shader(shaderIndices[0], desc.as) && get_shader(shaderIndices[1], desc.ms) && get_shader(shaderIndices[2], desc.ps) && desc.ms)
+            {
+                memcpy((char*)&desc + state_offset, states, stateSize);
+                GetPipelineState(desc, name);
+                ++warmupCount;
+            }
+        }
+        else if (type == GfxPipelineType::Compute)
+        {
+            GfxComputePipelineDesc desc;
+            if (get_shader(shaderIndices[0], desc.cs) && desc.cs)
+            {
+                GetPipelineState(desc, name);
+                ++warmupCount;
+            }
+        }
+    }
+
+    RE_INFO("[PipelineStateCache] warming up {} of {} PSOs from the previous run", warmupCount, psoCount);
+}
+
+void PipelineStateCache::SaveWarmupList()
+{
+    WaitForAll();
+
+    eastl::vector<uint8_t> shaderData;
+    eastl::vector<uint8_t> psoData;
+
+    auto write = [](eastl::vector<uint8_t>& data, const void* src, size_t size)
+    {
+        data.insert(data.end(), (const uint8_t*)src, (const uint8_t*)src + size);
+    };
+
+    auto write_string = [&](eastl::vector<uint8_t>& data, const eastl::string& str)
+    {
+        uint32_t length = (uint32_t)str.length();
+        write(data, &length, sizeof(uint32_t));
+        write(data, str.data(), length);
+    };
+
+    eastl::string shaderPath = std::filesystem::absolute(Engine::GetInstance()->GetShaderPath().c_str()).string().c_str();
+    eastl::hash_map<const IGfxShader*, uint32_t> shaderIndices;
+
+    auto shader_index = [&](const IGfxShader* shader)
+    {
+        if (shader == nullptr)
+        {
+            return UINT32_MAX;
+        }
+
+        auto iter = shaderIndices.find(shader);
+        if (iter != shaderIndices.end())
+        {
+            return iter->second;
+        }
+
+        //stored relative to the shader folder, which is how ShaderCache::GetShader expects them
+        const GfxShaderDesc& desc = shader->GetDesc();
+        eastl::string file = std::filesystem::path(desc.file.c_str()).lexically_relative(shaderPath.c_str()).generic_string().c_str();
+
+        write_string(shaderData, file);
+        write_string(shaderData, desc.entry_point);
+        write(shaderData, &desc.type, sizeof(desc.type));
+        write(shaderData, &desc.flags, sizeof(desc.flags));
+
+        uint32_t defineCount = (uint32_t)desc.defines.size();
+        write(shaderData, &defineCount, sizeof(uint32_t));
+        for (uint32_t i = 0; i < defineCount; ++i)
+        {
+            write_string(shaderData, desc.defines[i]);
+        }
+
+        uint32_t index = (uint32_t)shaderIndices.size();
+        shaderIndices.insert(eastl::make_pair(shader, index));
+        return index;
+    };
+
+    uint32_t psoCount = 0;
+    auto write_pso = [&](const IGfxPipelineState* pso, std::initializer_list<const IGfxShader*> shaders, const void* states, uint32_t stateSize)
+    {
+        //PSOs which failed to compile are not worth warming up
+        if (!pso->IsReady())
+        {
+            return;
+        }
+
+        uint32_t indices[3] = { UINT32_MAX, UINT32_MAX, UINT32_MAX };
+        uint32_t i = 0;
+        for (const IGfxShader* shader : shaders)
+        {
+            indices[i++] = shader_index(shader);
+        }
+
+        GfxPipelineType type = pso->GetType();
+        write(psoData, &type, sizeof(type));
+        write_string(psoData, pso->GetName());
+        write(psoData, indices, sizeof(indices));
+        write(psoData, &stateSize, sizeof(uint32_t));
+        write(psoData, states, stateSize);
+        ++psoCount;
+    };
+
+    for (auto iter = m_cachedGraphicsPSO.begin(); iter != m_cachedGraphicsPSO.end(); ++iter)
+    {
+        const GfxGraphicsPipelineDesc& desc = iter->first;
+        const size_t state_offset = offsetof(GfxGraphicsPipelineDesc, rasterizer_state);
+        write_pso(iter->second.get(), { desc.vs, desc.ps }, (const char*)&desc + state_offset, sizeof(desc) - state_offset);
+    }
+
+    for (auto iter = m_cachedMeshShadingPSO.begin(); iter != m_cachedMeshShadingPSO.end(); ++iter)
+    {
+        const GfxMeshShadingPipelineDesc& desc = iter->first;
+        const size_t state_offset = offsetof(GfxMeshShadingPipelineDesc, rasterizer_state);
+        write_pso(iter->second.get(), { desc.as, desc.ms, desc.ps }, (const char*)&desc + state_offset, sizeof(desc) - state_offset);
+    }
+
+    for (auto iter = m_cachedComputePSO.begin(); iter != m_cachedComputePSO.end(); ++iter)
+    {
+        write_pso(iter->second.get(), { iter->first.cs }, nullptr, 0);
+    }
+
+    eastl::vector<uint8_t> data;
+    uint32_t shaderCount = (uint32_t)shaderIndices.size();
+    write(data, &shaderCount, sizeof(uint32_t));
+    data.insert(data.end(), shaderData.begin(), shaderData.end());
+    write(data, &psoCount, sizeof(uint32_t));
+    data.insert(data.end(), psoData.begin(), psoData.end());
+
+    if (m_pRenderer->GetPrecomputedDataCache()->Save("pso_warmup", GetWarmupListHash(), data.data(), (uint32_t)data.size()))
+    {
+        RE_INFO("[PipelineStateCache] saved {} PSOs to the warm-up list", psoCount);
+    }
+}
+
+uint64_t PipelineStateCache::GetWarmupListHash() const
+{
+    //the states are stored as raw bytes, any change of the desc layouts invalidates the list
+    uint32_t settings[] = { PSO_WARMUP_VERSION, (uint32_t)m_pRenderer->GetDevice()->GetDesc().backend,
+        (uint32_t)sizeof(GfxGraphicsPipelineDesc), (uint32_t)sizeof(GfxMeshShadingPipelineDesc), (uint32_t)sizeof(GfxShaderDesc) };
+    return XXH3_64bits(settings, sizeof(settings));
+}
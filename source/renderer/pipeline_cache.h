@@ -4,6 +4,7 @@
 #include "xxHash/xxhash.h"
 #include "EASTL/hash_map.h"
 #include "EASTL/unique_ptr.h"
+#include <mutex>
 
 //cityhash Hash128to64
 inline uint64_t hash_combine_64(uint64_t hash0, uint64_t hash1)
@@ -16,6 +17,7 @@ inline uint64_t hash_combine_64(uint64_t hash0, uint64_t hash1)
     return b * kMul;
 }
 
+//PSOs are keyed by shader identity : shaders are unique per GfxShaderDesc and may still be compiling
 namespace eastl
 {
     template <>
@@ -23,8 +25,8 @@ namespace eastl
     {
         size_t operator()(const GfxGraphicsPipelineDesc& desc) const
         {
-            uint64_t vs_hash = desc.vs->GetHash();
-            uint64_t ps_hash = desc.ps ? desc.ps->GetHash() : 0;
+            uint64_t vs_hash = (uint64_t)desc.vs;
+            uint64_t ps_hash = (uint64_t)desc.ps;
 
             const size_t state_offset = offsetof(GfxGraphicsPipelineDesc, rasterizer_state);
             uint64_t state_hash = XXH3_64bits((char*)&desc + state_offset, sizeof(GfxGraphicsPipelineDesc) - state_offset);
@@ -41,9 +43,9 @@ namespace eastl
     {
         size_t operator()(const GfxMeshShadingPipelineDesc& desc) const
         {
-            uint64_t ms_hash = desc.ms->GetHash();
-            uint64_t as_hash = desc.as ? desc.as->GetHash() : 0;
-            uint64_t ps_hash = desc.ps ? desc.ps->GetHash() : 0;
+            uint64_t ms_hash = (uint64_t)desc.ms;
+            uint64_t as_hash = (uint64_t)desc.as;
+            uint64_t ps_hash = (uint64_t)desc.ps;
 
             const size_t state_offset = offsetof(GfxMeshShadingPipelineDesc, rasterizer_state);
             uint64_t state_hash = XXH3_64bits((char*)&desc + state_offset, sizeof(GfxGraphicsPipelineDesc) - state_offset);
@@ -61,26 +63,51 @@ namespace eastl
         size_t operator()(const GfxComputePipelineDesc& desc) const
         {
             static_assert(sizeof(size_t) == sizeof(uint64_t), "only supports 64 bits platforms");
-            return desc.cs->GetHash();
+            return hash_combine_64((uint64_t)desc.cs, 0);
         }
     };
 }
 
 class Renderer;
+struct GfxCapturedPipeline;
+namespace enki { class TaskSet; }
 
 class PipelineStateCache
 {
 public:
     PipelineStateCache(Renderer* pRenderer);
+    ~PipelineStateCache();
 
+    //returns immediately, PSOs with shaders still compiling are created on a worker thread once the shaders are ready. thread-safe
     IGfxPipelineState* GetPipelineState(const GfxGraphicsPipelineDesc& desc, const eastl::string& name);
     IGfxPipelineState* GetPipelineState(const GfxMeshShadingPipelineDesc& desc, const eastl::string& name);
     IGfxPipelineState* GetPipelineState(const GfxComputePipelineDesc& desc, const eastl::string& name);
 
+    void WaitForPipelineState(IGfxPipelineState* pso); //thread-safe
+    void WaitForAll();
+    uint32_t GetPendingCount() const;
+    void ReleaseCompletedTasks(); //not thread-safe with WaitForPipelineState
+
     void RecreatePSO(IGfxShader* shader);
 
+    //fills the shaders and fixed function states of a cached PSO, used by the command capture
+    bool DescribePipelineState(const IGfxPipelineState* pso, GfxCapturedPipeline& pipeline) const;
+
+    //every PSO created in a session is saved at shutdown and requested again at the next startup,
+    //so they are compiled in parallel with the other startup PSOs instead of on the render thread
+    void LoadWarmupList();
+    void SaveWarmupList();
+
+private:
+    void CreateAsync(IGfxPipelineState* pso, std::initializer_list<IGfxShader*> shaders);
+    uint64_t GetWarmupListHash() const;
+
 private:
     Renderer* m_pRenderer;
+
+    //guards the PSO and task maps, materials create their PSOs lazily from the parallel world tick
+    std::mutex m_psoMutex;
+    eastl::hash_map<IGfxPipelineState*, eastl::unique_ptr<enki::TaskSet>> m_createTasks;
     eastl::hash_map<GfxGraphicsPipelineDesc, eastl::unique_ptr<IGfxPipelineState>> m_cachedGraphicsPSO;
     eastl::hash_map<GfxMeshShadingPipelineDesc, eastl::unique_ptr<IGfxPipelineState>> m_cachedMeshShadingPSO;
     eastl::hash_map<GfxComputePipelineDesc, eastl::unique_ptr<IGfxPipelineState>> m_cachedComputePSO;
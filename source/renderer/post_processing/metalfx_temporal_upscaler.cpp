@@ -3,6 +3,7 @@
 
 #include "../renderer.h"
 #include "gfx/metal/metal_command_list.h"
+#include "gfx/gfx_command_capture.h"
 #include "core/engine.h"
 #include "utils/gui_util.h"
 
@@ -96,7 +97,7 @@ RGHandle MetalFXTemporalUpscaler::AddPass(RenderGraph* pRenderGraph, RGHandle in
             m_pUpscaler->setDepthReversed(true);
             m_pUpscaler->setReset(false);
             
-            m_pUpscaler->setFence(((MetalCommandList*)pCommandList)->GetFence());
+            m_pUpscaler->setFence(((MetalCommandList*)UnwrapCommandList(pCommandList))->GetFence());
             m_pUpscaler->encodeToCommandBuffer((MTL::CommandBuffer*)pCommandList->GetHandle());
         
             pCommandList->ResetState();
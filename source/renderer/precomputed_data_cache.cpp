@@ -0,0 +1,86 @@
+#include "precomputed_data_cache.h"
+#include "utils/log.h"
+#include <filesystem>
+#include <fstream>
+
+#define PRECOMPUTED_DATA_MAGIC 0x44434552 //'RECD'
+#define PRECOMPUTED_DATA_VERSION 1
+
+struct PrecomputedDataHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t hash;
+    uint64_t size;
+};
+
+const void* PrecomputedDataCache::Entry::GetData() const
+{
+    return m_file.GetData() + sizeof(PrecomputedDataHeader);
+}
+
+uint32_t PrecomputedDataCache::Entry::GetSize() const
+{
+    return (uint32_t)(m_file.GetSize() - sizeof(PrecomputedDataHeader));
+}
+
+PrecomputedDataCache::PrecomputedDataCache(const eastl::string& path) : m_path(path)
+{
+}
+
+bool PrecomputedDataCache::Load(const eastl::string& name, uint64_t hash, Entry& entry)
+{
+    eastl::string file = GetFilePath(name);
+
+    if (entry.m_file.Open(file) && entry.m_file.GetSize() >= sizeof(PrecomputedDataHeader))
+    {
+        const PrecomputedDataHeader* header = (const PrecomputedDataHeader*)entry.m_file.GetData();
+
+        if (header->magic == PRECOMPUTED_DATA_MAGIC &&
+            header->version == PRECOMPUTED_DATA_VERSION &&
+            header->hash == hash &&
+            header->size == entry.m_file.GetSize() - sizeof(PrecomputedDataHeader))
+        {
+            m_nHits++;
+            return true;
+        }
+
+        RE_DEBUG("[PrecomputedDataCache] {} is out of date", file);
+    }
+
+    entry.m_file.Close();
+    m_nMisses++;
+    return false;
+}
+
+bool PrecomputedDataCache::Save(const eastl::string& name, uint64_t hash, const void* data, uint32_t size)
+{
+    std::error_code error;
+    std::filesystem::create_directories(m_path.c_str(), error);
+
+    eastl::string file = GetFilePath(name);
+
+    std::ofstream os;
+    os.open(file.c_str(), std::ios::binary);
+    if (os.fail())
+    {
+        RE_WARN("[PrecomputedDataCache] failed to write {}", file);
+        return false;
+    }
+
+    PrecomputedDataHeader header = { PRECOMPUTED_DATA_MAGIC, PRECOMPUTED_DATA_VERSION, hash, size };
+    os.write((const char*)&header, sizeof(header));
+    os.write((const char*)data, size);
+
+    return !os.fail();
+}
+
+void PrecomputedDataCache::LogStats() const
+{
+    RE_INFO("[PrecomputedDataCache] hits : {}, misses : {}", m_nHits.load(), m_nMisses.load());
+}
+
+eastl::string PrecomputedDataCache::GetFilePath(const eastl::string& name) const
+{
+    return m_path + name + ".bin";
+}
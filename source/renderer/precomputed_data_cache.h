@@ -0,0 +1,37 @@
+#pragma once
+
+#include "utils/memory_mapped_file.h"
+#include "EASTL/atomic.h"
+
+// on-disk cache for CPU-generated data (LUTs, packed textures...), entries are invalidated by their parameter hash
+// thread-safe as long as concurrent calls use different names
+class PrecomputedDataCache
+{
+public:
+    class Entry
+    {
+    public:
+        const void* GetData() const;
+        uint32_t GetSize() const;
+
+    private:
+        friend class PrecomputedDataCache;
+        MemoryMappedFile m_file;
+    };
+
+    PrecomputedDataCache(const eastl::string& path);
+
+    bool Load(const eastl::string& name, uint64_t hash, Entry& entry);
+    bool Save(const eastl::string& name, uint64_t hash, const void* data, uint32_t size);
+
+    void LogStats() const;
+
+private:
+    eastl::string GetFilePath(const eastl::string& name) const;
+
+private:
+    eastl::string m_path;
+
+    eastl::atomic<uint32_t> m_nHits{ 0 };
+    eastl::atomic<uint32_t> m_nMisses{ 0 };
+};
@@ -95,6 +95,11 @@ private:
 
 inline void DrawBatch(IGfxCommandList* pCommandList, const RenderBatch& batch)
 {
+    if (!batch.pso->IsReady())
+    {
+        return; //still compiling
+    }
+
     GPU_EVENT(pCommandList, batch.label);
 
     pCommandList->SetPipelineState(batch.pso);
@@ -172,6 +177,11 @@ private:
 
 inline void DispatchBatch(IGfxCommandList* pCommandList, const ComputeBatch& batch)
 {
+    if (!batch.pso->IsReady())
+    {
+        return; //still compiling
+    }
+
     GPU_EVENT(pCommandList, batch.label);
 
     pCommandList->SetPipelineState(batch.pso);
@@ -124,6 +124,7 @@ void RenderGraph::Execute(Renderer* pRenderer, IGfxCommandList* pCommandList, IG
 {
     CPU_EVENT("Render", "RenderGraph::Execute");
     GPU_EVENT(pCommandList, "RenderGraph");
+    MemoryTagScope memoryTag(MemoryTag::RenderGraph);
 
     RenderGraphPassExecuteContext context = {};
     context.renderer = pRenderer;
@@ -1,6 +1,7 @@
 #include "render_graph_pass.h"
 #include "render_graph.h"
 #include "renderer.h"
+#include "pass_profiler.h"
 #include "EASTL/algorithm.h"
 
 RenderGraphPassBase::RenderGraphPassBase(const eastl::string& name, RenderPassType type, DirectedAcyclicGraph& graph) :
@@ -254,9 +255,14 @@ void RenderGraphPassBase::Execute(const RenderGraph& graph, RenderGraphPassExecu
     {        
         GPU_EVENT(pCommandList, m_name);
 
+        PassProfiler* pProfiler = context.renderer->GetPassProfiler();
+        uint32_t profilerPass = pProfiler->BeginPass(pCommandList, m_name);
+
         Begin(graph, pCommandList);
         ExecuteImpl(pCommandList);
         End(pCommandList);
+
+        pProfiler->EndPass(pCommandList, profilerPass);
     }
 
     for (uint32_t i = 0; i < m_nEndEventNum; ++i)
@@ -3,6 +3,8 @@
 #include "shader_compiler.h"
 #include "shader_cache.h"
 #include "pipeline_cache.h"
+#include "pass_profiler.h"
+#include "precomputed_data_cache.h"
 #include "gpu_driven_debug_line.h"
 #include "gpu_driven_debug_print.h"
 #include "gpu_driven_stats.h"
@@ -17,26 +19,42 @@
 #include "lighting/clustered_light_lists.h"
 #include "post_processing/post_processor.h"
 #include "core/engine.h"
+#include "gfx/gfx_command_capture.h"
+#include "gfx/gfx_command_replay.h"
 #include "utils/profiler.h"
 #include "utils/log.h"
+#include "utils/gui_util.h"
 #include "fmt/format.h"
+#include "enkiTS/TaskScheduler.h"
+#include "sokol/sokol_time.h"
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "stb/stb_image_write.h"
 #include "lodepng/lodepng.h"
 #include "global_constants.hlsli"
+#include <filesystem>
 
 Renderer::Renderer()
 {
     m_pShaderCache = eastl::make_unique<ShaderCache>(this);
     m_pShaderCompiler = eastl::make_unique<ShaderCompiler>(this);
     m_pPipelineCache = eastl::make_unique<PipelineStateCache>(this);
+    m_pPrecomputedDataCache = eastl::make_unique<PrecomputedDataCache>(Engine::GetInstance()->GetWorkPath() + "cache/");
     m_cbAllocator = eastl::make_unique<LinearAllocator>(8 * 1024 * 1024);
+    m_pBLASRefitScheduler = eastl::make_unique<BLASRefitScheduler>();
 
     Engine::GetInstance()->WindowResizeSignal.connect(&Renderer::OnWindowResize, this);
 }
 
 Renderer::~Renderer()
 {
+    m_pPipelineCache->WaitForAll();
+    m_pShaderCache->WaitForAll();
+
+    if (m_pDevice)
+    {
+        m_pPipelineCache->SaveWarmupList();
+    }
+
     WaitGpuFinished();
     
     if (m_pRenderGraph)
@@ -60,6 +78,7 @@ bool Renderer::CreateDevice(GfxRenderBackend backend, void* window_handle, uint3
     
     GfxDeviceDesc desc;
     desc.backend = backend;
+    desc.pipeline_cache_path = Engine::GetInstance()->GetWorkPath() + "cache/";
     m_pDevice.reset(CreateGfxDevice(desc));
     if (m_pDevice == nullptr)
     {
@@ -73,12 +92,32 @@ bool Renderer::CreateDevice(GfxRenderBackend backend, void* window_handle, uint3
     swapchainDesc.height = window_height;
     m_pSwapchain.reset(m_pDevice->CreateSwapchain(swapchainDesc, "Renderer::m_pSwapchain"));
 
+    if (m_bEnableCommandCapture)
+    {
+        PipelineStateCache* pipelineCache = m_pPipelineCache.get();
+        m_pCommandCapture = eastl::make_unique<GfxCommandCapture>(backend, [pipelineCache](const IGfxPipelineState* pso, GfxCapturedPipeline& pipeline)
+            {
+                return pipelineCache->DescribePipelineState(pso, pipeline);
+            });
+    }
+
+    //the commands are recorded only while a frame is being captured, otherwise the wrapper just forwards them
+    auto create_command_list = [&](GfxCommandQueue queue, const eastl::string& name) -> IGfxCommandList*
+    {
+        IGfxCommandList* pCommandList = m_pDevice->CreateCommandList(queue, name);
+        if (m_pCommandCapture && pCommandList)
+        {
+            pCommandList = new GfxCaptureCommandList(pCommandList, m_pCommandCapture.get());
+        }
+        return pCommandList;
+    };
+
     m_pFrameFence.reset(m_pDevice->CreateFence("Renderer::m_pFrameFence"));
 
     for (int i = 0; i < GFX_MAX_INFLIGHT_FRAMES; ++i)
     {
         eastl::string name = fmt::format("Renderer::m_pCommandLists[{}]", i).c_str();
-        m_pCommandLists[i].reset(m_pDevice->CreateCommandList(GfxCommandQueue::Graphics, name));
+        m_pCommandLists[i].reset(create_command_list(GfxCommandQueue::Graphics, name));
     }
 
     m_pAsyncComputeFence.reset(m_pDevice->CreateFence("Renderer::m_pAsyncComputeFence"));
@@ -86,7 +125,7 @@ bool Renderer::CreateDevice(GfxRenderBackend backend, void* window_handle, uint3
     for (int i = 0; i < GFX_MAX_INFLIGHT_FRAMES; ++i)
     {
         eastl::string name = fmt::format("Renderer::m_pComputeCommandLists[{}]", i).c_str();
-        m_pComputeCommandLists[i].reset(m_pDevice->CreateCommandList(GfxCommandQueue::Compute, name));
+        m_pComputeCommandLists[i].reset(create_command_list(GfxCommandQueue::Compute, name));
     }
 
     m_pUploadFence.reset(m_pDevice->CreateFence("Renderer::m_pUploadFence"));
@@ -94,11 +133,17 @@ bool Renderer::CreateDevice(GfxRenderBackend backend, void* window_handle, uint3
     for (int i = 0; i < GFX_MAX_INFLIGHT_FRAMES; ++i)
     {
         eastl::string name = fmt::format("Renderer::m_pUploadCommandList[{}]", i).c_str();
-        m_pUploadCommandList[i].reset(m_pDevice->CreateCommandList(GfxCommandQueue::Copy, name));
-
-        m_pStagingBufferAllocator[i] = eastl::make_unique<StagingBufferAllocator>(this);
+        m_pUploadCommandList[i].reset(create_command_list(GfxCommandQueue::Copy, name));
     }
 
+    m_pPassProfiler = eastl::make_unique<PassProfiler>(m_pDevice.get(), Engine::GetInstance()->GetWorkPath() + "profiler/");
+
+    m_pStagingBufferAllocator = eastl::make_unique<StagingBufferAllocator>(this, 64 * 1024 * 1024);
+
+    //the passes only record their shader/PSO requests here, everything is compiled in parallel and waited for at the end
+    m_bBatchPipelineCreation = true;
+    uint64_t compileTicks = stm_now();
+
     CreateCommonResources();
 
     m_pRenderGraph = eastl::make_unique<RenderGraph>(this);
@@ -113,6 +158,18 @@ bool Renderer::CreateDevice(GfxRenderBackend backend, void* window_handle, uint3
     m_pPathTracer = eastl::make_unique<PathTracer>(this);
     m_pSkyCubeMap = eastl::make_unique<SkyCubeMap>(this);
 
+    //PSOs requested lazily in the previous run (materials, debug views...)
+    m_pPipelineCache->LoadWarmupList();
+
+    m_bBatchPipelineCreation = false;
+    uint32_t pendingPSOCount = m_pPipelineCache->GetPendingCount();
+    m_pPipelineCache->WaitForAll();
+    m_pShaderCache->WaitForAll();
+
+    RE_INFO("[Renderer] startup shaders and PSOs ready in {:.2f} ms ({} PSOs were compiled asynchronously)", stm_ms(stm_since(compileTicks)), pendingPSOCount);
+    m_pShaderCache->LogStats();
+    m_pDevice->LogPipelineCacheStats();
+
     return true;
 }
 
@@ -120,6 +177,15 @@ void Renderer::RenderFrame()
 {
     CPU_EVENT("Render", "Renderer::RenderFrame");
 
+    ReplayPendingCapture();
+
+    //nothing waits on the compile tasks between frames. the PSO tasks hold the tasks of their shaders, so those stay until no PSO is pending
+    m_pPipelineCache->ReleaseCompletedTasks();
+    if (m_pPipelineCache->GetPendingCount() == 0)
+    {
+        m_pShaderCache->ReleaseCompletedTasks();
+    }
+
     m_pGpuScene->Update();
 
     BuildRenderGraph(m_outputColorHandle, m_outputDepthHandle);
@@ -136,6 +202,12 @@ void Renderer::BeginFrame()
 {
     CPU_EVENT("Render", "Renderer::BeginFrame");
 
+    if (m_bCaptureNextFrame)
+    {
+        m_pCommandCapture->BeginFrame();
+        m_bCaptureNextFrame = false;
+    }
+
     uint32_t frame_index = m_pDevice->GetFrameID() % GFX_MAX_INFLIGHT_FRAMES;
     {
         CPU_EVENT("Render", "IGfxFence::Wait");
@@ -144,8 +216,10 @@ void Renderer::BeginFrame()
     m_pDevice->BeginFrame();
 
     IGfxCommandList* pCommandList = m_pCommandLists[frame_index].get();
+    m_stateCacheStats = pCommandList->GetStateCacheStats(); //recorded GFX_MAX_INFLIGHT_FRAMES frames ago
     pCommandList->ResetAllocator();
     pCommandList->Begin();
+    m_pPassProfiler->BeginFrame(pCommandList); //collects the timings of GFX_MAX_INFLIGHT_FRAMES frames ago
 
     IGfxCommandList* pComputeCommandList = m_pComputeCommandLists[frame_index].get();
     pComputeCommandList->ResetAllocator();
@@ -156,6 +230,14 @@ void Renderer::UploadResources()
 {
     CPU_EVENT("Render", "Renderer::UploadResources");
 
+    std::scoped_lock lock(m_uploadMutex);
+
+    m_pStagingBufferAllocator->Retire(m_pUploadFence->GetCompletedValue());
+    FlushDeferredUploads();
+
+    m_nPeakUploadedBytes = max(m_nPeakUploadedBytes, m_nUploadedBytes);
+    m_nUploadedBytes = 0;
+
     if (m_pendingTextureUploads.empty() && m_pendingBufferUpload.empty())
     {
         return;
@@ -180,7 +262,7 @@ void Renderer::UploadResources()
         {
             const TextureUpload& upload = m_pendingTextureUploads[i];
             pUploadCommandList->CopyBufferToTexture(upload.texture, upload.mip_level, upload.array_slice,
-                upload.staging_buffer.buffer, upload.staging_buffer.offset + upload.offset);
+                upload.staging_buffer.buffer, upload.staging_buffer.offset);
         }
     }
 
@@ -188,6 +270,8 @@ void Renderer::UploadResources()
     pUploadCommandList->Signal(m_pUploadFence.get(), ++m_nCurrentUploadFenceValue);
     pUploadCommandList->Submit();
 
+    m_pStagingBufferAllocator->Submit(m_nCurrentUploadFenceValue);
+
     IGfxCommandList* pCommandList = m_pCommandLists[frame_index].get();
     pCommandList->Wait(m_pUploadFence.get(), m_nCurrentUploadFenceValue);
 
@@ -207,17 +291,37 @@ void Renderer::UploadResources()
 
 void Renderer::FlushComputePass(IGfxCommandList* pCommandList)
 {
-    if (!m_animationBatchs.empty())
+    m_nSkinningJobCount = (uint32_t)m_skinningJobs.size();
+    m_nSkinnedVertexCount = 0;
+
+    //startup PSOs aren't waited for one by one, the skinning shader may have failed to compile
+    if (!m_skinningJobs.empty() && m_pVertexSkinningPSO->IsReady())
     {
         GPU_EVENT(pCommandList, "Animation Pass");
 
-        m_pGpuScene->BeginAnimationUpdate(pCommandList);
-
-        for (size_t i = 0; i < m_animationBatchs.size(); ++i)
+        //all skinned meshes are processed by one dispatch, every thread group finds its mesh in the job table
+        uint32_t group_count = 0;
+        for (size_t i = 0; i < m_skinningJobs.size(); ++i)
         {
-            DispatchBatch(pCommandList, m_animationBatchs[i]);
+            m_skinningJobs[i].firstGroup = group_count;
+            group_count += DivideRoudingUp(m_skinningJobs[i].vertexCount, 64);
+            m_nSkinnedVertexCount += m_skinningJobs[i].vertexCount;
         }
 
+        uint32_t job_count = (uint32_t)m_skinningJobs.size();
+        uint32_t job_buffer_address = AllocateSceneConstant(m_skinningJobs.data(), sizeof(SkinningJob) * job_count);
+
+        const uint32_t max_group_count = 65535;
+        uint32_t group_count_x = min(group_count, max_group_count);
+        uint32_t group_count_y = DivideRoudingUp(group_count, max_group_count);
+        uint32_t root_constants[4] = { job_count, job_buffer_address, group_count, group_count_x };
+
+        m_pGpuScene->BeginAnimationUpdate(pCommandList);
+
+        pCommandList->SetPipelineState(m_pVertexSkinningPSO);
+        pCommandList->SetComputeConstants(0, root_constants, sizeof(root_constants));
+        pCommandList->Dispatch(group_count_x, group_count_y, 1);
+
         m_pGpuScene->EndAnimationUpdate(pCommandList);
     }
 }
@@ -240,6 +344,13 @@ void Renderer::BuildRayTracingAS(IGfxCommandList* pGraphicsCommandList, IGfxComm
         IGfxCommandList* pCommandList = m_bEnableAsyncCompute ? pComputeCommandList : pGraphicsCommandList;
         GPU_EVENT(pCommandList, "BuildRayTracingAS");
 
+        World* world = Engine::GetInstance()->GetWorld();
+        m_pBLASRefitScheduler->Schedule(GetFrameID(), world->GetCamera()->GetPosition(), m_scheduledBLASRefits, m_scheduledBLASRebuilds);
+
+        //periodic rebuilds of refit BLASes, to bound the loss of BVH quality
+        m_pendingBLASBuilds.insert(m_pendingBLASBuilds.end(), m_scheduledBLASRebuilds.begin(), m_scheduledBLASRebuilds.end());
+        m_scheduledBLASRebuilds.clear();
+
         if (!m_pendingBLASBuilds.empty())
         {
             GPU_EVENT(pCommandList, "BuildBLAS");
@@ -253,15 +364,16 @@ void Renderer::BuildRayTracingAS(IGfxCommandList* pGraphicsCommandList, IGfxComm
             pCommandList->GlobalBarrier(GfxAccessMaskAS, GfxAccessMaskAS);
         }
 
-        if (!m_pendingBLASUpdates.empty())
+        if (!m_scheduledBLASRefits.empty())
         {
             GPU_EVENT(pCommandList, "UpdateBLAS");
 
-            for (size_t i = 0; i < m_pendingBLASUpdates.size(); ++i)
+            for (size_t i = 0; i < m_scheduledBLASRefits.size(); ++i)
             {
-                pCommandList->UpdateRayTracingBLAS(m_pendingBLASUpdates[i].blas, m_pendingBLASUpdates[i].vertex_buffer, m_pendingBLASUpdates[i].vertex_buffer_offset);
+                const BLASRefitScheduler::Request& refit = m_scheduledBLASRefits[i];
+                pCommandList->UpdateRayTracingBLAS(refit.blas, refit.vertex_buffer, refit.vertex_buffer_offset);
             }
-            m_pendingBLASUpdates.clear();
+            m_scheduledBLASRefits.clear();
 
             pCommandList->GlobalBarrier(GfxAccessMaskAS, GfxAccessMaskAS);
         }
@@ -360,12 +472,18 @@ void Renderer::CopyToBackbuffer(IGfxCommandList* pCommandList, RGHandle color, R
 {
     GPU_EVENT(pCommandList, "CopyToBackbuffer");
 
+    IGfxPipelineState* pso = needUpscaleDepth ? m_pCopyColorDepthPSO : m_pCopyColorPSO;
+    if (!pso->IsReady())
+    {
+        return;
+    }
+
     RGTexture* colorRT = m_pRenderGraph->GetTexture(color);
     RGTexture* depthRT = m_pRenderGraph->GetTexture(depth);
 
     uint32_t constants[3] = { colorRT->GetSRV()->GetHeapIndex(), depthRT->GetSRV()->GetHeapIndex(), m_pPointClampSampler->GetHeapIndex() };
     pCommandList->SetGraphicsConstants(0, constants, sizeof(constants));
-    pCommandList->SetPipelineState(needUpscaleDepth ? m_pCopyColorDepthPSO : m_pCopyColorPSO);
+    pCommandList->SetPipelineState(pso);
     pCommandList->Draw(3);
 }
 
@@ -379,6 +497,7 @@ void Renderer::EndFrame()
     pComputeCommandList->End();
 
     IGfxCommandList* pCommandList = m_pCommandLists[frame_index].get();
+    m_pPassProfiler->EndFrame(pCommandList);
     pCommandList->End();
 
     m_nFrameFenceValue[frame_index] = ++m_nCurrentFrameFenceValue;
@@ -387,17 +506,29 @@ void Renderer::EndFrame()
     pCommandList->Signal(m_pFrameFence.get(), m_nCurrentFrameFenceValue);
     pCommandList->Submit();
 
-    m_pStagingBufferAllocator[frame_index]->Reset();
     m_cbAllocator->Reset();
+    for (size_t i = 0; i < m_threadBatches.size(); ++i)
+    {
+        m_threadBatches[i]->cbAllocator.Reset();
+    }
     m_pGpuScene->ResetFrameData();
 
-    m_animationBatchs.clear();
+    m_skinningJobs.clear();
     m_forwardPassBatchs.clear();
     m_velocityPassBatchs.clear();
     m_idPassBatchs.clear();
     m_guiBatchs.clear();
 
     m_pDevice->EndFrame();
+
+    if (m_pCommandCapture && m_pCommandCapture->IsCapturing())
+    {
+        eastl::string file = fmt::format("{}capture/frame_{}.recap", Engine::GetInstance()->GetWorkPath(), m_pDevice->GetFrameID()).c_str();
+        if (m_pCommandCapture->EndFrame(file))
+        {
+            m_lastCaptureFile = file;
+        }
+    }
 }
 
 void Renderer::WaitGpuFinished()
@@ -449,16 +580,58 @@ IGfxShader* Renderer::GetShader(const eastl::string& file, const eastl::string&
 }
 
 IGfxPipelineState* Renderer::GetPipelineState(const GfxGraphicsPipelineDesc& desc, const eastl::string& name)
+{
+    IGfxPipelineState* pso = m_pPipelineCache->GetPipelineState(desc, name);
+    if (pso && !m_bBatchPipelineCreation)
+    {
+        m_pPipelineCache->WaitForPipelineState(pso);
+        if (!pso->IsReady())
+        {
+            return nullptr; //its shaders failed to compile
+        }
+    }
+    return pso;
+}
+
+IGfxPipelineState* Renderer::GetPipelineStateAsync(const GfxGraphicsPipelineDesc& desc, const eastl::string& name)
 {
     return m_pPipelineCache->GetPipelineState(desc, name);
 }
 
 IGfxPipelineState* Renderer::GetPipelineState(const GfxMeshShadingPipelineDesc& desc, const eastl::string& name)
+{
+    IGfxPipelineState* pso = m_pPipelineCache->GetPipelineState(desc, name);
+    if (pso && !m_bBatchPipelineCreation)
+    {
+        m_pPipelineCache->WaitForPipelineState(pso);
+        if (!pso->IsReady())
+        {
+            return nullptr; //its shaders failed to compile
+        }
+    }
+    return pso;
+}
+
+IGfxPipelineState* Renderer::GetPipelineStateAsync(const GfxMeshShadingPipelineDesc& desc, const eastl::string& name)
 {
     return m_pPipelineCache->GetPipelineState(desc, name);
 }
 
 IGfxPipelineState* Renderer::GetPipelineState(const GfxComputePipelineDesc& desc, const eastl::string& name)
+{
+    IGfxPipelineState* pso = m_pPipelineCache->GetPipelineState(desc, name);
+    if (pso && !m_bBatchPipelineCreation)
+    {
+        m_pPipelineCache->WaitForPipelineState(pso);
+        if (!pso->IsReady())
+        {
+            return nullptr; //its shaders failed to compile
+        }
+    }
+    return pso;
+}
+
+IGfxPipelineState* Renderer::GetPipelineStateAsync(const GfxComputePipelineDesc& desc, const eastl::string& name)
 {
     return m_pPipelineCache->GetPipelineState(desc, name);
 }
@@ -550,6 +723,8 @@ void Renderer::CreateCommonResources()
     m_pSTBN = eastl::make_unique<STBN>(this);
     m_pSTBN->Load(asset_path + "textures/blue_noise/STBN/");
 
+    m_pPrecomputedDataCache->LogStats();
+
     m_pSPDCounterBuffer.reset(CreateTypedBuffer(nullptr, GfxFormat::R32UI, 1, "Renderer::m_pSPDCounterBuffer", GfxMemoryType::GpuOnly, true));
 
     GfxGraphicsPipelineDesc psoDesc;
@@ -569,6 +744,9 @@ void Renderer::CreateCommonResources()
     GfxComputePipelineDesc computePsoDesc;
     computePsoDesc.cs = GetShader("copy.hlsl", "cs_copy_depth", GfxShaderType::CS);
     m_pCopyDepthPSO = GetPipelineState(computePsoDesc, "Copy Depth PSO");
+
+    computePsoDesc.cs = GetShader("vertex_skinning.hlsl", "main", GfxShaderType::CS);
+    m_pVertexSkinningPSO = GetPipelineState(computePsoDesc, "Vertex Skinning PSO");
 }
 
 void Renderer::SetupGlobalConstants(IGfxCommandList* pCommandList)
@@ -815,18 +993,31 @@ RawBuffer* Renderer::CreateRawBuffer(const void* data, uint32_t size, const east
     return buffer;
 }
 
+static inline void LogTextureLoadThroughput(const eastl::string& file, uint32_t size, uint64_t start_ticks)
+{
+    double ms = stm_ms(stm_since(start_ticks));
+    double mb = size / (1024.0 * 1024.0);
+    RE_DEBUG("[Renderer] loaded {} : {:.2f} MB in {:.2f} ms ({:.1f} MB/s)", file, mb, ms, ms > 0.0 ? mb * 1000.0 / ms : 0.0);
+}
+
 Texture2D* Renderer::CreateTexture2D(const eastl::string& file, bool srgb)
 {
+    uint64_t ticks = stm_now();
+
     TextureLoader loader;
     if (!loader.Load(file, srgb))
     {
         return nullptr;
     }
 
+    //decoding above can run on any thread, gfx resource creation is serialized
+    std::scoped_lock lock(m_resourceCreationMutex);
+
     Texture2D* texture = CreateTexture2D(loader.GetWidth(), loader.GetHeight(), loader.GetMipLevels(), loader.GetFormat(), 0, file);
     if (texture)
     {
         UploadTexture(texture->GetTexture(), loader.GetData());
+        LogTextureLoadThroughput(file, loader.GetDataSize(), ticks);
     }
 
     return texture;
@@ -845,16 +1036,22 @@ Texture2D* Renderer::CreateTexture2D(uint32_t width, uint32_t height, uint32_t l
 
 Texture3D* Renderer::CreateTexture3D(const eastl::string& file, bool srgb)
 {
+    uint64_t ticks = stm_now();
+
     TextureLoader loader;
     if (!loader.Load(file, srgb))
     {
         return nullptr;
     }
 
+    //decoding above can run on any thread, gfx resource creation is serialized
+    std::scoped_lock lock(m_resourceCreationMutex);
+
     Texture3D* texture = CreateTexture3D(loader.GetWidth(), loader.GetHeight(), loader.GetDepth(), loader.GetMipLevels(), loader.GetFormat(), 0, file);
     if (texture)
     {
         UploadTexture(texture->GetTexture(), loader.GetData());
+        LogTextureLoadThroughput(file, loader.GetDataSize(), ticks);
     }
 
     return texture;
@@ -873,16 +1070,22 @@ Texture3D* Renderer::CreateTexture3D(uint32_t width, uint32_t height, uint32_t d
 
 TextureCube* Renderer::CreateTextureCube(const eastl::string& file, bool srgb)
 {
+    uint64_t ticks = stm_now();
+
     TextureLoader loader;
     if (!loader.Load(file, srgb))
     {
         return nullptr;
     }
 
+    //decoding above can run on any thread, gfx resource creation is serialized
+    std::scoped_lock lock(m_resourceCreationMutex);
+
     TextureCube* texture = CreateTextureCube(loader.GetWidth(), loader.GetHeight(), loader.GetMipLevels(), loader.GetFormat(), 0, file);
     if (texture)
     {
         UploadTexture(texture->GetTexture(), loader.GetData());
+        LogTextureLoadThroughput(file, loader.GetDataSize(), ticks);
     }
 
     return texture;
@@ -901,16 +1104,22 @@ TextureCube* Renderer::CreateTextureCube(uint32_t width, uint32_t height, uint32
 
 Texture2DArray* Renderer::CreateTexture2DArray(const eastl::string& file, bool srgb)
 {
+    uint64_t ticks = stm_now();
+
     TextureLoader loader;
     if (!loader.Load(file, srgb))
     {
         return nullptr;
     }
 
+    //decoding above can run on any thread, gfx resource creation is serialized
+    std::scoped_lock lock(m_resourceCreationMutex);
+
     Texture2DArray* texture = CreateTexture2DArray(loader.GetWidth(), loader.GetHeight(), loader.GetMipLevels(), loader.GetArraySize(), loader.GetFormat(), 0, file);
     if (texture)
     {
         UploadTexture(texture->GetTexture(), loader.GetData());
+        LogTextureLoadThroughput(file, loader.GetDataSize(), ticks);
     }
 
     return texture;
@@ -934,7 +1143,11 @@ IGfxBuffer* Renderer::GetSceneStaticBuffer() const
 
 OffsetAllocator::Allocation Renderer::AllocateSceneStaticBuffer(const void* data, uint32_t size)
 {
-    OffsetAllocator::Allocation allocation = m_pGpuScene->AllocateStaticBuffer(size);
+    OffsetAllocator::Allocation allocation;
+    {
+        std::scoped_lock lock(m_sceneStaticBufferMutex);
+        allocation = m_pGpuScene->AllocateStaticBuffer(size);
+    }
 
     if (data)
     {
@@ -946,6 +1159,7 @@ OffsetAllocator::Allocation Renderer::AllocateSceneStaticBuffer(const void* data
 
 void Renderer::FreeSceneStaticBuffer(OffsetAllocator::Allocation allocation)
 {
+    std::scoped_lock lock(m_sceneStaticBufferMutex);
     m_pGpuScene->FreeStaticBuffer(allocation);
 }
 
@@ -987,15 +1201,21 @@ uint32_t Renderer::AddLocalLight(const LocalLightData& data)
     return m_pGpuScene->AddLocalLight(data);
 }
 
-inline void image_copy(char* dst_data, uint32_t dst_row_pitch, char* src_data, uint32_t src_row_pitch, uint32_t row_num, uint32_t d)
+inline void image_copy(char* dst_data, uint32_t dst_row_pitch, const char* src_data, uint32_t src_row_pitch, uint32_t row_num, uint32_t d)
 {
     uint32_t src_slice_size = src_row_pitch * row_num;
     uint32_t dst_slice_size = dst_row_pitch * row_num;
 
+    if (src_row_pitch == dst_row_pitch)
+    {
+        memcpy(dst_data, src_data, src_slice_size * d);
+        return;
+    }
+
     for (uint32_t z = 0; z < d; z++)
     {
         char* dst_slice = dst_data + dst_slice_size * z;
-        char* src_slice = src_data + src_slice_size * z;
+        const char* src_slice = src_data + src_slice_size * z;
 
         for (uint32_t row = 0; row < row_num; ++row)
         {
@@ -1008,21 +1228,13 @@ inline void image_copy(char* dst_data, uint32_t dst_row_pitch, char* src_data, u
 
 void Renderer::UploadTexture(IGfxTexture* texture, const void* data)
 {
-    uint32_t frame_index = m_pDevice->GetFrameID() % GFX_MAX_INFLIGHT_FRAMES;
-    StagingBufferAllocator* pAllocator = m_pStagingBufferAllocator[frame_index].get();
-
-    uint32_t required_size = texture->GetRequiredStagingBufferSize();
-    StagingBuffer buffer = pAllocator->Allocate(required_size);
+    std::scoped_lock lock(m_uploadMutex);
 
     const GfxTextureDesc& desc = texture->GetDesc();
-
-    char* dst_data = (char*)buffer.buffer->GetCpuAddress() + buffer.offset;
-    uint32_t dst_offset = 0;
-    uint32_t src_offset = 0;
-    
     const uint32_t min_width = GetFormatBlockWidth(desc.format);
     const uint32_t min_height = GetFormatBlockHeight(desc.format);
-    const uint32_t alignment = m_pDevice->GetDesc().backend == GfxRenderBackend::D3D12 ? 512 : 1; //512 : D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT
+
+    uint32_t src_offset = 0;
 
     for (uint32_t slice = 0; slice < desc.array_size; ++slice)
     {
@@ -1033,34 +1245,123 @@ void Renderer::UploadTexture(IGfxTexture* texture, const void* data)
             uint32_t d = max(desc.depth >> mip, 1u);
 
             uint32_t src_row_pitch = GetFormatRowPitch(desc.format, w) * GetFormatBlockHeight(desc.format);
-            uint32_t dst_row_pitch = texture->GetRowPitch(mip);
-
             uint32_t row_num = h / GetFormatBlockHeight(desc.format);
+            uint32_t src_size = src_row_pitch * row_num * d;
+
+            const char* src_data = (const char*)data + src_offset;
+            src_offset += src_size;
 
-            image_copy(dst_data + dst_offset, dst_row_pitch,
-                (char*)data + src_offset, src_row_pitch,
-                row_num, d);
+            //keep the upload order once anything has been deferred
+            if (m_deferredUploads.empty() && UploadTextureSubresource(texture, mip, slice, src_data, src_row_pitch, row_num, d))
+            {
+                continue;
+            }
 
-            TextureUpload upload;
+            DeferredUpload& upload = m_deferredUploads.push_back();
             upload.texture = texture;
             upload.mip_level = mip;
             upload.array_slice = slice;
-            upload.staging_buffer = buffer;
-            upload.offset = dst_offset;
-            m_pendingTextureUploads.push_back(upload);
-
-            dst_offset += RoundUpPow2(dst_row_pitch * row_num, alignment);
-            src_offset += src_row_pitch * row_num;
+            upload.src_row_pitch = src_row_pitch;
+            upload.row_num = row_num;
+            upload.depth = d;
+            upload.data.assign(src_data, src_data + src_size);
         }
     }
 }
 
 void Renderer::UploadBuffer(IGfxBuffer* buffer, uint32_t offset, const void* data, uint32_t data_size)
 {
-    uint32_t frame_index = m_pDevice->GetFrameID() % GFX_MAX_INFLIGHT_FRAMES;
-    StagingBufferAllocator* pAllocator = m_pStagingBufferAllocator[frame_index].get();
+    std::scoped_lock lock(m_uploadMutex);
+
+    //large buffers are split into ranges which can go in different frames
+    const uint32_t chunk_size = m_pStagingBufferAllocator->GetCapacity() / 4;
+
+    for (uint32_t chunk_offset = 0; chunk_offset < data_size; chunk_offset += chunk_size)
+    {
+        uint32_t size = min(chunk_size, data_size - chunk_offset);
+        const char* src_data = (const char*)data + chunk_offset;
+
+        if (m_deferredUploads.empty() && UploadBufferRange(buffer, offset + chunk_offset, src_data, size))
+        {
+            continue;
+        }
+
+        DeferredUpload& upload = m_deferredUploads.push_back();
+        upload.buffer = buffer;
+        upload.offset = offset + chunk_offset;
+        upload.data.assign(src_data, src_data + size);
+    }
+}
+
+void Renderer::CancelUploads(IGfxResource* resource)
+{
+    std::scoped_lock lock(m_uploadMutex);
+
+    m_deferredUploads.erase(eastl::remove_if(m_deferredUploads.begin(), m_deferredUploads.end(),
+        [&](const DeferredUpload& upload) { return upload.texture == resource || upload.buffer == resource; }), m_deferredUploads.end());
+
+    m_pendingTextureUploads.erase(eastl::remove_if(m_pendingTextureUploads.begin(), m_pendingTextureUploads.end(),
+        [&](const TextureUpload& upload) { return upload.texture == resource; }), m_pendingTextureUploads.end());
+
+    m_pendingBufferUpload.erase(eastl::remove_if(m_pendingBufferUpload.begin(), m_pendingBufferUpload.end(),
+        [&](const BufferUpload& upload) { return upload.buffer == resource; }), m_pendingBufferUpload.end());
+}
+
+bool Renderer::AllocateStagingBuffer(uint32_t size, StagingBuffer& buffer)
+{
+    if (m_nUploadedBytes > 0 && m_nUploadedBytes + size > m_nUploadBudget)
+    {
+        return false;
+    }
+
+    if (size > m_pStagingBufferAllocator->GetCapacity())
+    {
+        buffer = m_pStagingBufferAllocator->AllocateDedicated(size);
+    }
+    else
+    {
+        buffer = m_pStagingBufferAllocator->Allocate(size);
+    }
+
+    if (buffer.buffer == nullptr)
+    {
+        return false;
+    }
+
+    m_nUploadedBytes += size;
+    return true;
+}
+
+bool Renderer::UploadTextureSubresource(IGfxTexture* texture, uint32_t mip_level, uint32_t array_slice, const char* data, uint32_t src_row_pitch, uint32_t row_num, uint32_t depth)
+{
+    uint32_t dst_row_pitch = texture->GetRowPitch(mip_level);
+
+    StagingBuffer buffer;
+    if (!AllocateStagingBuffer(dst_row_pitch * row_num * depth, buffer))
+    {
+        return false;
+    }
+
+    char* dst_data = (char*)buffer.buffer->GetCpuAddress() + buffer.offset;
+    image_copy(dst_data, dst_row_pitch, data, src_row_pitch, row_num, depth);
 
-    StagingBuffer staging_buffer = pAllocator->Allocate(data_size);
+    TextureUpload upload;
+    upload.texture = texture;
+    upload.mip_level = mip_level;
+    upload.array_slice = array_slice;
+    upload.staging_buffer = buffer;
+    m_pendingTextureUploads.push_back(upload);
+
+    return true;
+}
+
+bool Renderer::UploadBufferRange(IGfxBuffer* buffer, uint32_t offset, const char* data, uint32_t data_size)
+{
+    StagingBuffer staging_buffer;
+    if (!AllocateStagingBuffer(data_size, staging_buffer))
+    {
+        return false;
+    }
 
     char* dst_data = (char*)staging_buffer.buffer->GetCpuAddress() + staging_buffer.offset;
     memcpy(dst_data, data, data_size);
@@ -1070,6 +1371,27 @@ void Renderer::UploadBuffer(IGfxBuffer* buffer, uint32_t offset, const void* dat
     upload.offset = offset;
     upload.staging_buffer = staging_buffer;
     m_pendingBufferUpload.push_back(upload);
+
+    return true;
+}
+
+void Renderer::FlushDeferredUploads()
+{
+    while (!m_deferredUploads.empty())
+    {
+        const DeferredUpload& upload = m_deferredUploads.front();
+
+        bool success = upload.texture ?
+            UploadTextureSubresource(upload.texture, upload.mip_level, upload.array_slice, upload.data.data(), upload.src_row_pitch, upload.row_num, upload.depth) :
+            UploadBufferRange(upload.buffer, upload.offset, upload.data.data(), (uint32_t)upload.data.size());
+
+        if (!success)
+        {
+            break;
+        }
+
+        m_deferredUploads.pop_front();
+    }
 }
 
 void Renderer::BuildRayTracingBLAS(IGfxRayTracingBLAS* blas)
@@ -1077,21 +1399,138 @@ void Renderer::BuildRayTracingBLAS(IGfxRayTracingBLAS* blas)
     m_pendingBLASBuilds.push_back(blas);
 }
 
-void Renderer::UpdateRayTracingBLAS(IGfxRayTracingBLAS* blas, IGfxBuffer* vertex_buffer, uint32_t vertex_buffer_offset)
+void Renderer::UpdateRayTracingBLAS(IGfxRayTracingBLAS* blas, IGfxBuffer* vertex_buffer, uint32_t vertex_buffer_offset, const float3& center, float radius)
 {
-    m_pendingBLASUpdates.push_back({ blas, vertex_buffer, vertex_buffer_offset });
+    BLASRefitScheduler::Request request = { blas, vertex_buffer, vertex_buffer_offset, center, radius };
+
+    ThreadBatches* batches = GetThreadBatches();
+    if (batches)
+    {
+        batches->blasUpdates.push_back(request);
+    }
+    else
+    {
+        m_pBLASRefitScheduler->AddRequest(request);
+    }
 }
 
 RenderBatch& Renderer::AddBasePassBatch()
 {
+    ThreadBatches* batches = GetThreadBatches();
+    if (batches)
+    {
+        return batches->basePassBatchs.emplace_back(batches->cbAllocator);
+    }
     return m_pBasePass->AddBatch();
 }
 
+RenderBatch& Renderer::AddForwardPassBatch()
+{
+    ThreadBatches* batches = GetThreadBatches();
+    if (batches)
+    {
+        return batches->forwardPassBatchs.emplace_back(batches->cbAllocator);
+    }
+    return m_forwardPassBatchs.emplace_back(*m_cbAllocator);
+}
+
+RenderBatch& Renderer::AddVelocityPassBatch()
+{
+    ThreadBatches* batches = GetThreadBatches();
+    if (batches)
+    {
+        return batches->velocityPassBatchs.emplace_back(batches->cbAllocator);
+    }
+    return m_velocityPassBatchs.emplace_back(*m_cbAllocator);
+}
+
+RenderBatch& Renderer::AddObjectIDPassBatch()
+{
+    ThreadBatches* batches = GetThreadBatches();
+    if (batches)
+    {
+        return batches->idPassBatchs.emplace_back(batches->cbAllocator);
+    }
+    return m_idPassBatchs.emplace_back(*m_cbAllocator);
+}
+
+void Renderer::AddSkinningJob(const SkinningJob& job)
+{
+    ThreadBatches* batches = GetThreadBatches();
+    if (batches)
+    {
+        batches->skinningJobs.push_back(job);
+    }
+    else
+    {
+        m_skinningJobs.push_back(job);
+    }
+}
+
+Renderer::ThreadBatches* Renderer::GetThreadBatches() const
+{
+    if (!m_bParallelPhase)
+    {
+        return nullptr;
+    }
+
+    uint32_t thread_num = Engine::GetInstance()->GetTaskScheduler()->GetThreadNum();
+    return m_threadBatches[thread_num].get();
+}
+
+void Renderer::BeginParallelPhase()
+{
+    RE_ASSERT(!m_bParallelPhase);
+
+    uint32_t thread_count = Engine::GetInstance()->GetTaskScheduler()->GetNumTaskThreads();
+    while (m_threadBatches.size() < thread_count)
+    {
+        m_threadBatches.push_back(eastl::make_unique<ThreadBatches>());
+    }
+
+    m_pGpuScene->BeginParallelPhase(thread_count);
+    m_bParallelPhase = true;
+}
+
+void Renderer::EndParallelPhase()
+{
+    CPU_EVENT("Render", "Renderer::EndParallelPhase");
+    RE_ASSERT(m_bParallelPhase);
+
+    m_bParallelPhase = false;
+    m_pGpuScene->EndParallelPhase();
+
+    //the batches are copied with their constants, which stay in the thread's allocator until the end of the frame
+    for (size_t i = 0; i < m_threadBatches.size(); ++i)
+    {
+        ThreadBatches* batches = m_threadBatches[i].get();
+
+        for (size_t j = 0; j < batches->basePassBatchs.size(); ++j)
+        {
+            m_pBasePass->AddBatch(batches->basePassBatchs[j]);
+        }
+
+        m_forwardPassBatchs.insert(m_forwardPassBatchs.end(), batches->forwardPassBatchs.begin(), batches->forwardPassBatchs.end());
+        m_velocityPassBatchs.insert(m_velocityPassBatchs.end(), batches->velocityPassBatchs.begin(), batches->velocityPassBatchs.end());
+        m_idPassBatchs.insert(m_idPassBatchs.end(), batches->idPassBatchs.begin(), batches->idPassBatchs.end());
+        m_skinningJobs.insert(m_skinningJobs.end(), batches->skinningJobs.begin(), batches->skinningJobs.end());
+        for (size_t j = 0; j < batches->blasUpdates.size(); ++j)
+        {
+            m_pBLASRefitScheduler->AddRequest(batches->blasUpdates[j]);
+        }
+
+        batches->basePassBatchs.clear();
+        batches->forwardPassBatchs.clear();
+        batches->velocityPassBatchs.clear();
+        batches->idPassBatchs.clear();
+        batches->skinningJobs.clear();
+        batches->blasUpdates.clear();
+    }
+}
+
 StagingBufferAllocator* Renderer::GetStagingBufferAllocator() const
 {
-    uint32_t frame_index = m_pDevice->GetFrameID() % GFX_MAX_INFLIGHT_FRAMES;
-    StagingBufferAllocator* pAllocator = m_pStagingBufferAllocator[frame_index].get();
-    return pAllocator;
+    return m_pStagingBufferAllocator.get();
 }
 
 void Renderer::SaveTexture(const eastl::string& file, const void* data, uint32_t width, uint32_t height, GfxFormat format)
@@ -1157,4 +1596,156 @@ void Renderer::OnGui()
     m_pLightingProcessor->OnGui();
     m_pPathTracer->OnGui();
     m_pPostProcessor->OnGui();
+
+    if (ImGui::CollapsingHeader("Uploads"))
+    {
+        StagingBufferAllocator::Stats stats = m_pStagingBufferAllocator->GetStats();
+        const float mb = 1.0f / (1024.0f * 1024.0f);
+
+        int budget = m_nUploadBudget / (1024 * 1024);
+        if (ImGui::SliderInt("Budget per frame (MB)##Renderer", &budget, 1, 256))
+        {
+            m_nUploadBudget = budget * 1024 * 1024;
+        }
+
+        ImGui::Text("Staging ring : %.1f / %.1f MB, high water mark %.1f MB", stats.usedSize * mb, m_pStagingBufferAllocator->GetCapacity() * mb, stats.highWaterMark * mb);
+        ImGui::Text("Dedicated staging : %.1f MB, high water mark %.1f MB", stats.dedicatedSize * mb, stats.dedicatedHighWaterMark * mb);
+        ImGui::Text("Peak upload per frame : %.1f MB", m_nPeakUploadedBytes * mb);
+        ImGui::Text("Deferred uploads : %d", (int)m_deferredUploads.size());
+    }
+
+    if (ImGui::CollapsingHeader("Vertex skinning"))
+    {
+        ImGui::Text("Skinned meshes : %u", m_nSkinningJobCount);
+        ImGui::Text("Skinned vertices : %u", m_nSkinnedVertexCount);
+    }
+
+    if (ImGui::CollapsingHeader("BLAS refit"))
+    {
+        m_pBLASRefitScheduler->OnGui();
+    }
+
+    if (ImGui::CollapsingHeader("Command list state"))
+    {
+        const GfxStateCache::Stats& stats = m_stateCacheStats;
+        ImGui::Text("Pipeline states : %d set, %d skipped", stats.pipelineStates, stats.pipelineStatesSkipped);
+        ImGui::Text("Constants : %d set, %d skipped", stats.constants, stats.constantsSkipped);
+        ImGui::Text("Index buffers : %d set, %d skipped", stats.indexBuffers, stats.indexBuffersSkipped);
+        ImGui::Text("Viewports/scissors : %d set, %d skipped", stats.viewports, stats.viewportsSkipped);
+    }
+
+    if (m_pCommandCapture && ImGui::CollapsingHeader("Command capture"))
+    {
+        if (ImGui::Button("Capture frame##Renderer"))
+        {
+            CaptureFrame();
+        }
+
+        if (!m_lastCaptureFile.empty())
+        {
+            ImGui::Text("%s", m_lastCaptureFile.c_str());
+            ImGui::SliderInt("Replay iterations##Renderer", &m_nReplayIterations, 1, 1000);
+
+            if (ImGui::Button("Replay##Renderer"))
+            {
+                m_bReplayPending = true;
+                m_bReplayOnMockDevice = false;
+            }
+
+            ImGui::SameLine();
+            if (ImGui::Button("Replay on mock device##Renderer"))
+            {
+                m_bReplayPending = true;
+                m_bReplayOnMockDevice = true;
+            }
+        }
+    }
+}
+
+void Renderer::ReplayPendingCapture()
+{
+    if (!m_bReplayPending)
+    {
+        return;
+    }
+    m_bReplayPending = false;
+
+    if (m_bReplayOnMockDevice)
+    {
+        GfxDeviceDesc desc;
+        desc.backend = GfxRenderBackend::Mock;
+        eastl::unique_ptr<IGfxDevice> device(CreateGfxDevice(desc));
+        if (device)
+        {
+            ReplayCapture(device.get());
+        }
+    }
+    else
+    {
+        //the replay begins and ends frames on the live device, none of the renderer's frames can be in flight
+        WaitGpuFinished();
+        ReplayCapture(m_pDevice.get());
+    }
+}
+
+void Renderer::ReplayCapture(IGfxDevice* device)
+{
+    GfxCommandReplay::PipelineFactory factory;
+    if (device == m_pDevice.get())
+    {
+        //real devices need compiled shaders, the capture stores their descs and they are compiled again here
+        factory = [&](const GfxCapturedPipeline& pipeline, const eastl::string& name) -> IGfxPipelineState*
+        {
+            eastl::string shaderPath = std::filesystem::absolute(Engine::GetInstance()->GetShaderPath().c_str()).string().c_str();
+
+            IGfxShader* shaders[3] = {};
+            for (uint32_t i = 0; i < 3; ++i)
+            {
+                if (pipeline.shaderMask & (1 << i))
+                {
+                    const GfxShaderDesc& desc = pipeline.shaders[i];
+                    eastl::string file = std::filesystem::path(desc.file.c_str()).lexically_relative(shaderPath.c_str()).generic_string().c_str();
+                    shaders[i] = GetShader(file, desc.entry_point, desc.type, desc.defines, desc.flags);
+                }
+            }
+
+            switch (pipeline.type)
+            {
+            case GfxPipelineType::Graphics:
+            {
+                GfxGraphicsPipelineDesc desc;
+                const size_t offset = offsetof(GfxGraphicsPipelineDesc, rasterizer_state);
+                memcpy((uint8_t*)&desc + offset, pipeline.states.data(), eastl::min(pipeline.states.size(), sizeof(desc) - offset));
+                desc.vs = shaders[0];
+                desc.ps = shaders[1];
+                return GetPipelineState(desc, name);
+            }
+            case GfxPipelineType::MeshShading:
+            {
+                GfxMeshShadingPipelineDesc desc;
+                const size_t offset = offsetof(GfxMeshShadingPipelineDesc, rasterizer_state);
+                memcpy((uint8_t*)&desc + offset, pipeline.states.data(), eastl::min(pipeline.states.size(), sizeof(desc) - offset));
+                desc.as = shaders[0];
+                desc.ms = shaders[1];
+                desc.ps = shaders[2];
+                return GetPipelineState(desc, name);
+            }
+            case GfxPipelineType::Compute:
+            {
+                GfxComputePipelineDesc desc;
+                desc.cs = shaders[0];
+                return GetPipelineState(desc, name);
+            }
+            default:
+                return nullptr;
+            }
+        };
+    }
+
+    GfxCommandReplay replay(device, factory);
+    if (replay.Load(m_lastCaptureFile))
+    {
+        replay.Replay(m_nReplayIterations);
+        replay.LogStats();
+    }
 }
@@ -12,6 +12,8 @@
 #include "resource/raw_buffer.h"
 #include "resource/typed_buffer.h"
 #include "staging_buffer_allocator.h"
+#include "blas_refit_scheduler.h"
+#include <mutex>
 
 enum class RendererOutput
 {
@@ -58,6 +60,8 @@ public:
     class ShaderCompiler* GetShaderCompiler() const { return m_pShaderCompiler.get(); }
     class ShaderCache* GetShaderCache() const { return m_pShaderCache.get(); }
     class PipelineStateCache* GetPipelineStateCache() const { return m_pPipelineCache.get(); }
+    class PrecomputedDataCache* GetPrecomputedDataCache() const { return m_pPrecomputedDataCache.get(); }
+    class PassProfiler* GetPassProfiler() const { return m_pPassProfiler.get(); }
     RenderGraph* GetRenderGraph() { return m_pRenderGraph.get(); }
 
     RendererOutput GetOutputType() const { return m_outputType; }
@@ -76,9 +80,15 @@ public:
     IGfxDevice* GetDevice() const { return m_pDevice.get(); }
     IGfxSwapchain* GetSwapchain() const { return m_pSwapchain.get(); }
     IGfxShader* GetShader(const eastl::string& file, const eastl::string& entry_point, GfxShaderType type, const eastl::vector<eastl::string>& defines = {}, GfxShaderCompilerFlags flags = 0);
+    //shaders and PSOs are compiled on worker threads, GetPipelineState waits for the PSO and returns nullptr if its shaders failed to compile.
+    //during the startup batch it returns immediately, those PSOs must be checked with IsReady() before they are bound
     IGfxPipelineState* GetPipelineState(const GfxGraphicsPipelineDesc& desc, const eastl::string& name);
     IGfxPipelineState* GetPipelineState(const GfxMeshShadingPipelineDesc& desc, const eastl::string& name);
     IGfxPipelineState* GetPipelineState(const GfxComputePipelineDesc& desc, const eastl::string& name);
+    //never waits, batches using a PSO which is not ready yet are skipped
+    IGfxPipelineState* GetPipelineStateAsync(const GfxGraphicsPipelineDesc& desc, const eastl::string& name);
+    IGfxPipelineState* GetPipelineStateAsync(const GfxMeshShadingPipelineDesc& desc, const eastl::string& name);
+    IGfxPipelineState* GetPipelineStateAsync(const GfxComputePipelineDesc& desc, const eastl::string& name);
     void ReloadShaders();
     IGfxDescriptor* GetPointSampler() const { return m_pPointRepeatSampler.get(); }
     IGfxDescriptor* GetLinearSampler() const { return m_pBilinearRepeatSampler.get(); }
@@ -127,18 +137,32 @@ public:
     bool IsAsyncComputeEnabled() const { return m_bEnableAsyncCompute; }
     void SetAsyncComputeEnabled(bool value) { m_bEnableAsyncCompute = value; }
 
+    //wraps the command lists to record their calls, should be set before CreateDevice
+    void SetCommandCaptureEnabled(bool value) { m_bEnableCommandCapture = value; }
+    void CaptureFrame() { m_bCaptureNextFrame = m_pCommandCapture != nullptr; }
+
     void UploadTexture(IGfxTexture* texture, const void* data);
     void UploadBuffer(IGfxBuffer* buffer, uint32_t offset, const void* data, uint32_t data_size);
+    //uploads can be deferred to later frames, a resource must cancel them before it is destroyed
+    void CancelUploads(IGfxResource* resource);
     void BuildRayTracingBLAS(IGfxRayTracingBLAS* blas);
-    void UpdateRayTracingBLAS(IGfxRayTracingBLAS* blas, IGfxBuffer* vertex_buffer, uint32_t vertex_buffer_offset);
+    //the refits are prioritized and budgeted by the BLASRefitScheduler, center and radius are the world space bounds of the mesh
+    void UpdateRayTracingBLAS(IGfxRayTracingBLAS* blas, IGfxBuffer* vertex_buffer, uint32_t vertex_buffer_offset, const float3& center, float radius);
+    BLASRefitScheduler* GetBLASRefitScheduler() const { return m_pBLASRefitScheduler.get(); }
 
     LinearAllocator* GetConstantAllocator() const { return m_cbAllocator.get(); }
     RenderBatch& AddBasePassBatch();
-    RenderBatch& AddForwardPassBatch() { return m_forwardPassBatchs.emplace_back(*m_cbAllocator); }
-    RenderBatch& AddVelocityPassBatch() { return m_velocityPassBatchs.emplace_back(*m_cbAllocator); }
-    RenderBatch& AddObjectIDPassBatch() { return m_idPassBatchs.emplace_back(*m_cbAllocator); }
+    RenderBatch& AddForwardPassBatch();
+    RenderBatch& AddVelocityPassBatch();
+    RenderBatch& AddObjectIDPassBatch();
     RenderBatch& AddGuiPassBatch() { return m_guiBatchs.emplace_back(*m_cbAllocator); }
-    ComputeBatch& AddAnimationBatch() { return m_animationBatchs.emplace_back(*m_cbAllocator); }
+    //firstGroup is assigned when the jobs of all meshes are merged into one vertex skinning dispatch
+    void AddSkinningJob(const SkinningJob& job);
+
+    //between these calls AllocateSceneConstant, AddInstance, AddLocalLight, UpdateRayTracingBLAS and the scene batch functions above
+    //may be called from any task thread, they record into per-thread lists which are appended to the frame's lists in EndParallelPhase
+    void BeginParallelPhase();
+    void EndParallelPhase();
 
     void SetupGlobalConstants(IGfxCommandList* pCommandList);
 
@@ -159,9 +183,15 @@ public:
 private:
     void CreateCommonResources();
     void OnWindowResize(void* window, uint32_t width, uint32_t height);
+    void ReplayCapture(IGfxDevice* device);
+    void ReplayPendingCapture();
 
     void BeginFrame();
     void UploadResources();
+    bool AllocateStagingBuffer(uint32_t size, StagingBuffer& buffer);
+    bool UploadTextureSubresource(IGfxTexture* texture, uint32_t mip_level, uint32_t array_slice, const char* data, uint32_t src_row_pitch, uint32_t row_num, uint32_t depth);
+    bool UploadBufferRange(IGfxBuffer* buffer, uint32_t offset, const char* data, uint32_t data_size);
+    void FlushDeferredUploads();
     void Render();
     void BuildRenderGraph(RGHandle& outColor, RGHandle& outDepth);
     void EndFrame();
@@ -187,6 +217,8 @@ private:
     eastl::unique_ptr<class ShaderCompiler> m_pShaderCompiler;
     eastl::unique_ptr<class ShaderCache> m_pShaderCache;
     eastl::unique_ptr<class PipelineStateCache> m_pPipelineCache;
+    eastl::unique_ptr<class PrecomputedDataCache> m_pPrecomputedDataCache;
+    bool m_bBatchPipelineCreation = false;
     eastl::unique_ptr<class GpuScene> m_pGpuScene;
 
     RendererOutput m_outputType = RendererOutput::Default;
@@ -201,6 +233,17 @@ private:
 
     eastl::unique_ptr<LinearAllocator> m_cbAllocator;
 
+    //declared before the command lists, which reference it
+    eastl::unique_ptr<class GfxCommandCapture> m_pCommandCapture;
+    bool m_bEnableCommandCapture = false;
+    bool m_bCaptureNextFrame = false;
+    eastl::string m_lastCaptureFile;
+    int m_nReplayIterations = 100;
+    bool m_bReplayPending = false; //replays run between frames, not from the gui in the middle of one
+    bool m_bReplayOnMockDevice = false;
+
+    eastl::unique_ptr<class PassProfiler> m_pPassProfiler;
+
     eastl::unique_ptr<IGfxFence> m_pFrameFence;
     uint64_t m_nCurrentFrameFenceValue = 0;
     uint64_t m_nFrameFenceValue[GFX_MAX_INFLIGHT_FRAMES] = {};
@@ -213,7 +256,17 @@ private:
     eastl::unique_ptr<IGfxFence> m_pUploadFence;
     uint64_t m_nCurrentUploadFenceValue = 0;
     eastl::unique_ptr<IGfxCommandList> m_pUploadCommandList[GFX_MAX_INFLIGHT_FRAMES];
-    eastl::unique_ptr<StagingBufferAllocator> m_pStagingBufferAllocator[GFX_MAX_INFLIGHT_FRAMES];
+    eastl::unique_ptr<StagingBufferAllocator> m_pStagingBufferAllocator;
+    uint32_t m_nUploadBudget = 32 * 1024 * 1024; //per frame
+    uint32_t m_nUploadedBytes = 0;
+    uint32_t m_nPeakUploadedBytes = 0;
+
+    GfxStateCache::Stats m_stateCacheStats; //graphics command list, from the last completed frame
+
+    //textures/scene buffers can be loaded from worker threads (see ResourceCache)
+    std::mutex m_uploadMutex;
+    std::mutex m_sceneStaticBufferMutex;
+    std::mutex m_resourceCreationMutex;
 
     struct TextureUpload
     {
@@ -221,7 +274,6 @@ private:
         uint32_t mip_level;
         uint32_t array_slice;
         StagingBuffer staging_buffer;
-        uint32_t offset;
     };
     eastl::vector<TextureUpload> m_pendingTextureUploads;
 
@@ -233,13 +285,43 @@ private:
     };
     eastl::vector<BufferUpload> m_pendingBufferUpload;
 
-    struct BLASUpdate
+    //uploads which didn't fit in the staging ring or the frame budget, they are dropped by CancelUploads when their resource is destroyed
+    struct DeferredUpload
     {
-        IGfxRayTracingBLAS* blas;
-        IGfxBuffer* vertex_buffer;
-        uint32_t vertex_buffer_offset;
+        IGfxTexture* texture = nullptr;
+        uint32_t mip_level = 0;
+        uint32_t array_slice = 0;
+        uint32_t src_row_pitch = 0;
+        uint32_t row_num = 0;
+        uint32_t depth = 0;
+
+        IGfxBuffer* buffer = nullptr;
+        uint32_t offset = 0;
+
+        eastl::vector<char> data;
     };
-    eastl::vector<BLASUpdate> m_pendingBLASUpdates;
+    eastl::deque<DeferredUpload> m_deferredUploads;
+
+    eastl::unique_ptr<BLASRefitScheduler> m_pBLASRefitScheduler;
+    eastl::vector<BLASRefitScheduler::Request> m_scheduledBLASRefits;
+    eastl::vector<IGfxRayTracingBLAS*> m_scheduledBLASRebuilds;
+
+    struct ThreadBatches
+    {
+        ThreadBatches() : cbAllocator(1024 * 1024) {}
+
+        LinearAllocator cbAllocator; //reset with m_cbAllocator at the end of the frame, grows when a thread ticks most of the objects
+        eastl::vector<RenderBatch> basePassBatchs;
+        eastl::vector<RenderBatch> forwardPassBatchs;
+        eastl::vector<RenderBatch> velocityPassBatchs;
+        eastl::vector<RenderBatch> idPassBatchs;
+        eastl::vector<SkinningJob> skinningJobs;
+        eastl::vector<BLASRefitScheduler::Request> blasUpdates;
+    };
+    ThreadBatches* GetThreadBatches() const; //of the calling task thread, or nullptr outside of a parallel phase
+
+    eastl::vector<eastl::unique_ptr<ThreadBatches>> m_threadBatches;
+    bool m_bParallelPhase = false;
     eastl::vector<IGfxRayTracingBLAS*> m_pendingBLASBuilds;
 
     eastl::unique_ptr<IGfxDescriptor> m_pAniso2xSampler;
@@ -294,6 +376,7 @@ private:
     IGfxPipelineState* m_pCopyColorPSO = nullptr;
     IGfxPipelineState* m_pCopyColorDepthPSO = nullptr;
     IGfxPipelineState* m_pCopyDepthPSO = nullptr;
+    IGfxPipelineState* m_pVertexSkinningPSO = nullptr;
 
     eastl::unique_ptr<class HZB> m_pHZB;
     eastl::unique_ptr<class BasePass> m_pBasePass;
@@ -306,7 +389,9 @@ private:
     eastl::unique_ptr<class GpuDrivenDebugPrint> m_pGpuDebugPrint;
     eastl::unique_ptr<class GpuDrivenStats> m_pGpuStats;
 
-    eastl::vector<ComputeBatch> m_animationBatchs;
+    eastl::vector<SkinningJob> m_skinningJobs;
+    uint32_t m_nSkinningJobCount = 0; //of the last frame, for the gui
+    uint32_t m_nSkinnedVertexCount = 0;
 
     eastl::vector<RenderBatch> m_forwardPassBatchs;
     eastl::vector<RenderBatch> m_velocityPassBatchs;
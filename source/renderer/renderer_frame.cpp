@@ -8,6 +8,8 @@
 
 void Renderer::BuildRenderGraph(RGHandle& outColor, RGHandle& outDepth)
 {
+    MemoryTagScope memoryTag(MemoryTag::RenderGraph);
+
     m_pRenderGraph->Clear();
 
     ImportPrevFrameTextures();
@@ -312,6 +314,11 @@ void Renderer::CopyHistoryPass(RGHandle sceneDepth, RGHandle normal, RGHandle sc
         },
         [&](const CopyDepthPassData& data, IGfxCommandList* pCommandList)
         {
+            if (!m_pCopyDepthPSO->IsReady())
+            {
+                return;
+            }
+
             RGTexture* srcSceneDepthTexture = m_pRenderGraph->GetTexture(data.srcSceneDepthTexture);
 
             uint32_t cb[2] = { srcSceneDepthTexture->GetSRV()->GetHeapIndex(), m_pPrevSceneDepthTexture->GetUAV()->GetHeapIndex() };
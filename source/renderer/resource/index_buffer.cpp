@@ -8,6 +8,15 @@ IndexBuffer::IndexBuffer(const eastl::string& name)
     m_name = name;
 }
 
+IndexBuffer::~IndexBuffer()
+{
+    Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
+    if (pRenderer && m_pBuffer)
+    {
+        pRenderer->CancelUploads(m_pBuffer.get());
+    }
+}
+
 bool IndexBuffer::Create(uint32_t stride, uint32_t index_count, GfxMemoryType memory_type)
 {
     RE_ASSERT(stride == 2 || stride == 4);
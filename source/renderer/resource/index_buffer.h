@@ -7,6 +7,7 @@ class IndexBuffer
 {
 public:
     IndexBuffer(const eastl::string& name);
+    ~IndexBuffer();
 
     bool Create(uint32_t stride, uint32_t index_count, GfxMemoryType memory_type);
 
@@ -7,6 +7,15 @@ RawBuffer::RawBuffer(const eastl::string& name)
     m_name = name;
 }
 
+RawBuffer::~RawBuffer()
+{
+    Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
+    if (pRenderer && m_pBuffer)
+    {
+        pRenderer->CancelUploads(m_pBuffer.get());
+    }
+}
+
 bool RawBuffer::Create(uint32_t size, GfxMemoryType memory_type, bool uav)
 {
     Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
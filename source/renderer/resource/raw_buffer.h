@@ -7,6 +7,7 @@ class RawBuffer
 {
 public:
     RawBuffer(const eastl::string& name);
+    ~RawBuffer();
 
     bool Create(uint32_t size, GfxMemoryType memory_type, bool uav);
 
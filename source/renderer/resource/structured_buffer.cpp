@@ -7,6 +7,15 @@ StructuredBuffer::StructuredBuffer(const eastl::string& name)
     m_name = name;
 }
 
+StructuredBuffer::~StructuredBuffer()
+{
+    Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
+    if (pRenderer && m_pBuffer)
+    {
+        pRenderer->CancelUploads(m_pBuffer.get());
+    }
+}
+
 bool StructuredBuffer::Create(uint32_t stride, uint32_t element_count, GfxMemoryType memory_type, bool uav)
 {
     Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
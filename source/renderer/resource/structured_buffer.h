@@ -7,6 +7,7 @@ class StructuredBuffer
 {
 public:
     StructuredBuffer(const eastl::string& name);
+    ~StructuredBuffer();
 
     bool Create(uint32_t stride, uint32_t element_count, GfxMemoryType memory_type, bool uav);
 
@@ -8,6 +8,15 @@ Texture2D::Texture2D(const eastl::string& name)
     m_name = name;
 }
 
+Texture2D::~Texture2D()
+{
+    Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
+    if (pRenderer && m_pTexture)
+    {
+        pRenderer->CancelUploads(m_pTexture.get());
+    }
+}
+
 bool Texture2D::Create(uint32_t width, uint32_t height, uint32_t levels, GfxFormat format, GfxTextureUsageFlags flags)
 {
     Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
@@ -9,6 +9,7 @@ class Texture2D
 {
 public:
     Texture2D(const eastl::string& name);
+    ~Texture2D();
 
     bool Create(uint32_t width, uint32_t height, uint32_t levels, GfxFormat format, GfxTextureUsageFlags flags);
 
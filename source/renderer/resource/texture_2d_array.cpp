@@ -7,6 +7,15 @@ Texture2DArray::Texture2DArray(const eastl::string& name)
     m_name = name;
 }
 
+Texture2DArray::~Texture2DArray()
+{
+    Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
+    if (pRenderer && m_pTexture)
+    {
+        pRenderer->CancelUploads(m_pTexture.get());
+    }
+}
+
 bool Texture2DArray::Create(uint32_t width, uint32_t height, uint32_t levels, uint32_t array_size, GfxFormat format, GfxTextureUsageFlags flags)
 {
     Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
@@ -9,6 +9,7 @@ class Texture2DArray
 {
 public:
     Texture2DArray(const eastl::string& name);
+    ~Texture2DArray();
 
     bool Create(uint32_t width, uint32_t height, uint32_t levels, uint32_t array_size, GfxFormat format, GfxTextureUsageFlags flags);
 
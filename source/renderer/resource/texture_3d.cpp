@@ -7,6 +7,15 @@ Texture3D::Texture3D(const eastl::string& name)
     m_name = name;
 }
 
+Texture3D::~Texture3D()
+{
+    Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
+    if (pRenderer && m_pTexture)
+    {
+        pRenderer->CancelUploads(m_pTexture.get());
+    }
+}
+
 bool Texture3D::Create(uint32_t width, uint32_t height, uint32_t depth, uint32_t levels, GfxFormat format, GfxTextureUsageFlags flags)
 {
     Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
@@ -9,6 +9,7 @@ class Texture3D
 {
 public:
     Texture3D(const eastl::string& name);
+    ~Texture3D();
 
     bool Create(uint32_t width, uint32_t height, uint32_t depth, uint32_t levels, GfxFormat format, GfxTextureUsageFlags flags);
 
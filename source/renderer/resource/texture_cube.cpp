@@ -7,6 +7,15 @@ TextureCube::TextureCube(const eastl::string& name)
     m_name = name;
 }
 
+TextureCube::~TextureCube()
+{
+    Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
+    if (pRenderer && m_pTexture)
+    {
+        pRenderer->CancelUploads(m_pTexture.get());
+    }
+}
+
 bool TextureCube::Create(uint32_t width, uint32_t height, uint32_t levels, GfxFormat format, GfxTextureUsageFlags flags)
 {
     Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
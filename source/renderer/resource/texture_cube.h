@@ -7,6 +7,7 @@ class TextureCube
 {
 public:
     TextureCube(const eastl::string& name);
+    ~TextureCube();
 
     bool Create(uint32_t width, uint32_t height, uint32_t levels, GfxFormat format, GfxTextureUsageFlags flags);
 
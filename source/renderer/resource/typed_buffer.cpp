@@ -7,6 +7,15 @@ TypedBuffer::TypedBuffer(const eastl::string& name)
     m_name = name;
 }
 
+TypedBuffer::~TypedBuffer()
+{
+    Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
+    if (pRenderer && m_pBuffer)
+    {
+        pRenderer->CancelUploads(m_pBuffer.get());
+    }
+}
+
 bool TypedBuffer::Create(GfxFormat format, uint32_t element_count, GfxMemoryType memory_type, bool uav)
 {
     Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
@@ -7,6 +7,7 @@ class TypedBuffer
 {
 public:
     TypedBuffer(const eastl::string& name);
+    ~TypedBuffer();
 
     bool Create(GfxFormat format, uint32_t element_count, GfxMemoryType memory_type, bool uav);
 
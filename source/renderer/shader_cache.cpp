@@ -2,11 +2,14 @@
 #include "renderer.h"
 #include "shader_compiler.h"
 #include "pipeline_cache.h"
+#include "precomputed_data_cache.h"
 #include "utils/log.h"
+#include "utils/fmt.h"
+#include "utils/parallel_for.h"
 #include "core/engine.h"
+#include "sokol/sokol_time.h"
+#include "enkiTS/TaskScheduler.h"
 #include <fstream>
-#include <filesystem>
-#include <regex>
 
 inline bool operator==(const GfxShaderDesc& lhs, const GfxShaderDesc& rhs)
 {
@@ -53,9 +56,18 @@ static inline eastl::string LoadFile(const eastl::string& path)
     return content;
 }
 
+//bump when the layout of the shader binaries changes (e.g. MetalShaderReflection)
+#define SHADER_BINARY_VERSION 1
+
 ShaderCache::ShaderCache(Renderer* pRenderer)
 {
     m_pRenderer = pRenderer;
+    m_pBinaryCache = eastl::make_unique<PrecomputedDataCache>(Engine::GetInstance()->GetWorkPath() + "cache/shaders/");
+}
+
+ShaderCache::~ShaderCache()
+{
+    WaitForAll();
 }
 
 IGfxShader* ShaderCache::GetShader(const eastl::string& file, const eastl::string& entry_point, GfxShaderType type, const eastl::vector<eastl::string>& defines, GfxShaderCompilerFlags flags)
@@ -70,6 +82,8 @@ IGfxShader* ShaderCache::GetShader(const eastl::string& file, const eastl::strin
     desc.defines = defines;
     desc.flags = flags;
 
+    std::scoped_lock lock(m_shaderMutex);
+
     auto iter = m_cachedShaders.find(desc);
     if (iter != m_cachedShaders.end())
     {
@@ -87,133 +101,366 @@ IGfxShader* ShaderCache::GetShader(const eastl::string& file, const eastl::strin
 
 eastl::string ShaderCache::GetCachedFileContent(const eastl::string& file)
 {
-    auto iter = m_cachedFile.find(file);
-    if (iter != m_cachedFile.end())
     {
-        return iter->second;
+        std::scoped_lock lock(m_fileMutex);
+
+        auto iter = m_cachedFile.find(file);
+        if (iter != m_cachedFile.end())
+        {
+            return iter->second.content;
+        }
+    }
+
+    //the time is queried first, an edit while reading shows up as a newer time on the next reload
+    CachedFile cached;
+    std::error_code error;
+    cached.time = std::filesystem::last_write_time(file.c_str(), error);
+    cached.content = LoadFile(file);
+
+    std::scoped_lock lock(m_fileMutex);
+    m_cachedFile.insert(eastl::make_pair(file, cached));
+
+    return cached.content;
+}
+
+enki::ICompletable* ShaderCache::GetCompileTask(const IGfxShader* shader) const
+{
+    std::scoped_lock lock(m_shaderMutex);
+
+    auto iter = m_compileTasks.find(shader);
+    if (iter != m_compileTasks.end())
+    {
+        return iter->second.get();
     }
+    return nullptr;
+}
 
-    eastl::string source = LoadFile(file);
+void ShaderCache::WaitForAll()
+{
+    for (auto iter = m_compileTasks.begin(); iter != m_compileTasks.end(); ++iter)
+    {
+        if (!iter->second->GetIsComplete())
+        {
+            Engine::GetInstance()->GetTaskScheduler()->WaitforTask(iter->second.get());
+        }
+    }
+}
 
-    m_cachedFile.insert(eastl::make_pair(file, source));
+void ShaderCache::ReleaseCompletedTasks()
+{
+    std::scoped_lock lock(m_shaderMutex);
 
-    return source;
+    for (auto iter = m_compileTasks.begin(); iter != m_compileTasks.end();)
+    {
+        if (iter->second->GetIsComplete())
+        {
+            iter = m_compileTasks.erase(iter);
+        }
+        else
+        {
+            ++iter;
+        }
+    }
 }
 
 void ShaderCache::ReloadShaders()
 {
-    for (auto iter = m_cachedFile.begin(); iter != m_cachedFile.end(); ++iter)
+    WaitForAll();
+
+    eastl::hash_set<IGfxShader*> changedShaders;
+
     {
-        const eastl::string& path = iter->first;
-        const eastl::string& source = iter->second;
-        
-        eastl::string new_source = LoadFile(path);
+        std::scoped_lock lock(m_fileMutex);
 
-        if (source != new_source)
+        for (auto iter = m_cachedFile.begin(); iter != m_cachedFile.end(); ++iter)
         {
-            m_cachedFile[path] = new_source;
+            const eastl::string& path = iter->first;
+            CachedFile& file = iter->second;
+
+            std::error_code error;
+            std::filesystem::file_time_type time = std::filesystem::last_write_time(path.c_str(), error);
+            if (error || time == file.time)
+            {
+                continue;
+            }
+
+            file.time = time;
 
-            eastl::vector<IGfxShader*> changedShaders = GetShaderList(path);
-            for (size_t i = 0; i < changedShaders.size(); ++i)
+            //touched without changing the content
+            eastl::string content = LoadFile(path);
+            if (content == file.content)
             {
-                RecompileShader(changedShaders[i]);
+                continue;
             }
+
+            file.content = content;
+
+            eastl::vector<IGfxShader*> shaders = GetShaderList(path);
+            changedShaders.insert(shaders.begin(), shaders.end());
         }
     }
-}
 
-IGfxShader* ShaderCache::CreateShader(const eastl::string& file, const eastl::string& entry_point, GfxShaderType type, const eastl::vector<eastl::string>& defines, GfxShaderCompilerFlags flags)
-{
-    eastl::string source = GetCachedFileContent(file);
+    if (changedShaders.empty())
+    {
+        return;
+    }
+
+    uint64_t ticks = stm_now();
+
+    eastl::vector<IGfxShader*> shaders(changedShaders.begin(), changedShaders.end());
+    eastl::vector<eastl::vector<uint8_t>> shaderBlobs(shaders.size());
+
+    ParallelFor((uint32_t)shaders.size(), [&](uint32_t i)
+        {
+            const GfxShaderDesc& desc = shaders[i]->GetDesc();
+            RE_INFO("recompling shader : {} : {}", desc.file, desc.entry_point);
+
+            eastl::vector<eastl::string> included_files;
+            bool compiled = CompileShader(desc.file, desc.entry_point, desc.type, desc.defines, desc.flags, shaderBlobs[i], included_files);
+            if (!compiled)
+            {
+                shaderBlobs[i].clear();
+            }
 
-    eastl::vector<uint8_t> shader_blob;
-    if (!m_pRenderer->GetShaderCompiler()->Compile(source, file, entry_point, type, defines, flags, shader_blob))
+            UpdateDependencies(shaders[i], included_files, compiled);
+        });
+
+    //shaders which failed to compile keep their previous bytecode
+    PipelineStateCache* pipelineCache = m_pRenderer->GetPipelineStateCache();
+    for (size_t i = 0; i < shaders.size(); ++i)
     {
-        return nullptr;
+        if (!shaderBlobs[i].empty() && shaders[i]->Create(shaderBlobs[i]))
+        {
+            pipelineCache->RecreatePSO(shaders[i]);
+        }
     }
 
+    RE_INFO("[ShaderCache] recompiled {} shaders in {:.2f} ms", shaders.size(), stm_ms(stm_since(ticks)));
+}
+
+IGfxShader* ShaderCache::CreateShader(const eastl::string& file, const eastl::string& entry_point, GfxShaderType type, const eastl::vector<eastl::string>& defines, GfxShaderCompilerFlags flags)
+{
     GfxShaderDesc desc;
     desc.type = type;
     desc.file = file;
     desc.entry_point = entry_point;
     desc.defines = defines;
+    desc.flags = flags;
 
+    //created without bytecode, it is filled in by the compile task
     eastl::string name = file + " : " + entry_point;
-    IGfxShader* shader = m_pRenderer->GetDevice()->CreateShader(desc, shader_blob, name);
+    IGfxShader* shader = m_pRenderer->GetDevice()->CreateShader(desc, {}, name);
+    if (shader == nullptr)
+    {
+        return nullptr;
+    }
+
+    auto task = eastl::make_unique<enki::TaskSet>([this, shader](enki::TaskSetPartition range, uint32_t threadnum)
+        {
+            const GfxShaderDesc& desc = shader->GetDesc();
+
+            eastl::vector<uint8_t> shader_blob;
+            eastl::vector<eastl::string> included_files;
+            bool compiled = CompileShader(desc.file, desc.entry_point, desc.type, desc.defines, desc.flags, shader_blob, included_files);
+            if (compiled)
+            {
+                shader->Create(shader_blob);
+            }
+
+            UpdateDependencies(shader, included_files, compiled);
+        });
+
+    Engine::GetInstance()->GetTaskScheduler()->AddTaskSetToPipe(task.get());
+    m_compileTasks.insert(eastl::make_pair(shader, eastl::move(task)));
+
     return shader;
 }
 
-void ShaderCache::RecompileShader(IGfxShader* shader)
+bool ShaderCache::CompileShader(const eastl::string& file, const eastl::string& entry_point, GfxShaderType type, const eastl::vector<eastl::string>& defines, GfxShaderCompilerFlags flags,
+    eastl::vector<uint8_t>& shader_blob, eastl::vector<eastl::string>& included_files)
 {
-    const GfxShaderDesc& desc = shader->GetDesc();
-    RE_INFO("recompling shader : {}", desc.file);
+    eastl::string name = fmt::format("{}_{}", std::filesystem::path(file.c_str()).stem().string(), entry_point).c_str();
+    uint64_t hash = GetPermutationHash(file, entry_point, type, defines, flags);
+    name += fmt::format("_{:016x}", hash).c_str();
 
-    eastl::string source = GetCachedFileContent(desc.file);
+    if (LoadShaderBinary(name, hash, shader_blob, included_files))
+    {
+        m_nBinaryHits++;
+        return true;
+    }
+
+    m_nBinaryMisses++;
 
-    eastl::vector<uint8_t> shader_blob;
-    if (!m_pRenderer->GetShaderCompiler()->Compile(source, desc.file, desc.entry_point, desc.type, desc.defines, desc.flags, shader_blob))
+    uint64_t ticks = stm_now();
+
+    eastl::string source = GetCachedFileContent(file);
+    if (!m_pRenderer->GetShaderCompiler()->Compile(source, file, entry_point, type, defines, flags, shader_blob, &included_files))
     {
-        return;
+        return false;
     }
 
-    shader->Create(shader_blob);
+    m_nCompileTicks += stm_since(ticks);
 
-    PipelineStateCache* pipelineCache = m_pRenderer->GetPipelineStateCache();
-    pipelineCache->RecreatePSO(shader);
+    SaveShaderBinary(name, hash, included_files, shader_blob);
+    return true;
 }
 
-eastl::vector<IGfxShader*> ShaderCache::GetShaderList(const eastl::string& file)
+// binary layout : dependency count, { content hash, path length, path } * count, shader blob
+bool ShaderCache::LoadShaderBinary(const eastl::string& name, uint64_t hash, eastl::vector<uint8_t>& shader_blob, eastl::vector<eastl::string>& included_files)
 {
-    eastl::vector<IGfxShader*> shaders;
+    PrecomputedDataCache::Entry entry;
+    if (!m_pBinaryCache->Load(name, hash, entry))
+    {
+        return false;
+    }
+
+    const uint8_t* data = (const uint8_t*)entry.GetData();
+    const uint8_t* end = data + entry.GetSize();
 
-    for (auto iter = m_cachedShaders.begin(); iter != m_cachedShaders.end(); ++iter)
+    auto read = [&](void* dst, size_t size)
     {
-        if (IsFileIncluded(iter->second.get(), file))
+        if (data + size > end)
         {
-            shaders.push_back(iter->second.get());
+            return false;
+        }
+        memcpy(dst, data, size);
+        data += size;
+        return true;
+    };
+
+    uint32_t dependency_count;
+    if (!read(&dependency_count, sizeof(uint32_t)))
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < dependency_count; ++i)
+    {
+        uint64_t content_hash;
+        uint32_t path_length;
+        if (!read(&content_hash, sizeof(uint64_t)) || !read(&path_length, sizeof(uint32_t)) || data + path_length > end)
+        {
+            return false;
         }
+
+        eastl::string path((const char*)data, path_length);
+        data += path_length;
+
+        eastl::string content = GetCachedFileContent(path);
+        if (XXH3_64bits(content.data(), content.length()) != content_hash)
+        {
+            RE_DEBUG("[ShaderCache] {} is out of date, {} has changed", name, path);
+            m_nBinaryOutOfDate++;
+            return false;
+        }
+
+        included_files.push_back(path);
     }
 
-    return shaders;
+    shader_blob.assign(data, end);
+    return !shader_blob.empty();
 }
 
-bool ShaderCache::IsFileIncluded(const IGfxShader* shader, const eastl::string& file)
+void ShaderCache::SaveShaderBinary(const eastl::string& name, uint64_t hash, const eastl::vector<eastl::string>& included_files, const eastl::vector<uint8_t>& shader_blob)
 {
-    const GfxShaderDesc& desc = shader->GetDesc();
+    eastl::vector<uint8_t> data;
+    auto write = [&](const void* src, size_t size)
+    {
+        data.insert(data.end(), (const uint8_t*)src, (const uint8_t*)src + size);
+    };
 
-    if (desc.file == file)
+    uint32_t dependency_count = (uint32_t)included_files.size();
+    write(&dependency_count, sizeof(uint32_t));
+
+    for (size_t i = 0; i < included_files.size(); ++i)
     {
-        return true;
+        eastl::string content = GetCachedFileContent(included_files[i]);
+        uint64_t content_hash = XXH3_64bits(content.data(), content.length());
+        uint32_t path_length = (uint32_t)included_files[i].length();
+
+        write(&content_hash, sizeof(uint64_t));
+        write(&path_length, sizeof(uint32_t));
+        write(included_files[i].data(), path_length);
     }
 
-    eastl::string extension = std::filesystem::path(file.c_str()).extension().string().c_str();
-    bool is_header = extension == ".hlsli" || extension == ".h";
+    write(shader_blob.data(), shader_blob.size());
+
+    m_pBinaryCache->Save(name, hash, data.data(), (uint32_t)data.size());
+}
+
+uint64_t ShaderCache::GetPermutationHash(const eastl::string& file, const eastl::string& entry_point, GfxShaderType type, const eastl::vector<eastl::string>& defines, GfxShaderCompilerFlags flags)
+{
+    IGfxDevice* device = m_pRenderer->GetDevice();
+
+    //the main source is part of the key, included files are validated when loading
+    eastl::string source = GetCachedFileContent(file);
+
+    uint64_t hash = XXH3_64bits(source.data(), source.length());
+    hash = hash_combine_64(hash, XXH3_64bits(file.data(), file.length()));
+    hash = hash_combine_64(hash, XXH3_64bits(entry_point.data(), entry_point.length()));
 
-    if (is_header)
+    for (size_t i = 0; i < defines.size(); ++i)
     {
-        std::string source = GetCachedFileContent(desc.file).c_str();
-        std::regex r("#include\\s*\"\\s*\\S+.\\S+\\s*\"");
+        hash = hash_combine_64(hash, XXH3_64bits(defines[i].data(), defines[i].length()));
+    }
 
-        std::smatch result;
-        while (std::regex_search(source, result, r))
-        {
-            eastl::string include = result[0].str().c_str();
+#ifdef _DEBUG
+    const uint32_t debug = 1;
+#else
+    const uint32_t debug = 0;
+#endif
+    uint32_t settings[] = { (uint32_t)type, (uint32_t)flags, (uint32_t)device->GetDesc().backend, (uint32_t)device->GetVendor(), debug, SHADER_BINARY_VERSION };
+    hash = hash_combine_64(hash, XXH3_64bits(settings, sizeof(settings)));
 
-            size_t first = include.find_first_of('\"');
-            size_t last = include.find_last_of('\"');
-            eastl::string header = include.substr(first + 1, last - first - 1);
+    return hash_combine_64(hash, m_pRenderer->GetShaderCompiler()->GetVersionHash());
+}
 
-            std::filesystem::path path(desc.file.c_str());
-            std::filesystem::path header_path = path.parent_path() / header.c_str();
+void ShaderCache::UpdateDependencies(IGfxShader* shader, const eastl::vector<eastl::string>& included_files, bool compiled)
+{
+    std::scoped_lock lock(m_dependencyMutex);
 
-            if (std::filesystem::absolute(header_path).string().c_str() == file)
-            {
-                return true;
-            }
+    eastl::vector<eastl::string>& dependencies = m_shaderDependencies[shader];
 
-            source = result.suffix();
+    //a failed compilation may have stopped before reaching every include, the previous edges are kept then
+    if (compiled)
+    {
+        for (size_t i = 0; i < dependencies.size(); ++i)
+        {
+            m_fileDependents[dependencies[i]].erase(shader);
         }
+        dependencies.clear();
     }
 
-    return false;
+    auto add = [&](const eastl::string& file)
+    {
+        if (m_fileDependents[file].insert(shader).second)
+        {
+            dependencies.push_back(file);
+        }
+    };
+
+    add(shader->GetDesc().file);
+    for (size_t i = 0; i < included_files.size(); ++i)
+    {
+        add(included_files[i]);
+    }
+}
+
+eastl::vector<IGfxShader*> ShaderCache::GetShaderList(const eastl::string& file)
+{
+    std::scoped_lock lock(m_dependencyMutex);
+
+    auto iter = m_fileDependents.find(file);
+    if (iter == m_fileDependents.end())
+    {
+        return {};
+    }
+
+    return eastl::vector<IGfxShader*>(iter->second.begin(), iter->second.end());
+}
+
+void ShaderCache::LogStats() const
+{
+    RE_INFO("[ShaderCache] binary cache hits : {}, misses : {} ({} out of date), compile time (all threads) : {:.2f} ms",
+        m_nBinaryHits.load(), m_nBinaryMisses.load(), m_nBinaryOutOfDate.load(), stm_ms(m_nCompileTicks.load()));
 }
@@ -2,7 +2,14 @@
 
 #include "../gfx/gfx.h"
 #include "EASTL/hash_map.h"
+#include "EASTL/hash_set.h"
 #include "EASTL/unique_ptr.h"
+#include "EASTL/atomic.h"
+#include <mutex>
+#include <filesystem>
+
+class PrecomputedDataCache;
+namespace enki { class TaskSet; class ICompletable; }
 
 namespace eastl
 {
@@ -28,21 +35,59 @@ class ShaderCache
 {
 public:
     ShaderCache(Renderer* pRenderer);
+    ~ShaderCache();
 
+    //returns immediately, the shader is compiled on a worker thread and becomes ready when it finishes. thread-safe
     IGfxShader* GetShader(const eastl::string& file, const eastl::string& entry_point, GfxShaderType type, const eastl::vector<eastl::string>& defines, GfxShaderCompilerFlags flags);
-    eastl::string GetCachedFileContent(const eastl::string& file);
+    eastl::string GetCachedFileContent(const eastl::string& file); //thread-safe
+
+    enki::ICompletable* GetCompileTask(const IGfxShader* shader) const; //thread-safe
+    void WaitForAll();
+    void ReleaseCompletedTasks(); //only while no PSO is pending, the PSO tasks wait on the compile tasks of their shaders
 
     void ReloadShaders();
 
+    void LogStats() const;
+
 private:
     IGfxShader* CreateShader(const eastl::string& file, const eastl::string& entry_point, GfxShaderType type, const eastl::vector<eastl::string>& defines, GfxShaderCompilerFlags flags);
-    void RecompileShader(IGfxShader* shader);
 
+    //included_files : every file the shader depends on, nested includes included
+    bool CompileShader(const eastl::string& file, const eastl::string& entry_point, GfxShaderType type, const eastl::vector<eastl::string>& defines, GfxShaderCompilerFlags flags,
+        eastl::vector<uint8_t>& shader_blob, eastl::vector<eastl::string>& included_files);
+
+    //compiled blobs on disk, validated against the content of every file the shader included
+    bool LoadShaderBinary(const eastl::string& name, uint64_t hash, eastl::vector<uint8_t>& shader_blob, eastl::vector<eastl::string>& included_files);
+    void SaveShaderBinary(const eastl::string& name, uint64_t hash, const eastl::vector<eastl::string>& included_files, const eastl::vector<uint8_t>& shader_blob);
+    uint64_t GetPermutationHash(const eastl::string& file, const eastl::string& entry_point, GfxShaderType type, const eastl::vector<eastl::string>& defines, GfxShaderCompilerFlags flags);
+
+    void UpdateDependencies(IGfxShader* shader, const eastl::vector<eastl::string>& included_files, bool compiled); //thread-safe
     eastl::vector<IGfxShader*> GetShaderList(const eastl::string& file);
-    bool IsFileIncluded(const IGfxShader* shader, const eastl::string& file);
 
 private:
     Renderer* m_pRenderer;
+
+    //guards the shader and task maps, objects request their shaders lazily from the parallel world tick
+    mutable std::mutex m_shaderMutex;
     eastl::hash_map<GfxShaderDesc, eastl::unique_ptr<IGfxShader>> m_cachedShaders;
-    eastl::hash_map<eastl::string, eastl::string> m_cachedFile;
+    eastl::hash_map<const IGfxShader*, eastl::unique_ptr<enki::TaskSet>> m_compileTasks;
+
+    struct CachedFile
+    {
+        eastl::string content;
+        std::filesystem::file_time_type time;
+    };
+    std::mutex m_fileMutex;
+    eastl::hash_map<eastl::string, CachedFile> m_cachedFile;
+
+    //include graph captured by the compiler, a file maps to every shader which includes it directly or through other headers
+    std::mutex m_dependencyMutex;
+    eastl::hash_map<const IGfxShader*, eastl::vector<eastl::string>> m_shaderDependencies;
+    eastl::hash_map<eastl::string, eastl::hash_set<IGfxShader*>> m_fileDependents;
+
+    eastl::unique_ptr<PrecomputedDataCache> m_pBinaryCache;
+    eastl::atomic<uint32_t> m_nBinaryHits{ 0 };
+    eastl::atomic<uint32_t> m_nBinaryMisses{ 0 };
+    eastl::atomic<uint32_t> m_nBinaryOutOfDate{ 0 };
+    eastl::atomic<uint64_t> m_nCompileTicks{ 0 }; //summed over all worker threads
 };
\ No newline at end of file
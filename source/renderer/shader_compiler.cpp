@@ -5,6 +5,8 @@
 #include "utils/log.h"
 #include "utils/string.h"
 #include "utils/assert.h"
+#include "utils/fmt.h"
+#include "xxHash/xxhash.h"
 
 #include <filesystem>
 #if RE_PLATFORM_WINDOWS
@@ -19,11 +21,18 @@ public:
     {
     }
 
+    const eastl::vector<eastl::string>& GetIncludedFiles() const { return m_includedFiles; }
+
     HRESULT STDMETHODCALLTYPE LoadSource(LPCWSTR fileName, IDxcBlob** includeSource) override
     {
         eastl::string absolute_path = std::filesystem::absolute(fileName).string().c_str();
         eastl::string source = m_pShaderCache->GetCachedFileContent(absolute_path);
 
+        if (eastl::find(m_includedFiles.begin(), m_includedFiles.end(), absolute_path) == m_includedFiles.end())
+        {
+            m_includedFiles.push_back(absolute_path);
+        }
+
         *includeSource = nullptr;
         return m_pDxcUtils->CreateBlob(source.data(), (UINT32)source.size(), CP_UTF8, reinterpret_cast<IDxcBlobEncoding**>(includeSource));
     }
@@ -69,8 +78,21 @@ private:
     ShaderCache* m_pShaderCache = nullptr;
     IDxcUtils* m_pDxcUtils = nullptr;
     std::atomic<ULONG> m_ref = 0;
+    eastl::vector<eastl::string> m_includedFiles;
+};
+
+//dxc compilers are not thread-safe, each concurrent compilation uses its own instance
+struct ShaderCompiler::Instance
+{
+    IDxcCompiler3* dxcCompiler = nullptr;
+    IDxcUtils* dxcUtils = nullptr;
+#if RE_PLATFORM_MAC
+    IRCompiler* metalCompiler = nullptr;
+#endif
 };
 
+static DxcCreateInstanceProc s_DxcCreateInstance = nullptr;
+
 ShaderCompiler::ShaderCompiler(Renderer* pRenderer) : m_pRenderer(pRenderer)
 {
 #if RE_PLATFORM_WINDOWS
@@ -82,44 +104,80 @@ ShaderCompiler::ShaderCompiler(Renderer* pRenderer) : m_pRenderer(pRenderer)
     if (dxc)
     {
 #if RE_PLATFORM_WINDOWS
-        DxcCreateInstanceProc DxcCreateInstance = (DxcCreateInstanceProc)GetProcAddress(dxc, "DxcCreateInstance");
+        s_DxcCreateInstance = (DxcCreateInstanceProc)GetProcAddress(dxc, "DxcCreateInstance");
 #else
-        DxcCreateInstanceProc DxcCreateInstance = (DxcCreateInstanceProc)dlsym(dxc, "DxcCreateInstance");
+        s_DxcCreateInstance = (DxcCreateInstanceProc)dlsym(dxc, "DxcCreateInstance");
 #endif
-
-        DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&m_pDxcUtils));
-        DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&m_pDxcCompiler));
-
-        //m_pDxcUtils->CreateDefaultIncludeHandler(&m_pDxcIncludeHandler);
-        m_pDxcIncludeHandler = new DXCIncludeHandler(pRenderer->GetShaderCache(), m_pDxcUtils);
-        m_pDxcIncludeHandler->AddRef();
     }
     
 #if RE_PLATFORM_MAC
     CreateMetalCompiler();
 #endif
+
+    if (s_DxcCreateInstance)
+    {
+        Instance* instance = AcquireInstance();
+        CreateVersionHash(instance);
+        ReleaseInstance(instance);
+    }
 }
 
 ShaderCompiler::~ShaderCompiler()
 {
-    if(m_pDxcIncludeHandler)
-    {
-        m_pDxcIncludeHandler->Release();
-    }
-    
-    if(m_pDxcCompiler)
+    for (size_t i = 0; i < m_instances.size(); ++i)
     {
-        m_pDxcCompiler->Release();
+        Instance* instance = m_instances[i];
+
+        if (instance->dxcCompiler)
+        {
+            instance->dxcCompiler->Release();
+        }
+
+        if (instance->dxcUtils)
+        {
+            instance->dxcUtils->Release();
+        }
+
+#if RE_PLATFORM_MAC
+        IRCompilerDestroy(instance->metalCompiler);
+#endif
+        delete instance;
     }
     
-    if(m_pDxcUtils)
+#if RE_PLATFORM_MAC
+    DestroyMetalCompiler();
+#endif
+}
+
+ShaderCompiler::Instance* ShaderCompiler::AcquireInstance()
+{
     {
-        m_pDxcUtils->Release();
+        std::scoped_lock lock(m_instanceMutex);
+
+        if (!m_freeInstances.empty())
+        {
+            Instance* instance = m_freeInstances.back();
+            m_freeInstances.pop_back();
+            return instance;
+        }
     }
-    
+
+    Instance* instance = new Instance;
+    s_DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&instance->dxcUtils));
+    s_DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&instance->dxcCompiler));
 #if RE_PLATFORM_MAC
-    DestroyMetalCompiler();
+    instance->metalCompiler = IRCompilerCreate();
 #endif
+
+    std::scoped_lock lock(m_instanceMutex);
+    m_instances.push_back(instance);
+    return instance;
+}
+
+void ShaderCompiler::ReleaseInstance(Instance* instance)
+{
+    std::scoped_lock lock(m_instanceMutex);
+    m_freeInstances.push_back(instance);
 }
 
 inline const wchar_t* GetShaderProfile(GfxShaderType type)
@@ -141,9 +199,60 @@ inline const wchar_t* GetShaderProfile(GfxShaderType type)
     }
 }
 
+void ShaderCompiler::CreateVersionHash(Instance* instance)
+{
+    eastl::string version;
+
+    CComPtr<IDxcVersionInfo> pVersionInfo;
+    if (SUCCEEDED(instance->dxcCompiler->QueryInterface(IID_PPV_ARGS(&pVersionInfo))))
+    {
+        UINT32 major = 0, minor = 0;
+        pVersionInfo->GetVersion(&major, &minor);
+        version += fmt::format("dxc {}.{}", major, minor).c_str();
+    }
+
+    CComPtr<IDxcVersionInfo2> pVersionInfo2;
+    if (SUCCEEDED(instance->dxcCompiler->QueryInterface(IID_PPV_ARGS(&pVersionInfo2))))
+    {
+        UINT32 commit_count = 0;
+        char* commit_hash = nullptr;
+        if (SUCCEEDED(pVersionInfo2->GetCommitInfo(&commit_count, &commit_hash)))
+        {
+            version += fmt::format(" ({}, {})", commit_count, commit_hash).c_str();
+            CoTaskMemFree(commit_hash);
+        }
+    }
+
+#if RE_PLATFORM_MAC
+    //metal shader converter settings, see CompileMetalIR
+    version += " metal_irconverter Apple7 macOS 15.0.0";
+#endif
+
+    RE_INFO("[ShaderCompiler] {}", version);
+
+    m_nVersionHash = XXH3_64bits(version.data(), version.length());
+}
+
 bool ShaderCompiler::Compile(const eastl::string& source, const eastl::string& file, const eastl::string& entry_point,
     GfxShaderType type, const eastl::vector<eastl::string>& defines, GfxShaderCompilerFlags flags,
-    eastl::vector<uint8_t>& output_blob)
+    eastl::vector<uint8_t>& output_blob, eastl::vector<eastl::string>* included_files)
+{
+    if (s_DxcCreateInstance == nullptr)
+    {
+        RE_ERROR("[ShaderCompiler] dxcompiler is not loaded");
+        return false;
+    }
+
+    Instance* instance = AcquireInstance();
+    bool result = Compile(instance, source, file, entry_point, type, defines, flags, output_blob, included_files);
+    ReleaseInstance(instance);
+
+    return result;
+}
+
+bool ShaderCompiler::Compile(Instance* instance, const eastl::string& source, const eastl::string& file, const eastl::string& entry_point,
+    GfxShaderType type, const eastl::vector<eastl::string>& defines, GfxShaderCompilerFlags flags,
+    eastl::vector<uint8_t>& output_blob, eastl::vector<eastl::string>* included_files)
 {
     DxcBuffer sourceBuffer;
     sourceBuffer.Ptr = source.data();
@@ -259,8 +368,16 @@ bool ShaderCompiler::Compile(const eastl::string& source, const eastl::string& f
     arguments.push_back(L"-Vd"); //disable dxil validation because we don't have a libdxil.so for mac
 #endif
 
+    //a handler per compilation, it records the files included by this shader
+    CComPtr<DXCIncludeHandler> pIncludeHandler = new DXCIncludeHandler(m_pRenderer->GetShaderCache(), instance->dxcUtils);
+
     CComPtr<IDxcResult> pResults;
-    m_pDxcCompiler->Compile(&sourceBuffer, arguments.data(), (UINT32)arguments.size(), m_pDxcIncludeHandler, IID_PPV_ARGS(&pResults));
+    instance->dxcCompiler->Compile(&sourceBuffer, arguments.data(), (UINT32)arguments.size(), pIncludeHandler, IID_PPV_ARGS(&pResults));
+
+    if (included_files)
+    {
+        *included_files = pIncludeHandler->GetIncludedFiles();
+    }
 
     CComPtr<IDxcBlobUtf8> pErrors = nullptr;
     pResults->GetOutput(DXC_OUT_ERRORS, IID_PPV_ARGS(&pErrors), nullptr);
@@ -286,7 +403,7 @@ bool ShaderCompiler::Compile(const eastl::string& source, const eastl::string& f
 #if RE_PLATFORM_MAC
     if(m_pRenderer->GetDevice()->GetDesc().backend == GfxRenderBackend::Metal)
     {
-        return CompileMetalIR(file, entry_point, type, pShader->GetBufferPointer(), (uint32_t)pShader->GetBufferSize(), output_blob);
+        return CompileMetalIR(instance->metalCompiler, file, entry_point, type, pShader->GetBufferPointer(), (uint32_t)pShader->GetBufferSize(), output_blob);
     }
     else
 #else
@@ -2,15 +2,14 @@
 
 #include "core/platform.h"
 #include "gfx/gfx_defines.h"
+#include <mutex>
 
-struct IDxcCompiler3;
-struct IDxcUtils;
-struct IDxcIncludeHandler;
 struct IRCompiler;
 struct IRRootSignature;
 
 class Renderer;
 
+// thread-safe, shaders can be compiled concurrently from worker threads
 class ShaderCompiler
 {
 public:
@@ -19,24 +18,39 @@ public:
 
     bool Compile(const eastl::string& source, const eastl::string& file, const eastl::string& entry_point, 
         GfxShaderType type, const eastl::vector<eastl::string>& defines, GfxShaderCompilerFlags flags,
-        eastl::vector<uint8_t>& output_blob);
+        eastl::vector<uint8_t>& output_blob, eastl::vector<eastl::string>* included_files = nullptr);
+
+    //identifies the compiler toolchain, part of the shader binary cache key
+    uint64_t GetVersionHash() const { return m_nVersionHash; }
+
+private:
+    struct Instance;
+    Instance* AcquireInstance();
+    void ReleaseInstance(Instance* instance);
+
+    bool Compile(Instance* instance, const eastl::string& source, const eastl::string& file, const eastl::string& entry_point,
+        GfxShaderType type, const eastl::vector<eastl::string>& defines, GfxShaderCompilerFlags flags,
+        eastl::vector<uint8_t>& output_blob, eastl::vector<eastl::string>* included_files);
+
+    void CreateVersionHash(Instance* instance);
 
 #if RE_PLATFORM_MAC
 private:
     void CreateMetalCompiler();
     void DestroyMetalCompiler();
-    bool CompileMetalIR(const eastl::string& file, const eastl::string& entry_point, GfxShaderType type,
+    bool CompileMetalIR(IRCompiler* compiler, const eastl::string& file, const eastl::string& entry_point, GfxShaderType type,
         const void* data, uint32_t data_size, eastl::vector<uint8_t>& output_blob);
 #endif
     
 private:
     Renderer* m_pRenderer = nullptr;
-    IDxcCompiler3* m_pDxcCompiler = nullptr;
-    IDxcUtils* m_pDxcUtils = nullptr;
-    IDxcIncludeHandler* m_pDxcIncludeHandler = nullptr;
+    uint64_t m_nVersionHash = 0;
+
+    std::mutex m_instanceMutex;
+    eastl::vector<Instance*> m_instances;
+    eastl::vector<Instance*> m_freeInstances;
     
 #if RE_PLATFORM_MAC
-    IRCompiler* m_pMetalCompiler = nullptr;
     IRRootSignature* m_pMetalRootSignature = nullptr;
 #endif
 };
@@ -66,8 +66,6 @@ inline void GetReflectionInfo(IRShaderReflection* pShaderReflection, IRShaderSta
 
 void ShaderCompiler::CreateMetalCompiler()
 {
-    m_pMetalCompiler = IRCompilerCreate();
-    
     //D3D12Device::CreateRootSignature
     IRRootParameter1 rootParameters[3] = {};
     
@@ -109,20 +107,19 @@ void ShaderCompiler::CreateMetalCompiler()
 void ShaderCompiler::DestroyMetalCompiler()
 {
     IRRootSignatureDestroy(m_pMetalRootSignature);
-    IRCompilerDestroy(m_pMetalCompiler);
 }
 
-bool ShaderCompiler::CompileMetalIR(const eastl::string& file, const eastl::string& entry_point, GfxShaderType type, const void* data, uint32_t data_size, eastl::vector<uint8_t>& output_blob)
+bool ShaderCompiler::CompileMetalIR(IRCompiler* compiler, const eastl::string& file, const eastl::string& entry_point, GfxShaderType type, const void* data, uint32_t data_size, eastl::vector<uint8_t>& output_blob)
 {
-    IRCompilerSetGlobalRootSignature(m_pMetalCompiler, m_pMetalRootSignature);
-    IRCompilerSetMinimumGPUFamily(m_pMetalCompiler, IRGPUFamilyApple7);
-    IRCompilerSetMinimumDeploymentTarget(m_pMetalCompiler, IROperatingSystem_macOS, "15.0.0"); // mac os 15, metal 3.2
-    IRCompilerSetEntryPointName(m_pMetalCompiler, entry_point.c_str());
+    IRCompilerSetGlobalRootSignature(compiler, m_pMetalRootSignature);
+    IRCompilerSetMinimumGPUFamily(compiler, IRGPUFamilyApple7);
+    IRCompilerSetMinimumDeploymentTarget(compiler, IROperatingSystem_macOS, "15.0.0"); // mac os 15, metal 3.2
+    IRCompilerSetEntryPointName(compiler, entry_point.c_str());
     
     IRObject* pDXIL = IRObjectCreateFromDXIL((const uint8_t*)data, (size_t)data_size, IRBytecodeOwnershipNone);
     
     IRError* pError = nullptr;
-    IRObject* pOutIR = IRCompilerAllocCompileAndLink(m_pMetalCompiler, nullptr, pDXIL, &pError);
+    IRObject* pOutIR = IRCompilerAllocCompileAndLink(compiler, nullptr, pDXIL, &pError);
 
     if (!pOutIR)
     {
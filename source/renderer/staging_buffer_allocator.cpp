@@ -2,60 +2,113 @@
 #include "renderer.h"
 #include "utils/math.h"
 
-#define BUFFER_SIZE (64 * 1024 * 1024)
+#define ALIGNMENT 512 //D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT
 
-StagingBufferAllocator::StagingBufferAllocator(Renderer* pRenderer)
+StagingBufferAllocator::StagingBufferAllocator(Renderer* pRenderer, uint32_t capacity)
 {
     m_pRenderer = pRenderer;
+    m_nCapacity = capacity;
+
+    GfxBufferDesc desc;
+    desc.size = capacity;
+    desc.memory_type = GfxMemoryType::CpuOnly;
+    m_pBuffer.reset(pRenderer->GetDevice()->CreateBuffer(desc, "StagingBufferAllocator::m_pBuffer"));
 }
 
 StagingBuffer StagingBufferAllocator::Allocate(uint32_t size)
 {
-    RE_ASSERT(size <= BUFFER_SIZE);
+    RE_ASSERT(size <= m_nCapacity);
+
+    //an empty ring restarts at a lap boundary, otherwise an allocation larger than the space left before the end of the
+    //buffer would need the tail to move past the current head, and could never succeed
+    if (m_nHead == m_nTail && m_nHead % m_nCapacity != 0)
+    {
+        RE_ASSERT(m_submissions.empty());
+        m_nHead = m_nTail = (m_nHead / m_nCapacity + 1) * m_nCapacity;
+    }
 
-    if (m_pBuffers.empty())
+    uint64_t position = (m_nHead + ALIGNMENT - 1) & ~(uint64_t)(ALIGNMENT - 1);
+
+    //allocations never wrap around the end of the buffer
+    if (position % m_nCapacity + size > m_nCapacity)
     {
-        CreateNewBuffer();
+        position = (position / m_nCapacity + 1) * m_nCapacity;
     }
 
-    if (m_nAllocatedSize + size > BUFFER_SIZE)
+    if (position + size - m_nTail > m_nCapacity)
     {
-        CreateNewBuffer();
-        m_nCurrentBuffer++;
-        m_nAllocatedSize = 0;
+        return { nullptr, 0, 0 };
     }
 
+    m_nHead = position + size;
+    m_nHighWaterMark = max(m_nHighWaterMark, m_nHead - m_nTail);
+
     StagingBuffer buffer;
-    buffer.buffer = m_pBuffers[m_nCurrentBuffer].get();
+    buffer.buffer = m_pBuffer.get();
     buffer.size = size;
-    buffer.offset = m_nAllocatedSize;
+    buffer.offset = (uint32_t)(position % m_nCapacity);
+    return buffer;
+}
+
+StagingBuffer StagingBufferAllocator::AllocateDedicated(uint32_t size)
+{
+    GfxBufferDesc desc;
+    desc.size = size;
+    desc.memory_type = GfxMemoryType::CpuOnly;
 
-    m_nAllocatedSize += RoundUpPow2(size, 512); //512 : D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT
-    m_nLastAllocatedFrame = m_pRenderer->GetFrameID();
+    IGfxBuffer* buffer = m_pRenderer->GetDevice()->CreateBuffer(desc, "StagingBufferAllocator::m_dedicatedBuffers");
+    m_dedicatedBuffers.push_back({ eastl::unique_ptr<IGfxBuffer>(buffer), 0 });
 
-    return buffer;
+    m_nDedicatedSize += size;
+    m_nDedicatedHighWaterMark = max(m_nDedicatedHighWaterMark, m_nDedicatedSize);
+
+    return { buffer, size, 0 };
 }
 
-void StagingBufferAllocator::Reset()
+void StagingBufferAllocator::Submit(uint64_t fence_value)
 {
-    m_nCurrentBuffer = 0;
-    m_nAllocatedSize = 0;
+    if (m_submissions.empty() || m_submissions.back().head != m_nHead)
+    {
+        m_submissions.push_back({ fence_value, m_nHead });
+    }
 
-    if (!m_pBuffers.empty())
+    for (size_t i = 0; i < m_dedicatedBuffers.size(); ++i)
     {
-        if (m_pRenderer->GetFrameID() - m_nLastAllocatedFrame > 100)
+        if (m_dedicatedBuffers[i].fence_value == 0)
         {
-            m_pBuffers.clear();
+            m_dedicatedBuffers[i].fence_value = fence_value;
         }
     }
 }
 
-void StagingBufferAllocator::CreateNewBuffer()
+void StagingBufferAllocator::Retire(uint64_t completed_fence_value)
 {
-    GfxBufferDesc desc;
-    desc.size = BUFFER_SIZE;
-    desc.memory_type = GfxMemoryType::CpuOnly;
+    while (!m_submissions.empty() && m_submissions.front().fence_value <= completed_fence_value)
+    {
+        m_nTail = m_submissions.front().head;
+        m_submissions.pop_front();
+    }
 
-    IGfxBuffer* buffer = m_pRenderer->GetDevice()->CreateBuffer(desc, "StagingBufferAllocator::m_pBuffer");
-    m_pBuffers.push_back(eastl::unique_ptr<IGfxBuffer>(buffer));
+    for (auto iter = m_dedicatedBuffers.begin(); iter != m_dedicatedBuffers.end();)
+    {
+        if (iter->fence_value != 0 && iter->fence_value <= completed_fence_value)
+        {
+            m_nDedicatedSize -= iter->buffer->GetDesc().size;
+            iter = m_dedicatedBuffers.erase(iter);
+        }
+        else
+        {
+            ++iter;
+        }
+    }
+}
+
+StagingBufferAllocator::Stats StagingBufferAllocator::GetStats() const
+{
+    Stats stats;
+    stats.usedSize = GetUsedSize();
+    stats.highWaterMark = m_nHighWaterMark;
+    stats.dedicatedSize = m_nDedicatedSize;
+    stats.dedicatedHighWaterMark = m_nDedicatedHighWaterMark;
+    return stats;
 }
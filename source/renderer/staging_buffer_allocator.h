@@ -2,6 +2,7 @@
 
 #include "../gfx/gfx.h"
 #include "EASTL/unique_ptr.h"
+#include "EASTL/deque.h"
 
 class Renderer;
 
@@ -12,21 +13,58 @@ struct StagingBuffer
     uint32_t offset;
 };
 
+// ring buffer shared by all frames, space is reclaimed once the upload fence passes the value it was submitted with
 class StagingBufferAllocator
 {
 public:
-    StagingBufferAllocator(Renderer* pRenderer);
+    StagingBufferAllocator(Renderer* pRenderer, uint32_t capacity);
 
+    // returns a null buffer if the ring has no free space right now
     StagingBuffer Allocate(uint32_t size);
-    void Reset();
 
-private:
-    void CreateNewBuffer();
+    // allocations larger than the ring get their own buffer
+    StagingBuffer AllocateDedicated(uint32_t size);
+
+    // all allocations since the last submit are in use until the fence reaches fence_value
+    void Submit(uint64_t fence_value);
+    void Retire(uint64_t completed_fence_value);
+
+    uint32_t GetCapacity() const { return m_nCapacity; }
+    uint64_t GetUsedSize() const { return m_nHead - m_nTail; }
+
+    struct Stats
+    {
+        uint64_t usedSize;
+        uint64_t highWaterMark;
+        uint64_t dedicatedSize;
+        uint64_t dedicatedHighWaterMark;
+    };
+    Stats GetStats() const;
 
 private:
     Renderer* m_pRenderer = nullptr;
-    eastl::vector<eastl::unique_ptr<IGfxBuffer>> m_pBuffers;
-    uint32_t m_nCurrentBuffer = 0;
-    uint32_t m_nAllocatedSize = 0;
-    uint64_t m_nLastAllocatedFrame = 0;
-};
\ No newline at end of file
+    eastl::unique_ptr<IGfxBuffer> m_pBuffer;
+    uint32_t m_nCapacity = 0;
+
+    //monotonic positions, the ring offset is position % capacity
+    uint64_t m_nHead = 0;
+    uint64_t m_nTail = 0;
+
+    struct Submission
+    {
+        uint64_t fence_value;
+        uint64_t head;
+    };
+    eastl::deque<Submission> m_submissions;
+
+    struct DedicatedBuffer
+    {
+        eastl::unique_ptr<IGfxBuffer> buffer;
+        uint64_t fence_value; //0 : not submitted yet
+    };
+    eastl::vector<DedicatedBuffer> m_dedicatedBuffers;
+    uint64_t m_nDedicatedSize = 0;
+
+    uint64_t m_nHighWaterMark = 0;
+    uint64_t m_nDedicatedHighWaterMark = 0;
+};
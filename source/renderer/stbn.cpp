@@ -1,8 +1,21 @@
 #include "stbn.h"
 #include "renderer.h"
 #include "texture_loader.h"
+#include "precomputed_data_cache.h"
 #include "utils/fmt.h"
-#include "utils/memory.h"
+#include "utils/log.h"
+#include "utils/parallel_for.h"
+#include "EASTL/atomic.h"
+#include "sokol/sokol_time.h"
+
+#define STBN_SIZE 128
+#define STBN_SLICES 64
+#define STBN_ARCHIVE_VERSION 1
+
+// the archive stores the 3 texture arrays tightly packed in upload layout : scalar(R8), vec2(RG8), vec3(RGBA8)
+static const uint32_t scalar_size = STBN_SIZE * STBN_SIZE * STBN_SLICES * 1;
+static const uint32_t vec2_size = STBN_SIZE * STBN_SIZE * STBN_SLICES * 2;
+static const uint32_t vec3_size = STBN_SIZE * STBN_SIZE * STBN_SLICES * 4;
 
 STBN::STBN(Renderer* renderer)
 {
@@ -11,76 +24,100 @@ STBN::STBN(Renderer* renderer)
 
 void STBN::Load(const eastl::string& path)
 {
-    uint8_t* data = nullptr;
+    uint64_t ticks = stm_now();
 
-    // scalar
-    for (uint32_t i = 0; i < 64; ++i)
-    {
-        TextureLoader loader;
-        loader.Load(fmt::format("{}stbn_scalar_2Dx1Dx1D_128x128x64x1_{}.png", path.c_str(), i).c_str(), false);
+    PrecomputedDataCache* cache = m_renderer->GetPrecomputedDataCache();
+    PrecomputedDataCache::Entry archive;
+    const uint64_t hash = (uint64_t)STBN_ARCHIVE_VERSION << 32 | STBN_SIZE << 16 | STBN_SLICES;
 
-        if (i == 0)
-        {
-            data = (uint8_t*)RE_ALLOC(loader.GetDataSize() * 64);
-        }
+    if (cache->Load("stbn", hash, archive) && archive.GetSize() == scalar_size + vec2_size + vec3_size)
+    {
+        const uint8_t* scalar = (const uint8_t*)archive.GetData();
+        CreateTextures(scalar, scalar + scalar_size, scalar + scalar_size + vec2_size);
 
-        memcpy(data + loader.GetDataSize() * i, loader.GetData(), loader.GetDataSize());
+        RE_INFO("[STBN] loaded from the archive in {:.2f} ms", stm_ms(stm_since(ticks)));
+        return;
     }
 
-    m_scalarTexture.reset(m_renderer->CreateTexture2DArray(128, 128, 1, 64, GfxFormat::R8UNORM, 0, "STBN scalar"));
-    if (m_scalarTexture)
-    {
-        m_renderer->UploadTexture(m_scalarTexture->GetTexture(), data);
-    }
+    eastl::vector<uint8_t> data(scalar_size + vec2_size + vec3_size);
+    uint8_t* scalar = data.data();
+    uint8_t* vec2 = scalar + scalar_size;
+    uint8_t* vec3 = vec2 + vec2_size;
+
+    bool success = LoadSlices(path + "stbn_scalar_2Dx1Dx1D_128x128x64x1_", 1, scalar) &&
+        LoadSlices(path + "stbn_vec2_2Dx1D_128x128x64_", 2, vec2) &&
+        LoadSlices(path + "stbn_vec3_2Dx1D_128x128x64_", 4, vec3);
 
-    // vec3
-    for (uint32_t i = 0; i < 64; ++i)
+    if (!success)
     {
-        TextureLoader loader;
-        loader.Load(fmt::format("{}stbn_vec3_2Dx1D_128x128x64_{}.png", path.c_str(), i).c_str(), false);
+        RE_ERROR("[STBN] failed to load {}", path);
+    }
 
-        if (i == 0)
-        {
-            data = (uint8_t*)RE_REALLOC(data, loader.GetDataSize() * 64);
-        }
+    CreateTextures(scalar, vec2, vec3);
 
-        memcpy(data + loader.GetDataSize() * i, loader.GetData(), loader.GetDataSize());
-    }
+    RE_INFO("[STBN] decoded {} in {:.2f} ms", path, stm_ms(stm_since(ticks)));
 
-    m_vec3Texture.reset(m_renderer->CreateTexture2DArray(128, 128, 1, 64, GfxFormat::RGBA8UNORM, 0, "STBN vec3"));
-    if (m_vec3Texture)
+    if (success)
     {
-        m_renderer->UploadTexture(m_vec3Texture->GetTexture(), data);
+        cache->Save("stbn", hash, data.data(), (uint32_t)data.size());
     }
+}
 
-    // vec2
-    for (uint32_t i = 0; i < 64; ++i)
-    {
-        TextureLoader loader;
-        loader.Load(fmt::format("{}stbn_vec2_2Dx1D_128x128x64_{}.png", path.c_str(), i).c_str(), false);
-
-        uint32_t sliceSize = loader.GetDataSize() / 2;
+bool STBN::LoadSlices(const eastl::string& file_prefix, uint32_t components, uint8_t* dst)
+{
+    const uint32_t slice_size = STBN_SIZE * STBN_SIZE * components;
+    eastl::atomic<bool> success{ true };
 
-        if (i == 0)
+    ParallelFor(STBN_SLICES, [&](uint32_t i)
         {
-            data = (uint8_t*)RE_REALLOC(data, sliceSize * 64);
-        }
-
-        byte4* srcData = (byte4*)loader.GetData();
+            TextureLoader loader;
+            if (!loader.Load(fmt::format("{}{}.png", file_prefix, i).c_str(), false) ||
+                loader.GetWidth() != STBN_SIZE || loader.GetHeight() != STBN_SIZE)
+            {
+                success = false;
+                return;
+            }
+
+            const uint8_t* src = (const uint8_t*)loader.GetData();
+            uint32_t src_components = GetFormatComponentNum(loader.GetFormat());
+            uint8_t* slice = dst + slice_size * i;
+
+            if (src_components == components)
+            {
+                memcpy(slice, src, slice_size);
+                return;
+            }
+
+            // e.g. rgba8 -> rg8
+            for (uint32_t j = 0; j < STBN_SIZE * STBN_SIZE; ++j)
+            {
+                for (uint32_t c = 0; c < components; ++c)
+                {
+                    slice[j * components + c] = c < src_components ? src[j * src_components + c] : 0;
+                }
+            }
+        });
+
+    return success;
+}
 
-        // rgba8 -> rg8
-        for (uint32_t j = 0; j < loader.GetWidth() * loader.GetHeight(); ++j)
-        {
-            data[sliceSize * i + j * 2 + 0] = srcData[j].x;
-            data[sliceSize * i + j * 2 + 1] = srcData[j].y;
-        }
+void STBN::CreateTextures(const uint8_t* scalar, const uint8_t* vec2, const uint8_t* vec3)
+{
+    m_scalarTexture.reset(m_renderer->CreateTexture2DArray(STBN_SIZE, STBN_SIZE, 1, STBN_SLICES, GfxFormat::R8UNORM, 0, "STBN scalar"));
+    if (m_scalarTexture)
+    {
+        m_renderer->UploadTexture(m_scalarTexture->GetTexture(), scalar);
     }
 
-    m_vec2Texture.reset(m_renderer->CreateTexture2DArray(128, 128, 1, 64, GfxFormat::RG8UNORM, 0, "STBN vec2"));
+    m_vec2Texture.reset(m_renderer->CreateTexture2DArray(STBN_SIZE, STBN_SIZE, 1, STBN_SLICES, GfxFormat::RG8UNORM, 0, "STBN vec2"));
     if (m_vec2Texture)
     {
-        m_renderer->UploadTexture(m_vec2Texture->GetTexture(), data);
+        m_renderer->UploadTexture(m_vec2Texture->GetTexture(), vec2);
     }
 
-    RE_FREE(data);
+    m_vec3Texture.reset(m_renderer->CreateTexture2DArray(STBN_SIZE, STBN_SIZE, 1, STBN_SLICES, GfxFormat::RGBA8UNORM, 0, "STBN vec3"));
+    if (m_vec3Texture)
+    {
+        m_renderer->UploadTexture(m_vec3Texture->GetTexture(), vec3);
+    }
 }
@@ -12,6 +12,10 @@ public:
     IGfxDescriptor* GetVec2TextureSRV() const { return m_vec2Texture->GetSRV(); }
     IGfxDescriptor* GetVec3TextureSRV() const { return m_vec3Texture->GetSRV(); }
 
+private:
+    bool LoadSlices(const eastl::string& file_prefix, uint32_t components, uint8_t* dst);
+    void CreateTextures(const uint8_t* scalar, const uint8_t* vec2, const uint8_t* vec3);
+
 private:
     Renderer* m_renderer = nullptr;
     eastl::unique_ptr<Texture2DArray> m_scalarTexture;
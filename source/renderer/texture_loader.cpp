@@ -1,9 +1,9 @@
 #include "texture_loader.h"
 #include "utils/assert.h"
 #include "utils/log.h"
+#include "utils/memory.h"
 #include "stb/stb_image.h"
 #include "ddspp/ddspp.h"
-#include <fstream>
 
 #define STB_IMAGE_RESIZE_IMPLEMENTATION
 #include "stb//stb_image_resize.h"
@@ -159,24 +159,15 @@ TextureLoader::~TextureLoader()
 
 bool TextureLoader::Load(const eastl::string& file, bool srgb)
 {
-    std::ifstream is;
-    is.open(file.c_str(), std::ios::binary);
-    if (is.fail())
+    MemoryTagScope memoryTag(MemoryTag::Loader);
+
+    //the file is mapped instead of read, so DDS data goes straight from the page cache into the staging buffer
+    if (!m_file.Open(file))
     {
         RE_DEBUG("[TextureLoader] failed to load {}", file);
         return false;
     }
 
-    is.seekg(0, std::ios::end);
-    uint32_t length = (uint32_t)is.tellg();
-    is.seekg(0, std::ios::beg);
-
-    m_fileData.resize(length);
-    char* buffer = (char*)m_fileData.data();
-
-    is.read(buffer, length);
-    is.close();
-
     if (file.find(".dds") != eastl::string::npos)
     {
         return LoadDDS(srgb);
@@ -189,7 +180,7 @@ bool TextureLoader::Load(const eastl::string& file, bool srgb)
 
 bool TextureLoader::LoadDDS(bool srgb)
 {
-    uint8_t* data = m_fileData.data();
+    uint8_t* data = (uint8_t*)m_file.GetData();
 
     ddspp::Descriptor desc;
     ddspp::Result result = ddspp::decode_header((unsigned char*)data, desc);
@@ -207,23 +198,26 @@ bool TextureLoader::LoadDDS(bool srgb)
     m_format = get_texture_format(desc.format, srgb);
 
     m_pTextureData = data + desc.headerSize;
-    m_textureSize = (uint32_t)m_fileData.size() - desc.headerSize;
+    m_textureSize = (uint32_t)m_file.GetSize() - desc.headerSize;
 
     return true;
 }
 
 bool TextureLoader::LoadSTB(bool srgb)
 {
+    const stbi_uc* data = (const stbi_uc*)m_file.GetData();
+    int size = (int)m_file.GetSize();
+
     int x, y, comp;
-    stbi_info_from_memory((stbi_uc*)m_fileData.data(), (int)m_fileData.size(), &x, &y, &comp);
+    stbi_info_from_memory(data, size, &x, &y, &comp);
 
-    bool isHDR = stbi_is_hdr_from_memory((stbi_uc*)m_fileData.data(), (int)m_fileData.size());
-    bool is16Bits = stbi_is_16_bit_from_memory((stbi_uc*)m_fileData.data(), (int)m_fileData.size());
+    bool isHDR = stbi_is_hdr_from_memory(data, size);
+    bool is16Bits = stbi_is_16_bit_from_memory(data, size);
     int desired_channels = comp == 3 ? 4 : 0;
 
     if (isHDR)
     {
-        m_pDecompressedData = stbi_loadf_from_memory((stbi_uc*)m_fileData.data(), (int)m_fileData.size(), &x, &y, &comp, desired_channels);
+        m_pDecompressedData = stbi_loadf_from_memory(data, size, &x, &y, &comp, desired_channels);
 
         switch (comp)
         {
@@ -244,7 +238,7 @@ bool TextureLoader::LoadSTB(bool srgb)
     }
     else if (is16Bits)
     {
-        m_pDecompressedData = stbi_load_16_from_memory((stbi_uc*)m_fileData.data(), (int)m_fileData.size(), &x, &y, &comp, desired_channels);
+        m_pDecompressedData = stbi_load_16_from_memory(data, size, &x, &y, &comp, desired_channels);
 
         switch (comp)
         {
@@ -265,7 +259,7 @@ bool TextureLoader::LoadSTB(bool srgb)
     }
     else
     {
-        m_pDecompressedData = stbi_load_from_memory((stbi_uc*)m_fileData.data(), (int)m_fileData.size(), &x, &y, &comp, desired_channels);
+        m_pDecompressedData = stbi_load_from_memory(data, size, &x, &y, &comp, desired_channels);
 
         switch (comp)
         {
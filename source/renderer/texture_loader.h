@@ -1,6 +1,7 @@
 #pragma once
 
 #include "gfx/gfx.h"
+#include "utils/memory_mapped_file.h"
 
 class TextureLoader
 {
@@ -39,5 +40,5 @@ private:
     void* m_pDecompressedData = nullptr;
     uint32_t m_textureSize = 0;
 
-    eastl::vector<uint8_t> m_fileData;
+    MemoryMappedFile m_file;
 };
\ No newline at end of file
@@ -16,8 +16,12 @@ set(D3D12_FILES
     ${SOURCE_ROOT}/gfx/d3d12/d3d12_header.h
     ${SOURCE_ROOT}/gfx/d3d12/d3d12_heap.cpp
     ${SOURCE_ROOT}/gfx/d3d12/d3d12_heap.h
+    ${SOURCE_ROOT}/gfx/d3d12/d3d12_pipeline_library.cpp
+    ${SOURCE_ROOT}/gfx/d3d12/d3d12_pipeline_library.h
     ${SOURCE_ROOT}/gfx/d3d12/d3d12_pipeline_state.cpp
     ${SOURCE_ROOT}/gfx/d3d12/d3d12_pipeline_state.h
+    ${SOURCE_ROOT}/gfx/d3d12/d3d12_query_heap.cpp
+    ${SOURCE_ROOT}/gfx/d3d12/d3d12_query_heap.h
     ${SOURCE_ROOT}/gfx/d3d12/d3d12_rt_blas.cpp
     ${SOURCE_ROOT}/gfx/d3d12/d3d12_rt_blas.h
     ${SOURCE_ROOT}/gfx/d3d12/d3d12_rt_tlas.cpp
@@ -88,6 +92,8 @@ set(ENGINE_SRC_FILES
     ${SOURCE_ROOT}/gfx/mock/mock_heap.h
     ${SOURCE_ROOT}/gfx/mock/mock_pipeline_state.cpp
     ${SOURCE_ROOT}/gfx/mock/mock_pipeline_state.h
+    ${SOURCE_ROOT}/gfx/mock/mock_query_heap.cpp
+    ${SOURCE_ROOT}/gfx/mock/mock_query_heap.h
     ${SOURCE_ROOT}/gfx/mock/mock_rt_blas.cpp
     ${SOURCE_ROOT}/gfx/mock/mock_rt_blas.h
     ${SOURCE_ROOT}/gfx/mock/mock_rt_tlas.cpp
@@ -117,8 +123,12 @@ set(ENGINE_SRC_FILES
     ${SOURCE_ROOT}/gfx/vulkan/vulkan_header.h
     ${SOURCE_ROOT}/gfx/vulkan/vulkan_heap.cpp
     ${SOURCE_ROOT}/gfx/vulkan/vulkan_heap.h
+    ${SOURCE_ROOT}/gfx/vulkan/vulkan_pipeline_cache.cpp
+    ${SOURCE_ROOT}/gfx/vulkan/vulkan_pipeline_cache.h
     ${SOURCE_ROOT}/gfx/vulkan/vulkan_pipeline_state.cpp
     ${SOURCE_ROOT}/gfx/vulkan/vulkan_pipeline_state.h
+    ${SOURCE_ROOT}/gfx/vulkan/vulkan_query_heap.cpp
+    ${SOURCE_ROOT}/gfx/vulkan/vulkan_query_heap.h
     ${SOURCE_ROOT}/gfx/vulkan/vulkan_rt_blas.cpp
     ${SOURCE_ROOT}/gfx/vulkan/vulkan_rt_blas.h
     ${SOURCE_ROOT}/gfx/vulkan/vulkan_rt_tlas.cpp
@@ -132,17 +142,26 @@ set(ENGINE_SRC_FILES
     ${SOURCE_ROOT}/gfx/gfx.cpp
     ${SOURCE_ROOT}/gfx/gfx.h
     ${SOURCE_ROOT}/gfx/gfx_buffer.h
+    ${SOURCE_ROOT}/gfx/gfx_command_capture.cpp
+    ${SOURCE_ROOT}/gfx/gfx_command_capture.h
     ${SOURCE_ROOT}/gfx/gfx_command_list.h
+    ${SOURCE_ROOT}/gfx/gfx_command_replay.cpp
+    ${SOURCE_ROOT}/gfx/gfx_command_replay.h
+    ${SOURCE_ROOT}/gfx/gfx_constant_buffer_allocator.cpp
+    ${SOURCE_ROOT}/gfx/gfx_constant_buffer_allocator.h
     ${SOURCE_ROOT}/gfx/gfx_defines.h
     ${SOURCE_ROOT}/gfx/gfx_descriptor.h
+    ${SOURCE_ROOT}/gfx/gfx_device.cpp
     ${SOURCE_ROOT}/gfx/gfx_device.h
     ${SOURCE_ROOT}/gfx/gfx_fence.h
     ${SOURCE_ROOT}/gfx/gfx_heap.h
     ${SOURCE_ROOT}/gfx/gfx_pipeline_state.h
+    ${SOURCE_ROOT}/gfx/gfx_query_heap.h
     ${SOURCE_ROOT}/gfx/gfx_resource.h
     ${SOURCE_ROOT}/gfx/gfx_rt_blas.h
     ${SOURCE_ROOT}/gfx/gfx_rt_tlas.h
     ${SOURCE_ROOT}/gfx/gfx_shader.h
+    ${SOURCE_ROOT}/gfx/gfx_state_cache.h
     ${SOURCE_ROOT}/gfx/gfx_swapchain.h
     ${SOURCE_ROOT}/gfx/gfx_texture.h
     ${SOURCE_ROOT}/physics/jolt/jolt_body_activation_listener.cpp
@@ -170,8 +189,11 @@ set(ENGINE_SRC_FILES
     ${SOURCE_ROOT}/physics/physics.h
     ${SOURCE_ROOT}/physics/physics_constraint.h
     ${SOURCE_ROOT}/physics/physics_defines.h
+    ${SOURCE_ROOT}/physics/physics_query_benchmark.cpp
+    ${SOURCE_ROOT}/physics/physics_query_benchmark.h
     ${SOURCE_ROOT}/physics/physics_rigid_body.h
     ${SOURCE_ROOT}/physics/physics_shape.h
+    ${SOURCE_ROOT}/physics/physics_step_clock.h
     ${SOURCE_ROOT}/physics/physics_system.h
     ${SOURCE_ROOT}/renderer/lighting/clustered_light_lists.cpp
     ${SOURCE_ROOT}/renderer/lighting/clustered_light_lists.h
@@ -249,6 +271,8 @@ set(ENGINE_SRC_FILES
     ${SOURCE_ROOT}/renderer/resource/typed_buffer.h
     ${SOURCE_ROOT}/renderer/base_pass.cpp
     ${SOURCE_ROOT}/renderer/base_pass.h
+    ${SOURCE_ROOT}/renderer/blas_refit_scheduler.cpp
+    ${SOURCE_ROOT}/renderer/blas_refit_scheduler.h
     ${SOURCE_ROOT}/renderer/clear_uav.cpp
     ${SOURCE_ROOT}/renderer/clear_uav.h
     ${SOURCE_ROOT}/renderer/directed_acyclic_graph.cpp
@@ -267,10 +291,14 @@ set(ENGINE_SRC_FILES
     ${SOURCE_ROOT}/renderer/marschner_hair_lut.h
     ${SOURCE_ROOT}/renderer/oidn.cpp
     ${SOURCE_ROOT}/renderer/oidn.h
+    ${SOURCE_ROOT}/renderer/pass_profiler.cpp
+    ${SOURCE_ROOT}/renderer/pass_profiler.h
     ${SOURCE_ROOT}/renderer/path_tracer.cpp
     ${SOURCE_ROOT}/renderer/path_tracer.h
     ${SOURCE_ROOT}/renderer/pipeline_cache.cpp
     ${SOURCE_ROOT}/renderer/pipeline_cache.h
+    ${SOURCE_ROOT}/renderer/precomputed_data_cache.cpp
+    ${SOURCE_ROOT}/renderer/precomputed_data_cache.h
     ${SOURCE_ROOT}/renderer/render_batch.h
     ${SOURCE_ROOT}/renderer/render_graph.cpp
     ${SOURCE_ROOT}/renderer/render_graph.h
@@ -306,12 +334,15 @@ set(ENGINE_SRC_FILES
     ${SOURCE_ROOT}/utils/log.h
     ${SOURCE_ROOT}/utils/math.h
     ${SOURCE_ROOT}/utils/memory.h
+    ${SOURCE_ROOT}/utils/memory_mapped_file.h
     ${SOURCE_ROOT}/utils/parallel_for.h
     ${SOURCE_ROOT}/utils/profiler.h
     ${SOURCE_ROOT}/utils/string.h
     ${SOURCE_ROOT}/utils/system.h
     ${SOURCE_ROOT}/world/animation.cpp
     ${SOURCE_ROOT}/world/animation.h
+    ${SOURCE_ROOT}/world/animation_lod.cpp
+    ${SOURCE_ROOT}/world/animation_lod.h
     ${SOURCE_ROOT}/world/billboard_sprite.cpp
     ${SOURCE_ROOT}/world/billboard_sprite.h
     ${SOURCE_ROOT}/world/camera.cpp
@@ -324,6 +355,8 @@ set(ENGINE_SRC_FILES
     ${SOURCE_ROOT}/world/light.h
     ${SOURCE_ROOT}/world/mesh_material.cpp
     ${SOURCE_ROOT}/world/mesh_material.h
+    ${SOURCE_ROOT}/world/node_hierarchy.cpp
+    ${SOURCE_ROOT}/world/node_hierarchy.h
     ${SOURCE_ROOT}/world/point_light.cpp
     ${SOURCE_ROOT}/world/point_light.h
     ${SOURCE_ROOT}/world/rect_light.cpp
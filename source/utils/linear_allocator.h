@@ -3,6 +3,7 @@
 #include "memory.h"
 #include "assert.h"
 #include "math.h"
+#include "EASTL/vector.h"
 
 class LinearAllocator
 {
@@ -15,21 +16,46 @@ public:
 
     ~LinearAllocator()
     {
+        Reset();
         RE_FREE(m_pMemory);
     }
 
     void* Alloc(uint32_t size, uint32_t alignment = 1)
     {
         uint32_t address = RoundUpPow2(m_nPointerOffset, alignment);
-        RE_ASSERT(address + size <= m_nMemorySize);
+        if (address + size > m_nMemorySize)
+        {
+            Grow(size);
+            address = 0;
+        }
 
         m_nPointerOffset = address + size;
 
         return (char*)m_pMemory + address;
     }
 
+    //the blocks filled since the last reset are freed, the current one is at least as large as all of them together
     void Reset()
     {
+        for (size_t i = 0; i < m_fullBlocks.size(); ++i)
+        {
+            RE_FREE(m_fullBlocks[i]);
+        }
+        m_fullBlocks.clear();
+
+        m_nPointerOffset = 0;
+    }
+
+private:
+    //the previous allocations stay valid until the next reset, so a full block is kept and a larger one is started
+    void Grow(uint32_t min_size)
+    {
+        m_fullBlocks.push_back(m_pMemory);
+
+        m_nMemorySize = max(m_nMemorySize * 2, min_size);
+        m_pMemory = RE_ALLOC(m_nMemorySize);
+        RE_ASSERT(m_pMemory != nullptr);
+
         m_nPointerOffset = 0;
     }
 
@@ -37,4 +63,5 @@ private:
     void* m_pMemory = nullptr;
     uint32_t m_nMemorySize = 0;
     uint32_t m_nPointerOffset = 0;
+    eastl::vector<void*> m_fullBlocks;
 };
\ No newline at end of file
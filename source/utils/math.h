@@ -59,6 +59,59 @@ inline float4x4 inverse(const float4x4& m)
 #endif
 }
 
+//the first 3 rows of an affine 4x4 matrix, the last row is implicitly (0, 0, 0, 1)
+struct affine3x4
+{
+    hlslpp::float4 rows[3];
+};
+
+inline affine3x4 to_affine3x4(const float4x4& m)
+{
+    affine3x4 a;
+    for (int i = 0; i < 3; ++i)
+    {
+        a.rows[i] = hlslpp::float4(m[0][i], m[1][i], m[2][i], m[3][i]);
+    }
+    return a;
+}
+
+inline float4x4 to_float4x4(const affine3x4& a)
+{
+    float4x4 m;
+    for (int i = 0; i < 4; ++i)
+    {
+        m[i] = float4(a.rows[0].f32[i], a.rows[1].f32[i], a.rows[2].f32[i], i == 3 ? 1.0f : 0.0f);
+    }
+    return m;
+}
+
+//same as mul(translation_matrix(t), mul(rotation_matrix(r), scaling_matrix(s)))
+inline affine3x4 affine_transform(const float3& t, const float4& r, const float3& s)
+{
+    float3 x = qxdir(r) * s.x;
+    float3 y = qydir(r) * s.y;
+    float3 z = qzdir(r) * s.z;
+
+    affine3x4 a;
+    a.rows[0] = hlslpp::float4(x.x, y.x, z.x, t.x);
+    a.rows[1] = hlslpp::float4(x.y, y.y, z.y, t.y);
+    a.rows[2] = hlslpp::float4(x.z, y.z, z.z, t.z);
+    return a;
+}
+
+inline affine3x4 mul(const affine3x4& a, const affine3x4& b)
+{
+    const hlslpp::float4 w(0.0f, 0.0f, 0.0f, 1.0f);
+
+    affine3x4 result;
+    for (int i = 0; i < 3; ++i)
+    {
+        const hlslpp::float4& row = a.rows[i];
+        result.rows[i] = hlslpp::float4(row.xxxx) * b.rows[0] + hlslpp::float4(row.yyyy) * b.rows[1] + hlslpp::float4(row.zzzz) * b.rows[2] + row * w;
+    }
+    return result;
+}
+
 template<class T>
 inline T radians(T degree)
 {
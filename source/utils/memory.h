@@ -1,23 +1,203 @@
 #pragma once
 
 #include "rpmalloc/rpmalloc.h"
+#include <atomic>
+#include <string.h>
+
+//allocations made through RE_ALLOC are attributed to the tag of the innermost MemoryTagScope on the calling thread
+enum class MemoryTag : uint32_t
+{
+    Default, //EASTL containers and everything outside of a scope
+    RenderGraph,
+    World,
+    Physics,
+    Loader,
+    Editor,
+    Count,
+};
+
+inline const char* GetMemoryTagName(MemoryTag tag)
+{
+    static const char* names[] = { "Default", "RenderGraph", "World", "Physics", "Loader", "Editor" };
+    static_assert(sizeof(names) / sizeof(names[0]) == (size_t)MemoryTag::Count);
+    return names[(size_t)tag];
+}
+
+//padded to a cache line, so threads allocating with different tags don't contend
+struct alignas(64) MemoryTagStats
+{
+    std::atomic<int64_t> liveBytes { 0 };
+    std::atomic<int64_t> peakBytes { 0 };
+    std::atomic<uint64_t> allocCount { 0 };
+    std::atomic<uint64_t> freeCount { 0 };
+
+    //only accessed by the main thread, see UpdateMemoryFrameStats
+    uint64_t lastAllocCount = 0;
+    uint64_t lastFreeCount = 0;
+    uint32_t frameAllocCount = 0;
+    uint32_t frameFreeCount = 0;
+};
+
+inline MemoryTagStats g_memoryTagStats[(size_t)MemoryTag::Count];
+inline thread_local MemoryTag g_currentMemoryTag = MemoryTag::Default;
+
+class MemoryTagScope
+{
+public:
+    MemoryTagScope(MemoryTag tag) : m_previousTag(g_currentMemoryTag) { g_currentMemoryTag = tag; }
+    ~MemoryTagScope() { g_currentMemoryTag = m_previousTag; }
+
+    MemoryTagScope(const MemoryTagScope&) = delete;
+    MemoryTagScope& operator=(const MemoryTagScope&) = delete;
+
+private:
+    MemoryTag m_previousTag;
+};
+
+inline const MemoryTagStats& GetMemoryTagStats(MemoryTag tag)
+{
+    return g_memoryTagStats[(size_t)tag];
+}
+
+//called once per frame, computes the allocation counts of the last frame
+inline void UpdateMemoryFrameStats()
+{
+    for (size_t i = 0; i < (size_t)MemoryTag::Count; ++i)
+    {
+        MemoryTagStats& stats = g_memoryTagStats[i];
+        uint64_t allocCount = stats.allocCount.load(std::memory_order_relaxed);
+        uint64_t freeCount = stats.freeCount.load(std::memory_order_relaxed);
+
+        stats.frameAllocCount = (uint32_t)(allocCount - stats.lastAllocCount);
+        stats.frameFreeCount = (uint32_t)(freeCount - stats.lastFreeCount);
+        stats.lastAllocCount = allocCount;
+        stats.lastFreeCount = freeCount;
+    }
+}
+
+namespace memory_detail
+{
+    //stored right before every pointer returned by RE_ALLOC
+    struct AllocationHeader
+    {
+        uint64_t size;
+        uint32_t offset; //from the rpmalloc block to the returned pointer
+        MemoryTag tag;
+    };
+    static_assert(sizeof(AllocationHeader) == 16);
+
+    static const size_t DEFAULT_ALIGNMENT = 16; //rpmalloc's natural alignment
+
+    inline AllocationHeader* GetHeader(void* ptr)
+    {
+        return (AllocationHeader*)ptr - 1;
+    }
+
+    inline void OnAlloc(MemoryTag tag, size_t size)
+    {
+        MemoryTagStats& stats = g_memoryTagStats[(size_t)tag];
+        int64_t live = stats.liveBytes.fetch_add((int64_t)size, std::memory_order_relaxed) + (int64_t)size;
+        stats.allocCount.fetch_add(1, std::memory_order_relaxed);
+
+        int64_t peak = stats.peakBytes.load(std::memory_order_relaxed);
+        while (live > peak && !stats.peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    inline void OnFree(MemoryTag tag, size_t size)
+    {
+        MemoryTagStats& stats = g_memoryTagStats[(size_t)tag];
+        stats.liveBytes.fetch_sub((int64_t)size, std::memory_order_relaxed);
+        stats.freeCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    inline void* Alloc(size_t size, size_t alignment, MemoryTag tag)
+    {
+        size_t offset = alignment > DEFAULT_ALIGNMENT ? alignment : DEFAULT_ALIGNMENT;
+        void* block = offset > DEFAULT_ALIGNMENT ? rpaligned_alloc(offset, size + offset) : rpmalloc(size + offset);
+        if (block == nullptr)
+        {
+            return nullptr;
+        }
+
+        void* ptr = (char*)block + offset;
+        AllocationHeader* header = GetHeader(ptr);
+        header->size = size;
+        header->offset = (uint32_t)offset;
+        header->tag = tag;
+
+        OnAlloc(tag, size);
+        return ptr;
+    }
+}
+
+static inline void* RE_ALLOC(size_t size, MemoryTag tag)
+{
+    return memory_detail::Alloc(size, memory_detail::DEFAULT_ALIGNMENT, tag);
+}
+
+static inline void* RE_ALLOC(size_t size, size_t alignment, MemoryTag tag)
+{
+    return memory_detail::Alloc(size, alignment, tag);
+}
 
 static inline void* RE_ALLOC(size_t size)
 {
-    return rpmalloc(size);
+    return memory_detail::Alloc(size, memory_detail::DEFAULT_ALIGNMENT, g_currentMemoryTag);
 }
 
 static inline void* RE_ALLOC(size_t size, size_t alignment)
 {
-    return rpaligned_alloc(alignment, size);
+    return memory_detail::Alloc(size, alignment, g_currentMemoryTag);
 }
 
-static inline void* RE_REALLOC(void* ptr, size_t size)
+static inline void RE_FREE(void* ptr)
 {
-    return rprealloc(ptr, size);
+    if (ptr == nullptr)
+    {
+        return;
+    }
+
+    memory_detail::AllocationHeader* header = memory_detail::GetHeader(ptr);
+    memory_detail::OnFree(header->tag, header->size);
+    rpfree((char*)ptr - header->offset);
 }
 
-static inline void RE_FREE(void* ptr)
+//keeps the tag of the original allocation
+static inline void* RE_REALLOC(void* ptr, size_t size)
 {
-    rpfree(ptr);
+    if (ptr == nullptr)
+    {
+        return RE_ALLOC(size);
+    }
+
+    memory_detail::AllocationHeader* header = memory_detail::GetHeader(ptr);
+    MemoryTag tag = header->tag;
+    size_t old_size = header->size;
+
+    if (header->offset == memory_detail::DEFAULT_ALIGNMENT)
+    {
+        void* block = rprealloc((char*)ptr - header->offset, size + memory_detail::DEFAULT_ALIGNMENT);
+        if (block == nullptr)
+        {
+            return nullptr;
+        }
+
+        void* new_ptr = (char*)block + memory_detail::DEFAULT_ALIGNMENT;
+        memory_detail::GetHeader(new_ptr)->size = size;
+
+        memory_detail::OnFree(tag, old_size);
+        memory_detail::OnAlloc(tag, size);
+        return new_ptr;
+    }
+
+    //over-aligned blocks can't be moved by rprealloc without breaking the alignment
+    void* new_ptr = memory_detail::Alloc(size, header->offset, tag);
+    if (new_ptr)
+    {
+        memcpy(new_ptr, ptr, old_size < size ? old_size : size);
+        RE_FREE(ptr);
+    }
+    return new_ptr;
 }
\ No newline at end of file
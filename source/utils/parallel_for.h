@@ -16,7 +16,7 @@ inline void ParallelFor(uint32_t begin, uint32_t end, F fun)
             }
         });
     ts->AddTaskSetToPipe(&taskSet);
-    ts->WaitforTask(&taskSet);
+    ts->WaitforTask(&taskSet, taskSet.m_Priority); //doesn't pick up lower priority background work, e.g. async physics steps
 }
 
 template <typename F>
@@ -1,82 +1,420 @@
 #include "animation.h"
-#include "skeletal_mesh.h"
+#include "utils/log.h"
+#include "sokol/sokol_time.h"
+#include "EASTL/algorithm.h"
+
+static const float SQRT2 = 1.41421356f;
+static const uint32_t MAX_LINEAR_SEEK_STEPS = 4;
+static volatile float s_benchmarkSink;
+
+AnimationKey EncodeRotation(float4 q)
+{
+    q = normalize(q);
+
+    uint32_t largest = 0;
+    for (uint32_t i = 1; i < 4; ++i)
+    {
+        if (abs(q[i]) > abs(q[largest]))
+        {
+            largest = i;
+        }
+    }
+
+    //q and -q are the same rotation, so the largest component can always be positive
+    if (q[largest] < 0.0f)
+    {
+        q = -q;
+    }
+
+    //the other components are in [-1/sqrt(2), 1/sqrt(2)]
+    AnimationKey key;
+    uint32_t j = 0;
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        if (i != largest)
+        {
+            float v = clamp(q[i] * SQRT2 * 0.5f + 0.5f, 0.0f, 1.0f);
+            key.value[j++] = (uint16_t)(v * 32767.0f + 0.5f);
+        }
+    }
+
+    key.value[0] |= (uint16_t)((largest & 1) << 15);
+    key.value[1] |= (uint16_t)((largest >> 1) << 15);
+    key.value[2] &= 0x7fff;
+    return key;
+}
+
+float4 DecodeRotation(const AnimationKey& key)
+{
+    uint32_t largest = (key.value[0] >> 15) | ((key.value[1] >> 15) << 1);
+
+    float c[3];
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        c[i] = ((key.value[i] & 0x7fff) / 32767.0f * 2.0f - 1.0f) / SQRT2;
+    }
+
+    float w = sqrt(max(0.0f, 1.0f - c[0] * c[0] - c[1] * c[1] - c[2] * c[2]));
+
+    float4 q;
+    uint32_t j = 0;
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        q[i] = i == largest ? w : c[j++];
+    }
+    return q;
+}
+
+static AnimationKey EncodeRange(const float3& value, const float3& range_min, const float3& range_extent)
+{
+    AnimationKey key;
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        float v = range_extent[i] > 0.0f ? clamp((value[i] - range_min[i]) / range_extent[i], 0.0f, 1.0f) : 0.0f;
+        key.value[i] = (uint16_t)(v * 65535.0f + 0.5f);
+    }
+    return key;
+}
+
+static void InterpolateLinear(hlslpp::float4* lower, const hlslpp::float4* upper, const hlslpp::float4& t)
+{
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        lower[i] = hlslpp::lerp(lower[i], upper[i], t);
+    }
+}
+
+//slerp of 4 quaternion pairs at once, the components of the 4 quaternions are in lower[0..3]/upper[0..3]
+static void InterpolateRotation(hlslpp::float4* lower, hlslpp::float4* upper, const hlslpp::float4& t)
+{
+    const hlslpp::float4 zero(0.0f);
+    const hlslpp::float4 one(1.0f);
+    const hlslpp::float4 threshold(0.9995f);
+
+    hlslpp::float4 d = lower[0] * upper[0] + lower[1] * upper[1] + lower[2] * upper[2] + lower[3] * upper[3];
+
+    //make sure we take the shortest path
+    hlslpp::float4 s = one - hlslpp::float4(2.0f) * (d < zero);
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        upper[i] = upper[i] * s;
+    }
+    d = hlslpp::abs(d);
+
+    //quaternions too close to each other are linearly interpolated, the slerp weights of those lanes are discarded
+    hlslpp::float4 near = d > threshold;
+    hlslpp::float4 theta0 = hlslpp::acos(hlslpp::min(d, threshold));
+    hlslpp::float4 theta = t * theta0;
+    hlslpp::float4 sinTheta = hlslpp::sin(theta);
+    hlslpp::float4 sinTheta0 = hlslpp::sin(theta0);
+
+    hlslpp::float4 wb = sinTheta / sinTheta0;
+    hlslpp::float4 wa = hlslpp::cos(theta) - d * wb;
+    wa = hlslpp::lerp(wa, one - t, near);
+    wb = hlslpp::lerp(wb, t, near);
+
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        lower[i] = wa * lower[i] + wb * upper[i];
+    }
+
+    hlslpp::float4 length = hlslpp::sqrt(lower[0] * lower[0] + lower[1] * lower[1] + lower[2] * lower[2] + lower[3] * lower[3]);
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        lower[i] = lower[i] / length;
+    }
+}
 
 Animation::Animation(const eastl::string& name)
 {
     m_name = name;
 }
 
-void Animation::Update(SkeletalMesh* mesh, float delta_time)
+void Animation::AddChannel(uint32_t target_node, AnimationChannelMode mode, const float* times, const float4* values, uint32_t key_count)
 {
-    m_currentAnimTime += delta_time;
-    if (m_currentAnimTime > m_timeDuration)
+    RE_ASSERT(key_count > 0);
+
+    AnimationChannel channel;
+    channel.targetNode = target_node;
+    channel.mode = mode;
+    channel.firstKey = (uint32_t)m_keys.size();
+    channel.keyCount = key_count;
+    channel.rangeMin = float3(0.0f, 0.0f, 0.0f);
+    channel.rangeExtent = float3(0.0f, 0.0f, 0.0f);
+
+    if (mode != AnimationChannelMode::Rotation)
     {
-        m_currentAnimTime = m_currentAnimTime - m_timeDuration;
+        float3 range_min = values[0].xyz();
+        float3 range_max = values[0].xyz();
+        for (uint32_t i = 1; i < key_count; ++i)
+        {
+            range_min = min(range_min, values[i].xyz());
+            range_max = max(range_max, values[i].xyz());
+        }
+
+        channel.rangeMin = range_min;
+        channel.rangeExtent = range_max - range_min;
     }
 
-    for (size_t i = 0; i < m_channels.size(); ++i)
+    for (uint32_t i = 0; i < key_count; ++i)
+    {
+        m_keyTimes.push_back(times[i]);
+        m_keys.push_back(mode == AnimationChannelMode::Rotation ? EncodeRotation(values[i]) : EncodeRange(values[i].xyz(), channel.rangeMin, channel.rangeExtent));
+    }
+
+    auto iter = eastl::upper_bound(m_channels.begin(), m_channels.end(), channel,
+        [](const AnimationChannel& a, const AnimationChannel& b) { return a.mode < b.mode; });
+    m_channels.insert(iter, channel);
+
+    m_timeDuration = max(m_timeDuration, times[key_count - 1] - times[0]);
+}
+
+void Animation::InitCursor(AnimationCursor& cursor, float time) const
+{
+    cursor.time = time;
+    cursor.keys.assign(m_channels.size(), 0);
+    cursor.values.resize(m_channels.size());
+}
+
+float4 Animation::DecodeKey(const AnimationChannel& channel, uint32_t key) const
+{
+    const AnimationKey& value = m_keys[channel.firstKey + key];
+
+    if (channel.mode == AnimationChannelMode::Rotation)
     {
-        const AnimationChannel& channel = m_channels[i];
-        UpdateChannel(mesh, channel);
+        return DecodeRotation(value);
     }
+
+    float3 v = channel.rangeMin + channel.rangeExtent * float3(value.value[0], value.value[1], value.value[2]) / 65535.0f;
+    return float4(v, 0.0f);
 }
 
-void Animation::UpdateChannel(SkeletalMesh* mesh, const AnimationChannel& channel)
+void Animation::SeekChannel(AnimationCursor& cursor, uint32_t channel, float time) const
 {
-    eastl::pair<float, float4> lower_frame;
-    eastl::pair<float, float4> upper_frame;
+    const AnimationChannel& ch = m_channels[channel];
+    const float* times = m_keyTimes.data() + ch.firstKey;
+    uint32_t last = ch.keyCount - 1;
+    uint32_t& key = cursor.keys[channel];
 
-    bool found = false;
-    for (size_t frame = 0; frame < channel.keyframes.size() - 1; ++frame)
+    //forward playback only moves a few keys per frame
+    bool seek = key > 0 && time < times[key];
+    if (!seek)
     {
-        if (channel.keyframes[frame].first <= m_currentAnimTime &&
-            channel.keyframes[frame + 1].first >= m_currentAnimTime)
+        uint32_t steps = 0;
+        while (key < last && times[key + 1] <= time)
         {
-            lower_frame = channel.keyframes[frame];
-            upper_frame = channel.keyframes[frame + 1];
-            found = true;
-            break;
+            if (++steps > MAX_LINEAR_SEEK_STEPS)
+            {
+                seek = true;
+                break;
+            }
+            ++key;
         }
     }
 
-    float interpolation_value;
-    if (found)
+    if (seek)
     {
-        interpolation_value = (m_currentAnimTime - lower_frame.first) / (upper_frame.first - lower_frame.first);
+        uint32_t upper = (uint32_t)(eastl::upper_bound(times, times + ch.keyCount, time) - times);
+        key = upper > 0 ? min(upper - 1, last) : 0;
+    }
+}
+
+void Animation::Sample(AnimationCursor& cursor, float time) const
+{
+    RE_ASSERT(cursor.keys.size() == m_channels.size());
+    cursor.time = time;
+
+    uint32_t channel_count = (uint32_t)m_channels.size();
+    uint32_t first = 0;
+
+    while (first < channel_count)
+    {
+        AnimationChannelMode mode = m_channels[first].mode;
+
+        float4 lower[4];
+        float4 upper[4];
+        float alpha[4];
+
+        uint32_t lanes = 0;
+        while (lanes < 4 && first + lanes < channel_count && m_channels[first + lanes].mode == mode)
+        {
+            uint32_t channel = first + lanes;
+            const AnimationChannel& ch = m_channels[channel];
+
+            SeekChannel(cursor, channel, time);
+
+            uint32_t key = cursor.keys[channel];
+            uint32_t next = min(key + 1, ch.keyCount - 1);
+            float t0 = m_keyTimes[ch.firstKey + key];
+            float t1 = m_keyTimes[ch.firstKey + next];
+
+            lower[lanes] = DecodeKey(ch, key);
+            upper[lanes] = DecodeKey(ch, next);
+            alpha[lanes] = t1 > t0 ? clamp((time - t0) / (t1 - t0), 0.0f, 1.0f) : 0.0f;
+            ++lanes;
+        }
+
+        for (uint32_t i = lanes; i < 4; ++i)
+        {
+            lower[i] = upper[i] = lower[0];
+            alpha[i] = 0.0f;
+        }
+
+        //transposed, so each SIMD lane is one channel
+        hlslpp::float4 l[4], u[4];
+        for (uint32_t i = 0; i < 4; ++i)
+        {
+            l[i] = hlslpp::float4(lower[0][i], lower[1][i], lower[2][i], lower[3][i]);
+            u[i] = hlslpp::float4(upper[0][i], upper[1][i], upper[2][i], upper[3][i]);
+        }
+        hlslpp::float4 t(alpha[0], alpha[1], alpha[2], alpha[3]);
+
+        if (mode == AnimationChannelMode::Rotation)
+        {
+            InterpolateRotation(l, u, t);
+        }
+        else
+        {
+            InterpolateLinear(l, u, t);
+        }
+
+        for (uint32_t i = 0; i < lanes; ++i)
+        {
+            cursor.values[first + i] = float4(l[0].f32[i], l[1].f32[i], l[2].f32[i], l[3].f32[i]);
+        }
+
+        first += lanes;
+    }
+}
+
+void Animation::Advance(AnimationCursor& cursor, float delta_time) const
+{
+    float time = cursor.time + delta_time;
+    if (time > m_timeDuration)
+    {
+        time = m_timeDuration > 0.0f ? fmodf(time, m_timeDuration) : 0.0f;
+    }
+
+    Sample(cursor, time);
+}
+
+//the previous format : decoded keys, scanned linearly from the first one for every sample
+static float4 SampleLinearScan(const float* times, const float4* values, uint32_t key_count, AnimationChannelMode mode, float time)
+{
+    uint32_t lower = key_count - 1;
+    uint32_t upper = key_count - 1;
+    float alpha = 0.0f;
+
+    if (time <= times[0])
+    {
+        lower = upper = 0;
     }
     else
     {
-        lower_frame = upper_frame = channel.keyframes[0];
-        interpolation_value = 0.0f;
+        for (uint32_t i = 0; i + 1 < key_count; ++i)
+        {
+            if (times[i] <= time && times[i + 1] >= time)
+            {
+                lower = i;
+                upper = i + 1;
+                alpha = times[i + 1] > times[i] ? (time - times[i]) / (times[i + 1] - times[i]) : 0.0f;
+                break;
+            }
+        }
     }
 
-    SkeletalMeshNode* node = mesh->GetNode(channel.targetNode);
+    if (mode == AnimationChannelMode::Rotation)
+    {
+        return rotation_slerp(values[lower], values[upper], alpha);
+    }
+    return lerp(values[lower], values[upper], alpha);
+}
 
-    switch (channel.mode)
+Animation::BenchmarkResult Animation::Benchmark(uint32_t instance_count, uint32_t frame_count) const
+{
+    BenchmarkResult result;
+    if (m_channels.empty() || instance_count == 0)
     {
-    case AnimationChannelMode::Translation:
+        return result;
+    }
+
+    const float delta_time = 1.0f / 60.0f;
+
+    auto advance = [&](float time)
     {
-        float3 lower_value = float3(lower_frame.second.x, lower_frame.second.y, -lower_frame.second.z);
-        float3 upper_value = float3(upper_frame.second.x, upper_frame.second.y, -upper_frame.second.z);
+        time += delta_time;
+        return time > m_timeDuration ? (m_timeDuration > 0.0f ? fmodf(time, m_timeDuration) : 0.0f) : time;
+    };
 
-        node->translation = lerp(lower_value, upper_value, interpolation_value);
-        break;
+    eastl::vector<AnimationCursor> cursors(instance_count);
+    for (uint32_t i = 0; i < instance_count; ++i)
+    {
+        InitCursor(cursors[i], m_timeDuration * i / instance_count);
     }
-    case AnimationChannelMode::Rotation:
+
+    uint64_t begin = stm_now();
+    for (uint32_t frame = 0; frame < frame_count; ++frame)
     {
-        float4 lower_value = float4(lower_frame.second.x, lower_frame.second.y, -lower_frame.second.z, -lower_frame.second.w);
-        float4 upper_value = float4(upper_frame.second.x, upper_frame.second.y, -upper_frame.second.z, -upper_frame.second.w);
+        for (uint32_t i = 0; i < instance_count; ++i)
+        {
+            Advance(cursors[i], delta_time);
+        }
+    }
+    result.cursorTime = stm_ms(stm_since(begin));
 
-        //node->rotation = slerp(lower_value, upper_value, interpolation_value);
-        node->rotation = rotation_slerp(lower_value, upper_value, interpolation_value);
-        break;
+    eastl::vector<float4> decoded(m_keys.size());
+    for (size_t c = 0; c < m_channels.size(); ++c)
+    {
+        for (uint32_t k = 0; k < m_channels[c].keyCount; ++k)
+        {
+            decoded[m_channels[c].firstKey + k] = DecodeKey(m_channels[c], k);
+        }
     }
-    case AnimationChannelMode::Scale:
+
+    eastl::vector<float> times(instance_count);
+    for (uint32_t i = 0; i < instance_count; ++i)
     {
-        node->scale = lerp(lower_frame.second.xyz(), upper_frame.second.xyz(), interpolation_value);
-        break;
+        times[i] = m_timeDuration * i / instance_count;
     }
-    default:
-        break;
+
+    eastl::vector<float4> reference(m_channels.size());
+
+    begin = stm_now();
+    for (uint32_t frame = 0; frame < frame_count; ++frame)
+    {
+        for (uint32_t i = 0; i < instance_count; ++i)
+        {
+            times[i] = advance(times[i]);
+
+            for (size_t c = 0; c < m_channels.size(); ++c)
+            {
+                const AnimationChannel& ch = m_channels[c];
+                reference[c] = SampleLinearScan(&m_keyTimes[ch.firstKey], &decoded[ch.firstKey], ch.keyCount, ch.mode, times[i]);
+            }
+            s_benchmarkSink = reference[0].x; //keeps the loop from being optimized out
+        }
     }
-}
+    result.scanTime = stm_ms(stm_since(begin));
+
+    for (uint32_t i = 0; i < instance_count; ++i)
+    {
+        for (size_t c = 0; c < m_channels.size(); ++c)
+        {
+            const AnimationChannel& ch = m_channels[c];
+            float4 expected = SampleLinearScan(&m_keyTimes[ch.firstKey], &decoded[ch.firstKey], ch.keyCount, ch.mode, times[i]);
+            float4 actual = cursors[i].values[c];
+
+            float error = maxelem(abs(expected - actual));
+            if (ch.mode == AnimationChannelMode::Rotation)
+            {
+                error = min(error, maxelem(abs(expected + actual)));
+            }
+            result.maxError = max(result.maxError, error);
+        }
+    }
+
+    RE_INFO("[Animation] {} : {} instances x {} frames, {} channels, cursors {:.2f} ms, linear scan {:.2f} ms, max error {:.6f}, keys {} KB (was {} KB)",
+        m_name, instance_count, frame_count, m_channels.size(), result.cursorTime, result.scanTime, result.maxError,
+        (m_keys.size() * (sizeof(AnimationKey) + sizeof(float))) / 1024, (m_keys.size() * sizeof(eastl::pair<float, float4>)) / 1024);
+    return result;
+}
\ No newline at end of file
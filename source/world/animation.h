@@ -11,30 +11,73 @@ enum class AnimationChannelMode
     Scale,
 };
 
+//rotations are stored with smallest-three (15 bits per component, the largest component's index in the top bits),
+//translations and scales are quantized to 16 bits in the range of their channel
+struct AnimationKey
+{
+    uint16_t value[3];
+};
+
+//q and -q are the same rotation, the decoded quaternion's largest component is always positive
+AnimationKey EncodeRotation(float4 q);
+float4 DecodeRotation(const AnimationKey& key);
+
 struct AnimationChannel
 {
     uint32_t targetNode;
     AnimationChannelMode mode;
-    eastl::vector<eastl::pair<float, float4>> keyframes;
+    uint32_t firstKey; //into the clip's time and key arrays
+    uint32_t keyCount;
+    float3 rangeMin;
+    float3 rangeExtent;
 };
 
-class SkeletalMesh;
+//playback state of one instance, a clip can be sampled by any number of cursors
+struct AnimationCursor
+{
+    float time = 0.0f;
+    eastl::vector<uint32_t> keys; //lower key of each channel, relative to its first key
+    eastl::vector<float4> values; //sampled value of each channel
+};
 
 class Animation
 {
-    friend class GLTFLoader;
-
 public:
+    struct BenchmarkResult
+    {
+        double cursorTime = 0.0; //ms
+        double scanTime = 0.0; //ms
+        float maxError = 0.0f; //of the cursors against the linear scan, after the last frame
+    };
+
     Animation(const eastl::string& name);
 
-    void Update(SkeletalMesh* mesh, float delta_time);
+    //the values are in the engine's coordinate system
+    void AddChannel(uint32_t target_node, AnimationChannelMode mode, const float* times, const float4* values, uint32_t key_count);
+
+    float GetDuration() const { return m_timeDuration; }
+    uint32_t GetChannelCount() const { return (uint32_t)m_channels.size(); }
+    const AnimationChannel& GetChannel(uint32_t index) const { return m_channels[index]; }
+
+    void InitCursor(AnimationCursor& cursor, float time = 0.0f) const;
+
+    //forward playback advances the cursor in amortized O(1), seeking backwards or far ahead does a binary search
+    void Sample(AnimationCursor& cursor, float time) const;
+
+    //moves the cursor forward, wrapping around at the end of the clip, and samples it. cursor.values is indexed like the channels
+    void Advance(AnimationCursor& cursor, float delta_time) const;
+
+    //samples instance_count cursors at staggered times, and compares against decoding and scanning the keys every frame
+    BenchmarkResult Benchmark(uint32_t instance_count, uint32_t frame_count) const;
 
 private:
-    void UpdateChannel(SkeletalMesh* mesh, const AnimationChannel& channel);
+    void SeekChannel(AnimationCursor& cursor, uint32_t channel, float time) const;
+    float4 DecodeKey(const AnimationChannel& channel, uint32_t key) const;
 
 private:
     eastl::string m_name;
-    eastl::vector<AnimationChannel> m_channels;
+    eastl::vector<AnimationChannel> m_channels; //sorted by mode, so the channels can be interpolated 4 at a time
+    eastl::vector<float> m_keyTimes;
+    eastl::vector<AnimationKey> m_keys;
     float m_timeDuration = 0.0f;
-    float m_currentAnimTime = 0.0f;
 };
\ No newline at end of file
@@ -0,0 +1,157 @@
+#include "animation_lod.h"
+#include "camera.h"
+#include "utils/gui_util.h"
+
+AnimationLOD::AnimationLOD()
+{
+    m_levels[0] = { 0.25f, 1, false };
+    m_levels[1] = { 0.1f, 2, true };
+    m_levels[2] = { 0.02f, 4, false };
+
+    for (uint32_t i = 0; i < LEVEL_COUNT + 1; ++i)
+    {
+        m_levelCounts[i] = 0;
+    }
+
+    for (size_t i = 0; i < (size_t)Counter::Count; ++i)
+    {
+        m_counters[i] = 0;
+    }
+}
+
+void AnimationLOD::BeginFrame()
+{
+    ++m_nFrameIndex;
+
+    for (uint32_t i = 0; i < LEVEL_COUNT + 1; ++i)
+    {
+        m_lastLevelCounts[i] = m_levelCounts[i].exchange(0, eastl::memory_order_relaxed);
+    }
+
+    for (size_t i = 0; i < (size_t)Counter::Count; ++i)
+    {
+        m_lastCounters[i] = m_counters[i].exchange(0, eastl::memory_order_relaxed);
+    }
+}
+
+uint32_t AnimationLOD::SelectLevel(const Camera* camera, const float3& center, float radius) const
+{
+    if (!m_bEnabled)
+    {
+        return 0;
+    }
+
+    if (!::FrustumCull(camera->GetFrustumPlanes(), 6, center, radius))
+    {
+        return CULLED_LEVEL;
+    }
+
+    float screen_size = CalcScreenSize(camera, center, radius);
+
+    for (uint32_t i = 0; i < LEVEL_COUNT; ++i)
+    {
+        if (screen_size >= m_levels[i].minScreenSize)
+        {
+            return i;
+        }
+    }
+
+    return CULLED_LEVEL;
+}
+
+const AnimationLOD::Level& AnimationLOD::GetLevel(uint32_t level) const
+{
+    RE_ASSERT(level <= CULLED_LEVEL);
+    return level == CULLED_LEVEL ? m_culledLevel : m_levels[level];
+}
+
+bool AnimationLOD::IsUpdateFrame(uint32_t level, uint32_t object_id, uint32_t frames_since_update) const
+{
+    if (frames_since_update == UINT32_MAX)
+    {
+        return true; //never updated
+    }
+
+    uint32_t interval = GetLevel(level).updateInterval;
+    if (interval == 0)
+    {
+        return false;
+    }
+
+    return frames_since_update > interval || (m_nFrameIndex + object_id) % interval == 0;
+}
+
+float AnimationLOD::GetInterpolationAlpha(uint32_t level, uint32_t frames_since_update) const
+{
+    const Level& lod = GetLevel(level);
+    if (!lod.interpolate || lod.updateInterval <= 1)
+    {
+        return 1.0f;
+    }
+
+    return min((float)(frames_since_update + 1) / lod.updateInterval, 1.0f);
+}
+
+void AnimationLOD::AddLevelCount(uint32_t level)
+{
+    m_levelCounts[level].fetch_add(1, eastl::memory_order_relaxed);
+}
+
+void AnimationLOD::AddCounter(Counter counter, uint32_t value)
+{
+    m_counters[(size_t)counter].fetch_add(value, eastl::memory_order_relaxed);
+}
+
+void AnimationLOD::OnGui()
+{
+    ImGui::Checkbox("Enable##AnimationLOD", &m_bEnabled);
+
+    for (uint32_t i = 0; i < LEVEL_COUNT; ++i)
+    {
+        ImGui::PushID(i);
+
+        if (ImGui::TreeNodeEx("Level", ImGuiTreeNodeFlags_DefaultOpen, "Level %d", i))
+        {
+            ImGui::SliderFloat("Min Screen Size", &m_levels[i].minScreenSize, 0.0f, 1.0f, "%.3f");
+
+            int interval = (int)m_levels[i].updateInterval;
+            if (ImGui::SliderInt("Update Interval", &interval, 1, 8))
+            {
+                m_levels[i].updateInterval = (uint32_t)interval;
+            }
+
+            ImGui::Checkbox("Interpolate", &m_levels[i].interpolate);
+            ImGui::TreePop();
+        }
+
+        ImGui::PopID();
+    }
+
+    ImGui::Separator();
+
+    for (uint32_t i = 0; i < LEVEL_COUNT; ++i)
+    {
+        ImGui::Text("Level %d : %u meshes", i, m_lastLevelCounts[i]);
+    }
+    ImGui::Text("Culled : %u meshes", m_lastLevelCounts[CULLED_LEVEL]);
+
+    static const char* counterNames[] = { "Sampled", "Skipped Sampling", "Interpolated", "Skinned", "Skipped Skinning", "BLAS Updates", "Skipped BLAS Updates" };
+    static_assert(sizeof(counterNames) / sizeof(counterNames[0]) == (size_t)Counter::Count);
+
+    for (size_t i = 0; i < (size_t)Counter::Count; ++i)
+    {
+        ImGui::Text("%s : %u", counterNames[i], m_lastCounters[i]);
+    }
+}
+
+float AnimationLOD::CalcScreenSize(const Camera* camera, const float3& center, float radius)
+{
+    float dist = distance(camera->GetPosition(), center);
+    if (dist <= radius)
+    {
+        return 1.0f;
+    }
+
+    //diameter over the screen height : 2r / (2 * d * tan(fov / 2))
+    return radius / (dist * tanf(radians(camera->GetFov()) * 0.5f));
+}
\ No newline at end of file
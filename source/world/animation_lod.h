@@ -0,0 +1,67 @@
+#pragma once
+
+#include "utils/math.h"
+#include "EASTL/atomic.h"
+
+class Camera;
+
+//selects how often a skeletal mesh is animated from its size on screen.
+//interpolated levels sample the pose every updateInterval frames and blend the joint matrices in between,
+//the other levels skin and refit their BLAS only on update frames and reuse the previous skinned vertices otherwise
+class AnimationLOD
+{
+public:
+    static const uint32_t LEVEL_COUNT = 3;
+    static const uint32_t CULLED_LEVEL = LEVEL_COUNT; //off-screen or smaller than the last level, not animated at all
+
+    struct Level
+    {
+        float minScreenSize; //projected diameter of the bounding sphere divided by the screen height
+        uint32_t updateInterval; //0 : never
+        bool interpolate;
+    };
+
+    enum class Counter
+    {
+        Sampled,
+        SkippedSampling,
+        Interpolated, //frames which blended the joint matrices
+        Skinned,
+        SkippedSkinning,
+        BLASUpdates,
+        SkippedBLASUpdates,
+        Count,
+    };
+
+    AnimationLOD();
+
+    void BeginFrame();
+
+    uint32_t SelectLevel(const Camera* camera, const float3& center, float radius) const;
+    const Level& GetLevel(uint32_t level) const;
+
+    //updates of objects at the same level are spread over the interval by their ID,
+    //objects which missed their update, e.g. after being culled, are updated immediately
+    bool IsUpdateFrame(uint32_t level, uint32_t object_id, uint32_t frames_since_update) const;
+    float GetInterpolationAlpha(uint32_t level, uint32_t frames_since_update) const;
+
+    //thread-safe
+    void AddLevelCount(uint32_t level);
+    void AddCounter(Counter counter, uint32_t value = 1);
+
+    void OnGui();
+
+    static float CalcScreenSize(const Camera* camera, const float3& center, float radius);
+
+private:
+    bool m_bEnabled = true;
+    Level m_levels[LEVEL_COUNT];
+    Level m_culledLevel = { 0.0f, 0, false };
+    uint64_t m_nFrameIndex = 0;
+
+    //of the current frame, copied to the last frame's for the gui in BeginFrame
+    eastl::atomic<uint32_t> m_levelCounts[LEVEL_COUNT + 1];
+    eastl::atomic<uint32_t> m_counters[(size_t)Counter::Count];
+    uint32_t m_lastLevelCounts[LEVEL_COUNT + 1] = {};
+    uint32_t m_lastCounters[(size_t)Counter::Count] = {};
+};
\ No newline at end of file
@@ -42,6 +42,7 @@ void BillboardSpriteRenderer::AddSprite(const float3& position, float size, Text
     sprite.texture = texture->GetSRV()->GetHeapIndex();
     sprite.objectID = objectID;
 
+    std::scoped_lock lock(m_spriteMutex);
     m_sprites.push_back(sprite);
 }
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "renderer/renderer.h"
+#include <mutex>
 
 class BillboardSpriteRenderer
 {
@@ -8,7 +9,7 @@ public:
     BillboardSpriteRenderer(Renderer* pRenderer);
     ~BillboardSpriteRenderer();
 
-    void AddSprite(const float3& position, float size, Texture2D* texture, const float4& color, uint32_t objectID);
+    void AddSprite(const float3& position, float size, Texture2D* texture, const float4& color, uint32_t objectID); //thread-safe
     void Render();
 
 private:
@@ -26,5 +27,6 @@ private:
         uint32_t objectID;
         float distance;
     };
-    eastl::vector<Sprite> m_sprites;
+    eastl::vector<Sprite> m_sprites; //sorted by distance before rendering, so the order they are added in doesn't matter
+    std::mutex m_spriteMutex;
 };
\ No newline at end of file
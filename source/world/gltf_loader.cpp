@@ -141,6 +141,8 @@ void GLTFLoader::LoadSettings(tinyxml2::XMLElement* element)
 
 void GLTFLoader::Load(const char* gltf_file)
 {
+    MemoryTagScope memoryTag(MemoryTag::Loader);
+
     eastl::string file = Engine::GetInstance()->GetAssetPath() + (gltf_file ? gltf_file : m_file);
 
     cgltf_options options = {};
@@ -596,20 +598,11 @@ StaticMesh* GLTFLoader::LoadStaticMesh(const cgltf_primitive* primitive, const e
         switch (vertex_types[i])
         {
         case cgltf_attribute_type_position:
-            mesh->m_posBuffer = cache->GetSceneBuffer("model(" + m_file + " " + name + ") pos", remapped_vertices[i], (uint32_t)vertex_streams[i].stride * (uint32_t)remapped_vertex_count);
-
             {
-                IPhysicsSystem* physics = Engine::GetInstance()->GetWorld()->GetPhysicsSystem();
-                if (indices.stride == 2)
-                {
-                    mesh->m_pShape.reset(physics->CreateMeshShape((const float*)remapped_vertices[i], (uint32_t)vertex_streams[i].stride, (uint32_t)remapped_vertex_count,
-                        (const uint16_t*)remapped_indices, (uint32_t)index_count, bFrontFaceCCW));
-                }
-                else
-                {
-                    mesh->m_pShape.reset(physics->CreateMeshShape((const float*)remapped_vertices[i], (uint32_t)vertex_streams[i].stride, (uint32_t)remapped_vertex_count,
-                        (const uint32_t*)remapped_indices, (uint32_t)index_count, bFrontFaceCCW));
-                }
+                eastl::string key = "model(" + m_file + " " + name + ") pos";
+                mesh->m_posBuffer = cache->GetSceneBuffer(key, remapped_vertices[i], (uint32_t)vertex_streams[i].stride * (uint32_t)remapped_vertex_count);
+                mesh->m_pShape = cache->GetMeshShape(key, (const float*)remapped_vertices[i], (uint32_t)vertex_streams[i].stride, (uint32_t)remapped_vertex_count,
+                    remapped_indices, (uint32_t)indices.stride, (uint32_t)index_count, bFrontFaceCCW);
             }
             break;
         case cgltf_attribute_type_texcoord:
@@ -653,24 +646,22 @@ Animation* GLTFLoader::LoadAnimation(const cgltf_data* data, const cgltf_animati
 {
     Animation* animation = new Animation(gltf_animation->name ? gltf_animation->name : "");
 
-    animation->m_channels.reserve(gltf_animation->channels_count);
     for (cgltf_size i = 0; i < gltf_animation->channels_count; ++i)
     {
         const cgltf_animation_channel* gltf_channel = &gltf_animation->channels[i];
 
-        AnimationChannel channel;
-        channel.targetNode = GetNodeIndex(data, gltf_channel->target_node);
+        AnimationChannelMode mode = AnimationChannelMode::Translation;
 
         switch (gltf_channel->target_path)
         {
         case cgltf_animation_path_type_translation:
-            channel.mode = AnimationChannelMode::Translation;
+            mode = AnimationChannelMode::Translation;
             break;
         case cgltf_animation_path_type_rotation:
-            channel.mode = AnimationChannelMode::Rotation;
+            mode = AnimationChannelMode::Rotation;
             break;
         case cgltf_animation_path_type_scale:
-            channel.mode = AnimationChannelMode::Scale;
+            mode = AnimationChannelMode::Scale;
             break;
         default:
             RE_ASSERT(false);
@@ -685,27 +676,32 @@ Animation* GLTFLoader::LoadAnimation(const cgltf_data* data, const cgltf_animati
         RE_ASSERT(time_accessor->count == value_accessor->count);
 
         cgltf_size keyframe_num = time_accessor->count;
-        channel.keyframes.reserve(keyframe_num);
+        eastl::vector<float> times(keyframe_num);
+        eastl::vector<float4> values(keyframe_num);
 
         char* time_data = (char*)time_accessor->buffer_view->buffer->data + time_accessor->buffer_view->offset + time_accessor->offset;
         char* value_data = (char*)value_accessor->buffer_view->buffer->data + value_accessor->buffer_view->offset + value_accessor->offset;
 
         for (cgltf_size k = 0; k < keyframe_num; ++k)
         {
-            float time;
-            float4 value;
-
-            memcpy(&time, time_data + time_accessor->stride * k, time_accessor->stride);
+            float4 value = float4(0.0f, 0.0f, 0.0f, 0.0f);
+            memcpy(&times[k], time_data + time_accessor->stride * k, time_accessor->stride);
             memcpy(&value, value_data + value_accessor->stride * k, value_accessor->stride);
 
-            channel.keyframes.push_back(eastl::make_pair(time, value));
-        }
+            //to the engine's coordinate system
+            if (mode == AnimationChannelMode::Translation)
+            {
+                value = float4(value.x, value.y, -value.z, 0.0f);
+            }
+            else if (mode == AnimationChannelMode::Rotation)
+            {
+                value = float4(value.x, value.y, -value.z, -value.w);
+            }
 
-        animation->m_channels.push_back(channel);
+            values[k] = value;
+        }
 
-        RE_ASSERT(time_accessor->has_min && time_accessor->has_max);
-        float duration = time_accessor->max[0] - time_accessor->min[0];
-        animation->m_timeDuration = max(duration, animation->m_timeDuration);
+        animation->AddChannel(GetNodeIndex(data, gltf_channel->target_node), mode, times.data(), values.data(), (uint32_t)keyframe_num);
     }
 
     return animation;
@@ -748,11 +744,7 @@ Skeleton* GLTFLoader::LoadSkeleton(const cgltf_data* data, const cgltf_skin* ski
         rotation.z *= -1;
         rotation.w *= -1;
 
-        float4x4 T = translation_matrix(translation);
-        float4x4 R = rotation_matrix(rotation);
-        float4x4 S = scaling_matrix(scale);
-
-        skeleton->m_inverseBindMatrices[i] = mul(T, mul(R, S));
+        skeleton->m_inverseBindMatrices[i] = affine_transform(translation, rotation, scale);
     }
 
     return skeleton;
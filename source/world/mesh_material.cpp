@@ -45,7 +45,7 @@ IGfxPipelineState* MeshMaterial::GetPSO()
         psoDesc.rt_format[4] = GfxFormat::RGBA8UNORM;
         psoDesc.depthstencil_format = GfxFormat::D32F;
 
-        m_pPSO = pRenderer->GetPipelineState(psoDesc, "model PSO");
+        m_pPSO = pRenderer->GetPipelineStateAsync(psoDesc, "model PSO");
     }
     return m_pPSO;
 }
@@ -74,7 +74,7 @@ IGfxPipelineState* MeshMaterial::GetMeshletPSO()
         psoDesc.rt_format[4] = GfxFormat::RGBA8UNORM;
         psoDesc.depthstencil_format = GfxFormat::D32F;
 
-        m_pMeshletPSO = pRenderer->GetPipelineState(psoDesc, "model meshlet PSO");
+        m_pMeshletPSO = pRenderer->GetPipelineStateAsync(psoDesc, "model meshlet PSO");
     }
     return m_pMeshletPSO;
 }
@@ -106,7 +106,7 @@ IGfxPipelineState* MeshMaterial::GetShadowPSO()
         psoDesc.depthstencil_state.depth_func = GfxCompareFunc::LessEqual;
         psoDesc.depthstencil_format = GfxFormat::D16;
 
-        m_pShadowPSO = pRenderer->GetPipelineState(psoDesc, "model shadow PSO");
+        m_pShadowPSO = pRenderer->GetPipelineStateAsync(psoDesc, "model shadow PSO");
     }
     return m_pShadowPSO;
 }
@@ -136,7 +136,7 @@ IGfxPipelineState* MeshMaterial::GetVelocityPSO()
         psoDesc.rt_format[0] = GfxFormat::RGBA16F;
         psoDesc.depthstencil_format = GfxFormat::D32F;
 
-        m_pVelocityPSO = pRenderer->GetPipelineState(psoDesc, "model velocity PSO");
+        m_pVelocityPSO = pRenderer->GetPipelineStateAsync(psoDesc, "model velocity PSO");
     }
     return m_pVelocityPSO;
 }
@@ -165,7 +165,7 @@ IGfxPipelineState* MeshMaterial::GetIDPSO()
         psoDesc.rt_format[0] = GfxFormat::R32UI;
         psoDesc.depthstencil_format = GfxFormat::D32F;
 
-        m_pIDPSO = pRenderer->GetPipelineState(psoDesc, "model ID PSO");
+        m_pIDPSO = pRenderer->GetPipelineStateAsync(psoDesc, "model ID PSO");
     }
     return m_pIDPSO;
 }
@@ -194,24 +194,11 @@ IGfxPipelineState* MeshMaterial::GetOutlinePSO()
         psoDesc.rt_format[0] = GfxFormat::RGBA16F;
         psoDesc.depthstencil_format = GfxFormat::D32F;
 
-        m_pOutlinePSO = pRenderer->GetPipelineState(psoDesc, "model outline PSO");
+        m_pOutlinePSO = pRenderer->GetPipelineStateAsync(psoDesc, "model outline PSO");
     }
     return m_pOutlinePSO;
 }
 
-IGfxPipelineState* MeshMaterial::GetVertexSkinningPSO()
-{
-    if (m_pVertexSkinningPSO == nullptr)
-    {
-        Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
-
-        GfxComputePipelineDesc desc;
-        desc.cs = pRenderer->GetShader("vertex_skinning.hlsl", "main", GfxShaderType::CS);
-        m_pVertexSkinningPSO = pRenderer->GetPipelineState(desc, "vertex skinning PSO");
-    }
-    return m_pVertexSkinningPSO;
-}
-
 void MeshMaterial::UpdateConstants()
 {
     m_materialCB.shadingModel = (uint)m_shadingModel;
@@ -19,8 +19,6 @@ public:
 
     IGfxPipelineState* GetMeshletPSO();
 
-    IGfxPipelineState* GetVertexSkinningPSO();
-
     void UpdateConstants();
     const ModelMaterialConstant* GetConstants() const { return &m_materialCB; }
     void OnGui();
@@ -43,7 +41,6 @@ private:
     IGfxPipelineState* m_pIDPSO = nullptr;
     IGfxPipelineState* m_pOutlinePSO = nullptr;
     IGfxPipelineState* m_pMeshletPSO = nullptr;
-    IGfxPipelineState* m_pVertexSkinningPSO = nullptr;
 
     ShadingModel m_shadingModel = ShadingModel::Default;
 
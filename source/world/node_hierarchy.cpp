@@ -0,0 +1,64 @@
+#include "node_hierarchy.h"
+
+void NodeHierarchy::Build(eastl::span<const uint32_t> parents)
+{
+    const uint32_t node_count = (uint32_t)parents.size();
+
+    //the children of node i are children[firstChild[i], firstChild[i + 1])
+    eastl::vector<uint32_t> firstChild(node_count + 1, 0);
+    for (uint32_t i = 0; i < node_count; ++i)
+    {
+        if (parents[i] != UINT32_MAX)
+        {
+            RE_ASSERT(parents[i] < node_count);
+            firstChild[parents[i] + 1]++;
+        }
+    }
+
+    for (uint32_t i = 0; i < node_count; ++i)
+    {
+        firstChild[i + 1] += firstChild[i];
+    }
+
+    eastl::vector<uint32_t> children(firstChild[node_count]);
+    eastl::vector<uint32_t> childCount(node_count, 0);
+    for (uint32_t i = 0; i < node_count; ++i)
+    {
+        if (parents[i] != UINT32_MAX)
+        {
+            children[firstChild[parents[i]] + childCount[parents[i]]++] = i;
+        }
+    }
+
+    m_sortedNodes.clear();
+    m_sortedParents.clear();
+    m_sortedIndices.assign(node_count, UINT32_MAX);
+
+    eastl::vector<uint32_t> stack;
+    for (uint32_t i = 0; i < node_count; ++i)
+    {
+        if (parents[i] == UINT32_MAX)
+        {
+            stack.push_back(i);
+        }
+    }
+
+    while (!stack.empty())
+    {
+        uint32_t node_id = stack.back();
+        stack.pop_back();
+
+        m_sortedIndices[node_id] = (uint32_t)m_sortedNodes.size();
+        m_sortedNodes.push_back(node_id);
+        m_sortedParents.push_back(parents[node_id] == UINT32_MAX ? UINT32_MAX : m_sortedIndices[parents[node_id]]);
+
+        for (uint32_t i = firstChild[node_id]; i < firstChild[node_id + 1]; ++i)
+        {
+            stack.push_back(children[i]);
+        }
+    }
+
+    //nodes in a cycle are never reached from a root
+    RE_ASSERT(m_sortedNodes.size() == node_count);
+    m_globalTransforms.resize(m_sortedNodes.size());
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "utils/math.h"
+#include "EASTL/span.h"
+#include "EASTL/vector.h"
+
+//a node tree flattened in topological order, so the global transforms are computed in one loop with parents before their children
+class NodeHierarchy
+{
+public:
+    //parents[i] is the parent of node i, UINT32_MAX for roots
+    void Build(eastl::span<const uint32_t> parents);
+
+    //get_local_transform(node_id) returns the local transform of a node as an affine3x4
+    template<typename F>
+    void UpdateTransforms(F&& get_local_transform)
+    {
+        for (size_t i = 0; i < m_sortedNodes.size(); ++i)
+        {
+            affine3x4 local = get_local_transform(m_sortedNodes[i]);
+
+            uint32_t parent = m_sortedParents[i];
+            m_globalTransforms[i] = parent == UINT32_MAX ? local : mul(m_globalTransforms[parent], local);
+        }
+    }
+
+    uint32_t GetNodeCount() const { return (uint32_t)m_sortedIndices.size(); }
+    uint32_t GetSortedIndex(uint32_t node_id) const { return m_sortedIndices[node_id]; }
+
+    const affine3x4& GetGlobalTransform(uint32_t node_id) const
+    {
+        RE_ASSERT(node_id < m_sortedIndices.size());
+        return m_globalTransforms[m_sortedIndices[node_id]];
+    }
+
+private:
+    eastl::vector<uint32_t> m_sortedNodes; //node id of each sorted node
+    eastl::vector<uint32_t> m_sortedParents; //sorted index of the parent, UINT32_MAX for roots
+    eastl::vector<uint32_t> m_sortedIndices; //sorted index of each node id
+    eastl::vector<affine3x4> m_globalTransforms; //in sorted order
+};
@@ -9,4 +9,5 @@ public:
     virtual void Tick(float delta_time) override;
     virtual bool FrustumCull(const float4* planes, uint32_t plane_count) const override;
     virtual void OnGui() override;
+    virtual bool IsParallelSafe() const override { return true; }
 };
\ No newline at end of file
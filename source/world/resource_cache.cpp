@@ -1,6 +1,14 @@
 #include "resource_cache.h"
 #include "renderer/renderer.h"
+#include "renderer/pipeline_cache.h"
 #include "core/engine.h"
+#include "physics/physics.h"
+#include "utils/log.h"
+#include "utils/fmt.h"
+#include "xxHash/xxhash.h"
+#include "sokol/sokol_time.h"
+
+#define MESH_SHAPE_CACHE_VERSION 1
 
 ResourceCache* ResourceCache::GetInstance()
 {
@@ -8,23 +16,88 @@ ResourceCache* ResourceCache::GetInstance()
     return &cache;
 }
 
-Texture2D* ResourceCache::GetTexture2D(const eastl::string& file, bool srgb)
+ResourceCache::ResourceCache() : m_shapeDiskCache(Engine::GetInstance()->GetWorkPath() + "cache/physics/")
+{
+}
+
+template<typename T, typename LoadFunc>
+T ResourceCache::Acquire(Shard<T>* shards, const eastl::string& key, LoadFunc load)
 {
-    auto iter = m_cachedTexture2D.find(file);
-    if (iter != m_cachedTexture2D.end())
+    Shard<T>& shard = GetShard(shards, key);
+
+    std::promise<T> promise;
+    std::shared_future<T> resource;
+    bool owner = false;
+
     {
-        iter->second.refCount++;
-        return (Texture2D*)iter->second.ptr;
+        std::scoped_lock lock(shard.mutex);
+
+        auto iter = shard.entries.find(key);
+        if (iter != shard.entries.end())
+        {
+            iter->second.refCount++;
+            resource = iter->second.resource;
+        }
+        else
+        {
+            resource = promise.get_future().share();
+            shard.entries.insert(eastl::make_pair(key, Entry<T>{ resource, 1 }));
+            owner = true;
+        }
     }
 
-    Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
+    if (owner)
+    {
+        m_nMisses++;
+
+        //loading happens outside of the shard lock, other requests for this key wait on the future
+        T value = load();
+
+        //failed loads aren't cached, the requests waiting on this one fail too but the next one tries again.
+        //nothing is released for them, the release functions ignore the failed values
+        if (!IsLoaded(value))
+        {
+            std::scoped_lock lock(shard.mutex);
+            shard.entries.erase(key);
+        }
+
+        promise.set_value(value);
+    }
+    else
+    {
+        m_nHits++;
 
-    Resource texture;
-    texture.refCount = 1;
-    texture.ptr = pRenderer->CreateTexture2D(file, srgb);
-    m_cachedTexture2D.insert(eastl::make_pair(file, texture));
+        if (resource.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            m_nSharedLoads++;
+        }
+    }
 
-    return (Texture2D*)texture.ptr;
+    return resource.get();
+}
+
+Texture2D* ResourceCache::GetTexture2D(const eastl::string& file, bool srgb)
+{
+    return Acquire(m_textureShards, file, [&]()
+        {
+            uint64_t ticks = stm_now();
+
+            Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
+            Texture2D* texture = pRenderer->CreateTexture2D(file, srgb);
+
+            if (texture)
+            {
+                uint32_t size = texture->GetTexture()->GetRequiredStagingBufferSize();
+                m_nLoadedBytes += size;
+                m_nTextureBytes += size;
+                m_nTextureTicks += stm_since(ticks);
+
+                std::scoped_lock lock(m_reverseMutex);
+                m_textureKeys.insert(eastl::make_pair(texture, file));
+            }
+
+            return texture;
+        });
 }
 
 void ResourceCache::ReleaseTexture2D(Texture2D* texture)
@@ -34,42 +107,55 @@ void ResourceCache::ReleaseTexture2D(Texture2D* texture)
         return;
     }
 
-    for (auto iter = m_cachedTexture2D.begin(); iter != m_cachedTexture2D.end(); ++iter)
+    eastl::string key;
     {
-        if (iter->second.ptr == texture)
-        {
-            iter->second.refCount--;
-            
-            if (iter->second.refCount == 0)
-            {
-                delete texture;
-                m_cachedTexture2D.erase(iter);
-            }
+        std::scoped_lock lock(m_reverseMutex);
 
+        auto iter = m_textureKeys.find(texture);
+        if (iter == m_textureKeys.end())
+        {
+            RE_ASSERT(false);
             return;
         }
+        key = iter->second;
     }
 
-    RE_ASSERT(false);
+    Shard<Texture2D*>& shard = GetShard(m_textureShards, key);
+    std::scoped_lock lock(shard.mutex);
+
+    auto iter = shard.entries.find(key);
+    RE_ASSERT(iter != shard.entries.end());
+
+    if (--iter->second.refCount == 0)
+    {
+        shard.entries.erase(iter);
+
+        {
+            std::scoped_lock reverse_lock(m_reverseMutex);
+            m_textureKeys.erase(texture);
+        }
+
+        delete texture;
+    }
 }
 
 OffsetAllocator::Allocation ResourceCache::GetSceneBuffer(const eastl::string& name, const void* data, uint32_t size)
 {
-    auto iter = m_cachedSceneBuffer.find(name);
-    if (iter != m_cachedSceneBuffer.end())
-    {
-        iter->second.refCount++;
-        return iter->second.allocation;
-    }
+    return Acquire(m_sceneBufferShards, name, [&]()
+        {
+            Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
+            OffsetAllocator::Allocation allocation = pRenderer->AllocateSceneStaticBuffer(data, size);
 
-    Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
+            if (allocation.metadata != OffsetAllocator::Allocation::NO_SPACE)
+            {
+                m_nLoadedBytes += size;
 
-    SceneBuffer buffer;
-    buffer.refCount = 1;
-    buffer.allocation = pRenderer->AllocateSceneStaticBuffer(data, size);
-    m_cachedSceneBuffer.insert(eastl::make_pair(name, buffer));
+                std::scoped_lock lock(m_reverseMutex);
+                m_sceneBufferKeys.insert(eastl::make_pair(allocation.offset, name));
+            }
 
-    return buffer.allocation;
+            return allocation;
+        });
 }
 
 void ResourceCache::RelaseSceneBuffer(OffsetAllocator::Allocation allocation)
@@ -79,22 +165,171 @@ void ResourceCache::RelaseSceneBuffer(OffsetAllocator::Allocation allocation)
         return;
     }
 
-    for (auto iter = m_cachedSceneBuffer.begin(); iter != m_cachedSceneBuffer.end(); ++iter)
+    eastl::string key;
     {
-        if (iter->second.allocation.metadata == allocation.metadata &&
-            iter->second.allocation.offset == allocation.offset)
+        std::scoped_lock lock(m_reverseMutex);
+
+        auto iter = m_sceneBufferKeys.find(allocation.offset);
+        if (iter == m_sceneBufferKeys.end())
         {
-            iter->second.refCount--;
+            RE_ASSERT(false);
+            return;
+        }
+        key = iter->second;
+    }
+
+    Shard<OffsetAllocator::Allocation>& shard = GetShard(m_sceneBufferShards, key);
+    std::scoped_lock lock(shard.mutex);
+
+    auto iter = shard.entries.find(key);
+    RE_ASSERT(iter != shard.entries.end());
+    RE_ASSERT(iter->second.resource.get().metadata == allocation.metadata);
+
+    if (--iter->second.refCount == 0)
+    {
+        shard.entries.erase(iter);
 
-            if (iter->second.refCount == 0)
+        {
+            std::scoped_lock reverse_lock(m_reverseMutex);
+            m_sceneBufferKeys.erase(allocation.offset);
+        }
+
+        Engine::GetInstance()->GetRenderer()->FreeSceneStaticBuffer(allocation);
+    }
+}
+
+IPhysicsShape* ResourceCache::GetMeshShape(const eastl::string& name, const float* vertices, uint32_t vertex_stride, uint32_t vertex_count,
+    const void* indices, uint32_t index_stride, uint32_t index_count, bool winding_order_ccw)
+{
+    //instances with a mirrored transform flip the winding order, they can't share the shape
+    eastl::string key = name + (winding_order_ccw ? " ccw" : " cw");
+
+    return Acquire(m_meshShapeShards, key, [&]()
+        {
+            IPhysicsShape* shape = LoadMeshShape(key, vertices, vertex_stride, vertex_count, indices, index_stride, index_count, winding_order_ccw);
+
+            if (shape)
             {
-                Engine::GetInstance()->GetRenderer()->FreeSceneStaticBuffer(allocation);
-                m_cachedSceneBuffer.erase(iter);
+                std::scoped_lock lock(m_reverseMutex);
+                m_meshShapeKeys.insert(eastl::make_pair(shape, key));
             }
 
+            return shape;
+        });
+}
+
+void ResourceCache::ReleaseMeshShape(IPhysicsShape* shape)
+{
+    if (shape == nullptr)
+    {
+        return;
+    }
+
+    eastl::string key;
+    {
+        std::scoped_lock lock(m_reverseMutex);
+
+        auto iter = m_meshShapeKeys.find(shape);
+        if (iter == m_meshShapeKeys.end())
+        {
+            RE_ASSERT(false);
             return;
         }
+        key = iter->second;
+    }
+
+    Shard<IPhysicsShape*>& shard = GetShard(m_meshShapeShards, key);
+    std::scoped_lock lock(shard.mutex);
+
+    auto iter = shard.entries.find(key);
+    RE_ASSERT(iter != shard.entries.end());
+
+    if (--iter->second.refCount == 0)
+    {
+        shard.entries.erase(iter);
+
+        {
+            std::scoped_lock reverse_lock(m_reverseMutex);
+            m_meshShapeKeys.erase(shape);
+        }
+
+        //the rigid bodies keep their own reference to the physics system's shape
+        delete shape;
+    }
+}
+
+IPhysicsShape* ResourceCache::LoadMeshShape(const eastl::string& key, const float* vertices, uint32_t vertex_stride, uint32_t vertex_count,
+    const void* indices, uint32_t index_stride, uint32_t index_count, bool winding_order_ccw)
+{
+    IPhysicsSystem* physics = Engine::GetInstance()->GetWorld()->GetPhysicsSystem();
+
+    //the file is named after the key, and invalidated by the content of the mesh
+    eastl::string file = fmt::format("mesh_shape_{:016x}", XXH3_64bits(key.data(), key.length())).c_str();
+
+    uint64_t hash = XXH3_64bits(vertices, (size_t)vertex_stride * vertex_count);
+    hash = hash_combine_64(hash, XXH3_64bits(indices, (size_t)index_stride * index_count));
+    hash = hash_combine_64(hash, (uint64_t)MESH_SHAPE_CACHE_VERSION << 32 | vertex_stride << 8 | index_stride << 1 | (winding_order_ccw ? 1 : 0));
+
+    PrecomputedDataCache::Entry entry;
+    if (m_shapeDiskCache.Load(file, hash, entry))
+    {
+        IPhysicsShape* shape = physics->LoadShape(entry.GetData(), entry.GetSize());
+        if (shape)
+        {
+            m_nDiskShapes++;
+            return shape;
+        }
+
+        RE_DEBUG("[ResourceCache] failed to load the shape of {} from the disk cache", key);
     }
 
-    RE_ASSERT(false);
+    IPhysicsShape* shape = nullptr;
+    if (index_stride == 2)
+    {
+        shape = physics->CreateMeshShape(vertices, vertex_stride, vertex_count, (const uint16_t*)indices, index_count, winding_order_ccw);
+    }
+    else
+    {
+        shape = physics->CreateMeshShape(vertices, vertex_stride, vertex_count, (const uint32_t*)indices, index_count, winding_order_ccw);
+    }
+
+    if (shape)
+    {
+        m_nBakedShapes++;
+
+        eastl::vector<uint8_t> data;
+        if (physics->SaveShape(shape, data))
+        {
+            m_shapeDiskCache.Save(file, hash, data.data(), (uint32_t)data.size());
+        }
+    }
+
+    return shape;
+}
+
+ResourceCache::Stats ResourceCache::GetStats() const
+{
+    Stats stats;
+    stats.hits = m_nHits;
+    stats.misses = m_nMisses;
+    stats.sharedLoads = m_nSharedLoads;
+    stats.loadedBytes = m_nLoadedBytes;
+    stats.textureBytes = m_nTextureBytes;
+    stats.textureTicks = m_nTextureTicks;
+    stats.bakedShapes = m_nBakedShapes;
+    stats.diskShapes = m_nDiskShapes;
+    return stats;
+}
+
+void ResourceCache::LogStats() const
+{
+    Stats stats = GetStats();
+    RE_INFO("[ResourceCache] hits : {}, misses : {}, shared loads : {}, loaded : {:.2f} MB",
+        stats.hits, stats.misses, stats.sharedLoads, stats.loadedBytes / (1024.0 * 1024.0));
+
+    double texture_mb = stats.textureBytes / (1024.0 * 1024.0);
+    double texture_ms = stm_ms(stats.textureTicks);
+    RE_INFO("[ResourceCache] textures : {:.2f} MB in {:.2f} ms ({:.1f} MB/s per loading thread)",
+        texture_mb, texture_ms, texture_ms > 0.0 ? texture_mb * 1000.0 / texture_ms : 0.0);
+    RE_INFO("[ResourceCache] mesh shapes baked : {}, loaded from the disk cache : {}", stats.bakedShapes, stats.diskShapes);
 }
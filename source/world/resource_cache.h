@@ -1,8 +1,15 @@
 #pragma once
 
 #include "renderer/renderer.h"
+#include "renderer/precomputed_data_cache.h"
 #include "EASTL/hash_map.h"
+#include "EASTL/atomic.h"
+#include <mutex>
+#include <future>
 
+class IPhysicsShape;
+
+// thread-safe : concurrent requests for the same key share a single load
 class ResourceCache
 {
 public:
@@ -14,19 +21,79 @@ public:
     OffsetAllocator::Allocation GetSceneBuffer(const eastl::string& name, const void* data, uint32_t size);
     void RelaseSceneBuffer(OffsetAllocator::Allocation allocation);
 
+    //name is the key of the scene buffer holding the vertices, the baked shapes are also saved to disk and loaded on later runs
+    IPhysicsShape* GetMeshShape(const eastl::string& name, const float* vertices, uint32_t vertex_stride, uint32_t vertex_count,
+        const void* indices, uint32_t index_stride, uint32_t index_count, bool winding_order_ccw);
+    void ReleaseMeshShape(IPhysicsShape* shape);
+
+    struct Stats
+    {
+        uint32_t hits;
+        uint32_t misses;
+        uint32_t sharedLoads; //hits which waited on a load still in flight
+        uint64_t loadedBytes;
+        uint64_t textureBytes;
+        uint64_t textureTicks; //summed over the loading threads
+        uint32_t bakedShapes;
+        uint32_t diskShapes; //loaded from the disk cache
+    };
+    Stats GetStats() const;
+    void LogStats() const;
+
 private:
-    struct Resource
+    ResourceCache();
+
+    IPhysicsShape* LoadMeshShape(const eastl::string& key, const float* vertices, uint32_t vertex_stride, uint32_t vertex_count,
+        const void* indices, uint32_t index_stride, uint32_t index_count, bool winding_order_ccw);
+
+private:
+    static const uint32_t SHARD_COUNT = 16;
+
+    template<typename T>
+    struct Entry
     {
-        void* ptr;
+        std::shared_future<T> resource;
         uint32_t refCount;
     };
 
-    struct SceneBuffer
+    template<typename T>
+    struct Shard
     {
-        OffsetAllocator::Allocation allocation;
-        uint32_t refCount;
+        std::mutex mutex;
+        eastl::hash_map<eastl::string, Entry<T>> entries;
     };
 
-    eastl::hash_map<eastl::string, Resource> m_cachedTexture2D;
-    eastl::hash_map<eastl::string, SceneBuffer> m_cachedSceneBuffer;
+    template<typename T>
+    Shard<T>& GetShard(Shard<T>* shards, const eastl::string& key) const
+    {
+        return shards[eastl::hash<eastl::string>{}(key) % SHARD_COUNT];
+    }
+
+    static bool IsLoaded(const void* resource) { return resource != nullptr; }
+    static bool IsLoaded(const OffsetAllocator::Allocation& allocation) { return allocation.metadata != OffsetAllocator::Allocation::NO_SPACE; }
+
+    template<typename T, typename LoadFunc>
+    T Acquire(Shard<T>* shards, const eastl::string& key, LoadFunc load);
+
+private:
+    Shard<Texture2D*> m_textureShards[SHARD_COUNT];
+    Shard<OffsetAllocator::Allocation> m_sceneBufferShards[SHARD_COUNT];
+    Shard<IPhysicsShape*> m_meshShapeShards[SHARD_COUNT];
+
+    PrecomputedDataCache m_shapeDiskCache;
+
+    //reverse lookup for release, always locked after a shard mutex
+    std::mutex m_reverseMutex;
+    eastl::hash_map<Texture2D*, eastl::string> m_textureKeys;
+    eastl::hash_map<uint32_t, eastl::string> m_sceneBufferKeys; //key : allocation offset
+    eastl::hash_map<IPhysicsShape*, eastl::string> m_meshShapeKeys;
+
+    eastl::atomic<uint32_t> m_nHits{ 0 };
+    eastl::atomic<uint32_t> m_nMisses{ 0 };
+    eastl::atomic<uint32_t> m_nSharedLoads{ 0 };
+    eastl::atomic<uint64_t> m_nLoadedBytes{ 0 };
+    eastl::atomic<uint64_t> m_nTextureBytes{ 0 };
+    eastl::atomic<uint64_t> m_nTextureTicks{ 0 };
+    eastl::atomic<uint32_t> m_nBakedShapes{ 0 };
+    eastl::atomic<uint32_t> m_nDiskShapes{ 0 };
 };
\ No newline at end of file
@@ -1,8 +1,8 @@
 #include "skeletal_mesh.h"
 #include "skeleton.h"
-#include "animation.h"
 #include "mesh_material.h"
 #include "resource_cache.h"
+#include "animation_lod.h"
 #include "core/engine.h"
 #include "utils/gui_util.h"
 
@@ -35,6 +35,9 @@ SkeletalMesh::SkeletalMesh(const eastl::string& name)
 
 bool SkeletalMesh::Create()
 {
+    m_pAnimation->InitCursor(m_animationCursor);
+    BuildNodeHierarchy();
+
     for (size_t i = 0; i < m_nodes.size(); ++i)
     {
         for (size_t j = 0; j < m_nodes[i]->meshes.size(); ++j)
@@ -109,21 +112,64 @@ void SkeletalMesh::Tick(float delta_time)
     float4x4 S = scaling_matrix(m_scale);
     m_mtxWorld = mul(T, mul(R, S));
 
-    m_pAnimation->Update(this, delta_time); //update node local transform
+    World* world = Engine::GetInstance()->GetWorld();
+    AnimationLOD* lod = world->GetAnimationLOD();
 
-    for (size_t i = 0; i < m_rootNodes.size(); ++i)
+    m_nLODLevel = lod->SelectLevel(world->GetCamera(), m_pos, m_radius);
+    lod->AddLevelCount(m_nLODLevel);
+
+    const AnimationLOD::Level& level = lod->GetLevel(m_nLODLevel);
+    m_pendingAnimationTime += delta_time;
+
+    if (m_nFramesSinceUpdate != UINT32_MAX)
+    {
+        ++m_nFramesSinceUpdate;
+    }
+
+    bool update = lod->IsUpdateFrame(m_nLODLevel, m_nID, m_nFramesSinceUpdate);
+    if (update)
+    {
+        bool snap = m_nFramesSinceUpdate == UINT32_MAX || m_nFramesSinceUpdate > level.updateInterval;
+
+        m_pAnimation->Advance(m_animationCursor, m_pendingAnimationTime);
+        m_pendingAnimationTime = 0.0f;
+
+        ApplyAnimation(); //update node local transform
+
+        UpdateNodeTransforms(); //update node global transform
+
+        if (m_pSkeleton)
+        {
+            m_pSkeleton->Update(this, snap);
+        }
+
+        m_nFramesSinceUpdate = 0;
+        lod->AddCounter(AnimationLOD::Counter::Sampled);
+    }
+    else
     {
-        UpdateNodeTransform(GetNode(m_rootNodes[i])); //update node global transform
+        lod->AddCounter(AnimationLOD::Counter::SkippedSampling);
     }
 
-    if (m_pSkeleton)
+    //interpolated levels blend the joint matrices every frame, so they are skinned every frame too
+    bool interpolate = !update && level.interpolate && m_nLODLevel != AnimationLOD::CULLED_LEVEL;
+    bool skin = update || interpolate;
+
+    if (m_pSkeleton && skin)
     {
-        m_pSkeleton->Update(this);
+        float alpha = lod->GetInterpolationAlpha(m_nLODLevel, m_nFramesSinceUpdate);
+        m_pSkeleton->Upload(alpha);
+
+        //the upload only blends the previous and current poses below 1, e.g. not on the last frame before an update
+        if (alpha < 1.0f)
+        {
+            lod->AddCounter(AnimationLOD::Counter::Interpolated);
+        }
     }
 
     for (size_t i = 0; i < m_rootNodes.size(); ++i)
     {
-        UpdateMeshConstants(GetNode(m_rootNodes[i]));
+        UpdateMeshConstants(GetNode(m_rootNodes[i]), skin);
     }
 }
 
@@ -150,31 +196,71 @@ SkeletalMeshNode* SkeletalMesh::GetNode(uint32_t node_id) const
     return m_nodes[node_id].get();
 }
 
-void SkeletalMesh::UpdateNodeTransform(SkeletalMeshNode* node)
+const affine3x4& SkeletalMesh::GetGlobalTransform(uint32_t node_id) const
 {
-    float4x4 T = translation_matrix(node->translation);
-    float4x4 R = rotation_matrix(node->rotation);
-    float4x4 S = scaling_matrix(node->scale);
-    node->globalTransform = mul(T, mul(R, S));
+    return m_hierarchy.GetGlobalTransform(node_id);
+}
 
-    if (node->parent != -1)
+void SkeletalMesh::BuildNodeHierarchy()
+{
+    eastl::vector<uint32_t> parents(m_nodes.size());
+    for (size_t i = 0; i < m_nodes.size(); ++i)
     {
-        node->globalTransform = mul(GetNode(node->parent)->globalTransform, node->globalTransform);
+        parents[i] = m_nodes[i]->parent;
     }
 
-    for (size_t i = 0; i < node->children.size(); ++i)
+    m_hierarchy.Build(parents);
+}
+
+void SkeletalMesh::ApplyAnimation()
+{
+    for (uint32_t i = 0; i < m_pAnimation->GetChannelCount(); ++i)
     {
-        UpdateNodeTransform(GetNode(node->children[i]));
+        const AnimationChannel& channel = m_pAnimation->GetChannel(i);
+        SkeletalMeshNode* node = GetNode(channel.targetNode);
+        const float4& value = m_animationCursor.values[i];
+
+        switch (channel.mode)
+        {
+        case AnimationChannelMode::Translation:
+            node->translation = value.xyz();
+            break;
+        case AnimationChannelMode::Rotation:
+            node->rotation = value;
+            break;
+        case AnimationChannelMode::Scale:
+            node->scale = value.xyz();
+            break;
+        default:
+            break;
+        }
     }
 }
 
-void SkeletalMesh::UpdateMeshConstants(SkeletalMeshNode* node)
+void SkeletalMesh::UpdateNodeTransforms()
+{
+    m_hierarchy.UpdateTransforms([&](uint32_t node_id)
+        {
+            const SkeletalMeshNode* node = m_nodes[node_id].get();
+            return affine_transform(node->translation, node->rotation, node->scale);
+        });
+}
+
+void SkeletalMesh::UpdateMeshConstants(SkeletalMeshNode* node, bool skin)
 {
+    AnimationLOD* lod = Engine::GetInstance()->GetWorld()->GetAnimationLOD();
+
     for (size_t i = 0; i < node->meshes.size(); ++i)
     {
         SkeletalMeshData* mesh = node->meshes[i].get();
 
-        eastl::swap(mesh->prevAnimPosBuffer, mesh->animPosBuffer);
+        bool isSkinnedMesh = mesh->material->IsVertexSkinned();
+        mesh->skinned = isSkinnedMesh && skin;
+
+        if (mesh->skinned)
+        {
+            eastl::swap(mesh->prevAnimPosBuffer, mesh->animPosBuffer);
+        }
 
         mesh->material->UpdateConstants();
 
@@ -185,7 +271,6 @@ void SkeletalMesh::UpdateMeshConstants(SkeletalMeshNode* node)
 
         mesh->instanceData.uvBufferAddress = mesh->uvBuffer.offset;
 
-        bool isSkinnedMesh = mesh->material->IsVertexSkinned();
         if (isSkinnedMesh)
         {
             mesh->instanceData.posBufferAddress = mesh->animPosBuffer.offset;
@@ -203,8 +288,7 @@ void SkeletalMesh::UpdateMeshConstants(SkeletalMeshNode* node)
         mesh->instanceData.materialDataAddress = m_pRenderer->AllocateSceneConstant((void*)mesh->material->GetConstants(), sizeof(ModelMaterialConstant));
         mesh->instanceData.objectID = m_nID;
 
-        SkeletalMeshNode* node = GetNode(mesh->nodeID);
-        float4x4 mtxNodeWorld = mul(m_mtxWorld, node->globalTransform);
+        float4x4 mtxNodeWorld = mul(m_mtxWorld, to_float4x4(GetGlobalTransform(mesh->nodeID)));
 
         mesh->instanceData.scale = max(max(abs(m_scale.x), abs(m_scale.y)), abs(m_scale.z)) * m_boundScaleFactor;
 
@@ -219,15 +303,23 @@ void SkeletalMesh::UpdateMeshConstants(SkeletalMeshNode* node)
         GfxRayTracingInstanceFlag flags = mesh->material->IsFrontFaceCCW() ? GfxRayTracingInstanceFlagFrontFaceCCW : 0;
         mesh->instanceIndex = m_pRenderer->AddInstance(mesh->instanceData, mesh->blas.get(), flags);
 
-        if (mesh->material->IsVertexSkinned())
+        if (mesh->skinned)
         {
-            m_pRenderer->UpdateRayTracingBLAS(mesh->blas.get(), m_pRenderer->GetSceneAnimationBuffer(), mesh->animPosBuffer.offset);
+            m_pRenderer->UpdateRayTracingBLAS(mesh->blas.get(), m_pRenderer->GetSceneAnimationBuffer(), mesh->animPosBuffer.offset, mesh->instanceData.center, mesh->instanceData.radius);
+
+            lod->AddCounter(AnimationLOD::Counter::Skinned);
+            lod->AddCounter(AnimationLOD::Counter::BLASUpdates);
+        }
+        else if (isSkinnedMesh)
+        {
+            lod->AddCounter(AnimationLOD::Counter::SkippedSkinning);
+            lod->AddCounter(AnimationLOD::Counter::SkippedBLASUpdates);
         }
     }
 
     for (size_t i = 0; i < node->children.size(); ++i)
     {
-        UpdateMeshConstants(GetNode(node->children[i]));
+        UpdateMeshConstants(GetNode(node->children[i]), skin);
     }
 }
 
@@ -238,16 +330,15 @@ void SkeletalMesh::Draw(const SkeletalMeshData* mesh)
         return; //todo
     }
 
-    if (mesh->material->IsVertexSkinned())
+    if (mesh->skinned)
     {
-        ComputeBatch& batch = m_pRenderer->AddAnimationBatch();
-        UpdateVertexSkinning(batch, mesh);
+        UpdateVertexSkinning(mesh);
     }
 
     RenderBatch& batch = m_pRenderer->AddBasePassBatch();
     Draw(batch, mesh, mesh->material->GetPSO());
 
-    if (mesh->material->IsVertexSkinned() || !nearly_equal(mesh->instanceData.mtxPrevWorld, mesh->instanceData.mtxWorld))
+    if (mesh->skinned || !nearly_equal(mesh->instanceData.mtxPrevWorld, mesh->instanceData.mtxWorld))
     {
         RenderBatch& velocityPassBatch = m_pRenderer->AddVelocityPassBatch();
         Draw(velocityPassBatch, mesh, mesh->material->GetVelocityPSO());
@@ -266,34 +357,30 @@ void SkeletalMesh::Draw(const SkeletalMeshData* mesh)
     }
 }
 
-void SkeletalMesh::UpdateVertexSkinning(ComputeBatch& batch, const SkeletalMeshData* mesh)
+void SkeletalMesh::UpdateVertexSkinning(const SkeletalMeshData* mesh)
 {
-    batch.label = m_name.c_str();
-    batch.SetPipelineState(mesh->material->GetVertexSkinningPSO());
-
-    uint32_t cb[10] = {
-        mesh->vertexCount,
+    SkinningJob job = {};
+    job.vertexCount = mesh->vertexCount;
+    job.jointIDBufferAddress = mesh->jointIDBuffer.offset;
+    job.jointWeightBufferAddress = mesh->jointWeightBuffer.offset;
 
-        mesh->staticPosBuffer.offset,
-        mesh->staticNormalBuffer.offset,
-        mesh->staticTangentBuffer.offset,
+    job.staticPosBufferAddress = mesh->staticPosBuffer.offset;
+    job.staticNormalBufferAddress = mesh->staticNormalBuffer.offset;
+    job.staticTangentBufferAddress = mesh->staticTangentBuffer.offset;
+    job.jointMatrixBufferAddress = m_pSkeleton->GetJointMatricesAddress();
 
-        mesh->animPosBuffer.offset,
-        mesh->animNormalBuffer.offset,
-        mesh->animTangentBuffer.offset,
+    job.animPosBufferAddress = mesh->animPosBuffer.offset;
+    job.animNormalBufferAddress = mesh->animNormalBuffer.offset;
+    job.animTangentBufferAddress = mesh->animTangentBuffer.offset;
 
-        mesh->jointIDBuffer.offset,
-        mesh->jointWeightBuffer.offset,
-        m_pSkeleton->GetJointMatricesAddress(),
-    };
-
-    batch.SetConstantBuffer(1, cb, sizeof(cb));
-    batch.Dispatch((mesh->vertexCount + 63) / 64, 1, 1);
+    m_pRenderer->AddSkinningJob(job);
 }
 
 void SkeletalMesh::Draw(RenderBatch& batch, const SkeletalMeshData* mesh, IGfxPipelineState* pso)
 {
-    uint32_t root_consts[2] = { mesh->instanceIndex, mesh->prevAnimPosBuffer.offset };
+    //the vertices didn't move if they weren't skinned in this frame
+    uint32_t prevPosBuffer = mesh->skinned ? mesh->prevAnimPosBuffer.offset : mesh->animPosBuffer.offset;
+    uint32_t root_consts[2] = { mesh->instanceIndex, prevPosBuffer };
 
     batch.label = m_name.c_str();
     batch.SetPipelineState(pso);
@@ -307,5 +394,24 @@ void SkeletalMesh::OnGui()
 {
     IVisibleObject::OnGui();
 
-    //todo
+    if (ImGui::CollapsingHeader("SkeletalMesh"))
+    {
+        World* world = Engine::GetInstance()->GetWorld();
+        float screen_size = AnimationLOD::CalcScreenSize(world->GetCamera(), m_pos, m_radius);
+
+        ImGui::Text("Screen Size : %.3f", screen_size);
+        if (m_nLODLevel == AnimationLOD::CULLED_LEVEL)
+        {
+            ImGui::Text("Animation LOD : Culled");
+        }
+        else
+        {
+            ImGui::Text("Animation LOD : %u", m_nLODLevel);
+        }
+    }
+
+    if (ImGui::Button("Benchmark Animation Sampling"))
+    {
+        m_pAnimation->Benchmark(1000, 600);
+    }
 }
\ No newline at end of file
@@ -1,9 +1,10 @@
 #pragma once
 
 #include "visible_object.h"
+#include "animation.h"
+#include "node_hierarchy.h"
 
 class Skeleton;
-class Animation;
 class MeshMaterial;
 
 struct SkeletalMeshData
@@ -35,6 +36,7 @@ struct SkeletalMeshData
 
     InstanceData instanceData = {};
     uint32_t instanceIndex = 0;
+    bool skinned = false; //in this frame, otherwise the skinned vertices of the last skinned frame are reused
 
     float3 center;
     float radius = 0.0;
@@ -54,8 +56,6 @@ struct SkeletalMeshNode
     float3 translation;
     float4 rotation;
     float3 scale;
-
-    float4x4 globalTransform;
 };
 
 class SkeletalMesh : public IVisibleObject
@@ -70,17 +70,22 @@ public:
     virtual void Render(Renderer* pRenderer) override;
     virtual bool FrustumCull(const float4* planes, uint32_t plane_count) const override;
     virtual void OnGui() override;
+    virtual TickPhase GetTickPhase() const override { return TickPhase::Animation; }
+    virtual bool IsParallelSafe() const override { return true; }
 
     SkeletalMeshNode* GetNode(uint32_t node_id) const;
+    const affine3x4& GetGlobalTransform(uint32_t node_id) const;
 
 private:
     void Create(SkeletalMeshData* mesh);
 
-    void UpdateNodeTransform(SkeletalMeshNode* node);
-    void UpdateMeshConstants(SkeletalMeshNode* node);
+    void BuildNodeHierarchy();
+    void ApplyAnimation();
+    void UpdateNodeTransforms();
+    void UpdateMeshConstants(SkeletalMeshNode* node, bool skin);
 
     void Draw(const SkeletalMeshData* mesh);
-    void UpdateVertexSkinning(ComputeBatch& batch, const SkeletalMeshData* mesh);
+    void UpdateVertexSkinning(const SkeletalMeshData* mesh);
     void Draw(RenderBatch& batch, const SkeletalMeshData* mesh, IGfxPipelineState* pso);
 
 private:
@@ -91,9 +96,14 @@ private:
 
     eastl::unique_ptr<Skeleton> m_pSkeleton;
     eastl::unique_ptr<Animation> m_pAnimation;
+    AnimationCursor m_animationCursor;
+    float m_pendingAnimationTime = 0.0f; //accumulated over the frames which didn't sample the animation
+    uint32_t m_nLODLevel = 0;
+    uint32_t m_nFramesSinceUpdate = UINT32_MAX;
 
     eastl::vector<eastl::unique_ptr<SkeletalMeshNode>> m_nodes;
     eastl::vector<uint32_t> m_rootNodes;
+    NodeHierarchy m_hierarchy;
 
     float m_radius = 0.0f;
     float m_boundScaleFactor = 3.0f;
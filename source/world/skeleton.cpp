@@ -8,14 +8,39 @@ Skeleton::Skeleton(const eastl::string& name)
     m_pRenderer = Engine::GetInstance()->GetRenderer();
 }
 
-void Skeleton::Update(const SkeletalMesh* mesh)
+void Skeleton::Update(const SkeletalMesh* mesh, bool snap)
 {
+    m_prevPose.swap(m_pose);
+    m_pose.resize(m_joints.size());
+
     for (size_t i = 0; i < m_joints.size(); ++i)
     {
-        const SkeletalMeshNode* node = mesh->GetNode(m_joints[i]);
+        m_pose[i] = mul(mesh->GetGlobalTransform(m_joints[i]), m_inverseBindMatrices[i]);
+    }
+
+    if (snap || m_prevPose.size() != m_pose.size())
+    {
+        m_prevPose = m_pose;
+    }
+}
+
+void Skeleton::Upload(float alpha)
+{
+    const affine3x4* matrices = m_pose.data();
+
+    if (alpha < 1.0f)
+    {
+        hlslpp::float4 t = hlslpp::float4(alpha);
 
-        m_jointMatrices[i] = mul(node->globalTransform, m_inverseBindMatrices[i]);
+        for (size_t i = 0; i < m_pose.size(); ++i)
+        {
+            for (int row = 0; row < 3; ++row)
+            {
+                m_jointMatrices[i].rows[row] = hlslpp::lerp(m_prevPose[i].rows[row], m_pose[i].rows[row], t);
+            }
+        }
+        matrices = m_jointMatrices.data();
     }
 
-    m_jointMatricesAddress = m_pRenderer->AllocateSceneConstant(m_jointMatrices.data(), sizeof(float4x4) * (uint32_t)m_jointMatrices.size());
+    m_jointMatricesAddress = m_pRenderer->AllocateSceneConstant(matrices, sizeof(affine3x4) * (uint32_t)m_pose.size());
 }
@@ -14,7 +14,13 @@ class Skeleton
 public:
     Skeleton(const eastl::string& name);
 
-    void Update(const SkeletalMesh* mesh);
+    //evaluates the joint matrices from the node transforms of the mesh, the previous pose is kept for Upload.
+    //snap discards the previous pose, e.g. when the last update is too old to blend from
+    void Update(const SkeletalMesh* mesh, bool snap);
+
+    //uploads the pose blended from the previous to the last evaluated one, the matrices are lerped which is
+    //good enough for the small rotations between two updates
+    void Upload(float alpha);
 
     uint32_t GetJointMatricesAddress() const { return m_jointMatricesAddress; }
 
@@ -22,8 +28,11 @@ private:
     Renderer* m_pRenderer;
     eastl::string m_name;
     eastl::vector<uint32_t> m_joints;
-    eastl::vector<float4x4> m_inverseBindMatrices;
+    eastl::vector<affine3x4> m_inverseBindMatrices;
+
+    eastl::vector<affine3x4> m_prevPose;
+    eastl::vector<affine3x4> m_pose;
 
-    eastl::vector<float4x4> m_jointMatrices;
+    eastl::vector<affine3x4> m_jointMatrices; //blended pose, uploaded as 3x4, the shader assumes the last row is (0, 0, 0, 1)
     uint32_t m_jointMatricesAddress;
 };
\ No newline at end of file
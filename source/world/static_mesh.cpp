@@ -28,6 +28,8 @@ StaticMesh::~StaticMesh()
     {
         m_pRigidBody->RemoveFromPhysicsSystem();
     }
+
+    cache->ReleaseMeshShape(m_pShape);
 }
 
 bool StaticMesh::Create()
@@ -57,7 +59,7 @@ bool StaticMesh::Create()
     if (m_pShape)
     {
         IPhysicsSystem* physics = Engine::GetInstance()->GetWorld()->GetPhysicsSystem();
-        m_pRigidBody.reset(physics->CreateRigidBody(m_pShape.get(), PhysicsMotion::Static, PhysicsLayers::STATIC, this));
+        m_pRigidBody.reset(physics->CreateRigidBody(m_pShape, PhysicsMotion::Static, PhysicsLayers::STATIC, this));
         m_pRigidBody->AddToPhysicsSystem(false);
     }
 
@@ -73,8 +75,11 @@ void StaticMesh::Tick(float delta_time)
 
     if (m_pRigidBody && m_pRigidBody->GetMotionType() == PhysicsMotion::Dynamic)
     {
-        m_pos = m_pRigidBody->GetPosition();
-        m_rotation = m_pRigidBody->GetRotation();
+        //physics runs at a fixed rate, the rendered transform is between its last two steps
+        float alpha = Engine::GetInstance()->GetWorld()->GetPhysicsSystem()->GetInterpolationAlpha();
+
+        m_pos = lerp(m_pRigidBody->GetPrevPosition(), m_pRigidBody->GetPosition(), alpha);
+        m_rotation = rotation_slerp(m_pRigidBody->GetPrevRotation(), m_pRigidBody->GetRotation(), alpha);
     }
 
     UpdateConstants();
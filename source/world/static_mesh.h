@@ -20,6 +20,7 @@ public:
     virtual void Render(Renderer* pRenderer) override;
     virtual bool FrustumCull(const float4* planes, uint32_t plane_count) const override;
     virtual void OnGui() override;
+    virtual bool IsParallelSafe() const override { return true; }
 
     virtual void SetPosition(const float3& pos) override;
     virtual void SetRotation(const quaternion& rotation) override;
@@ -41,7 +42,7 @@ private:
     eastl::unique_ptr<MeshMaterial> m_pMaterial = nullptr;
     eastl::unique_ptr<IGfxRayTracingBLAS> m_pBLAS;
     eastl::unique_ptr<IPhysicsRigidBody> m_pRigidBody;
-    eastl::unique_ptr<IPhysicsShape> m_pShape;
+    IPhysicsShape* m_pShape = nullptr; //shared by the instances, owned by the ResourceCache
 
     OffsetAllocator::Allocation m_posBuffer;
     OffsetAllocator::Allocation m_uvBuffer;
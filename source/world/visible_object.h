@@ -3,6 +3,14 @@
 #include "renderer/renderer.h"
 #include "utils/math.h"
 
+//objects tick in the phase they belong to, the objects of a phase are updated in parallel
+enum class TickPhase
+{
+    PrePhysics,  //before the physics step, e.g. to drive kinematic bodies
+    PostPhysics, //after the physics step and the camera update
+    Animation,   //after all PostPhysics objects
+};
+
 class IVisibleObject
 {
 public:
@@ -14,6 +22,12 @@ public:
     virtual bool FrustumCull(const float4* planes, uint32_t plane_count) const { return true; }
     virtual void OnGui();
 
+    virtual TickPhase GetTickPhase() const { return TickPhase::PostPhysics; }
+
+    //Tick and Render of parallel safe objects run on the task threads, the others run on the main thread after them.
+    //they may only call the renderer functions which are allowed in a parallel phase, see Renderer::BeginParallelPhase
+    virtual bool IsParallelSafe() const { return false; }
+
     virtual float3 GetPosition() const { return m_pos; }
     virtual void SetPosition(const float3& pos) { m_pos = pos; }
 
@@ -8,6 +8,8 @@
 #include "static_mesh.h"
 #include "mesh_material.h"
 #include "billboard_sprite.h"
+#include "animation_lod.h"
+#include "resource_cache.h"
 #include "utils/assert.h"
 #include "utils/string.h"
 #include "utils/profiler.h"
@@ -26,6 +28,7 @@ World::World()
     m_pPhysicsSystem->Initialize();
 
     m_pBillboardSpriteRenderer = eastl::make_unique<BillboardSpriteRenderer>(pRenderer);
+    m_pAnimationLOD = eastl::make_unique<AnimationLOD>();
     m_boxShape.reset(m_pPhysicsSystem->CreateBoxShape(float3(1.0f, 1.0f, 1.0f)));
     m_sphereShape.reset(m_pPhysicsSystem->CreateSphereShape(1.0f));
 }
@@ -35,6 +38,7 @@ World::~World() = default;
 void World::LoadScene(const eastl::string& file)
 {
     RE_INFO("Loading Scene : {}", file);
+    MemoryTagScope memoryTag(MemoryTag::World);
 
     tinyxml2::XMLDocument doc;
     if (tinyxml2::XML_SUCCESS != doc.LoadFile(file.c_str()))
@@ -53,6 +57,8 @@ void World::LoadScene(const eastl::string& file)
     }
 
     m_pPhysicsSystem->OptimizeTLAS();
+
+    ResourceCache::GetInstance()->LogStats();
 }
 
 void World::SaveScene(const eastl::string& file)
@@ -70,18 +76,27 @@ void World::AddObject(IVisibleObject* object)
 void World::Tick(float delta_time)
 {
     CPU_EVENT("Tick", "World::Tick");
+    MemoryTagScope memoryTag(MemoryTag::World);
 
     Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
 
+    //publishes the async steps which ran while the last frame was rendered
+    m_pPhysicsSystem->WaitForStep();
+
     PhysicsTest(pRenderer);
 
-    m_pPhysicsSystem->Tick(delta_time);
-    m_pCamera->Tick(delta_time);
+    m_pAnimationLOD->BeginFrame();
 
-    for (auto iter = m_objects.begin(); iter != m_objects.end(); ++iter)
+    TickObjects(TickPhase::PrePhysics, delta_time);
+
+    if (!m_pPhysicsSystem->IsAsyncStepEnabled())
     {
-        (*iter)->Tick(delta_time);
+        m_pPhysicsSystem->Tick(delta_time);
     }
+    m_pCamera->Tick(delta_time);
+
+    TickObjects(TickPhase::PostPhysics, delta_time);
+    TickObjects(TickPhase::Animation, delta_time);
 
     if (pRenderer->GetOutputType() != RendererOutput::Physics)
     {
@@ -99,13 +114,82 @@ void World::Tick(float delta_time)
 
         visibleObjects.resize(visibleCount);
 
-        for (auto iter = visibleObjects.begin(); iter != visibleObjects.end(); ++iter)
+        RenderObjects(visibleObjects);
+    }
+
+    m_pBillboardSpriteRenderer->Render();
+
+    if (m_pPhysicsSystem->IsAsyncStepEnabled())
+    {
+        //the objects see the results in the next frame
+        m_pPhysicsSystem->Tick(delta_time);
+    }
+}
+
+//the objects which aren't parallel safe are updated on the main thread first, then the parallel safe ones on the task threads.
+//the renderer records what they submit per thread and merges it when the phase ends, after the batches of the serial objects,
+//so e.g. the sky is drawn before the outlines of the meshes in the forward pass
+template <typename F>
+inline void RunParallelPhase(Renderer* pRenderer, const eastl::vector<IVisibleObject*>& objects, F fun)
+{
+    eastl::vector<IVisibleObject*> parallelObjects;
+    eastl::vector<IVisibleObject*> serialObjects;
+    parallelObjects.reserve(objects.size());
+
+    for (size_t i = 0; i < objects.size(); ++i)
+    {
+        if (objects[i]->IsParallelSafe())
         {
-            (*iter)->Render(pRenderer);
+            parallelObjects.push_back(objects[i]);
+        }
+        else
+        {
+            serialObjects.push_back(objects[i]);
         }
     }
 
-    m_pBillboardSpriteRenderer->Render();
+    for (size_t i = 0; i < serialObjects.size(); ++i)
+    {
+        fun(serialObjects[i]);
+    }
+
+    if (!parallelObjects.empty())
+    {
+        pRenderer->BeginParallelPhase();
+
+        ParallelFor((uint32_t)parallelObjects.size(), [&](uint32_t i)
+            {
+                MemoryTagScope memoryTag(MemoryTag::World);
+                fun(parallelObjects[i]);
+            });
+
+        pRenderer->EndParallelPhase();
+    }
+}
+
+void World::TickObjects(TickPhase phase, float delta_time)
+{
+    CPU_EVENT("Tick", "World::TickObjects");
+
+    eastl::vector<IVisibleObject*> objects;
+    for (auto iter = m_objects.begin(); iter != m_objects.end(); ++iter)
+    {
+        if ((*iter)->GetTickPhase() == phase)
+        {
+            objects.push_back(iter->get());
+        }
+    }
+
+    Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
+    RunParallelPhase(pRenderer, objects, [&](IVisibleObject* object) { object->Tick(delta_time); });
+}
+
+void World::RenderObjects(const eastl::vector<IVisibleObject*>& objects)
+{
+    CPU_EVENT("Tick", "World::RenderObjects");
+
+    Renderer* pRenderer = Engine::GetInstance()->GetRenderer();
+    RunParallelPhase(pRenderer, objects, [&](IVisibleObject* object) { object->Render(pRenderer); });
 }
 
 IVisibleObject* World::GetVisibleObject(uint32_t index) const
@@ -18,6 +18,7 @@ public:
     Camera* GetCamera() const { return m_pCamera.get(); }
     IPhysicsSystem* GetPhysicsSystem() const { return m_pPhysicsSystem.get(); }
     class BillboardSpriteRenderer* GetBillboardSpriteRenderer() const { return m_pBillboardSpriteRenderer.get(); }
+    class AnimationLOD* GetAnimationLOD() const { return m_pAnimationLOD.get(); }
 
     void LoadScene(const eastl::string& file);
     void SaveScene(const eastl::string& file);
@@ -40,10 +41,14 @@ private:
 
     void PhysicsTest(Renderer* pRenderer);
 
+    void TickObjects(TickPhase phase, float delta_time);
+    void RenderObjects(const eastl::vector<IVisibleObject*>& objects);
+
 private:
     eastl::unique_ptr<Camera> m_pCamera;
     eastl::unique_ptr<IPhysicsSystem> m_pPhysicsSystem;
     eastl::unique_ptr<class BillboardSpriteRenderer> m_pBillboardSpriteRenderer;
+    eastl::unique_ptr<class AnimationLOD> m_pAnimationLOD;
 
     eastl::vector<eastl::unique_ptr<IVisibleObject>> m_objects;
 
@@ -0,0 +1,268 @@
+#include "test.h"
+#include "world/animation.h"
+#include <math.h>
+#include <random>
+
+static const uint32_t ROTATION_COUNT = 10000;
+static const float MAX_ROTATION_ERROR = 2e-4f; //15 bits per component
+static const float MAX_SAMPLE_ERROR = 1e-3f;
+static const float DELTA_TIME = 1.0f / 60.0f;
+
+struct TestChannel
+{
+    AnimationChannelMode mode;
+    eastl::vector<float> times;
+    eastl::vector<float4> values;
+};
+
+static float4 GetRandomRotation(std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+    float4 q;
+    do
+    {
+        q = float4(unit(rng), unit(rng), unit(rng), unit(rng));
+    } while (length(q) < 0.1f);
+    return normalize(q);
+}
+
+//q and -q are the same rotation
+static float GetRotationError(const float4& a, const float4& b)
+{
+    return eastl::min(maxelem(abs(a - b)), maxelem(abs(a + b)));
+}
+
+//key times are uneven, and start at 0 like the gltf clips. the rotation steps are small enough for slerp to be well defined
+static TestChannel CreateRandomChannel(std::mt19937& rng, AnimationChannelMode mode, uint32_t key_count, float end_time)
+{
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> step(0.2f, 1.0f);
+
+    TestChannel channel;
+    channel.mode = mode;
+    channel.times.resize(key_count);
+    channel.values.resize(key_count);
+
+    float time = 0.0f;
+    for (uint32_t i = 0; i < key_count; ++i)
+    {
+        channel.times[i] = time;
+        time += step(rng);
+    }
+    for (uint32_t i = 0; i < key_count; ++i)
+    {
+        channel.times[i] *= key_count > 1 ? end_time / channel.times[key_count - 1] : 0.0f;
+    }
+
+    for (uint32_t i = 0; i < key_count; ++i)
+    {
+        switch (mode)
+        {
+        case AnimationChannelMode::Translation:
+            channel.values[i] = float4(unit(rng), unit(rng), unit(rng), 0.0f) * 2.0f;
+            break;
+        case AnimationChannelMode::Rotation:
+            channel.values[i] = i == 0 ? GetRandomRotation(rng) : normalize(channel.values[i - 1] + GetRandomRotation(rng) * 0.5f);
+            break;
+        case AnimationChannelMode::Scale:
+            channel.values[i] = float4(1.0f + unit(rng) * 0.5f, 1.0f + unit(rng) * 0.5f, 1.0f + unit(rng) * 0.5f, 0.0f);
+            break;
+        default:
+            break;
+        }
+    }
+    return channel;
+}
+
+//decodes nothing and scans from the first key, what the cursors are checked against
+static float4 SampleReference(const TestChannel& channel, float time)
+{
+    uint32_t last = (uint32_t)channel.times.size() - 1;
+    uint32_t lower = 0;
+    while (lower < last && channel.times[lower + 1] <= time)
+    {
+        ++lower;
+    }
+
+    uint32_t upper = eastl::min(lower + 1, last);
+    float t0 = channel.times[lower];
+    float t1 = channel.times[upper];
+    float alpha = t1 > t0 ? clamp((time - t0) / (t1 - t0), 0.0f, 1.0f) : 0.0f;
+
+    if (channel.mode == AnimationChannelMode::Rotation)
+    {
+        //the clip stores the quantized rotations
+        float4 a = DecodeRotation(EncodeRotation(channel.values[lower]));
+        float4 b = DecodeRotation(EncodeRotation(channel.values[upper]));
+        return rotation_slerp(a, b, alpha);
+    }
+    return lerp(channel.values[lower], channel.values[upper], alpha);
+}
+
+//the clip sorts its channels by mode, they are matched to the test channels with their target nodes
+static float GetSampleError(const Animation& animation, const eastl::vector<TestChannel>& channels, const AnimationCursor& cursor)
+{
+    float error = 0.0f;
+    for (uint32_t i = 0; i < animation.GetChannelCount(); ++i)
+    {
+        const TestChannel& channel = channels[animation.GetChannel(i).targetNode];
+        float4 expected = SampleReference(channel, cursor.time);
+        float4 actual = cursor.values[i];
+
+        error = eastl::max(error, channel.mode == AnimationChannelMode::Rotation ? GetRotationError(expected, actual) : maxelem(abs(expected.xyz() - actual.xyz())));
+    }
+    return error;
+}
+
+static void TestRotationCodec()
+{
+    std::mt19937 rng(42);
+    for (uint32_t i = 0; i < ROTATION_COUNT; ++i)
+    {
+        float4 q = GetRandomRotation(rng);
+        float4 decoded = DecodeRotation(EncodeRotation(q));
+
+        TEST_CHECK(GetRotationError(q, decoded) < MAX_ROTATION_ERROR);
+        TEST_CHECK(fabsf(length(decoded) - 1.0f) < MAX_ROTATION_ERROR);
+    }
+
+    //each component as the largest one, positive and negative. a negative largest component is decoded as -q
+    for (uint32_t largest = 0; largest < 4; ++largest)
+    {
+        for (float sign : { 1.0f, -1.0f })
+        {
+            float4 q(0.3f, -0.2f, 0.1f, 0.25f);
+            q[largest] = sign * 0.8f;
+            q = normalize(q);
+
+            float4 decoded = DecodeRotation(EncodeRotation(q));
+            TEST_CHECK(maxelem(abs(decoded - q * sign)) < MAX_ROTATION_ERROR);
+            TEST_CHECK(decoded[largest] > 0.0f);
+        }
+    }
+
+    //the other components at the ends of their range, and ties for the largest one
+    const float4 edges[] =
+    {
+        float4(0.0f, 0.0f, 0.0f, 1.0f),
+        float4(0.0f, 0.0f, 0.0f, -1.0f),
+        float4(0.70710678f, 0.70710678f, 0.0f, 0.0f),
+        float4(-0.70710678f, 0.0f, 0.0f, 0.70710678f),
+        float4(0.5f, -0.5f, 0.5f, -0.5f),
+        float4(-0.5f, -0.5f, -0.5f, -0.5f),
+    };
+    for (const float4& q : edges)
+    {
+        TEST_CHECK(GetRotationError(q, DecodeRotation(EncodeRotation(q))) < MAX_ROTATION_ERROR);
+    }
+}
+
+int main()
+{
+    TestEnvironment environment;
+
+    TestRotationCodec();
+
+    //more than 4 channels of a mode, so the sampling takes several SIMD batches, with a partly filled last one.
+    //some channels end before the clip does, and one has a single key
+    std::mt19937 rng(7);
+    eastl::vector<TestChannel> channels;
+    for (uint32_t i = 0; i < 6; ++i)
+    {
+        channels.push_back(CreateRandomChannel(rng, AnimationChannelMode::Rotation, 2 + rng() % 60, i == 0 ? 2.0f : 1.0f + i * 0.15f));
+    }
+    for (uint32_t i = 0; i < 5; ++i)
+    {
+        channels.push_back(CreateRandomChannel(rng, AnimationChannelMode::Translation, 2 + rng() % 60, 1.5f + i * 0.1f));
+    }
+    channels.push_back(CreateRandomChannel(rng, AnimationChannelMode::Scale, 40, 2.0f));
+    channels.push_back(CreateRandomChannel(rng, AnimationChannelMode::Scale, 1, 0.0f));
+
+    //added interleaved by mode, the clip sorts them
+    Animation animation("test");
+    for (uint32_t i = 0; i < (uint32_t)channels.size(); ++i)
+    {
+        uint32_t index = (i * 5) % (uint32_t)channels.size();
+        const TestChannel& channel = channels[index];
+        animation.AddChannel(index, channel.mode, channel.times.data(), channel.values.data(), (uint32_t)channel.times.size());
+    }
+    TEST_CHECK(animation.GetChannelCount() == channels.size());
+    TEST_CHECK(animation.GetDuration() == 2.0f);
+
+    for (uint32_t i = 1; i < animation.GetChannelCount(); ++i)
+    {
+        TEST_CHECK(animation.GetChannel(i - 1).mode <= animation.GetChannel(i).mode);
+    }
+
+    //forward playback, wrapping around at the end of the clip a few times
+    {
+        AnimationCursor cursor;
+        animation.InitCursor(cursor);
+
+        uint32_t wrapCount = 0;
+        for (uint32_t frame = 0; frame < 600; ++frame)
+        {
+            float previousTime = cursor.time;
+            animation.Advance(cursor, DELTA_TIME);
+
+            TEST_CHECK(cursor.time >= 0.0f && cursor.time <= animation.GetDuration());
+            if (cursor.time < previousTime)
+            {
+                TEST_CHECK(fabsf(cursor.time - (previousTime + DELTA_TIME - animation.GetDuration())) < 1e-4f);
+                ++wrapCount;
+            }
+
+            TEST_CHECK(GetSampleError(animation, channels, cursor) < MAX_SAMPLE_ERROR);
+        }
+        TEST_CHECK(wrapCount == 4);
+    }
+
+    //the clip end, right before and after the wrap
+    {
+        AnimationCursor cursor;
+        animation.InitCursor(cursor);
+
+        animation.Sample(cursor, animation.GetDuration() - 0.01f);
+        TEST_CHECK(GetSampleError(animation, channels, cursor) < MAX_SAMPLE_ERROR);
+
+        animation.Advance(cursor, 0.03f);
+        TEST_CHECK(fabsf(cursor.time - 0.02f) < 1e-4f);
+        TEST_CHECK(GetSampleError(animation, channels, cursor) < MAX_SAMPLE_ERROR);
+    }
+
+    //playing backwards seeks every frame
+    {
+        AnimationCursor cursor;
+        animation.InitCursor(cursor);
+
+        for (float time = animation.GetDuration(); time >= 0.0f; time -= DELTA_TIME)
+        {
+            animation.Sample(cursor, time);
+            TEST_CHECK(GetSampleError(animation, channels, cursor) < MAX_SAMPLE_ERROR);
+        }
+    }
+
+    //random seeks, back and far ahead, including past the end and before the first key
+    {
+        std::uniform_real_distribution<float> time(-0.1f, animation.GetDuration() + 0.1f);
+
+        AnimationCursor cursor;
+        animation.InitCursor(cursor);
+
+        for (uint32_t i = 0; i < 1000; ++i)
+        {
+            animation.Sample(cursor, time(rng));
+            TEST_CHECK(GetSampleError(animation, channels, cursor) < MAX_SAMPLE_ERROR);
+        }
+    }
+
+    //the benchmark of the editor, it checks its 1000 cursors against its own linear scan
+    {
+        Animation::BenchmarkResult result = animation.Benchmark(1000, 60);
+        TEST_CHECK(result.cursorTime > 0.0 && result.scanTime > 0.0);
+        TEST_CHECK(result.maxError < MAX_SAMPLE_ERROR);
+    }
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,166 @@
+#include "test.h"
+#include "renderer/blas_refit_scheduler.h"
+#include "gfx/mock/mock_device.h"
+#include "EASTL/unique_ptr.h"
+
+static const uint32_t BLAS_COUNT = 16;
+static const uint32_t BLAS_VERTEX_COUNT = 1000;
+static const uint32_t FRAME_COUNT = 400;
+
+//like the skinned meshes : the BLAS is built from one position buffer, and the skinning ping-pongs between two of them
+static uint32_t GetBuildOffset(uint32_t blas)
+{
+    return blas * BLAS_VERTEX_COUNT * 2 * sizeof(float3);
+}
+
+static uint32_t GetSkinnedOffset(uint32_t blas, uint64_t frame)
+{
+    return GetBuildOffset(blas) + (frame & 1 ? BLAS_VERTEX_COUNT * sizeof(float3) : 0);
+}
+
+static uint32_t FindBLAS(IGfxRayTracingBLAS* const* blases, const IGfxRayTracingBLAS* blas)
+{
+    for (uint32_t i = 0; i < BLAS_COUNT; ++i)
+    {
+        if (blases[i] == blas)
+        {
+            return i;
+        }
+    }
+    return BLAS_COUNT;
+}
+
+int main()
+{
+    TestEnvironment environment;
+
+    GfxDeviceDesc desc;
+    desc.backend = GfxRenderBackend::Mock;
+    MockDevice device(desc);
+    TEST_CHECK(device.Create());
+
+    GfxBufferDesc bufferDesc;
+    bufferDesc.size = GetBuildOffset(BLAS_COUNT);
+    eastl::unique_ptr<IGfxBuffer> vertexBuffer(device.CreateBuffer(bufferDesc, "vertex buffer"));
+
+    eastl::unique_ptr<IGfxRayTracingBLAS> blasObjects[BLAS_COUNT];
+    IGfxRayTracingBLAS* blases[BLAS_COUNT];
+    for (uint32_t i = 0; i < BLAS_COUNT; ++i)
+    {
+        GfxRayTracingGeometry geometry;
+        geometry.vertex_buffer = vertexBuffer.get();
+        geometry.vertex_buffer_offset = GetBuildOffset(i);
+        geometry.vertex_count = BLAS_VERTEX_COUNT;
+
+        GfxRayTracingBLASDesc blasDesc;
+        blasDesc.geometries.push_back(geometry);
+
+        blasObjects[i].reset(device.CreateRayTracingBLAS(blasDesc, "blas"));
+        blases[i] = blasObjects[i].get();
+    }
+
+    BLASRefitScheduler scheduler;
+    BLASRefitScheduler::Settings& settings = scheduler.GetSettings();
+    settings.maxRefits = 4;
+    settings.maxRebuilds = 1;
+    settings.rebuildInterval = 10;
+    settings.vertexBudget = BLAS_COUNT * BLAS_VERTEX_COUNT;
+
+    //the BLASes are lined up in front of the camera, the first one is the closest
+    const float3 cameraPos(0.0f, 0.0f, 0.0f);
+
+    uint32_t refitCount[BLAS_COUNT] = {};
+    uint32_t rebuildCount[BLAS_COUNT] = {};
+    uint32_t refitsSinceRebuild[BLAS_COUNT] = {};
+    uint32_t maxRefitsBeforeRebuild = 0;
+
+    eastl::vector<BLASRefitScheduler::Request> refits;
+    eastl::vector<IGfxRayTracingBLAS*> rebuilds;
+
+    for (uint64_t frame = 1; frame <= FRAME_COUNT; ++frame)
+    {
+        for (uint32_t i = 0; i < BLAS_COUNT; ++i)
+        {
+            scheduler.AddRequest({ blases[i], vertexBuffer.get(), GetSkinnedOffset(i, frame), float3((i + 1) * 5.0f, 0.0f, 0.0f), 1.0f });
+        }
+
+        refits.clear();
+        rebuilds.clear();
+        scheduler.Schedule(frame, cameraPos, refits, rebuilds);
+
+        TEST_CHECK(refits.size() + rebuilds.size() <= settings.maxRefits);
+        TEST_CHECK(rebuilds.size() <= settings.maxRebuilds);
+
+        for (size_t i = 0; i < refits.size(); ++i)
+        {
+            uint32_t blas = FindBLAS(blases, refits[i].blas);
+            TEST_CHECK(blas < BLAS_COUNT);
+            TEST_CHECK(refits[i].vertex_buffer_offset == GetSkinnedOffset(blas, frame));
+
+            refitCount[blas]++;
+            refitsSinceRebuild[blas]++;
+            maxRefitsBeforeRebuild = eastl::max(maxRefitsBeforeRebuild, refitsSinceRebuild[blas]);
+        }
+
+        for (size_t i = 0; i < rebuilds.size(); ++i)
+        {
+            uint32_t blas = FindBLAS(blases, rebuilds[i]);
+            TEST_CHECK(blas < BLAS_COUNT);
+
+            //a rebuild reads the build buffer, which only holds this frame's vertices every other frame
+            TEST_CHECK(GetSkinnedOffset(blas, frame) == GetBuildOffset(blas));
+            TEST_CHECK(refitsSinceRebuild[blas] >= settings.rebuildInterval);
+
+            rebuildCount[blas]++;
+            refitsSinceRebuild[blas] = 0;
+        }
+    }
+
+    //the far BLASes are refit less often, but still refit and rebuilt
+    for (uint32_t i = 0; i < BLAS_COUNT; ++i)
+    {
+        TEST_CHECK(refitCount[i] > 0);
+        TEST_CHECK(rebuildCount[i] > 0);
+    }
+    TEST_CHECK(refitCount[0] > refitCount[BLAS_COUNT - 1]);
+
+    //a due rebuild waits for a matching frame and a free rebuild slot, but not for long
+    TEST_CHECK(maxRefitsBeforeRebuild <= settings.rebuildInterval + BLAS_COUNT);
+
+    //the vertex budget limits the work of a frame
+    settings.vertexBudget = BLAS_VERTEX_COUNT * 5 / 2;
+    for (uint32_t i = 0; i < BLAS_COUNT; ++i)
+    {
+        scheduler.AddRequest({ blases[i], vertexBuffer.get(), GetSkinnedOffset(i, FRAME_COUNT + 1), float3(1.0f, 0.0f, 0.0f), 1.0f });
+    }
+
+    refits.clear();
+    rebuilds.clear();
+    scheduler.Schedule(FRAME_COUNT + 1, cameraPos, refits, rebuilds);
+    TEST_CHECK(refits.size() + rebuilds.size() == 2);
+    TEST_CHECK(scheduler.GetStats().skipped == BLAS_COUNT - 2);
+    TEST_CHECK(scheduler.GetStats().vertices == BLAS_VERTEX_COUNT * 2);
+
+    //a BLAS larger than the budget is still refit when it comes first
+    settings.vertexBudget = BLAS_VERTEX_COUNT / 2;
+    for (uint32_t i = 0; i < BLAS_COUNT; ++i)
+    {
+        scheduler.AddRequest({ blases[i], vertexBuffer.get(), GetSkinnedOffset(i, FRAME_COUNT + 2), float3(1.0f, 0.0f, 0.0f), 1.0f });
+    }
+
+    refits.clear();
+    rebuilds.clear();
+    scheduler.Schedule(FRAME_COUNT + 2, cameraPos, refits, rebuilds);
+    TEST_CHECK(refits.size() + rebuilds.size() == 1);
+
+    //BLASes which aren't requested any more are forgotten
+    TEST_CHECK(scheduler.GetTrackedCount() == BLAS_COUNT);
+
+    refits.clear();
+    rebuilds.clear();
+    scheduler.Schedule(FRAME_COUNT + 1000, cameraPos, refits, rebuilds);
+    TEST_CHECK(refits.empty() && rebuilds.empty());
+    TEST_CHECK(scheduler.GetTrackedCount() == 0);
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,148 @@
+#include "test.h"
+#include "gfx/mock/mock_device.h"
+#include "EASTL/vector.h"
+
+//every sub-allocator stands for a command list recorded on its own thread, like the parallel render passes.
+//together they need several pages per frame, so the overflow pages are created while the other threads allocate.
+//plain threads instead of the task scheduler, which doesn't split the work on machines with a single core
+static const uint32_t COMMAND_LIST_COUNT = 64;
+static const uint32_t ALLOCATIONS_PER_LIST = 1000;
+static const uint32_t MAX_CONSTANT_SIZE = 1024;
+static const uint32_t MOCK_CONSTANT_ALIGNMENT = 256;
+
+struct ConstantAllocation
+{
+    const uint32_t* address;
+    uint32_t size;
+    uint32_t seed;
+};
+
+static uint32_t GetConstantSize(uint32_t list, uint32_t index)
+{
+    return 16 * (1 + (list * 31 + index * 7) % (MAX_CONSTANT_SIZE / 16));
+}
+
+static uint32_t GetConstantValue(uint32_t seed, uint32_t i)
+{
+    return seed * 2654435761u + i;
+}
+
+static void RecordConstants(MockDevice* device, GfxConstantBufferSubAllocator& allocator, uint32_t list, uint32_t frame, eastl::vector<ConstantAllocation>& allocations)
+{
+    uint32_t data[MAX_CONSTANT_SIZE / sizeof(uint32_t)];
+
+    for (uint32_t i = 0; i < ALLOCATIONS_PER_LIST; ++i)
+    {
+        ConstantAllocation allocation;
+        allocation.size = GetConstantSize(list, i);
+        allocation.seed = (frame << 24) | (list << 12) | i;
+
+        for (uint32_t j = 0; j < allocation.size / sizeof(uint32_t); ++j)
+        {
+            data[j] = GetConstantValue(allocation.seed, j);
+        }
+
+        allocation.address = (const uint32_t*)device->AllocateConstantBuffer(allocator, data, allocation.size);
+        allocations.push_back(allocation);
+    }
+}
+
+//a block handed to two command lists, or to two allocations of one list, shows up as overwritten data
+static void CheckConstants(const eastl::vector<ConstantAllocation>& allocations)
+{
+    for (size_t i = 0; i < allocations.size(); ++i)
+    {
+        const ConstantAllocation& allocation = allocations[i];
+        TEST_CHECK(allocation.address != nullptr);
+        if (allocation.address == nullptr)
+        {
+            continue;
+        }
+
+        TEST_CHECK((uint64_t)allocation.address % MOCK_CONSTANT_ALIGNMENT == 0);
+
+        bool intact = true;
+        for (uint32_t j = 0; j < allocation.size / sizeof(uint32_t); ++j)
+        {
+            intact &= allocation.address[j] == GetConstantValue(allocation.seed, j);
+        }
+        TEST_CHECK(intact);
+    }
+}
+
+int main()
+{
+    TestEnvironment environment;
+
+    GfxDeviceDesc desc;
+    desc.backend = GfxRenderBackend::Mock;
+    MockDevice device(desc);
+    TEST_CHECK(device.Create());
+
+    //the sub-allocators live as long as the command lists, their blocks are invalidated when a frame's allocator is reset
+    eastl::vector<GfxConstantBufferSubAllocator> subAllocators(COMMAND_LIST_COUNT);
+
+    for (uint32_t frame = 0; frame < GFX_MAX_INFLIGHT_FRAMES * 3; ++frame)
+    {
+        device.BeginFrame();
+
+        eastl::vector<eastl::vector<ConstantAllocation>> allocations(COMMAND_LIST_COUNT);
+
+        eastl::vector<std::thread> threads;
+        for (uint32_t i = 0; i < COMMAND_LIST_COUNT; ++i)
+        {
+            threads.push_back(StartTestThread([&, i]()
+                {
+                    RecordConstants(&device, subAllocators[i], i, frame, allocations[i]);
+                }));
+        }
+
+        for (uint32_t i = 0; i < COMMAND_LIST_COUNT; ++i)
+        {
+            threads[i].join();
+        }
+
+        for (uint32_t i = 0; i < COMMAND_LIST_COUNT; ++i)
+        {
+            CheckConstants(allocations[i]);
+        }
+
+        device.EndFrame();
+    }
+
+    //once every page is used the allocations fail instead of overwriting the data of the frame, and the next frame starts over
+    {
+        device.BeginFrame();
+
+        GfxConstantBufferSubAllocator allocator;
+        uint32_t data[MAX_CONSTANT_SIZE / sizeof(uint32_t)] = {};
+
+        uint64_t allocatedSize = 0;
+        while (device.AllocateConstantBuffer(allocator, data, sizeof(data)) != nullptr)
+        {
+            allocatedSize += sizeof(data);
+            TEST_CHECK(allocatedSize <= 1024ull * 1024 * 1024);
+            if (allocatedSize > 1024ull * 1024 * 1024)
+            {
+                break;
+            }
+        }
+        TEST_CHECK(allocatedSize >= 8 * 1024 * 1024);
+        TEST_CHECK(device.AllocateConstantBuffer(allocator, data, sizeof(data)) == nullptr);
+
+        device.EndFrame();
+
+        //the exhausted allocator is reset when its frame index comes back
+        for (uint32_t i = 0; i < GFX_MAX_INFLIGHT_FRAMES - 1; ++i)
+        {
+            device.BeginFrame();
+            device.EndFrame();
+        }
+
+        device.BeginFrame();
+        TEST_CHECK(device.AllocateConstantBuffer(allocator, data, sizeof(data)) != nullptr);
+        device.EndFrame();
+    }
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,153 @@
+#include "test.h"
+#include "gfx/gfx_command_replay.h"
+#include "gfx/mock/mock_device.h"
+#include "EASTL/unique_ptr.h"
+#include <fstream>
+
+//gfx_replay is run on this capture after the test
+static const char* CAPTURE_FILE = "gfx_command_replay_test.capture";
+static const uint32_t DRAW_COUNT = 16;
+
+//the resource ids follow the order in which the resources are first used
+static const uint32_t TEXTURE_ID = 1;
+static const uint32_t BUFFER_ID = 3;
+
+static bool CaptureFrame(MockDevice* device)
+{
+    GfxCommandCapture capture(GfxRenderBackend::Mock, nullptr);
+
+    GfxTextureDesc textureDesc;
+    textureDesc.width = 256;
+    textureDesc.height = 256;
+    textureDesc.usage = GfxTextureUsageRenderTarget;
+    eastl::unique_ptr<IGfxTexture> texture(device->CreateTexture(textureDesc, "render target"));
+
+    GfxGraphicsPipelineDesc psoDesc;
+    eastl::unique_ptr<IGfxPipelineState> pso(device->CreateGraphicsPipelineState(psoDesc, "pso"));
+
+    GfxBufferDesc bufferDesc;
+    bufferDesc.size = 1024;
+    eastl::unique_ptr<IGfxBuffer> indexBuffer(device->CreateBuffer(bufferDesc, "index buffer"));
+
+    eastl::unique_ptr<IGfxCommandList> pCommandList(new GfxCaptureCommandList(device->CreateCommandList(GfxCommandQueue::Graphics, "command list"), &capture));
+
+    device->BeginFrame();
+    capture.BeginFrame();
+
+    pCommandList->ResetAllocator();
+    pCommandList->Begin();
+    pCommandList->TextureBarrier(texture.get(), GFX_ALL_SUB_RESOURCE, GfxAccessPresent, GfxAccessRTV);
+
+    GfxRenderPassDesc renderPass;
+    renderPass.color[0].texture = texture.get();
+    pCommandList->BeginRenderPass(renderPass);
+    pCommandList->SetPipelineState(pso.get());
+    pCommandList->SetIndexBuffer(indexBuffer.get(), 0, GfxFormat::R16UI);
+
+    for (uint32_t i = 0; i < DRAW_COUNT; ++i)
+    {
+        uint32_t constants[4] = { i, 0, 0, 0 };
+        pCommandList->SetGraphicsConstants(0, constants, sizeof(constants));
+        pCommandList->DrawIndexed(36);
+    }
+
+    pCommandList->EndRenderPass();
+    pCommandList->End();
+    pCommandList->Submit();
+
+    bool saved = capture.EndFrame(CAPTURE_FILE);
+    device->EndFrame();
+    return saved;
+}
+
+static eastl::vector<uint8_t> ReadFile(const char* file)
+{
+    std::ifstream stream(file, std::ios::binary | std::ios::ate);
+    eastl::vector<uint8_t> data((size_t)stream.tellg());
+    stream.seekg(0);
+    stream.read((char*)data.data(), data.size());
+    return data;
+}
+
+static void WriteFile(const char* file, const eastl::vector<uint8_t>& data)
+{
+    std::ofstream stream(file, std::ios::binary);
+    stream.write((const char*)data.data(), data.size());
+}
+
+//replaces the buffer of the SetIndexBuffer command with another id, like a corrupted capture would
+static bool PatchIndexBuffer(eastl::vector<uint8_t>& data, uint32_t id)
+{
+    GfxCaptureHeader header;
+    memcpy(&header, data.data(), sizeof(header));
+
+    uint8_t pattern[9];
+    pattern[0] = (uint8_t)GfxCaptureCommand::SetIndexBuffer;
+    memset(pattern + 1, 0, sizeof(uint32_t)); //the command list is the first resource
+    memcpy(pattern + 5, &BUFFER_ID, sizeof(uint32_t));
+
+    for (size_t i = sizeof(header) + header.resourceTableSize; i + sizeof(pattern) <= data.size(); ++i)
+    {
+        if (memcmp(data.data() + i, pattern, sizeof(pattern)) == 0)
+        {
+            memcpy(data.data() + i + 5, &id, sizeof(uint32_t));
+            return true;
+        }
+    }
+    return false;
+}
+
+int main()
+{
+    TestEnvironment environment;
+
+    GfxDeviceDesc desc;
+    desc.backend = GfxRenderBackend::Mock;
+    MockDevice device(desc);
+    TEST_CHECK(device.Create());
+
+    TEST_CHECK(CaptureFrame(&device));
+
+    {
+        GfxCommandReplay replay(&device);
+        TEST_CHECK(replay.Load(CAPTURE_FILE));
+        TEST_CHECK(replay.Replay(4));
+
+        TEST_CHECK(replay.GetStats(GfxCaptureCommand::DrawIndexed).count == DRAW_COUNT * 4);
+        TEST_CHECK(replay.GetStats(GfxCaptureCommand::DrawIndexed).skipped == 0);
+        TEST_CHECK(replay.GetStats(GfxCaptureCommand::SetGraphicsConstants).count == DRAW_COUNT * 4);
+        TEST_CHECK(replay.GetStats(GfxCaptureCommand::SetIndexBuffer).count == 4);
+        TEST_CHECK(replay.GetStats(GfxCaptureCommand::BeginRenderPass).count == 4);
+        TEST_CHECK(replay.GetStats(GfxCaptureCommand::TextureBarrier).count == 4);
+        TEST_CHECK(replay.GetStats(GfxCaptureCommand::Submit).count == 4);
+    }
+
+    const eastl::vector<uint8_t> data = ReadFile(CAPTURE_FILE);
+
+    //a texture where the command expects a buffer stops the replay instead of calling into the wrong object
+    {
+        eastl::vector<uint8_t> corrupted = data;
+        TEST_CHECK(PatchIndexBuffer(corrupted, TEXTURE_ID));
+        WriteFile("gfx_command_replay_test_kind.capture", corrupted);
+
+        GfxCommandReplay replay(&device);
+        TEST_CHECK(replay.Load("gfx_command_replay_test_kind.capture"));
+        TEST_CHECK(!replay.Replay(4));
+        TEST_CHECK(replay.GetStats(GfxCaptureCommand::SetIndexBuffer).count == 0);
+        TEST_CHECK(replay.GetStats(GfxCaptureCommand::DrawIndexed).count == 0);
+    }
+
+    //and so does an id which isn't in the resource table
+    {
+        eastl::vector<uint8_t> corrupted = data;
+        TEST_CHECK(PatchIndexBuffer(corrupted, 1000));
+        WriteFile("gfx_command_replay_test_range.capture", corrupted);
+
+        GfxCommandReplay replay(&device);
+        TEST_CHECK(replay.Load("gfx_command_replay_test_range.capture"));
+        TEST_CHECK(!replay.Replay(4));
+        TEST_CHECK(replay.GetStats(GfxCaptureCommand::DrawIndexed).count == 0);
+    }
+
+    return TEST_RESULT();
+}
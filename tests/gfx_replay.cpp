@@ -0,0 +1,40 @@
+#include "test.h"
+#include "gfx/gfx_command_replay.h"
+#include "gfx/mock/mock_device.h"
+#include "utils/log.h"
+#include <stdlib.h>
+
+//replays a capture of the renderer on the mock device and prints the cpu time of each command type,
+//so the gfx layer overhead can be measured on platforms without a gpu backend
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        printf("usage : gfx_replay <capture file> [iterations]\n");
+        return 1;
+    }
+
+    TestEnvironment environment;
+    spdlog::set_pattern("%v");
+
+    uint32_t iterations = argc > 2 ? (uint32_t)atoi(argv[2]) : 100;
+
+    GfxDeviceDesc desc;
+    desc.backend = GfxRenderBackend::Mock;
+    MockDevice device(desc);
+    if (!device.Create())
+    {
+        return 1;
+    }
+
+    GfxCommandReplay replay(&device);
+    if (!replay.Load(argv[1]))
+    {
+        return 1;
+    }
+
+    bool result = replay.Replay(iterations);
+    replay.LogStats();
+
+    return result ? 0 : 1;
+}
@@ -0,0 +1,112 @@
+#include "test.h"
+#include "physics/jolt/jolt_shape.h"
+#include "Jolt/RegisterTypes.h"
+#include "Jolt/Core/Factory.h"
+#include <random>
+
+static const uint32_t GRID_SIZE = 32; //quads per side
+static const float MAX_BOUNDS_ERROR = 0.05f;
+
+//a height field as an indexed triangle list, like the meshes the resource cache bakes
+template<typename T>
+static void CreateGrid(std::mt19937& rng, eastl::vector<float3>& vertices, eastl::vector<T>& indices)
+{
+    std::uniform_real_distribution<float> height(-1.0f, 1.0f);
+
+    for (uint32_t z = 0; z <= GRID_SIZE; ++z)
+    {
+        for (uint32_t x = 0; x <= GRID_SIZE; ++x)
+        {
+            vertices.push_back(float3((float)x, height(rng), (float)z));
+        }
+    }
+
+    for (uint32_t z = 0; z < GRID_SIZE; ++z)
+    {
+        for (uint32_t x = 0; x < GRID_SIZE; ++x)
+        {
+            T i = (T)(z * (GRID_SIZE + 1) + x);
+            T quad[6] = { i, (T)(i + GRID_SIZE + 1), (T)(i + 1), (T)(i + 1), (T)(i + GRID_SIZE + 1), (T)(i + GRID_SIZE + 2) };
+            indices.insert(indices.end(), quad, quad + 6);
+        }
+    }
+}
+
+static bool IsSameBounds(const JPH::AABox& a, const JPH::AABox& b)
+{
+    return a.mMin == b.mMin && a.mMax == b.mMax;
+}
+
+//bakes the mesh, saves it and loads it back like the disk cache of the mesh shapes
+static void TestRoundTrip(const JoltShape& baked, uint32_t triangle_count)
+{
+    TEST_CHECK(baked.GetShape()->GetStats().mNumTriangles == triangle_count);
+
+    eastl::vector<uint8_t> data;
+    TEST_CHECK(baked.Save(data));
+    TEST_CHECK(!data.empty());
+
+    JoltShape loaded;
+    TEST_CHECK(loaded.Load(data.data(), (uint32_t)data.size()));
+    if (loaded.GetShape() == nullptr)
+    {
+        return;
+    }
+
+    TEST_CHECK(loaded.GetShape()->GetSubType() == baked.GetShape()->GetSubType());
+    TEST_CHECK(IsSameBounds(loaded.GetShape()->GetLocalBounds(), baked.GetShape()->GetLocalBounds()));
+    TEST_CHECK(loaded.GetShape()->GetStats().mNumTriangles == triangle_count);
+    TEST_CHECK(!loaded.IsConvexShape());
+
+    //a truncated cache file is rejected, the cache bakes the shape again
+    JoltShape truncated;
+    TEST_CHECK(!truncated.Load(data.data(), (uint32_t)data.size() / 2));
+    TEST_CHECK(!truncated.Load(data.data(), 0));
+}
+
+int main()
+{
+    TestEnvironment environment;
+
+    JPH::RegisterDefaultAllocator();
+    JPH::Factory::sInstance = new JPH::Factory();
+    JPH::RegisterTypes();
+
+    {
+        std::mt19937 rng(42);
+        const uint32_t triangleCount = GRID_SIZE * GRID_SIZE * 2;
+
+        eastl::vector<float3> vertices;
+        eastl::vector<uint32_t> indices;
+        CreateGrid(rng, vertices, indices);
+
+        JoltShape shape;
+        TEST_CHECK(shape.CreateMesh(&vertices[0].x, sizeof(float3), (uint32_t)vertices.size(), indices.data(), (uint32_t)indices.size(), false));
+        TestRoundTrip(shape, triangleCount);
+
+        //the tree stores its bounds as half floats rounded outwards, so they are a bit larger than the vertices'
+        JPH::AABox bounds;
+        for (size_t i = 0; i < vertices.size(); ++i)
+        {
+            bounds.Encapsulate(JPH::Vec3(vertices[i].x, vertices[i].y, vertices[i].z));
+        }
+        JPH::AABox shapeBounds = shape.GetShape()->GetLocalBounds();
+        TEST_CHECK(shapeBounds.Contains(bounds));
+        TEST_CHECK(shapeBounds.mMin.IsClose(bounds.mMin, MAX_BOUNDS_ERROR * MAX_BOUNDS_ERROR));
+        TEST_CHECK(shapeBounds.mMax.IsClose(bounds.mMax, MAX_BOUNDS_ERROR * MAX_BOUNDS_ERROR));
+
+        eastl::vector<float3> vertices16;
+        eastl::vector<uint16_t> indices16;
+        CreateGrid(rng, vertices16, indices16);
+
+        JoltShape shape16;
+        TEST_CHECK(shape16.CreateMesh(&vertices16[0].x, sizeof(float3), (uint32_t)vertices16.size(), indices16.data(), (uint32_t)indices16.size(), true));
+        TestRoundTrip(shape16, triangleCount);
+    }
+
+    JPH::UnregisterTypes();
+    delete JPH::Factory::sInstance;
+    JPH::Factory::sInstance = nullptr;
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,124 @@
+#include "test.h"
+#include "world/node_hierarchy.h"
+#include <random>
+
+static const uint32_t HIERARCHY_COUNT = 200;
+static const uint32_t MAX_NODE_COUNT = 100;
+static const float MAX_ERROR = 1e-4f;
+
+struct TestNode
+{
+    uint32_t parent;
+    float3 translation;
+    float4 rotation;
+    float3 scale;
+};
+
+//a forest with parents in random order, so a parent often has a larger id than its children
+static eastl::vector<TestNode> CreateRandomHierarchy(std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> scale(0.5f, 1.5f);
+
+    uint32_t nodeCount = 1 + rng() % MAX_NODE_COUNT;
+
+    eastl::vector<uint32_t> ids(nodeCount);
+    for (uint32_t i = 0; i < nodeCount; ++i)
+    {
+        ids[i] = i;
+    }
+    for (uint32_t i = nodeCount - 1; i > 0; --i)
+    {
+        eastl::swap(ids[i], ids[rng() % (i + 1)]);
+    }
+
+    eastl::vector<TestNode> nodes(nodeCount);
+    for (uint32_t i = 0; i < nodeCount; ++i)
+    {
+        TestNode& node = nodes[ids[i]];
+        node.parent = i == 0 || rng() % 8 == 0 ? UINT32_MAX : ids[rng() % i];
+        node.translation = float3(unit(rng), unit(rng), unit(rng)) * 2.0f;
+        node.rotation = normalize(float4(unit(rng), unit(rng), unit(rng), unit(rng)));
+        node.scale = float3(scale(rng), scale(rng), scale(rng));
+    }
+    return nodes;
+}
+
+static float4x4 GetLocalMatrix(const TestNode& node)
+{
+    return mul(translation_matrix(node.translation), mul(rotation_matrix(node.rotation), scaling_matrix(node.scale)));
+}
+
+//the global transform walking up the parents, with the 4x4 matrices the node transforms were computed with before affine3x4
+static float4x4 GetReferenceTransform(const eastl::vector<TestNode>& nodes, uint32_t node_id)
+{
+    const TestNode& node = nodes[node_id];
+    float4x4 local = GetLocalMatrix(node);
+
+    return node.parent == UINT32_MAX ? local : mul(GetReferenceTransform(nodes, node.parent), local);
+}
+
+//relative to the largest element, the scales multiply along deep chains
+static float GetError(const float4x4& m, const float4x4& reference)
+{
+    float error = 0.0f;
+    float magnitude = 1.0f;
+    for (int c = 0; c < 4; ++c)
+    {
+        error = eastl::max(error, maxelem(abs(m[c] - reference[c])));
+        magnitude = eastl::max(magnitude, maxelem(abs(reference[c])));
+    }
+    return error / magnitude;
+}
+
+int main()
+{
+    TestEnvironment environment;
+
+    std::mt19937 rng(42);
+    NodeHierarchy hierarchy;
+
+    for (uint32_t h = 0; h < HIERARCHY_COUNT; ++h)
+    {
+        eastl::vector<TestNode> nodes = CreateRandomHierarchy(rng);
+
+        eastl::vector<uint32_t> parents(nodes.size());
+        for (size_t i = 0; i < nodes.size(); ++i)
+        {
+            parents[i] = nodes[i].parent;
+        }
+
+        //the hierarchy is rebuilt in place, like a skeletal mesh reusing its vectors
+        hierarchy.Build(parents);
+        TEST_CHECK(hierarchy.GetNodeCount() == nodes.size());
+
+        for (uint32_t i = 0; i < (uint32_t)nodes.size(); ++i)
+        {
+            TEST_CHECK(hierarchy.GetSortedIndex(i) < nodes.size());
+            if (nodes[i].parent != UINT32_MAX)
+            {
+                TEST_CHECK(hierarchy.GetSortedIndex(nodes[i].parent) < hierarchy.GetSortedIndex(i));
+            }
+        }
+
+        hierarchy.UpdateTransforms([&](uint32_t node_id)
+            {
+                const TestNode& node = nodes[node_id];
+                return affine_transform(node.translation, node.rotation, node.scale);
+            });
+
+        //every node is used as a joint, with the next node's local transform as its inverse bind matrix
+        for (uint32_t i = 0; i < (uint32_t)nodes.size(); ++i)
+        {
+            float4x4 reference = GetReferenceTransform(nodes, i);
+            TEST_CHECK(GetError(to_float4x4(hierarchy.GetGlobalTransform(i)), reference) < MAX_ERROR);
+
+            const TestNode& bindNode = nodes[(i + 1) % nodes.size()];
+            affine3x4 inverseBind = affine_transform(bindNode.translation, bindNode.rotation, bindNode.scale);
+            float4x4 joint = to_float4x4(mul(hierarchy.GetGlobalTransform(i), inverseBind));
+            TEST_CHECK(GetError(joint, mul(reference, GetLocalMatrix(bindNode))) < MAX_ERROR);
+        }
+    }
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,177 @@
+#include "test.h"
+#include "renderer/pass_profiler.h"
+#include "gfx/mock/mock_device.h"
+#include "EASTL/unique_ptr.h"
+#include <fstream>
+#include <math.h>
+#include <stdlib.h>
+
+//the mock command lists advance their timestamps by MOCK_TICKS_PER_WORK (1us) per draw,
+//pass B draws 1 to 100 times, so its gpu times are 0.001 to 0.1 ms, each once
+static const uint32_t SAMPLE_COUNT = 100;
+static const uint32_t FRAME_COUNT = SAMPLE_COUNT + GFX_MAX_INFLIGHT_FRAMES;
+static const uint32_t PASS_A_DRAWS = 3;
+static const float GPU_BUDGET_B = 0.0905f; //the frames with 91 to 100 draws are over budget
+
+static const char* CSV_FILE = "pass_profiler_test.csv";
+
+static bool IsNear(float a, float b)
+{
+    return fabsf(a - b) < 1e-6f;
+}
+
+static void RecordPass(PassProfiler& profiler, IGfxCommandList* pCommandList, const eastl::string& name, uint32_t draws)
+{
+    uint32_t pass = profiler.BeginPass(pCommandList, name);
+    for (uint32_t i = 0; i < draws; ++i)
+    {
+        pCommandList->Draw(3);
+    }
+    profiler.EndPass(pCommandList, pass);
+}
+
+static eastl::vector<eastl::string> ReadLines(const char* file)
+{
+    eastl::vector<eastl::string> lines;
+
+    std::ifstream stream(file);
+    std::string line;
+    while (std::getline(stream, line))
+    {
+        lines.push_back(line.c_str());
+    }
+    return lines;
+}
+
+static eastl::vector<eastl::string> SplitCSV(const eastl::string& line)
+{
+    eastl::vector<eastl::string> columns;
+
+    size_t begin = 0;
+    while (begin <= line.size())
+    {
+        size_t end = line.find(',', begin);
+        if (end == eastl::string::npos)
+        {
+            end = line.size();
+        }
+        columns.push_back(line.substr(begin, end - begin));
+        begin = end + 1;
+    }
+    return columns;
+}
+
+int main()
+{
+    TestEnvironment environment;
+
+    GfxDeviceDesc desc;
+    desc.backend = GfxRenderBackend::Mock;
+    MockDevice device(desc);
+    TEST_CHECK(device.Create());
+
+    eastl::unique_ptr<IGfxCommandList> pCommandList(device.CreateCommandList(GfxCommandQueue::Graphics, "command list"));
+
+    PassProfiler profiler(&device, "");
+    TEST_CHECK(profiler.IsGpuTimingSupported());
+
+    PassProfiler::Budget budget;
+    budget.gpu = GPU_BUDGET_B;
+    profiler.SetBudget("B", budget); //before the pass has run
+
+    for (uint32_t frame = 0; frame < FRAME_COUNT; ++frame)
+    {
+        device.BeginFrame();
+        pCommandList->ResetAllocator();
+        pCommandList->Begin();
+
+        //collects the frame recorded GFX_MAX_INFLIGHT_FRAMES frames ago
+        profiler.BeginFrame(pCommandList.get());
+
+        //passes with the same name are summed up
+        RecordPass(profiler, pCommandList.get(), "A", PASS_A_DRAWS);
+        RecordPass(profiler, pCommandList.get(), "B", 1 + frame % SAMPLE_COUNT);
+        RecordPass(profiler, pCommandList.get(), "A", PASS_A_DRAWS);
+
+        profiler.EndFrame(pCommandList.get());
+
+        pCommandList->End();
+        pCommandList->Submit();
+        device.EndFrame();
+
+        uint32_t collected = frame + 1 > GFX_MAX_INFLIGHT_FRAMES ? frame + 1 - GFX_MAX_INFLIGHT_FRAMES : 0;
+        TEST_CHECK(profiler.GetGpuStats("B").count == collected);
+    }
+
+    PassProfiler::Stats b = profiler.GetGpuStats("B");
+    TEST_CHECK(b.count == SAMPLE_COUNT);
+    TEST_CHECK(IsNear(b.min, 0.001f));
+    TEST_CHECK(IsNear(b.max, 0.1f));
+    TEST_CHECK(IsNear(b.avg, 0.0505f));
+    TEST_CHECK(IsNear(b.p50, 0.05f));
+    TEST_CHECK(IsNear(b.p95, 0.095f));
+    TEST_CHECK(IsNear(b.p99, 0.099f));
+
+    PassProfiler::Stats a = profiler.GetGpuStats("A");
+    TEST_CHECK(a.count == SAMPLE_COUNT);
+    TEST_CHECK(IsNear(a.min, 0.006f));
+    TEST_CHECK(IsNear(a.max, 0.006f));
+    TEST_CHECK(IsNear(a.p99, 0.006f));
+
+    PassProfiler::Stats frame = profiler.GetGpuStats("Frame");
+    TEST_CHECK(frame.count == SAMPLE_COUNT);
+    TEST_CHECK(IsNear(frame.min, 0.007f));
+    TEST_CHECK(IsNear(frame.max, 0.106f));
+
+    //the cpu times aren't deterministic, only their order is
+    PassProfiler::Stats cpu = profiler.GetCpuStats("B");
+    TEST_CHECK(cpu.count == SAMPLE_COUNT);
+    TEST_CHECK(cpu.min >= 0.0f && cpu.min <= cpu.p50 && cpu.p50 <= cpu.p95 && cpu.p95 <= cpu.p99 && cpu.p99 <= cpu.max);
+    TEST_CHECK(cpu.min <= cpu.avg && cpu.avg <= cpu.max);
+
+    TEST_CHECK(profiler.GetOverBudgetFrames("B") == 10);
+    TEST_CHECK(profiler.GetOverBudgetFrames("A") == 0);
+
+    //samples < 0 are frames without gpu timing, they are left out of the stats
+    {
+        const float samples[] = { 4.0f, -1.0f, 1.0f, 3.0f, -1.0f, 2.0f };
+        PassProfiler::Stats stats = PassProfiler::CalcStats(samples, 6);
+        TEST_CHECK(stats.count == 4);
+        TEST_CHECK(stats.min == 1.0f && stats.max == 4.0f && stats.avg == 2.5f);
+        TEST_CHECK(stats.p50 == 2.0f && stats.p95 == 4.0f);
+        TEST_CHECK(PassProfiler::CalcStats(samples + 1, 1).count == 0);
+    }
+
+    TEST_CHECK(profiler.ExportCSV(CSV_FILE));
+
+    eastl::vector<eastl::string> lines = ReadLines(CSV_FILE);
+    TEST_CHECK(lines.size() == 4);
+    if (lines.size() == 4)
+    {
+        TEST_CHECK(lines[0] == "pass,samples,cpu_min,cpu_avg,cpu_max,cpu_p50,cpu_p95,cpu_p99,gpu_min,gpu_avg,gpu_max,gpu_p50,gpu_p95,gpu_p99,cpu_budget,gpu_budget,over_budget_frames");
+
+        //sorted by name
+        eastl::vector<eastl::string> columns = SplitCSV(lines[2]);
+        TEST_CHECK(columns.size() == 17);
+        if (columns.size() == 17)
+        {
+            TEST_CHECK(columns[0] == "\"B\"");
+            TEST_CHECK(atoi(columns[1].c_str()) == (int)SAMPLE_COUNT);
+
+            const float gpu[] = { 0.001f, 0.0505f, 0.1f, 0.05f, 0.095f, 0.099f };
+            for (uint32_t i = 0; i < 6; ++i)
+            {
+                TEST_CHECK(IsNear((float)atof(columns[8 + i].c_str()), gpu[i]));
+            }
+
+            TEST_CHECK(columns[14] == "0.0000");
+            TEST_CHECK(columns[15] == "0.0905");
+            TEST_CHECK(columns[16] == "10");
+        }
+
+        TEST_CHECK(lines[1].find("\"A\",") == 0);
+        TEST_CHECK(lines[3].find("\"Frame\",") == 0);
+    }
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,101 @@
+#include "test.h"
+#include "physics/physics_step_clock.h"
+#include <math.h>
+#include <random>
+
+static const float STEP_RATE = 60.0f;
+static const uint32_t SESSION_SECONDS = 300;
+
+//frame times between 2 and 50 ms, never enough for more than max substeps
+static float GetRandomDeltaTime(std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> distribution(0.002f, 0.05f);
+    return distribution(rng);
+}
+
+static void CheckAlpha(const PhysicsStepClock& clock)
+{
+    TEST_CHECK(clock.GetInterpolationAlpha() >= 0.0f);
+    TEST_CHECK(clock.GetInterpolationAlpha() < 1.0f);
+}
+
+int main()
+{
+    TestEnvironment environment;
+
+    //the same session at 120 and 60 fps takes the same steps, give or take the one the rounding of the deltas moves over the end
+    PhysicsStepClock clock120;
+    PhysicsStepClock clock60;
+
+    for (uint32_t i = 0; i < SESSION_SECONDS * 120; ++i)
+    {
+        clock120.Tick(1.0f / 120.0f);
+        CheckAlpha(clock120);
+        TEST_CHECK(clock120.GetLastStepCount() <= 1);
+    }
+
+    for (uint32_t i = 0; i < SESSION_SECONDS * 60; ++i)
+    {
+        clock60.Tick(1.0f / 60.0f);
+        CheckAlpha(clock60);
+        TEST_CHECK(clock60.GetLastStepCount() <= 2);
+    }
+
+    const uint64_t expectedStepCount = (uint64_t)(SESSION_SECONDS * STEP_RATE);
+    TEST_CHECK(clock120.GetTotalStepCount() + 1 >= expectedStepCount && clock120.GetTotalStepCount() <= expectedStepCount + 1);
+    TEST_CHECK(clock60.GetTotalStepCount() + 1 >= expectedStepCount && clock60.GetTotalStepCount() <= expectedStepCount + 1);
+    TEST_CHECK(clock120.GetDroppedStepCount() == 0);
+    TEST_CHECK(clock60.GetDroppedStepCount() == 0);
+
+    //with random frame times, the steps taken always match the time accumulated so far
+    for (uint32_t seed = 1; seed <= 4; ++seed)
+    {
+        std::mt19937 rng(seed);
+        PhysicsStepClock clock;
+
+        double time = 0.0;
+        while (time < SESSION_SECONDS)
+        {
+            float delta_time = GetRandomDeltaTime(rng);
+            time += delta_time;
+
+            clock.Tick(delta_time);
+            CheckAlpha(clock);
+
+            double steps = clock.GetTotalStepCount() + clock.GetInterpolationAlpha();
+            TEST_CHECK(fabs(steps - time * STEP_RATE) < 0.01);
+        }
+
+        TEST_CHECK(clock.GetDroppedStepCount() == 0);
+        TEST_CHECK(clock.GetTotalStepCount() + 1 >= expectedStepCount);
+    }
+
+    //a hitch takes at most max substeps, the rest of the time is dropped instead of carried over
+    {
+        PhysicsStepClock clock;
+        clock.SetMaxSubsteps(4);
+
+        TEST_CHECK(clock.Tick(1.0f) == 4);
+        TEST_CHECK(clock.GetDroppedStepCount() == 56);
+        CheckAlpha(clock);
+
+        TEST_CHECK(clock.Tick(1.0f / 60.0f) <= 2);
+        TEST_CHECK(clock.GetDroppedStepCount() == 56);
+        TEST_CHECK(clock.GetTickCount() == 2);
+    }
+
+    //a new step rate applies from the next tick
+    {
+        PhysicsStepClock clock;
+        clock.SetStepRate(120.0f);
+
+        uint32_t stepCount = 0;
+        for (uint32_t i = 0; i < 60; ++i)
+        {
+            stepCount += clock.Tick(1.0f / 60.0f);
+        }
+        TEST_CHECK(stepCount + 1 >= 120 && stepCount <= 121);
+    }
+
+    return TEST_RESULT();
+}
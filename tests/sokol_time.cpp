@@ -0,0 +1,3 @@
+//the engine compiles the sokol implementation in engine.cpp
+#define SOKOL_IMPL
+#include "sokol/sokol_time.h"
@@ -0,0 +1,113 @@
+#include "test.h"
+#include "gfx/mock/mock_device.h"
+#include "gfx/gfx_command_list.h"
+#include "gfx/gfx_pipeline_state.h"
+#include "gfx/gfx_buffer.h"
+#include "EASTL/unique_ptr.h"
+
+static const uint32_t DRAW_COUNT = 8;
+
+//the state set before each draw of a batch loop : every change and repeat below is counted by hand in the checks
+static void RecordDraws(IGfxCommandList* pCommandList, IGfxPipelineState* psoA, IGfxPipelineState* psoB, IGfxBuffer* indexBuffer)
+{
+    uint32_t material[16] = { 1, 2, 3, 4 };
+    uint32_t largeConstants[GfxStateCache::MAX_CACHED_CONSTANT_SIZE / sizeof(uint32_t) * 2] = {};
+
+    for (uint32_t i = 0; i < DRAW_COUNT; ++i)
+    {
+        pCommandList->SetPipelineState(i < DRAW_COUNT / 2 ? psoA : psoB); //2 set, 6 skipped
+
+        uint32_t rootConstants[4] = { i / 2, 0, 0, 0 };
+        pCommandList->SetGraphicsConstants(0, rootConstants, sizeof(rootConstants)); //4 set, 4 skipped
+        pCommandList->SetGraphicsConstants(1, material, sizeof(material)); //1 set, 7 skipped
+        pCommandList->SetGraphicsConstants(2, largeConstants, sizeof(largeConstants)); //too large to be compared : 8 set
+
+        pCommandList->SetIndexBuffer(indexBuffer, 0, GfxFormat::R16UI); //1 set, 7 skipped
+        pCommandList->SetViewport(0, 0, 1920, 1080); //sets the scissor rect too : 2 set, 14 skipped
+
+        pCommandList->DrawIndexed(36);
+    }
+}
+
+static void CheckStats(const GfxStateCache::Stats& stats, const GfxStateCache::Stats& expected)
+{
+    TEST_CHECK(stats.pipelineStates == expected.pipelineStates);
+    TEST_CHECK(stats.pipelineStatesSkipped == expected.pipelineStatesSkipped);
+    TEST_CHECK(stats.constants == expected.constants);
+    TEST_CHECK(stats.constantsSkipped == expected.constantsSkipped);
+    TEST_CHECK(stats.indexBuffers == expected.indexBuffers);
+    TEST_CHECK(stats.indexBuffersSkipped == expected.indexBuffersSkipped);
+    TEST_CHECK(stats.viewports == expected.viewports);
+    TEST_CHECK(stats.viewportsSkipped == expected.viewportsSkipped);
+}
+
+int main()
+{
+    TestEnvironment environment;
+
+    GfxDeviceDesc desc;
+    desc.backend = GfxRenderBackend::Mock;
+    MockDevice device(desc);
+    TEST_CHECK(device.Create());
+
+    GfxGraphicsPipelineDesc psoDesc;
+    eastl::unique_ptr<IGfxPipelineState> psoA(device.CreateGraphicsPipelineState(psoDesc, "A"));
+    psoDesc.rasterizer_state.cull_mode = GfxCullMode::Front;
+    eastl::unique_ptr<IGfxPipelineState> psoB(device.CreateGraphicsPipelineState(psoDesc, "B"));
+
+    GfxBufferDesc bufferDesc;
+    bufferDesc.size = 1024;
+    eastl::unique_ptr<IGfxBuffer> indexBuffer(device.CreateBuffer(bufferDesc, "IB"));
+
+    eastl::unique_ptr<IGfxCommandList> pCommandList(device.CreateCommandList(GfxCommandQueue::Graphics, "CommandList"));
+
+    GfxStateCache::Stats expected;
+    expected.pipelineStates = 2;
+    expected.pipelineStatesSkipped = 6;
+    expected.constants = 4 + 1 + 8;
+    expected.constantsSkipped = 4 + 7;
+    expected.indexBuffers = 1;
+    expected.indexBuffersSkipped = 7;
+    expected.viewports = 2;
+    expected.viewportsSkipped = 14;
+
+    //the counters and the bound state start over with each frame
+    for (uint32_t frame = 0; frame < 2; ++frame)
+    {
+        device.BeginFrame();
+
+        pCommandList->ResetAllocator();
+        pCommandList->Begin();
+        RecordDraws(pCommandList.get(), psoA.get(), psoB.get(), indexBuffer.get());
+        pCommandList->End();
+
+        CheckStats(pCommandList->GetStateCacheStats(), expected);
+
+        device.EndFrame();
+    }
+
+    //after ResetState (e.g. the native command list was used by an upscaler), the same state has to be set again
+    device.BeginFrame();
+
+    pCommandList->ResetAllocator();
+    pCommandList->Begin();
+    RecordDraws(pCommandList.get(), psoA.get(), psoB.get(), indexBuffer.get());
+    pCommandList->ResetState();
+    RecordDraws(pCommandList.get(), psoB.get(), psoB.get(), indexBuffer.get());
+    pCommandList->End();
+
+    GfxStateCache::Stats reset;
+    reset.pipelineStates = 3; //psoB is set again after the reset, then skipped 7 times
+    reset.pipelineStatesSkipped = 13;
+    reset.constants = 26;
+    reset.constantsSkipped = 22;
+    reset.indexBuffers = 2;
+    reset.indexBuffersSkipped = 14;
+    reset.viewports = 4;
+    reset.viewportsSkipped = 28;
+    CheckStats(pCommandList->GetStateCacheStats(), reset);
+
+    device.EndFrame();
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "rpmalloc/rpmalloc.h"
+#include "sokol/sokol_time.h"
+#include "EASTL/utility.h"
+#include <stdio.h>
+#include <thread>
+
+//checks stay enabled in release builds, unlike RE_ASSERT. a test returns the result of TEST_RESULT() from main
+inline int g_testFailureCount = 0;
+
+#define TEST_CHECK(x) \
+    do \
+    { \
+        if (!(x)) \
+        { \
+            printf("%s(%d) : check failed : %s\n", __FILE__, __LINE__, #x); \
+            ++g_testFailureCount; \
+        } \
+    } while (0)
+
+#define TEST_RESULT() (g_testFailureCount == 0 ? 0 : 1)
+
+//the engine allocates through rpmalloc (RE_ALLOC), it has to be initialized before any EASTL container is used
+struct TestEnvironment
+{
+    TestEnvironment()
+    {
+        rpmalloc_initialize();
+        stm_setup();
+    }
+
+    ~TestEnvironment() { rpmalloc_finalize(); }
+};
+
+//threads started by a test, set up like the task threads of the engine
+template<typename F>
+std::thread StartTestThread(F&& fun)
+{
+    return std::thread([fun = eastl::forward<F>(fun)]()
+        {
+            rpmalloc_thread_initialize();
+            fun();
+            rpmalloc_thread_finalize(1);
+        });
+}